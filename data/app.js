@@ -1,19 +1,25 @@
-const MAX_TICKERS = 15;
+const MAX_TICKERS = 100;
 let config = null;
 let statusInterval = null;
 let tickerInterval = null;
 
 const TYPE_MAP = ['Crypto', 'Stock', 'Forex'];
+const CURRENCIES = ['USD', 'EUR', 'GBP', 'CHF', 'JPY'];
+const MAX_ALERTS = 16;
+let alerts = [];
 
 document.addEventListener('DOMContentLoaded', () => {
     loadConfig();
     loadStatus();
     startAutoRefresh();
+    compareFeeds();
+    loadAlerts();
+    connectMirror();
 });
 
 function startAutoRefresh() {
     statusInterval = setInterval(loadStatus, 5000);
-    tickerInterval = setInterval(loadTickers, 10000);
+    tickerInterval = setInterval(() => { loadTickers(); loadRecentAlerts(); }, 10000);
 }
 
 async function loadConfig() {
@@ -27,6 +33,14 @@ async function loadConfig() {
         document.getElementById('baseTimeVal').textContent = (config.baseTimeMs || 8000) / 1000;
         document.getElementById('coinGeckoKey').value = config.coinGeckoApiKey || '';
         document.getElementById('twelveDataKey').value = config.twelveDataApiKey || '';
+        document.getElementById('lanRelay').checked = !!config.lanRelay;
+        document.getElementById('lowPower').checked = config.lowPower !== false;
+        document.getElementById('marketStream').checked = config.marketStream !== false;
+        document.getElementById('staleMarker').checked = config.staleMarker !== false;
+        document.getElementById('currency').value = config.currency || 'USD';
+        document.getElementById('timezone').value = config.timezone || 'UTC0';
+        document.getElementById('quietStart').value = config.quietStartHour || 0;
+        document.getElementById('quietEnd').value = config.quietEndHour || 0;
 
         renderTickers();
         loadTickers();
@@ -46,36 +60,286 @@ async function loadStatus() {
         document.getElementById('rssi').textContent = status.rssi ? status.rssi + ' dBm' : '--';
         document.getElementById('heap').textContent = status.heap ? formatBytes(status.heap) : '--';
         document.getElementById('uptime').textContent = status.uptime || '--';
+
+        // Displayed price age: median / p90 and the share within the SLO
+        const age = status.dataAge;
+        document.getElementById('dataAge').textContent = age && age.displayed.count
+            ? formatAge(age.displayed.p50Ms) + ' / p90 ' + formatAge(age.displayed.p90Ms) +
+              ' (' + age.sloPct.toFixed(1) + '% ≤ ' + formatAge(age.sloMs) + ')'
+            : '--';
     } catch (e) {
         console.error('Status update failed:', e);
     }
 }
 
+// The feed is paged (?from=<slot>); follow nextSlot to the last page
+async function fetchTickerFeed() {
+    const tickers = [];
+    let from = 0;
+    while (from !== null) {
+        const res = await fetch('/api/v1/tickers.msgpack?from=' + from);
+        const page = decodeTickerFeed(await res.arrayBuffer());
+        tickers.push(...page.tickers);
+        from = page.nextSlot;
+    }
+    return tickers;
+}
+
 async function loadTickers() {
     try {
-        const res = await fetch('/api/tickers');
-        const tickers = await res.json();
+        const tickers = await fetchTickerFeed();
 
-        tickers.forEach((ticker, i) => {
-            const priceEl = document.getElementById('price-' + i);
+        tickers.forEach((ticker) => {
+            const priceEl = document.getElementById('price-' + ticker.slot);
             if (priceEl) {
-                if (ticker.valid && ticker.price !== undefined) {
+                if (ticker.valid) {
                     priceEl.textContent = '$' + ticker.price.toLocaleString(undefined, {
                         minimumFractionDigits: 2,
                         maximumFractionDigits: 2
                     });
                     priceEl.className = 'ticker-price';
+                    priceEl.title = ticker.lastUpdate
+                        ? 'Price from ' + formatAge(Date.now() - ticker.lastUpdate * 1000) + ' ago'
+                        : '';
                 } else {
                     priceEl.textContent = 'N/A';
                     priceEl.className = 'ticker-price invalid';
                 }
             }
         });
+
+        renderCharts(tickers);
     } catch (e) {
         console.error('Ticker update failed:', e);
     }
 }
 
+// Minimal MessagePack decoder for the ticker feed (see src/ticker_feed.h)
+function decodeMsgPack(buffer) {
+    const view = new DataView(buffer);
+    const bytes = new Uint8Array(buffer);
+    let pos = 0;
+
+    function array(n) {
+        const out = new Array(n);
+        for (let i = 0; i < n; i++) out[i] = next();
+        return out;
+    }
+
+    function str(n) {
+        const s = new TextDecoder().decode(bytes.subarray(pos, pos + n));
+        pos += n;
+        return s;
+    }
+
+    function next() {
+        const b = view.getUint8(pos++);
+        if (b < 0x80) return b;
+        if ((b & 0xF0) === 0x90) return array(b & 0x0F);
+        if ((b & 0xE0) === 0xA0) return str(b & 0x1F);
+        let v;
+        switch (b) {
+            case 0xC0: return null;
+            case 0xC2: return false;
+            case 0xC3: return true;
+            case 0xC4: {
+                const n = view.getUint8(pos);
+                v = bytes.slice(pos + 1, pos + 1 + n);
+                pos += 1 + n;
+                return v;
+            }
+            case 0xCA: v = view.getFloat32(pos); pos += 4; return v;
+            case 0xCB: v = view.getFloat64(pos); pos += 8; return v;
+            case 0xCC: v = view.getUint8(pos); pos += 1; return v;
+            case 0xCD: v = view.getUint16(pos); pos += 2; return v;
+            case 0xCE: v = view.getUint32(pos); pos += 4; return v;
+            case 0xDC: v = view.getUint16(pos); pos += 2; return array(v);
+        }
+        throw new Error('Unsupported msgpack type 0x' + b.toString(16));
+    }
+
+    return next();
+}
+
+function decodeTickerFeed(buffer) {
+    const [version, uptimeMs, rows, nextSlot] = decodeMsgPack(buffer);
+    if (version !== 3) throw new Error('Unsupported feed version ' + version);
+
+    return {
+        version,
+        uptimeMs,
+        nextSlot,
+        bytes: buffer.byteLength,
+        tickers: rows.map(r => ({
+            slot: r[0],
+            symbol: r[1],
+            type: r[2],
+            valid: r[3],
+            price: r[4],
+            change24h: r[5],
+            change: r[6],
+            high24h: r[7],
+            low24h: r[8],
+            lastUpdate: r[9],
+            sparklines: r[10].map(sp => sp && { min: sp[0], max: sp[1], points: sp[2] })
+        }))
+    };
+}
+
+const TIMEFRAMES = ['24H', '7D', '30D', '90D'];
+
+function renderCharts(tickers) {
+    const list = document.getElementById('chartList');
+    if (!list) return;
+    list.innerHTML = '';
+
+    tickers.forEach((ticker) => {
+        const row = document.createElement('div');
+        row.className = 'chart-row';
+
+        const label = document.createElement('div');
+        label.className = 'chart-symbol';
+        label.textContent = ticker.symbol;
+        row.appendChild(label);
+
+        ticker.sparklines.forEach((sp, tf) => {
+            const cell = document.createElement('div');
+            cell.className = 'chart-cell';
+            const pct = ticker.change[tf] || (tf > 0 ? ticker.change24h : 0);
+            const positive = pct >= 0;
+            const canvas = document.createElement('canvas');
+            canvas.width = 128;
+            canvas.height = 32;
+            drawSparkline(canvas, sp, positive);
+            const caption = document.createElement('span');
+            caption.className = positive ? 'chart-up' : 'chart-down';
+            caption.textContent = TIMEFRAMES[tf] + ' ' + (positive ? '+' : '') + pct.toFixed(1) + '%';
+            cell.appendChild(canvas);
+            cell.appendChild(caption);
+            row.appendChild(cell);
+        });
+
+        list.appendChild(row);
+    });
+}
+
+// Same look as the panel: dim fill under a bright line
+function drawSparkline(canvas, sp, positive) {
+    const ctx = canvas.getContext('2d');
+    ctx.fillStyle = '#000';
+    ctx.fillRect(0, 0, canvas.width, canvas.height);
+    if (!sp || sp.points.length < 2) return;
+
+    const pts = sp.points;
+    const w = canvas.width, h = canvas.height;
+    const x = i => (i * (w - 1)) / (pts.length - 1);
+    const y = v => h - 1 - (v * (h - 1)) / 255;
+
+    ctx.beginPath();
+    ctx.moveTo(0, h);
+    pts.forEach((v, i) => ctx.lineTo(x(i), y(v)));
+    ctx.lineTo(w - 1, h);
+    ctx.closePath();
+    ctx.fillStyle = positive ? '#005500' : '#550000';
+    ctx.fill();
+
+    ctx.beginPath();
+    pts.forEach((v, i) => (i ? ctx.lineTo(x(i), y(v)) : ctx.moveTo(x(i), y(v))));
+    ctx.strokeStyle = positive ? '#00ff00' : '#ff0000';
+    ctx.stroke();
+}
+
+// Live panel mirror over /ws/mirror: a keyframe, then XOR deltas
+// (palette + run-length frames, format in frame_mirror.h)
+let mirrorFrame = null;
+let mirrorSerial = 0;
+
+function connectMirror() {
+    const ws = new WebSocket('ws://' + location.host + '/ws/mirror');
+    ws.binaryType = 'arraybuffer';
+    let frames = 0, bytes = 0;
+    ws.onmessage = (ev) => {
+        if (!applyMirrorFrame(ev.data)) {
+            ws.send('key');   // Missed a frame: ask for a keyframe
+            return;
+        }
+        frames++;
+        bytes += ev.data.byteLength;
+        document.getElementById('mirrorStats').textContent =
+            'live, ' + ev.data.byteLength + ' B/frame (avg ' + Math.round(bytes / frames) + ' B)';
+    };
+    ws.onclose = () => {
+        document.getElementById('mirrorStats').textContent = 'reconnecting...';
+        mirrorFrame = null;
+        setTimeout(connectMirror, 3000);
+    };
+}
+
+// Returns false if a delta does not apply to the frame we hold
+function applyMirrorFrame(buffer) {
+    const v = new DataView(buffer);
+    if (v.getUint8(0) !== 0x4D) return true;
+    const flags = v.getUint8(1);
+    const w = v.getUint16(2, true), h = v.getUint16(4, true);
+    const serial = v.getUint32(6, true), base = v.getUint32(10, true);
+    const delta = flags & 1, raw = flags & 2;
+    if (delta && (!mirrorFrame || base !== mirrorSerial || mirrorFrame.length !== w * h)) return false;
+    if (!delta) mirrorFrame = new Uint16Array(w * h);
+
+    const colors = v.getUint8(14);
+    const palette = [];
+    let p = 15;
+    for (let k = 0; k < colors; k++, p += 2) palette.push(v.getUint16(p, true));
+    for (let i = 0; i < w * h && p < buffer.byteLength; ) {
+        const count = v.getUint8(p);
+        let value;
+        if (raw) { value = v.getUint16(p + 1, true); p += 3; }
+        else { value = palette[v.getUint8(p + 1)]; p += 2; }
+        for (let k = 0; k < count; k++, i++) {
+            mirrorFrame[i] = delta ? mirrorFrame[i] ^ value : value;
+        }
+    }
+    mirrorSerial = serial;
+    drawMirror(w, h);
+    return true;
+}
+
+function drawMirror(w, h) {
+    const canvas = document.getElementById('mirror');
+    if (canvas.width !== w || canvas.height !== h) {
+        canvas.width = w;
+        canvas.height = h;
+    }
+    const ctx = canvas.getContext('2d');
+    const img = ctx.createImageData(w, h);
+    mirrorFrame.forEach((c, i) => {
+        // RGB565 to RGB888, high bits replicated into the low ones
+        const r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+        img.data[i * 4] = (r << 3) | (r >> 2);
+        img.data[i * 4 + 1] = (g << 2) | (g >> 4);
+        img.data[i * 4 + 2] = (b << 3) | (b >> 2);
+        img.data[i * 4 + 3] = 255;
+    });
+    ctx.putImageData(img, 0, 0);
+}
+
+// Payload size + device-side serialization time, binary feed vs JSON
+async function compareFeeds() {
+    try {
+        const [bin, json] = await Promise.all([
+            fetch('/api/v1/tickers.msgpack'),
+            fetch('/api/tickers')
+        ]);
+        const binBytes = (await bin.arrayBuffer()).byteLength;
+        const jsonBytes = (await json.arrayBuffer()).byteLength;
+        document.getElementById('feedStats').textContent =
+            'binary ' + formatBytes(binBytes) + ' / ' + bin.headers.get('X-Serialize-Us') + ' µs' +
+            ' (first page, incl. sparklines) vs JSON ' + formatBytes(jsonBytes) + ' / ' + json.headers.get('X-Serialize-Us') + ' µs';
+    } catch (e) {
+        console.error('Feed comparison failed:', e);
+    }
+}
+
 function renderTickers() {
     const list = document.getElementById('tickerList');
     list.innerHTML = '';
@@ -95,6 +359,10 @@ function renderTickers() {
                 <option value="2" ${ticker.type === 2 ? 'selected' : ''}>Forex</option>
             </select>
             <input type="number" value="${ticker.timeMultiplier || 1.0}" step="0.1" min="0.5" max="5" id="mult-${i}">
+            <select id="cur-${i}" title="Display currency">
+                <option value="">Default</option>
+                ${CURRENCIES.map(c => `<option value="${c}" ${ticker.currency === c ? 'selected' : ''}>${c}</option>`).join('')}
+            </select>
             <input type="checkbox" ${ticker.enabled ? 'checked' : ''} id="enabled-${i}">
             <div class="ticker-price" id="price-${i}">--</div>
             <button class="btn-remove" onclick="removeTicker(${i})">×</button>
@@ -141,6 +409,130 @@ function updateAddButton() {
     btn.disabled = config.tickers && config.tickers.length >= MAX_TICKERS;
 }
 
+// Rules: {symbol, kind: above|below|move|range, price | pct + windowS}
+async function loadAlerts() {
+    try {
+        const res = await fetch('/api/alerts');
+        const data = await res.json();
+        alerts = data.rules || [];
+        renderAlerts();
+        renderRecentAlerts(data);
+    } catch (e) {
+        console.error('Alert load failed:', e);
+    }
+}
+
+async function loadRecentAlerts() {
+    try {
+        const res = await fetch('/api/alerts');
+        renderRecentAlerts(await res.json());
+    } catch (e) {
+        console.error('Alert refresh failed:', e);
+    }
+}
+
+function renderAlerts() {
+    const list = document.getElementById('alertList');
+    list.innerHTML = '';
+
+    alerts.forEach((rule, i) => {
+        const kind = rule.kind || 'above';
+        const value = kind === 'move' ? (rule.pct || '') : (rule.price || '');
+        const div = document.createElement('div');
+        div.className = 'ticker-item';
+        div.innerHTML = `
+            <div class="ticker-slot">#${i + 1}</div>
+            <input type="text" value="${rule.symbol || ''}" placeholder="Symbol" id="alertSymbol-${i}">
+            <select id="alertKind-${i}">
+                <option value="above" ${kind === 'above' ? 'selected' : ''}>Above</option>
+                <option value="below" ${kind === 'below' ? 'selected' : ''}>Below</option>
+                <option value="move" ${kind === 'move' ? 'selected' : ''}>Move %</option>
+                <option value="range" ${kind === 'range' ? 'selected' : ''}>24h range</option>
+            </select>
+            <input type="text" value="${kind === 'range' ? '' : value}" placeholder="Price / %" id="alertValue-${i}">
+            <input type="number" value="${(rule.windowS || 900) / 60}" min="1" max="1440" title="Move window (minutes)" id="alertWindow-${i}">
+            <button class="btn-remove" onclick="removeAlert(${i})">×</button>
+        `;
+        list.appendChild(div);
+    });
+
+    document.getElementById('addAlertBtn').disabled = alerts.length >= MAX_ALERTS;
+}
+
+function readAlerts() {
+    return alerts.map((rule, i) => {
+        const kind = document.getElementById('alertKind-' + i).value;
+        const value = document.getElementById('alertValue-' + i).value.trim();
+        const out = { symbol: document.getElementById('alertSymbol-' + i).value.trim().toUpperCase(), kind };
+        if (kind === 'above' || kind === 'below') {
+            out.price = value;  // Sent as text: the device parses it exactly
+        } else if (kind === 'move') {
+            out.pct = parseFloat(value) || 0;
+            out.windowS = (parseInt(document.getElementById('alertWindow-' + i).value) || 15) * 60;
+        }
+        return out;
+    });
+}
+
+function addAlert() {
+    alerts = readAlerts();
+    if (alerts.length >= MAX_ALERTS) {
+        showMessage('Maximum ' + MAX_ALERTS + ' alerts allowed', 'error');
+        return;
+    }
+    alerts.push({ symbol: '', kind: 'above', price: '' });
+    renderAlerts();
+}
+
+function removeAlert(index) {
+    alerts = readAlerts();
+    alerts.splice(index, 1);
+    renderAlerts();
+}
+
+async function saveAlerts() {
+    alerts = readAlerts();
+    try {
+        const res = await fetch('/api/alerts', {
+            method: 'POST',
+            headers: { 'Content-Type': 'application/json' },
+            body: JSON.stringify({ rules: alerts })
+        });
+        if (res.ok) {
+            showMessage('Alerts saved', 'success');
+            loadAlerts();
+        } else {
+            const text = await res.text();
+            showMessage('Save failed: ' + text, 'error');
+        }
+    } catch (e) {
+        showMessage('Save failed: ' + e.message, 'error');
+    }
+}
+
+// Recent alerts with their price-to-panel latency
+function renderRecentAlerts(data) {
+    const stats = data.stats || {};
+    document.getElementById('alertStats').textContent = stats.fired
+        ? stats.fired + ' fired, latency avg ' + stats.avgLatencyMs + ' ms / max ' + stats.maxLatencyMs + ' ms'
+        : '';
+
+    const list = document.getElementById('recentAlerts');
+    list.innerHTML = '';
+    (data.recent || []).forEach(a => {
+        const div = document.createElement('div');
+        div.className = 'ticker-item';
+        const latency = a.latencyMs !== undefined ? a.latencyMs + ' ms' : 'not shown';
+        div.innerHTML = `
+            <div class="ticker-slot">${a.symbol}</div>
+            <div>${a.detail}</div>
+            <div class="ticker-price">$${a.price}</div>
+            <div>${a.ageS}s ago, ${latency}</div>
+        `;
+        list.appendChild(div);
+    });
+}
+
 async function saveConfig() {
     if (!config) {
         showMessage('No config loaded', 'error');
@@ -151,12 +543,21 @@ async function saveConfig() {
     config.baseTimeMs = parseInt(document.getElementById('baseTime').value) * 1000;
     config.coinGeckoApiKey = document.getElementById('coinGeckoKey').value;
     config.twelveDataApiKey = document.getElementById('twelveDataKey').value;
+    config.lanRelay = document.getElementById('lanRelay').checked;
+    config.lowPower = document.getElementById('lowPower').checked;
+    config.marketStream = document.getElementById('marketStream').checked;
+    config.staleMarker = document.getElementById('staleMarker').checked;
+    config.currency = document.getElementById('currency').value;
+    config.timezone = document.getElementById('timezone').value || 'UTC0';
+    config.quietStartHour = parseInt(document.getElementById('quietStart').value) || 0;
+    config.quietEndHour = parseInt(document.getElementById('quietEnd').value) || 0;
 
     config.tickers = config.tickers.map((ticker, i) => ({
         symbol: document.getElementById('symbol-' + i).value,
         apiId: document.getElementById('apiId-' + i).value,
         type: parseInt(document.getElementById('type-' + i).value),
         timeMultiplier: parseFloat(document.getElementById('mult-' + i).value),
+        currency: document.getElementById('cur-' + i).value,
         enabled: document.getElementById('enabled-' + i).checked
     }));
 
@@ -181,51 +582,99 @@ async function saveConfig() {
     }
 }
 
-function uploadFirmware() {
-    const fileInput = document.getElementById('firmwareFile');
-    const file = fileInput.files[0];
+const OTA_CHUNK_SIZE = 32768;
+const OTA_MAX_RETRIES = 5;
+
+// gzip in the browser so less goes over the air (the device inflates it);
+// .gz files are sent as they are
+async function compressImage(file) {
+    if (file.name.endsWith('.gz') || typeof CompressionStream === 'undefined') {
+        return new Uint8Array(await file.arrayBuffer());
+    }
+    const stream = file.stream().pipeThrough(new CompressionStream('gzip'));
+    return new Uint8Array(await new Response(stream).arrayBuffer());
+}
+
+function setUploadProgress(percent) {
+    document.getElementById('uploadProgress').style.display = percent === null ? 'none' : 'block';
+    if (percent !== null) {
+        document.getElementById('progressBar').style.width = percent + '%';
+        document.getElementById('progressBar').textContent = Math.round(percent) + '%';
+    }
+}
+
+// Resumable upload (see /api/ota/*): chunks go up in order; after a
+// dropped connection the device's "received" says where to carry on
+async function uploadFirmware() {
+    const file = document.getElementById('firmwareFile').files[0];
+    const target = document.getElementById('otaTarget').value;
+    const sha256 = document.getElementById('otaSha256').value.trim();
 
     if (!file) {
-        showMessage('Please select a firmware file', 'error');
+        showMessage('Please select an image file', 'error');
         return;
     }
 
-    if (!file.name.endsWith('.bin')) {
-        showMessage('Please select a .bin file', 'error');
+    if (!/\.bin(\.gz)?$/.test(file.name)) {
+        showMessage('Please select a .bin or .bin.gz file', 'error');
         return;
     }
 
-    const formData = new FormData();
-    formData.append('firmware', file);
-
-    const xhr = new XMLHttpRequest();
-
-    xhr.upload.addEventListener('progress', (e) => {
-        if (e.lengthComputable) {
-            const percent = (e.loaded / e.total) * 100;
-            document.getElementById('uploadProgress').style.display = 'block';
-            document.getElementById('progressBar').style.width = percent + '%';
-            document.getElementById('progressBar').textContent = Math.round(percent) + '%';
-        }
-    });
+    try {
+        const image = await compressImage(file);
+        let params = `target=${target}&size=${image.length}`;
+        if (sha256) params += `&sha256=${sha256}`;
+
+        let res = await fetch('/api/ota/begin?' + params, { method: 'POST' });
+        let status = await res.json();
+        if (!res.ok) throw new Error(status.error || 'could not start');
+        setUploadProgress(0);
+
+        let offset = 0;
+        let retries = 0;
+        while (offset < image.length) {
+            let replied = false;
+            try {
+                res = await fetch(`/api/ota/chunk?offset=${offset}`, {
+                    method: 'POST',
+                    headers: { 'Content-Type': 'application/octet-stream' },
+                    body: image.subarray(offset, offset + OTA_CHUNK_SIZE)
+                });
+                status = await res.json();
+                replied = true;
+            } catch (e) {
+                await new Promise(r => setTimeout(r, 1000 * (retries + 1)));
+                try {
+                    status = await (await fetch('/api/ota')).json();
+                } catch (e2) {
+                    status = { state: 'receiving', received: offset };
+                }
+            }
 
-    xhr.addEventListener('load', () => {
-        if (xhr.status === 200) {
-            showMessage('Firmware uploaded successfully. Device will restart...', 'success');
-            document.getElementById('uploadProgress').style.display = 'none';
-        } else {
-            showMessage('Upload failed: ' + xhr.responseText, 'error');
-            document.getElementById('uploadProgress').style.display = 'none';
+            // A reply without progress backs off too: the device may still be
+            // finishing a fetch before it takes a gzip image
+            if (status.state !== 'receiving') throw new Error(status.error || 'upload session ended');
+            if (status.received > offset) {
+                retries = 0;
+            } else if (++retries > OTA_MAX_RETRIES) {
+                throw new Error('no progress, network error');
+            } else if (replied) {
+                await new Promise(r => setTimeout(r, 1000 * retries));
+            }
+            offset = status.received;
+            setUploadProgress((offset / image.length) * 100);
         }
-    });
 
-    xhr.addEventListener('error', () => {
-        showMessage('Upload failed: Network error', 'error');
-        document.getElementById('uploadProgress').style.display = 'none';
-    });
+        res = await fetch('/api/ota/finish', { method: 'POST' });
+        status = await res.json();
+        if (!res.ok) throw new Error(status.error || 'verification failed');
 
-    xhr.open('POST', '/update');
-    xhr.send(formData);
+        const saved = Math.round((1 - image.length / status.written) * 100);
+        showMessage(`Update verified (${saved}% less sent). Device will restart...`, 'success');
+    } catch (e) {
+        showMessage('Upload failed: ' + e.message, 'error');
+    }
+    setUploadProgress(null);
 }
 
 function restartDevice() {
@@ -254,6 +703,13 @@ function showMessage(text, type) {
     }, 5000);
 }
 
+function formatAge(ms) {
+    if (ms < 1000) return ms + 'ms';
+    if (ms < 60000) return (ms / 1000).toFixed(1) + 's';
+    if (ms < 3600000) return Math.round(ms / 60000) + 'm';
+    return (ms / 3600000).toFixed(1) + 'h';
+}
+
 function formatBytes(bytes) {
     if (bytes < 1024) return bytes + ' B';
     if (bytes < 1048576) return (bytes / 1024).toFixed(1) + ' KB';
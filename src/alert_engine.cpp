@@ -0,0 +1,317 @@
+#include "alert_engine.h"
+#include "alert_history.h"
+#include "display_renderer.h"
+#include "event_log.h"
+#include "app_clock.h"
+#include "config.h"
+#include <LittleFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+#define ALERTS_PATH "/alerts.json"
+
+// Per-rule runtime state, rebuilt whenever the rules or the watchlist change
+struct RuleState {
+  int16_t slot;          // Watchlist slot, -1 = symbol not in the watchlist
+  int8_t next;           // Next rule on the same slot, -1 = end
+  bool active;           // ABOVE/BELOW/RANGE condition held at the last update
+  uint32_t lastFired;    // 0 = never
+  PriceHistory history;  // MOVE
+};
+
+// Rules are replaced on the web server task and evaluated on the fetch task
+static SemaphoreHandle_t alertMutex = nullptr;
+static QueueHandle_t alertQueue = nullptr;
+
+static AlertRule rules[ALERT_MAX_RULES];
+static RuleState ruleState[ALERT_MAX_RULES];
+static int numRules = 0;
+static bool rulesChanged = true;
+static uint32_t boundVersion = 0;
+static int8_t slotRules[MAX_TICKERS];   // First rule per slot, -1 = none
+
+static AlertEvent recent[ALERT_RECENT];
+static int recentHead = 0;              // Next write position
+static int recentCount = 0;
+static AlertStats stats = {};
+static uint64_t latencyTotal = 0;
+
+static const char* kindNames[ALERT_KIND_COUNT] = { "above", "below", "move", "range" };
+
+static bool lock() {
+  return alertMutex && xSemaphoreTake(alertMutex, portMAX_DELAY) == pdTRUE;
+}
+
+static void unlock() {
+  xSemaphoreGive(alertMutex);
+}
+
+const char* getAlertKindName(AlertKind kind) {
+  return kind < ALERT_KIND_COUNT ? kindNames[kind] : "?";
+}
+
+static bool readPriceField(JsonVariantConst value, Price* out) {
+  if (value.is<const char*>()) return parsePrice(value.as<const char*>(), out);
+  if (value.is<double>()) {
+    *out = priceFromDouble(value.as<double>());
+    return true;
+  }
+  return false;
+}
+
+bool alertRuleFromJson(JsonObjectConst src, AlertRule* out) {
+  memset(out, 0, sizeof(AlertRule));
+  const char* symbol = src["symbol"] | "";
+  const char* kind = src["kind"] | "";
+  if (!symbol[0]) return false;
+  strlcpy(out->symbol, symbol, sizeof(out->symbol));
+
+  int k = 0;
+  while (k < ALERT_KIND_COUNT && strcmp(kind, kindNames[k]) != 0) k++;
+  if (k == ALERT_KIND_COUNT) return false;
+  out->kind = (AlertKind)k;
+
+  switch (out->kind) {
+    case ALERT_ABOVE:
+    case ALERT_BELOW:
+      return readPriceField(src["price"], &out->price) && out->price > 0;
+    case ALERT_MOVE:
+      out->pct = src["pct"] | 0.0f;
+      out->windowS = constrain(src["windowS"] | 900UL, 60UL, 86400UL);
+      return out->pct > 0;
+    default:
+      return true;
+  }
+}
+
+void alertRuleToJson(const AlertRule& rule, JsonObject dst) {
+  dst["symbol"] = rule.symbol;
+  dst["kind"] = getAlertKindName(rule.kind);
+  if (rule.kind == ALERT_ABOVE || rule.kind == ALERT_BELOW) {
+    char text[PRICE_TEXT_LEN];
+    formatPriceDecimal(rule.price, text);
+    dst["price"] = serialized(String(text));
+  } else if (rule.kind == ALERT_MOVE) {
+    dst["pct"] = rule.pct;
+    dst["windowS"] = rule.windowS;
+  }
+}
+
+// Resolve symbols to slots and chain the rules per slot; caller holds the lock
+static void bindRules(const AppConfig* config) {
+  memset(slotRules, -1, sizeof(slotRules));
+  for (int r = numRules - 1; r >= 0; r--) {
+    RuleState& st = ruleState[r];
+    memset(&st, 0, sizeof(st));
+    st.slot = -1;
+    st.next = -1;
+    for (int i = 0; i < config->numTickers; i++) {
+      if (strcmp(config->tickers[i].symbol, rules[r].symbol) == 0) {
+        st.slot = i;
+        st.next = slotRules[i];
+        slotRules[i] = r;
+        break;
+      }
+    }
+  }
+  boundVersion = config->version;
+  rulesChanged = false;
+}
+
+static void fire(const AlertRule& rule, Price price, bool up, const char* detail, uint32_t receivedAt, uint32_t now) {
+  AlertEvent ev = {};
+  strlcpy(ev.symbol, rule.symbol, sizeof(ev.symbol));
+  strlcpy(ev.detail, detail, sizeof(ev.detail));
+  ev.kind = rule.kind;
+  ev.up = up;
+  ev.price = price;
+  ev.receivedAt = receivedAt;
+  ev.firedAt = now;
+
+  stats.fired++;
+  if (xQueueSend(alertQueue, &ev, 0) != pdTRUE) stats.dropped++;
+
+  recent[recentHead] = ev;
+  recentHead = (recentHead + 1) % ALERT_RECENT;
+  if (recentCount < ALERT_RECENT) recentCount++;
+
+  char text[48];
+  snprintf(text, sizeof(text), "%s %s", rule.symbol, detail);
+  LOG_EVENT(EV_ALERT_FIRED, text, priceToFloat(price));
+}
+
+static void checkRule(int r, const TickerData& ticker, uint32_t receivedAt, uint32_t now) {
+  const AlertRule& rule = rules[r];
+  RuleState& st = ruleState[r];
+  Price price = ticker.currentPrice;
+  bool cond = false;
+  bool up = true;
+  char detail[32] = "";
+
+  switch (rule.kind) {
+    case ALERT_ABOVE:
+    case ALERT_BELOW: {
+      up = rule.kind == ALERT_ABOVE;
+      cond = up ? price >= rule.price : price <= rule.price;
+      char text[PRICE_TEXT_LEN];
+      formatPriceDecimal(rule.price, text);
+      snprintf(detail, sizeof(detail), "%s %s", up ? "ABOVE" : "BELOW", text);
+      break;
+    }
+
+    case ALERT_RANGE:
+      if (ticker.high24h > 0 && price > ticker.high24h) {
+        cond = true;
+        strlcpy(detail, "24H HIGH", sizeof(detail));
+      } else if (ticker.low24h > 0 && price < ticker.low24h) {
+        cond = true;
+        up = false;
+        strlcpy(detail, "24H LOW", sizeof(detail));
+      }
+      break;
+
+    case ALERT_MOVE: {
+      historyAdd(&st.history, rule.windowS * 1000, now, price);
+      float move = historyMove(&st.history, price);
+      cond = fabsf(move) >= rule.pct;
+      up = move >= 0;
+      snprintf(detail, sizeof(detail), "%+.1f%% %luM", move, (unsigned long)(rule.windowS / 60));
+      break;
+    }
+
+    default:
+      return;
+  }
+
+  // Level rules fire when the condition starts to hold; a move fires each
+  // time and then measures again from the current price
+  bool edge = rule.kind == ALERT_MOVE ? cond : cond && !st.active;
+  st.active = cond;
+  if (!edge) return;
+  if (st.lastFired != 0 && now - st.lastFired < ALERT_COOLDOWN_MS) return;
+  st.lastFired = now;
+
+  if (rule.kind == ALERT_MOVE) {
+    historyClear(&st.history);
+    historyAdd(&st.history, rule.windowS * 1000, now, price);
+  }
+  fire(rule, price, up, detail, receivedAt, now);
+}
+
+static void saveRules() {
+  JsonDocument doc;
+  JsonArray arr = doc.to<JsonArray>();
+  if (!lock()) return;
+  for (int r = 0; r < numRules; r++) alertRuleToJson(rules[r], arr.add<JsonObject>());
+  unlock();
+
+  File f = LittleFS.open(ALERTS_PATH, "w");
+  if (!f) return;
+  serializeJson(doc, f);
+  f.close();
+}
+
+void initAlertEngine() {
+  if (alertMutex) return;
+  alertMutex = xSemaphoreCreateMutex();
+  alertQueue = xQueueCreate(ALERT_QUEUE_DEPTH, sizeof(AlertEvent));
+  memset(slotRules, -1, sizeof(slotRules));
+
+  File f = LittleFS.open(ALERTS_PATH, "r");
+  if (!f) return;
+  JsonDocument doc;
+  DeserializationError error = deserializeJson(doc, f);
+  f.close();
+  if (error) return;
+
+  for (JsonObjectConst o : doc.as<JsonArrayConst>()) {
+    if (numRules < ALERT_MAX_RULES && alertRuleFromJson(o, &rules[numRules])) numRules++;
+  }
+  stats.rules = numRules;
+  LOG_EVENT(EV_ALERT_RULES, nullptr, numRules);
+}
+
+void evaluateAlerts(const AppConfig* config, const TickerData* tickers,
+                    const uint8_t* changed, int count, uint32_t receivedAt) {
+  if (count <= 0 || !lock()) return;
+  if (rulesChanged || boundVersion != config->version) bindRules(config);
+
+  uint32_t firedBefore = stats.fired;
+  uint32_t now = appMillis();
+  for (int k = 0; k < count; k++) {
+    int idx = changed[k];
+    if (idx >= config->numTickers || !tickers[idx].priceValid) continue;
+    for (int r = slotRules[idx]; r >= 0; r = ruleState[r].next) {
+      checkRule(r, tickers[idx], receivedAt, now);
+    }
+  }
+  bool fired = stats.fired != firedBefore;
+  unlock();
+
+  // Cut the current screen short
+  if (fired) wakeDisplay();
+}
+
+bool takeAlert(AlertEvent* out) {
+  return alertQueue && xQueueReceive(alertQueue, out, 0) == pdTRUE;
+}
+
+bool alertPending() {
+  return alertQueue && uxQueueMessagesWaiting(alertQueue) > 0;
+}
+
+void alertShown(const AlertEvent& alert) {
+  uint32_t now = appMillis();
+  uint32_t latency = now - alert.receivedAt;
+  if (!lock()) return;
+  stats.shown++;
+  stats.lastLatencyMs = latency;
+  if (latency > stats.maxLatencyMs) stats.maxLatencyMs = latency;
+  latencyTotal += latency;
+  stats.avgLatencyMs = (uint32_t)(latencyTotal / stats.shown);
+  for (int n = 0; n < recentCount; n++) {
+    AlertEvent& ev = recent[n];
+    if (ev.firedAt == alert.firedAt && strcmp(ev.symbol, alert.symbol) == 0) ev.shownAt = now;
+  }
+  unlock();
+  LOG_EVENT(EV_ALERT_SHOWN, alert.symbol, latency);
+}
+
+bool setAlertRules(const AlertRule* newRules, int count) {
+  if (count < 0 || count > ALERT_MAX_RULES || !lock()) return false;
+  memcpy(rules, newRules, count * sizeof(AlertRule));
+  numRules = count;
+  stats.rules = count;
+  rulesChanged = true;   // Rebound on the fetch task with its own config
+  unlock();
+  saveRules();
+  LOG_EVENT(EV_ALERT_RULES, nullptr, count);
+  return true;
+}
+
+int getAlertRules(AlertRule* out, int max) {
+  if (!lock()) return 0;
+  int n = min(numRules, max);
+  memcpy(out, rules, n * sizeof(AlertRule));
+  unlock();
+  return n;
+}
+
+int getRecentAlerts(AlertEvent* out, int max) {
+  if (!lock()) return 0;
+  int n = min(recentCount, max);
+  for (int k = 0; k < n; k++) {
+    out[k] = recent[(recentHead - 1 - k + ALERT_RECENT) % ALERT_RECENT];
+  }
+  unlock();
+  return n;
+}
+
+AlertStats getAlertStats() {
+  AlertStats s = {};
+  if (!lock()) return s;
+  s = stats;
+  unlock();
+  return s;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "ticker_types.h"
+
+// Price alerts that preempt the display rotation.
+// Rules name a ticker by symbol and are kept in /alerts.json (edited through
+// /api/alerts). The data manager hands every price update to
+// evaluateAlerts() with just the slots that changed, so the cost scales with
+// the update, not the watchlist. A rule that fires queues an AlertEvent and
+// wakes the render loop out of holdFrame(); the alert screen is up within
+// one dither frame. Latency is measured from the moment the price arrived
+// (fetch completion or relay packet) to the first alert frame on the panel.
+
+enum AlertKind : uint8_t {
+  ALERT_ABOVE = 0,   // Price at or above `price`
+  ALERT_BELOW = 1,   // Price at or below `price`
+  ALERT_MOVE  = 2,   // Moved `pct` percent (either way) within `windowS` seconds
+  ALERT_RANGE = 3,   // Broke out of the 24h high/low
+  ALERT_KIND_COUNT
+};
+
+struct AlertRule {
+  char symbol[MAX_SYMBOL_LEN];
+  AlertKind kind;
+  Price price;       // ABOVE / BELOW threshold
+  float pct;         // MOVE size
+  uint32_t windowS;  // MOVE window
+};
+
+// A fired rule, as shown on the panel and listed by /api/alerts
+struct AlertEvent {
+  char symbol[MAX_SYMBOL_LEN];
+  char detail[32];       // "ABOVE 70000", "+5.2% 15M", "24H HIGH"
+  AlertKind kind;
+  bool up;               // Upward move (colors the screen)
+  Price price;
+  uint32_t receivedAt;   // millis() when the triggering price arrived
+  uint32_t firedAt;
+  uint32_t shownAt;      // 0 until the alert screen was drawn
+};
+
+struct AlertStats {
+  uint8_t rules;
+  uint32_t fired;
+  uint32_t shown;
+  uint32_t dropped;          // Fired while the queue was full
+  uint32_t lastLatencyMs;    // Price arrival -> first alert frame
+  uint32_t avgLatencyMs;
+  uint32_t maxLatencyMs;
+};
+
+// Load /alerts.json (call once in setup, after LittleFS is mounted)
+void initAlertEngine();
+
+// Check the rules of the tickers in `changed` against their new prices.
+// receivedAt is when those prices arrived. Fetch task only.
+void evaluateAlerts(const AppConfig* config, const TickerData* tickers,
+                    const uint8_t* changed, int count, uint32_t receivedAt);
+
+// Render loop: next alert to show; false if none is waiting
+bool takeAlert(AlertEvent* out);
+
+// An alert is waiting (render loop polls this while holding a screen)
+bool alertPending();
+
+// Render loop: the alert's first frame is on the panel
+void alertShown(const AlertEvent& alert);
+
+// Replace all rules (web server) and save them. False if there are too many.
+bool setAlertRules(const AlertRule* rules, int count);
+
+// Copy of the rules; returns the count
+int getAlertRules(AlertRule* out, int max);
+
+// Most recent fired alerts, newest first; returns the count
+int getRecentAlerts(AlertEvent* out, int max);
+
+AlertStats getAlertStats();
+
+// "above", "below", "move", "range"
+const char* getAlertKindName(AlertKind kind);
+
+// JSON form shared by /alerts.json and /api/alerts:
+//   {"symbol":"BTC","kind":"above","price":70000}
+//   {"symbol":"ETH","kind":"move","pct":5,"windowS":900}
+//   {"symbol":"SOL","kind":"range"}
+// Returns false for an unknown kind, missing symbol or missing threshold.
+bool alertRuleFromJson(JsonObjectConst src, AlertRule* out);
+void alertRuleToJson(const AlertRule& rule, JsonObject dst);
@@ -0,0 +1,41 @@
+#include "alert_history.h"
+
+void historyAdd(PriceHistory* h, uint32_t windowMs, uint32_t now, Price price) {
+  while (h->count > 0 && now - h->samples[h->head].at > windowMs) {
+    h->head = (h->head + 1) % ALERT_HISTORY;
+    h->count--;
+  }
+
+  uint32_t bucketMs = windowMs / ALERT_HISTORY;
+  if (h->count > 0) {
+    PriceSample& newest = h->samples[(h->head + h->count - 1) % ALERT_HISTORY];
+    if (now - newest.at < bucketMs) {
+      newest.price = price;
+      return;
+    }
+  }
+
+  if (h->count == ALERT_HISTORY) {
+    h->head = (h->head + 1) % ALERT_HISTORY;
+    h->count--;
+  }
+  h->samples[(h->head + h->count) % ALERT_HISTORY] = { now, price };
+  h->count++;
+}
+
+void historyClear(PriceHistory* h) {
+  h->head = 0;
+  h->count = 0;
+}
+
+float historyMove(const PriceHistory* h, Price price) {
+  Price lo = price, hi = price;
+  for (int n = 0; n < h->count; n++) {
+    Price p = h->samples[(h->head + n) % ALERT_HISTORY].price;
+    if (p < lo) lo = p;
+    if (p > hi) hi = p;
+  }
+  float fromLow = lo > 0 ? priceToFloat(price - lo) / priceToFloat(lo) * 100.0f : 0;
+  float fromHigh = hi > 0 ? priceToFloat(hi - price) / priceToFloat(hi) * 100.0f : 0;
+  return fromLow >= fromHigh ? fromLow : -fromHigh;
+}
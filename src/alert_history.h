@@ -0,0 +1,31 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "price.h"
+
+// Price history of one move alert rule over its window.
+// Samples are kept one per windowMs / ALERT_HISTORY bucket: a price arriving
+// in the newest sample's bucket replaces that sample's price instead of
+// taking a new one. That way ALERT_HISTORY samples span the whole window
+// however often prices arrive (the market stream sends one a second).
+
+struct PriceSample {
+  uint32_t at;     // Start of the sample's bucket (first price in it)
+  Price price;     // Latest price in the bucket
+};
+
+struct PriceHistory {
+  uint8_t head;    // Oldest sample
+  uint8_t count;
+  PriceSample samples[ALERT_HISTORY];
+};
+
+// Drop samples older than the window and record the price received at now
+void historyAdd(PriceHistory* h, uint32_t windowMs, uint32_t now, Price price);
+
+// Forget all samples
+void historyClear(PriceHistory* h);
+
+// Move of price from the window's low or high, in percent: positive when
+// it is further above the low than below the high, else negative
+float historyMove(const PriceHistory* h, Price price);
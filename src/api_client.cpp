@@ -1,61 +1,418 @@
 #include "api_client.h"
 #include "config.h"
+#include "provider_health.h"
+#include "fetch_arena.h"
+#include "response_body.h"
+#include "market_calendar.h"
+#include "event_log.h"
+#include "trace.h"
+#include "layout.h"
+#if SIM_BUILD
+#include "simulator.h"
+#endif
 #include <HTTPClient.h>
 #include <WiFiClientSecure.h>
 #include <ArduinoJson.h>
 #include <float.h>
 
-static HTTPClient http;
-static WiFiClientSecure client;
-static String coinGeckoApiKey = "";
-static String cmcApiKey = "";
+// One connection + arena per provider host so the fetch engine can run them
+// in parallel without sharing state
+struct ApiConnection {
+  HTTPClient http;
+  WiFiClientSecure client;
+  WiFiClient plainClient;   // Used for http:// base URLs (local stand-in servers)
+  ResponseBody body;
+  ApiEndpoint endpoint;     // Of the request in progress
+  uint32_t startedAt;       // millis() at beginRequest
+  bool bodyOpen;            // 200 received; endResponse() records its stats
+};
+
+static ApiConnection connections[PROVIDER_COUNT];
+static const char* trackedHeaders[] = { "Retry-After", "Content-Encoding" };
+
+static const ApiProvider endpointProviders[ENDPOINT_COUNT] = {
+  PROVIDER_CMC, PROVIDER_COINGECKO, PROVIDER_COINGECKO, PROVIDER_TWELVEDATA, PROVIDER_TWELVEDATA
+};
+static const char* endpointNames[ENDPOINT_COUNT] = {
+  "cmc/quotes", "coingecko/markets", "coingecko/market_chart", "twelvedata/price", "twelvedata/time_series"
+};
+
+// Provider workers write, web server reads
+static EndpointStats endpointStats[ENDPOINT_COUNT];
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+#if FETCH_GZIP
+// One inflater for all providers: its ~43KB is allocated the first time the
+// heap can spare it and then kept. A request only asks for gzip when it can
+// take the inflater, so one that finds it in use goes uncompressed.
+// An OTA upload takes it too (see claimUploadInflater).
+static GzipInflater* inflater = nullptr;
+static ApiProvider inflaterOwner = PROVIDER_COUNT;
+static portMUX_TYPE inflaterMux = portMUX_INITIALIZER_UNLOCKED;
+#define INFLATER_UPLOAD ((ApiProvider)(PROVIDER_COUNT + 1))   // Owner while OTA holds it
+
+static bool claimInflater(ApiProvider provider, bool* busy = nullptr) {
+  portENTER_CRITICAL(&inflaterMux);
+  bool idle = inflaterOwner == PROVIDER_COUNT;
+  if (idle) inflaterOwner = provider;
+  portEXIT_CRITICAL(&inflaterMux);
+  if (busy) *busy = !idle;
+  if (!idle) return false;
+
+  if (!inflater && ESP.getMaxAllocHeap() >= FETCH_GZIP_MIN_HEAP) {
+    inflater = gzipBegin(nullptr, nullptr);
+  }
+  if (inflater) return true;
+  portENTER_CRITICAL(&inflaterMux);
+  inflaterOwner = PROVIDER_COUNT;
+  portEXIT_CRITICAL(&inflaterMux);
+  return false;
+}
+
+static bool ownsInflater(ApiProvider provider) {
+  portENTER_CRITICAL(&inflaterMux);
+  bool owns = inflaterOwner == provider;
+  portEXIT_CRITICAL(&inflaterMux);
+  return owns;
+}
+
+static void releaseInflater(ApiProvider provider) {
+  portENTER_CRITICAL(&inflaterMux);
+  if (inflaterOwner == provider) inflaterOwner = PROVIDER_COUNT;
+  portEXIT_CRITICAL(&inflaterMux);
+}
+
+GzipInflater* claimUploadInflater(GzipSink sink, void* ctx, bool* busy) {
+  if (!claimInflater(INFLATER_UPLOAD, busy)) return nullptr;
+  gzipReset(inflater, sink, ctx);
+  return inflater;
+}
+
+void releaseUploadInflater() {
+  releaseInflater(INFLATER_UPLOAD);
+}
+#else
+static void releaseInflater(ApiProvider) {}
+
+// No shared inflater: the upload gets its own
+static GzipInflater* uploadInflater = nullptr;
+
+GzipInflater* claimUploadInflater(GzipSink sink, void* ctx, bool* busy) {
+  *busy = false;
+  if (!uploadInflater) uploadInflater = gzipBegin(sink, ctx);
+  return uploadInflater;
+}
+
+void releaseUploadInflater() {
+  gzipEnd(uploadInflater);
+  uploadInflater = nullptr;
+}
+#endif
+
+static uint8_t arenaBuffers[PROVIDER_COUNT][FETCH_ARENA_SIZE] __attribute__((aligned(8)));
+static FetchArena arenas[PROVIDER_COUNT] = {
+  FetchArena(arenaBuffers[PROVIDER_CMC], FETCH_ARENA_SIZE),
+  FetchArena(arenaBuffers[PROVIDER_COINGECKO], FETCH_ARENA_SIZE),
+  FetchArena(arenaBuffers[PROVIDER_TWELVEDATA], FETCH_ARENA_SIZE),
+};
+
+#if TRACE_ENABLED
+// Span names per provider (the tracer stores only the pointer)
+static const char* requestSpans[PROVIDER_COUNT] = { "cmc.request", "coingecko.request", "twelvedata.request" };
+static const char* parseSpans[PROVIDER_COUNT] = { "cmc.parse", "coingecko.parse", "twelvedata.parse" };
+#endif
+
+static char coinGeckoApiKey[64] = "";
+static char cmcApiKey[64] = "";
 
 void initApiClient() {
-  client.setInsecure(); // Skip cert validation - ESP32 has limited CA store
-  Serial.println("[API] Client initialized");
+  for (int p = 0; p < PROVIDER_COUNT; p++) {
+    connections[p].client.setInsecure(); // Skip cert validation - ESP32 has limited CA store
+    // HTTP/1.0 avoids chunked transfer encoding so the body can be parsed
+    // straight off the socket instead of being buffered into a String
+    connections[p].http.useHTTP10(true);
+  }
+  LOG_EVENT(EV_API_INIT, nullptr);
+}
+
+// Start a request to an endpoint on its provider's connection; timeoutMs
+// bounds connect, TLS handshake and each read so a request cannot outlive
+// its deadline. Also resets the provider's arena for the new response.
+static HTTPClient& beginRequest(ApiEndpoint endpoint, const char* url, uint32_t timeoutMs) {
+  ApiProvider provider = endpointProviders[endpoint];
+  ApiConnection& conn = connections[provider];
+  arenas[provider].reset();
+  conn.endpoint = endpoint;
+  conn.startedAt = millis();
+  conn.bodyOpen = false;
+#if SIM_BUILD
+  // Responses come from recorded fixtures; the HTTPClient is never opened
+  simBeginRequest(provider, url, timeoutMs);
+  return conn.http;
+#endif
+  if (strncmp(url, "http://", 7) == 0) {
+    conn.http.begin(conn.plainClient, url);
+  } else {
+    conn.client.setHandshakeTimeout((timeoutMs + 999) / 1000);
+    conn.http.begin(conn.client, url);
+  }
+  conn.http.setConnectTimeout(timeoutMs);
+  conn.http.setTimeout(timeoutMs);
+  conn.http.collectHeaders(trackedHeaders, 2);
+#if FETCH_GZIP
+  if (claimInflater(provider)) conn.http.addHeader("Accept-Encoding", "gzip");
+#endif
+  return conn.http;
+}
+
+// After a 200: read the body through the provider's ResponseBody, inflating
+// it if the server gzipped it
+static void openBody(ApiProvider provider) {
+  ApiConnection& conn = connections[provider];
+  conn.bodyOpen = true;
+#if SIM_BUILD
+  conn.body.begin(&simResponseStream(provider));
+  return;
+#endif
+  Stream* src = &conn.http.getStream();
+#if FETCH_GZIP
+  if (ownsInflater(provider) && conn.http.header("Content-Encoding").equalsIgnoreCase("gzip")) {
+    conn.body.beginGzip(src, inflater);
+    return;
+  }
+  releaseInflater(provider);
+#endif
+  conn.body.begin(src);
+}
+
+// Send the GET and report status + Retry-After to the provider health tracker
+static int sendRequest(ApiProvider provider) {
+  ApiConnection& conn = connections[provider];
+#if SIM_BUILD
+  uint32_t simRetryAfterMs = 0;
+  int simCode = simSendRequest(provider, &simRetryAfterMs);
+  recordProviderResult(provider, simCode, simRetryAfterMs);
+  if (simCode == 200) openBody(provider);
+  return simCode;
+#endif
+  // Connect + TLS handshake + request + response headers
+  TRACE_BEGIN(requestSpans[provider]);
+  int httpCode = conn.http.GET();
+  TRACE_END(requestSpans[provider]);
+
+  // Retry-After is either delta-seconds or an HTTP-date; without a wall
+  // clock only the seconds form can be honored
+  uint32_t retryAfterMs = 0;
+  if (conn.http.hasHeader("Retry-After")) {
+    long seconds = conn.http.header("Retry-After").toInt();
+    if (seconds > 0) {
+      retryAfterMs = (uint32_t)seconds * 1000;
+    }
+  }
+
+  recordProviderResult(provider, httpCode, retryAfterMs);
+  if (httpCode == 200) {
+    openBody(provider);
+  } else {
+    releaseInflater(provider);
+  }
+  return httpCode;
+}
+
+// Response body, read straight off the socket (or the simulation fixture),
+// inflated on the way if gzipped
+static Stream& responseStream(ApiProvider provider) {
+  return connections[provider].body;
+}
+
+// Close the response and add it to its endpoint's stats
+static void endResponse(ApiProvider provider) {
+  ApiConnection& conn = connections[provider];
+  if (conn.bodyOpen) {
+    conn.bodyOpen = false;
+    ResponseBody& body = conn.body;
+    uint32_t elapsed = millis() - conn.startedAt;
+    if (body.gzipResult() > GZIP_DONE) {
+      LOG_EVENT(EV_API_GZIP_ERROR, getGzipResultName(body.gzipResult()), provider);
+    }
+    LOG_EVENT(EV_API_BODY, endpointNames[conn.endpoint], provider, body.wireBytes(), body.bodyBytes(), elapsed);
+
+    portENTER_CRITICAL(&statsMux);
+    EndpointStats& st = endpointStats[conn.endpoint];
+    st.responses++;
+    if (body.gzipped()) st.gzipped++;
+    st.wireBytes += body.wireBytes();
+    st.bodyBytes += body.bodyBytes();
+    st.totalMs += elapsed;
+    st.lastWireBytes = body.wireBytes();
+    st.lastBodyBytes = body.bodyBytes();
+    st.lastMs = elapsed;
+    portEXIT_CRITICAL(&statsMux);
+    body.end();
+  }
+  releaseInflater(provider);
+#if SIM_BUILD
+  simEndRequest(provider);
+  return;
+#endif
+  conn.http.end();
+}
+
+// Parse the response body straight from the socket into an arena-backed
+// document, keeping only the fields named in the filter
+static DeserializationError parseResponse(ApiProvider provider, JsonDocument& doc, JsonDocument& filter) {
+  TRACE_SCOPE(parseSpans[provider]);
+  DeserializationError error = deserializeJson(doc, responseStream(provider), DeserializationOption::Filter(filter));
+  endResponse(provider);
+  return error;
+}
+
+// Prices arrive as JSON strings (Twelve Data), parsed here from their text,
+// or as numbers (CMC, CoinGecko), which ArduinoJson has already turned into
+// a double; those are rounded to the nearest Price unit
+static bool readPrice(JsonVariantConst value, Price* out) {
+  if (value.is<const char*>()) return parsePrice(value.as<const char*>(), out);
+  if (value.is<double>()) {
+    *out = priceFromDouble(value.as<double>());
+    return true;
+  }
+  return false;
+}
+
+// Raw chart prices in the arena: min/max are kept exact, the points only
+// as float offsets from the first price (ample for 8-bit chart rows, and
+// half the arena of a Price array)
+struct RawSeries {
+  float* offsets;
+  int count;
+  Price base;
+  Price minPrice;
+  Price maxPrice;
+};
+
+static void addRawPrice(RawSeries* raw, int idx, Price price, bool first) {
+  if (first) {
+    raw->base = raw->minPrice = raw->maxPrice = price;
+  } else {
+    if (price < raw->minPrice) raw->minPrice = price;
+    if (price > raw->maxPrice) raw->maxPrice = price;
+  }
+  raw->offsets[idx] = (float)(price - raw->base);
+}
+
+// Resample raw prices (oldest first) to one point per chart column using linear interpolation
+static void resampleSparkline(const RawSeries& raw, SparklineData* outSparkline) {
+  TRACE_SCOPE("resample");
+  const float* offsets = raw.offsets;
+  int rawCount = raw.count;
+  float minOffset = (float)(raw.minPrice - raw.base);
+  float priceRange = (float)(raw.maxPrice - raw.minPrice);
+  if (priceRange <= 0) priceRange = 1.0f;
+
+  const int points = getSparklinePoints();
+  for (int i = 0; i < points; i++) {
+    float srcPos = (float)i * (rawCount - 1) / (points - 1);
+    int lo = (int)srcPos;
+    int hi = lo + 1;
+    if (hi >= rawCount) hi = rawCount - 1;
+    float frac = srcPos - lo;
+    float offset = offsets[lo] * (1.0f - frac) + offsets[hi] * frac;
+    float normalized = (offset - minOffset) / priceRange;
+    outSparkline->points[i] = (uint8_t)constrain((int)(normalized * 255.0f), 0, 255);
+  }
+
+  outSparkline->len = points;
+  outSparkline->priceMin = raw.minPrice;
+  outSparkline->priceMax = raw.maxPrice;
+  outSparkline->valid = true;
+
+  LOG_EVENT(EV_API_CHART_DATA, nullptr, rawCount, priceToFloat(raw.minPrice), priceToFloat(raw.maxPrice));
 }
 
 void setCoinGeckoApiKey(const char* key) {
-  coinGeckoApiKey = String(key);
-  Serial.printf("[API] CoinGecko API key set: %s\n", key);
+  strlcpy(coinGeckoApiKey, key, sizeof(coinGeckoApiKey));
+  LOG_EVENT(EV_API_CG_KEY_SET, nullptr);
 }
 
 void setCMCApiKey(const char* key) {
-  cmcApiKey = String(key);
-  Serial.printf("[API] CMC API key set\n");
+  strlcpy(cmcApiKey, key, sizeof(cmcApiKey));
+  LOG_EVENT(EV_API_CMC_KEY_SET, nullptr);
+}
+
+FetchArenaStats getFetchArenaStats(ApiProvider provider) {
+  const FetchArena& arena = arenas[provider];
+  return { arena.capacity(), arena.highWater(), arena.failures() };
 }
 
-int fetchCMCPrices(const char* slugs, TickerData* tickerData, int numTickers, const TickerConfig* configs) {
-  if (!slugs || strlen(slugs) == 0 || cmcApiKey.length() == 0) {
-    Serial.println("[API] CMC: no slugs or API key");
+EndpointStats getEndpointStats(ApiEndpoint endpoint) {
+  portENTER_CRITICAL(&statsMux);
+  EndpointStats st = endpointStats[endpoint];
+  portEXIT_CRITICAL(&statsMux);
+  return st;
+}
+
+const char* getEndpointName(ApiEndpoint endpoint) {
+  return endpoint < ENDPOINT_COUNT ? endpointNames[endpoint] : "?";
+}
+
+// Position of id in a comma-separated list, or -1
+static int listPosition(const char* list, const char* id) {
+  size_t idLen = strlen(id);
+  int pos = 0;
+  const char* p = list;
+  while (*p) {
+    const char* end = strchr(p, ',');
+    size_t len = end ? (size_t)(end - p) : strlen(p);
+    if (len == idLen && strncmp(p, id, len) == 0) return pos;
+    if (!end) break;
+    p = end + 1;
+    pos++;
+  }
+  return -1;
+}
+
+int fetchCMCPrices(const char* slugs, PriceQuote* outQuotes, int count, uint32_t timeoutMs) {
+  if (!slugs || strlen(slugs) == 0 || cmcApiKey[0] == '\0') {
+    LOG_EVENT(EV_API_NO_IDS, nullptr, PROVIDER_CMC);
     return 0;
   }
 
-  String url = "https://pro-api.coinmarketcap.com/v2/cryptocurrency/quotes/latest?slug=";
-  url += slugs;
+  char url[FETCH_URL_MAX];
+  snprintf(url, sizeof(url), CMC_BASE_URL "/v2/cryptocurrency/quotes/latest?slug=%s", slugs);
 
-  Serial.printf("[API] CMC fetching: %s\n", slugs);
+  LOG_EVENT(EV_API_CMC_FETCH, slugs);
 
-  http.begin(client, url);
-  http.setTimeout(10000);
+  HTTPClient& http = beginRequest(ENDPOINT_CMC_QUOTES, url, timeoutMs);
   http.addHeader("X-CMC_PRO_API_KEY", cmcApiKey);
   http.addHeader("Accept", "application/json");
-  int httpCode = http.GET();
+  int httpCode = sendRequest(PROVIDER_CMC);
 
   if (httpCode != 200) {
-    Serial.printf("[API] CMC HTTP error: %d\n", httpCode);
+    LOG_EVENT(EV_API_HTTP_ERROR, nullptr, PROVIDER_CMC, httpCode);
     http.end();
     return 0;
   }
 
-  String payload = http.getString();
-  http.end();
-
-  JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, payload);
+  FetchArena* arena = &arenas[PROVIDER_CMC];
+  JsonDocument filter(arena);
+  filter["status"]["error_code"] = true;
+  filter["status"]["error_message"] = true;
+  filter["status"]["credit_count"] = true;
+  JsonObject coinFilter = filter["data"]["*"].to<JsonObject>();
+  coinFilter["slug"] = true;
+  JsonObject usdFilter = coinFilter["quote"]["USD"].to<JsonObject>();
+  usdFilter["price"] = true;
+  usdFilter["percent_change_24h"] = true;
+  usdFilter["percent_change_7d"] = true;
+  usdFilter["percent_change_30d"] = true;
+  usdFilter["percent_change_90d"] = true;
+  usdFilter["last_updated"] = true;
+
+  JsonDocument doc(arena);
+  DeserializationError error = parseResponse(PROVIDER_CMC, doc, filter);
 
   if (error) {
-    Serial.printf("[API] CMC JSON parse error: %s\n", error.c_str());
+    LOG_EVENT(EV_API_PARSE_ERROR, error.c_str(), PROVIDER_CMC);
     return 0;
   }
 
@@ -63,7 +420,7 @@ int fetchCMCPrices(const char* slugs, TickerData* tickerData, int numTickers, co
   int errCode = doc["status"]["error_code"] | -1;
   if (errCode != 0) {
     const char* errMsg = doc["status"]["error_message"] | "unknown";
-    Serial.printf("[API] CMC API error %d: %s\n", errCode, errMsg);
+    LOG_EVENT(EV_API_CMC_ERROR, errMsg, errCode);
     return 0;
   }
 
@@ -76,134 +433,201 @@ int fetchCMCPrices(const char* slugs, TickerData* tickerData, int numTickers, co
     const char* slug = coin["slug"];
     if (!slug) continue;
 
-    // Match slug to our ticker configs
-    for (int i = 0; i < numTickers; i++) {
-      if (configs[i].type == TICKER_CRYPTO && strcmp(configs[i].apiId, slug) == 0) {
-        JsonObject quote = coin["quote"]["USD"];
-        tickerData[i].currentPrice = quote["price"].as<float>();
-        tickerData[i].priceChange24h = quote["percent_change_24h"].as<float>();
-        tickerData[i].priceChange[TIMEFRAME_24H] = quote["percent_change_24h"].as<float>();
-        tickerData[i].priceChange[TIMEFRAME_7D]  = quote["percent_change_7d"].as<float>();
-        tickerData[i].priceChange[TIMEFRAME_30D] = quote["percent_change_30d"].as<float>();
-        tickerData[i].priceChange[TIMEFRAME_90D] = quote["percent_change_90d"].as<float>();
-        tickerData[i].priceValid = true;
-        updated++;
-
-        Serial.printf("[API] CMC %s: $%.2f (24h:%.1f%% 7d:%.1f%% 30d:%.1f%% 90d:%.1f%%)\n",
-                     configs[i].symbol, tickerData[i].currentPrice,
-                     tickerData[i].priceChange[0], tickerData[i].priceChange[1],
-                     tickerData[i].priceChange[2], tickerData[i].priceChange[3]);
-        break;
-      }
-    }
+    // Match slug to its position in the request
+    int i = listPosition(slugs, slug);
+    if (i < 0 || i >= count) continue;
+
+    JsonObject quote = coin["quote"]["USD"];
+    PriceQuote& q = outQuotes[i];
+    if (!readPrice(quote["price"], &q.price)) continue;
+    q.change[TIMEFRAME_24H] = quote["percent_change_24h"].as<float>();
+    q.change[TIMEFRAME_7D]  = quote["percent_change_7d"].as<float>();
+    q.change[TIMEFRAME_30D] = quote["percent_change_30d"].as<float>();
+    q.change[TIMEFRAME_90D] = quote["percent_change_90d"].as<float>();
+    q.changeMask = (1 << TIMEFRAME_COUNT) - 1;
+    q.valid = true;
+    if (!parseIsoTime(quote["last_updated"].as<const char*>(), &q.sourceMs)) q.sourceMs = 0;
+    updated++;
+
+    LOG_EVENT(EV_API_CMC_QUOTE, slug, priceToFloat(q.price),
+              q.change[0], q.change[1], q.change[2], q.change[3]);
   }
 
-  Serial.printf("[API] CMC credits used: %d\n", doc["status"]["credit_count"] | 0);
+  LOG_EVENT(EV_API_CMC_CREDITS, nullptr, doc["status"]["credit_count"] | 0);
   return updated;
 }
 
-int fetchCryptoPrices(const char* ids, TickerData* tickerData, int numTickers, const TickerConfig* configs) {
-  if (!ids || strlen(ids) == 0) {
-    Serial.println("[API] No crypto IDs provided");
-    return 0;
+// Fill a RawSeries with prices[from..] from the arena; false if a point
+// is not a price or the arena is full
+static bool readRawSeries(JsonArrayConst prices, int from, FetchArena* arena, RawSeries* raw) {
+  raw->count = prices.size() - from;
+  raw->offsets = (float*)arena->alloc(raw->count * sizeof(float));
+  if (!raw->offsets) {
+    LOG_EVENT(EV_API_ARENA_EXHAUSTED, nullptr, PROVIDER_COINGECKO);
+    return false;
   }
+  int i = -from;
+  for (JsonVariantConst point : prices) {
+    Price price;
+    if (i >= 0) {
+      if (!readPrice(point, &price)) return false;
+      addRawPrice(raw, i, price, i == 0);
+    }
+    i++;
+  }
+  return true;
+}
 
-  String url = "https://api.coingecko.com/api/v3/coins/markets?vs_currency=usd&ids=";
-  url += ids;
-  url += "&price_change_percentage=24h&sparkline=false";
+// 7D chart from sparkline_in_7d (hourly, oldest first) and the 24H chart
+// from its last 24 hours
+static void readBatchCharts(JsonArrayConst prices, FetchArena* arena, BatchCharts* out) {
+  const int dayPoints = 25;   // 24 hourly steps
+  if ((int)prices.size() < dayPoints) {
+    LOG_EVENT(EV_API_NO_CHART_DATA, nullptr, PROVIDER_COINGECKO, (int)prices.size());
+    return;
+  }
+  RawSeries raw = {};
+  if (readRawSeries(prices, 0, arena, &raw)) resampleSparkline(raw, &out->week);
+  raw = RawSeries();
+  if (readRawSeries(prices, prices.size() - dayPoints, arena, &raw)) resampleSparkline(raw, &out->day);
+}
 
-  if (coinGeckoApiKey.length() > 0) {
-    url += "&x_cg_demo_api_key=";
-    url += coinGeckoApiKey;
+// One /coins/markets entry into its quote; false if it is not a requested id
+static bool readMarketsCoin(JsonObjectConst coin, const char* ids, PriceQuote* outQuotes, int count,
+                            BatchCharts* outCharts, FetchArena* arena) {
+  const char* coinId = coin["id"];
+  if (!coinId) return false;
+
+  int i = listPosition(ids, coinId);
+  if (i < 0 || i >= count) return false;
+
+  PriceQuote& q = outQuotes[i];
+  if (!readPrice(coin["current_price"], &q.price)) return false;
+  q.change[TIMEFRAME_24H] = coin["price_change_percentage_24h"].as<float>();
+  q.changeMask = 1 << TIMEFRAME_24H;
+  // Young coins have no 30d history (null)
+  static const struct { const char* field; ChartTimeframe tf; } longer[] = {
+    { "price_change_percentage_7d_in_currency",  TIMEFRAME_7D },
+    { "price_change_percentage_30d_in_currency", TIMEFRAME_30D },
+  };
+  for (const auto& l : longer) {
+    JsonVariantConst pct = coin[l.field];
+    if (!pct.is<float>()) continue;
+    q.change[l.tf] = pct.as<float>();
+    q.changeMask |= 1 << l.tf;
   }
+  q.valid = true;
+  if (!parseIsoTime(coin["last_updated"].as<const char*>(), &q.sourceMs)) q.sourceMs = 0;
 
-  Serial.printf("[API] Fetching crypto prices: %s\n", ids);
+  if (outCharts) readBatchCharts(coin["sparkline_in_7d"]["price"], arena, &outCharts[i]);
 
-  http.begin(client, url);
-  http.setTimeout(10000);
-  int httpCode = http.GET();
+  LOG_EVENT(EV_API_CG_QUOTE, coinId, priceToFloat(q.price), q.change[TIMEFRAME_24H]);
+  return true;
+}
 
-  if (httpCode != 200) {
-    Serial.printf("[API] HTTP error: %d\n", httpCode);
-    http.end();
+int fetchCryptoPrices(const char* ids, PriceQuote* outQuotes, int count, BatchCharts* outCharts, uint32_t timeoutMs) {
+  if (!ids || strlen(ids) == 0) {
+    LOG_EVENT(EV_API_NO_IDS, nullptr, PROVIDER_COINGECKO);
     return 0;
   }
+  for (int i = 0; outCharts && i < count; i++) {
+    outCharts[i].day.valid = false;
+    outCharts[i].week.valid = false;
+  }
+
+  char url[FETCH_URL_MAX];
+  int len = snprintf(url, sizeof(url),
+                     COINGECKO_BASE_URL "/coins/markets?vs_currency=usd&ids=%s&price_change_percentage=24h,7d,30d&sparkline=%s",
+                     ids, outCharts ? "true" : "false");
+  if (coinGeckoApiKey[0] && len > 0 && len < (int)sizeof(url)) {
+    snprintf(url + len, sizeof(url) - len, "&x_cg_demo_api_key=%s", coinGeckoApiKey);
+  }
 
-  String payload = http.getString();
-  http.end();
+  LOG_EVENT(EV_API_CG_FETCH, ids);
 
-  JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, payload);
+  HTTPClient& http = beginRequest(ENDPOINT_COINGECKO_MARKETS, url, timeoutMs);
+  int httpCode = sendRequest(PROVIDER_COINGECKO);
 
-  if (error) {
-    Serial.printf("[API] JSON parse error: %s\n", error.c_str());
+  if (httpCode != 200) {
+    LOG_EVENT(EV_API_HTTP_ERROR, nullptr, PROVIDER_COINGECKO, httpCode);
+    http.end();
     return 0;
   }
 
+  FetchArena* arena = &arenas[PROVIDER_COINGECKO];
+  JsonDocument filter(arena);
+  filter["id"] = true;
+  filter["current_price"] = true;
+  filter["price_change_percentage_24h"] = true;
+  filter["price_change_percentage_7d_in_currency"] = true;
+  filter["price_change_percentage_30d_in_currency"] = true;
+  filter["last_updated"] = true;
+  if (outCharts) filter["sparkline_in_7d"]["price"] = true;
+
+  // The array is parsed one coin at a time: a full page with 168-point
+  // sparklines is several times the arena, a single coin about 3KB
   int updated = 0;
-  JsonArray array = doc.as<JsonArray>();
-
-  // Match each API result to the corresponding ticker by apiId
-  for (JsonObject coin : array) {
-    const char* coinId = coin["id"];
-
-    for (int i = 0; i < numTickers; i++) {
-      if (configs[i].type == TICKER_CRYPTO && strcmp(configs[i].apiId, coinId) == 0) {
-        tickerData[i].currentPrice = coin["current_price"].as<float>();
-        tickerData[i].priceChange24h = coin["price_change_percentage_24h"].as<float>();
-        tickerData[i].priceValid = true;
-        updated++;
-
-        Serial.printf("[API] Updated %s: $%.2f (%.2f%%)\n",
-                     configs[i].symbol, tickerData[i].currentPrice, tickerData[i].priceChange24h);
-        break;
-      }
+  DeserializationError error = DeserializationError::Ok;
+  {
+    TRACE_SCOPE(parseSpans[PROVIDER_COINGECKO]);
+    Stream& body = responseStream(PROVIDER_COINGECKO);
+    if (!body.find("[")) {
+      error = DeserializationError::InvalidInput;
+    } else if (body.peek() != ']') {
+      do {
+        size_t mark = arena->used();
+        {
+          JsonDocument doc(arena);
+          error = deserializeJson(doc, body, DeserializationOption::Filter(filter));
+          if (error) break;
+          if (readMarketsCoin(doc.as<JsonObjectConst>(), ids, outQuotes, count, outCharts, arena)) updated++;
+        }
+        arena->rewind(mark);
+      } while (body.findUntil(",", "]"));
     }
+    endResponse(PROVIDER_COINGECKO);
   }
 
-  delay(200); // Be nice to the API
+  if (error) {
+    LOG_EVENT(EV_API_PARSE_ERROR, error.c_str(), PROVIDER_COINGECKO);
+  }
   return updated;
 }
 
-bool fetchCryptoChart(const char* coinId, int days, SparklineData* outSparkline) {
+bool fetchCryptoChart(const char* coinId, int days, SparklineData* outSparkline, uint32_t timeoutMs) {
   if (!coinId || !outSparkline) {
     return false;
   }
 
-  String url = "https://api.coingecko.com/api/v3/coins/";
-  url += coinId;
-  url += "/market_chart?vs_currency=usd&days=";
-  url += String(days);
   // Use daily interval for 30d+ to reduce response size (avoids memory issues)
-  if (days >= 14) {
-    url += "&interval=daily";
-  }
-
-  if (coinGeckoApiKey.length() > 0) {
-    url += "&x_cg_demo_api_key=";
-    url += coinGeckoApiKey;
+  char url[FETCH_URL_MAX];
+  int len = snprintf(url, sizeof(url), COINGECKO_BASE_URL "/coins/%s/market_chart?vs_currency=usd&days=%d%s",
+                     coinId, days, days >= 14 ? "&interval=daily" : "");
+  if (coinGeckoApiKey[0] && len > 0 && len < (int)sizeof(url)) {
+    snprintf(url + len, sizeof(url) - len, "&x_cg_demo_api_key=%s", coinGeckoApiKey);
   }
 
-  Serial.printf("[API] Fetching chart for %s (%dd)\n", coinId, days);
+  LOG_EVENT(EV_API_CHART_FETCH, coinId, days);
 
-  http.begin(client, url);
-  http.setTimeout(15000);
-  int httpCode = http.GET();
+  HTTPClient& http = beginRequest(ENDPOINT_COINGECKO_MARKET_CHART, url, timeoutMs);
+  int httpCode = sendRequest(PROVIDER_COINGECKO);
 
   if (httpCode != 200) {
-    Serial.printf("[API] HTTP error: %d\n", httpCode);
+    LOG_EVENT(EV_API_HTTP_ERROR, nullptr, PROVIDER_COINGECKO, httpCode);
     http.end();
     return false;
   }
 
-  String payload = http.getString();
-  http.end();
+  // market_caps and total_volumes are dropped by the filter
+  FetchArena* arena = &arenas[PROVIDER_COINGECKO];
+  JsonDocument filter(arena);
+  filter["prices"] = true;
 
-  JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, payload);
+  JsonDocument doc(arena);
+  DeserializationError error = parseResponse(PROVIDER_COINGECKO, doc, filter);
 
   if (error) {
-    Serial.printf("[API] JSON parse error: %s\n", error.c_str());
+    LOG_EVENT(EV_API_PARSE_ERROR, error.c_str(), PROVIDER_COINGECKO);
     return false;
   }
 
@@ -211,139 +635,109 @@ bool fetchCryptoChart(const char* coinId, int days, SparklineData* outSparkline)
   int rawCount = prices.size();
 
   if (rawCount < 2) {
-    Serial.println("[API] Insufficient data points");
+    LOG_EVENT(EV_API_NO_CHART_DATA, nullptr, PROVIDER_COINGECKO, rawCount);
     return false;
   }
 
-  // Find min and max prices
-  float minPrice = FLT_MAX;
-  float maxPrice = -FLT_MAX;
-
-  for (JsonArray point : prices) {
-    float price = point[1].as<float>();
-    if (price < minPrice) minPrice = price;
-    if (price > maxPrice) maxPrice = price;
+  RawSeries raw = {};
+  raw.count = rawCount;
+  raw.offsets = (float*)arena->alloc(rawCount * sizeof(float));
+  if (!raw.offsets) {
+    LOG_EVENT(EV_API_ARENA_EXHAUSTED, nullptr, PROVIDER_COINGECKO);
+    return false;
   }
 
-  // Collect raw prices into temporary array
-  float* rawPrices = new float[rawCount];
   int idx = 0;
   for (JsonArray point : prices) {
-    rawPrices[idx++] = point[1].as<float>();
-  }
-
-  // Resample to SPARKLINE_POINTS using linear interpolation
-  float priceRange = maxPrice - minPrice;
-  if (priceRange < 0.0001) priceRange = 1.0;
-
-  for (int i = 0; i < SPARKLINE_POINTS; i++) {
-    float srcPos = (float)i * (rawCount - 1) / (SPARKLINE_POINTS - 1);
-    int lo = (int)srcPos;
-    int hi = lo + 1;
-    if (hi >= rawCount) hi = rawCount - 1;
-    float frac = srcPos - lo;
-    float price = rawPrices[lo] * (1.0f - frac) + rawPrices[hi] * frac;
-    float normalized = (price - minPrice) / priceRange;
-    outSparkline->points[i] = (uint8_t)(normalized * 255.0);
+    Price price;
+    if (!readPrice(point[1], &price)) {
+      LOG_EVENT(EV_API_NO_CHART_DATA, nullptr, PROVIDER_COINGECKO, idx);
+      return false;
+    }
+    addRawPrice(&raw, idx, price, idx == 0);
+    idx++;
   }
 
-  delete[] rawPrices;
-
-  outSparkline->len = SPARKLINE_POINTS;
-  outSparkline->priceMin = minPrice;
-  outSparkline->priceMax = maxPrice;
-  outSparkline->valid = true;
-
-  Serial.printf("[API] Chart data: %d points, range $%.2f - $%.2f\n",
-               rawCount, minPrice, maxPrice);
-
-  delay(200); // Be nice to the API
+  resampleSparkline(raw, outSparkline);
   return true;
 }
 
-bool fetchStockPrice(const char* symbol, const char* apiKey, float* outPrice) {
+bool fetchStockPrice(const char* symbol, const char* apiKey, Price* outPrice, uint32_t timeoutMs) {
   if (!symbol || !apiKey || !outPrice) {
     return false;
   }
 
-  String url = "https://api.twelvedata.com/price?symbol=";
-  url += symbol;
-  url += "&apikey=";
-  url += apiKey;
+  char url[FETCH_URL_MAX];
+  snprintf(url, sizeof(url), TWELVEDATA_BASE_URL "/price?symbol=%s&apikey=%s", symbol, apiKey);
 
-  Serial.printf("[API] Fetching stock price: %s\n", symbol);
+  LOG_EVENT(EV_API_STOCK_FETCH, symbol);
 
-  http.begin(client, url);
-  http.setTimeout(10000);
-  int httpCode = http.GET();
+  HTTPClient& http = beginRequest(ENDPOINT_TWELVEDATA_PRICE, url, timeoutMs);
+  int httpCode = sendRequest(PROVIDER_TWELVEDATA);
 
   if (httpCode != 200) {
-    Serial.printf("[API] HTTP error: %d\n", httpCode);
+    LOG_EVENT(EV_API_HTTP_ERROR, nullptr, PROVIDER_TWELVEDATA, httpCode);
     http.end();
     return false;
   }
 
-  String payload = http.getString();
-  http.end();
+  FetchArena* arena = &arenas[PROVIDER_TWELVEDATA];
+  JsonDocument filter(arena);
+  filter["price"] = true;
 
-  JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, payload);
+  JsonDocument doc(arena);
+  DeserializationError error = parseResponse(PROVIDER_TWELVEDATA, doc, filter);
 
   if (error) {
-    Serial.printf("[API] JSON parse error: %s\n", error.c_str());
+    LOG_EVENT(EV_API_PARSE_ERROR, error.c_str(), PROVIDER_TWELVEDATA);
     return false;
   }
 
-  if (!doc["price"].isNull()) {
-    *outPrice = doc["price"].as<float>();
-    Serial.printf("[API] %s price: $%.2f\n", symbol, *outPrice);
-    delay(200);
+  if (readPrice(doc["price"], outPrice)) {
+    LOG_EVENT(EV_API_STOCK_QUOTE, symbol, priceToFloat(*outPrice));
     return true;
   } else {
-    Serial.printf("[API] No price field in response for %s\n", symbol);
+    LOG_EVENT(EV_API_NO_PRICE, symbol);
     return false;
   }
 }
 
-bool fetchStockChart(const char* symbol, const char* apiKey, const char* interval, int outputsize, SparklineData* outSparkline) {
+bool fetchStockChart(const char* symbol, const char* apiKey, const char* interval, int outputsize,
+                     SparklineData* outSparkline, uint32_t timeoutMs) {
   if (!symbol || !apiKey || !interval || !outSparkline) {
     return false;
   }
 
-  String url = "https://api.twelvedata.com/time_series?symbol=";
-  url += symbol;
-  url += "&interval=";
-  url += interval;
-  url += "&outputsize=";
-  url += String(outputsize);
-  url += "&apikey=";
-  url += apiKey;
+  char url[FETCH_URL_MAX];
+  snprintf(url, sizeof(url), TWELVEDATA_BASE_URL "/time_series?symbol=%s&interval=%s&outputsize=%d&apikey=%s",
+           symbol, interval, outputsize, apiKey);
 
-  Serial.printf("[API] Fetching stock chart: %s (%s, %d points)\n", symbol, interval, outputsize);
+  LOG_EVENT(EV_API_STOCK_CHART_FETCH, symbol, outputsize);
 
-  http.begin(client, url);
-  http.setTimeout(15000);
-  int httpCode = http.GET();
+  HTTPClient& http = beginRequest(ENDPOINT_TWELVEDATA_TIME_SERIES, url, timeoutMs);
+  int httpCode = sendRequest(PROVIDER_TWELVEDATA);
 
   if (httpCode != 200) {
-    Serial.printf("[API] HTTP error: %d\n", httpCode);
+    LOG_EVENT(EV_API_HTTP_ERROR, nullptr, PROVIDER_TWELVEDATA, httpCode);
     http.end();
     return false;
   }
 
-  String payload = http.getString();
-  http.end();
+  // Only the close price of each candle is used
+  FetchArena* arena = &arenas[PROVIDER_TWELVEDATA];
+  JsonDocument filter(arena);
+  filter["values"][0]["close"] = true;
 
-  JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, payload);
+  JsonDocument doc(arena);
+  DeserializationError error = parseResponse(PROVIDER_TWELVEDATA, doc, filter);
 
   if (error) {
-    Serial.printf("[API] JSON parse error: %s\n", error.c_str());
+    LOG_EVENT(EV_API_PARSE_ERROR, error.c_str(), PROVIDER_TWELVEDATA);
     return false;
   }
 
   if (doc["values"].isNull()) {
-    Serial.println("[API] No values field in response");
+    LOG_EVENT(EV_API_NO_CHART_DATA, nullptr, PROVIDER_TWELVEDATA, 0);
     return false;
   }
 
@@ -351,47 +745,30 @@ bool fetchStockChart(const char* symbol, const char* apiKey, const char* interva
   int rawCount = values.size();
 
   if (rawCount < 2) {
-    Serial.println("[API] Insufficient data points");
+    LOG_EVENT(EV_API_NO_CHART_DATA, nullptr, PROVIDER_TWELVEDATA, rawCount);
     return false;
   }
 
-  // Parse prices in reverse order (API returns newest first) and find min/max
-  float* rawPrices = new float[rawCount];
-  float minPrice = FLT_MAX;
-  float maxPrice = -FLT_MAX;
-
-  for (int i = 0; i < rawCount; i++) {
-    float price = values[rawCount - 1 - i]["close"].as<float>(); // reverse: oldest first
-    rawPrices[i] = price;
-    if (price < minPrice) minPrice = price;
-    if (price > maxPrice) maxPrice = price;
+  RawSeries raw = {};
+  raw.count = rawCount;
+  raw.offsets = (float*)arena->alloc(rawCount * sizeof(float));
+  if (!raw.offsets) {
+    LOG_EVENT(EV_API_ARENA_EXHAUSTED, nullptr, PROVIDER_TWELVEDATA);
+    return false;
   }
 
-  // Resample to SPARKLINE_POINTS using linear interpolation
-  float priceRange = maxPrice - minPrice;
-  if (priceRange < 0.0001) priceRange = 1.0;
-
-  for (int i = 0; i < SPARKLINE_POINTS; i++) {
-    float srcPos = (float)i * (rawCount - 1) / (SPARKLINE_POINTS - 1);
-    int lo = (int)srcPos;
-    int hi = lo + 1;
-    if (hi >= rawCount) hi = rawCount - 1;
-    float frac = srcPos - lo;
-    float price = rawPrices[lo] * (1.0f - frac) + rawPrices[hi] * frac;
-    float normalized = (price - minPrice) / priceRange;
-    outSparkline->points[i] = (uint8_t)(normalized * 255.0);
+  // API returns newest first: fill from the back so offsets are oldest first
+  int idx = rawCount;
+  for (JsonObject value : values) {
+    Price price;
+    if (!readPrice(value["close"], &price)) {
+      LOG_EVENT(EV_API_NO_CHART_DATA, nullptr, PROVIDER_TWELVEDATA, rawCount - idx);
+      return false;
+    }
+    --idx;
+    addRawPrice(&raw, idx, price, idx == rawCount - 1);
   }
 
-  delete[] rawPrices;
-
-  outSparkline->len = SPARKLINE_POINTS;
-  outSparkline->priceMin = minPrice;
-  outSparkline->priceMax = maxPrice;
-  outSparkline->valid = true;
-
-  Serial.printf("[API] Chart data: %d points, range $%.2f - $%.2f\n",
-               rawCount, minPrice, maxPrice);
-
-  delay(200);
+  resampleSparkline(raw, outSparkline);
   return true;
 }
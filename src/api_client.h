@@ -1,34 +1,108 @@
 #pragma once
 #include <Arduino.h>
 #include "ticker_types.h"
+#include "gzip_inflater.h"
 
-// Initialize HTTP client (call once in setup)
+// Provider hosts. Each host gets its own TLS connection (and its own worker
+// task in the fetch engine), so a slow provider only stalls its own requests.
+enum ApiProvider : uint8_t {
+  PROVIDER_CMC        = 0,
+  PROVIDER_COINGECKO  = 1,
+  PROVIDER_TWELVEDATA = 2,
+  PROVIDER_COUNT      = 3
+};
+
+// Endpoints, for per-endpoint transfer stats
+enum ApiEndpoint : uint8_t {
+  ENDPOINT_CMC_QUOTES              = 0,   // /v2/cryptocurrency/quotes/latest
+  ENDPOINT_COINGECKO_MARKETS       = 1,   // /coins/markets
+  ENDPOINT_COINGECKO_MARKET_CHART  = 2,   // /coins/{id}/market_chart
+  ENDPOINT_TWELVEDATA_PRICE        = 3,   // /price
+  ENDPOINT_TWELVEDATA_TIME_SERIES  = 4,   // /time_series
+  ENDPOINT_COUNT                   = 5
+};
+
+// Response bodies read from one endpoint (HTTP 200 only). wireBytes is what
+// came off the connection, bodyBytes the JSON it carried: the same for an
+// uncompressed body, more when the server gzipped it. The time runs from
+// the start of the request to the end of parsing.
+struct EndpointStats {
+  uint32_t responses;
+  uint32_t gzipped;           // Of responses
+  uint64_t wireBytes;
+  uint64_t bodyBytes;
+  uint64_t totalMs;
+  uint32_t lastWireBytes;
+  uint32_t lastBodyBytes;
+  uint32_t lastMs;
+};
+
+// Price + change% for one ticker, as returned by a batch price call
+// changeMask: bit N set when change[N] was supplied by the provider
+// sourceMs: the provider's own timestamp for the price, UTC ms (0 = none)
+struct PriceQuote {
+  Price price;
+  float change[TIMEFRAME_COUNT];
+  uint8_t changeMask;
+  bool valid;
+  int64_t sourceMs;
+};
+
+// Charts that come with a CoinGecko batch price call, per requested id:
+// the 7D chart from sparkline_in_7d (168 hourly points) and the 24H chart
+// cut from its last 24 hours
+struct BatchCharts {
+  SparklineData day;     // TIMEFRAME_24H
+  SparklineData week;    // TIMEFRAME_7D
+};
+
+// Per-provider fetch arena usage (see fetch_arena.h)
+struct FetchArenaStats {
+  size_t capacity;
+  size_t highWater;
+  uint32_t overflows;
+};
+
+// Initialize HTTP clients (call once in setup)
 void initApiClient();
 
-// Fetch current prices + 24h change for all crypto tickers in one batch call
-// Uses CoinGecko /coins/markets endpoint with sparkline=false
-// ids: comma-separated CoinGecko IDs (e.g. "bitcoin,ethereum,solana")
-// Results are written directly into the tickerData array
+// Arena usage for a provider, for the status API
+FetchArenaStats getFetchArenaStats(ApiProvider provider);
+
+EndpointStats getEndpointStats(ApiEndpoint endpoint);
+
+// Path-like name, e.g. "coingecko/markets"
+const char* getEndpointName(ApiEndpoint endpoint);
+
+// Fetch current prices + 24h/7d/30d change for all crypto tickers in one batch call
+// Uses CoinGecko /coins/markets endpoint; with outCharts, sparkline=true
+// fills the 24H and 7D charts of every coin from the same response
+// ids: comma-separated CoinGecko IDs (e.g. "bitcoin,ethereum,solana"), at
+// most FETCH_BATCH_MAX (the caller splits larger watchlists)
+// Results are written into outQuotes (and outCharts, count entries, valid
+// only where filled) at each id's position in the list
 // Returns number of tickers successfully updated
-int fetchCryptoPrices(const char* ids, TickerData* tickerData, int numTickers, const TickerConfig* configs);
+int fetchCryptoPrices(const char* ids, PriceQuote* outQuotes, int count, BatchCharts* outCharts = nullptr,
+                      uint32_t timeoutMs = 10000);
 
 // Fetch sparkline/chart data for a single crypto ticker
 // Uses CoinGecko /coins/{id}/market_chart?vs_currency=usd&days=N
-// Downsamples the price array to SPARKLINE_POINTS (64) uint8_t values
+// Downsamples the price array to getSparklinePoints() uint8_t values (chart width)
 // Returns true on success
-bool fetchCryptoChart(const char* coinId, int days, SparklineData* outSparkline);
+bool fetchCryptoChart(const char* coinId, int days, SparklineData* outSparkline, uint32_t timeoutMs = 15000);
 
 // Fetch current price for a single stock/forex ticker
 // Uses Twelve Data /price endpoint
 // Returns true on success
-bool fetchStockPrice(const char* symbol, const char* apiKey, float* outPrice);
+bool fetchStockPrice(const char* symbol, const char* apiKey, Price* outPrice, uint32_t timeoutMs = 10000);
 
 // Fetch historical data for a single stock/forex ticker
 // Uses Twelve Data /time_series endpoint
 // interval: "1h" for 24h, "1day" for 7d/30d/90d
 // outputsize: number of data points to fetch
 // Returns true on success
-bool fetchStockChart(const char* symbol, const char* apiKey, const char* interval, int outputsize, SparklineData* outSparkline);
+bool fetchStockChart(const char* symbol, const char* apiKey, const char* interval, int outputsize,
+                     SparklineData* outSparkline, uint32_t timeoutMs = 15000);
 
 // Set optional CoinGecko demo API key (adds x_cg_demo_api_key param)
 void setCoinGeckoApiKey(const char* key);
@@ -36,7 +110,17 @@ void setCoinGeckoApiKey(const char* key);
 // Set CoinMarketCap API key
 void setCMCApiKey(const char* key);
 
+// OTA: the inflater API responses use, restarted with the upload's sink so
+// a gzip image costs no second ~43KB while fetches are paused. nullptr when
+// there is no heap for one, or with *busy set while a fetch that started
+// before the pause still holds it (retry shortly).
+GzipInflater* claimUploadInflater(GzipSink sink, void* ctx, bool* busy);
+
+// Hand the inflater back to the fetches
+void releaseUploadInflater();
+
 // Fetch prices + per-timeframe change% from CoinMarketCap
-// slugs: comma-separated slugs (e.g. "bitcoin,ethereum,solana")
+// slugs: comma-separated slugs (e.g. "bitcoin,ethereum,solana"); results are
+// written into outQuotes at each slug's position in the list
 // Returns number of tickers successfully updated
-int fetchCMCPrices(const char* slugs, TickerData* tickerData, int numTickers, const TickerConfig* configs);
+int fetchCMCPrices(const char* slugs, PriceQuote* outQuotes, int count, uint32_t timeoutMs = 10000);
@@ -0,0 +1,31 @@
+#pragma once
+#include <Arduino.h>
+#include <time.h>
+#include <sys/time.h>
+#include "config.h"
+
+// Scheduling clock for the fetch path (data manager, fetch engine, provider
+// health). Normally millis(); the simulation build (SIM_BUILD) swaps in a
+// virtual clock so days of scheduling can run in seconds.
+//
+// appTime() is the matching wall clock (UTC seconds) for the market
+// calendar: time() on the device, and in the simulation the configured
+// start date advanced by the virtual clock. appWallMs() is the same clock
+// in milliseconds, for comparing against provider timestamps.
+
+#if SIM_BUILD
+uint32_t appMillis();
+time_t appTime();
+int64_t appWallMs();
+#else
+inline uint32_t appMillis() { return millis(); }
+inline time_t appTime() { return time(nullptr); }
+inline int64_t appWallMs() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+#endif
+
+// False until SNTP has set the clock
+inline bool appTimeValid(time_t t) { return t > CLOCK_VALID_AFTER; }
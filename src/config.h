@@ -17,16 +17,55 @@
 #define CLK_PIN 16
 #define LAT_PIN  4
 #define OE_PIN  15
+#define E_PIN   18   // Only used by 64-row (1/32 scan) panels
 
+// One panel module is PANEL_WIDTH x PANEL_HEIGHT (64x32 or 64x64);
+// PANEL_CHAIN modules are daisy-chained left to right.
+//   128x32 = 2 x 64x32, 192x32 = 3 x 64x32, 64x64 = 1 x 64x64, 128x64 = 2 x 64x64
+#ifndef PANEL_WIDTH
 #define PANEL_WIDTH   64
+#endif
+#ifndef PANEL_HEIGHT
 #define PANEL_HEIGHT  32
+#endif
+#ifndef PANEL_CHAIN
+#define PANEL_CHAIN   1
+#endif
+#define DISPLAY_WIDTH   (PANEL_WIDTH * PANEL_CHAIN)
+#define DISPLAY_HEIGHT  PANEL_HEIGHT
+
+// DMA memory the panel may take; a depth whose buffers would exceed this
+// (or leave less than DISPLAY_DMA_RESERVE free for WiFi/TLS) is skipped
+#define DISPLAY_DMA_BUDGET        96000
+#define DISPLAY_DMA_RESERVE       60000
+
+// Display quality controller: probe color depths from MAX down to MIN and
+// keep the deepest one whose refresh rate stays at or above the floor
+#define DISPLAY_MAX_COLOR_DEPTH   8
+#define DISPLAY_MIN_COLOR_DEPTH   3      // Always accepted as a last resort
+#ifndef DISPLAY_MIN_REFRESH_HZ
+#define DISPLAY_MIN_REFRESH_HZ    120    // Flicker floor
+#endif
+#define DISPLAY_GAMMA             2.2f
+#ifndef DISPLAY_DITHER_FPS
+#define DISPLAY_DITHER_FPS        60     // Temporal dither redraw rate, 0 = off
+#endif
 
 // =================== TICKERS ===================
-#define MAX_TICKERS       15
+#ifndef MAX_TICKERS
+#define MAX_TICKERS       100    // Watchlist slots; each costs ~56B per WATCHLIST_SLOTS entry
+#endif
 #define MAX_SYMBOL_LEN    12
 #define MAX_NAME_LEN      20
 #define MAX_API_ID_LEN    32
-#define SPARKLINE_POINTS  64  // Downsampled to display width
+#define SPARKLINE_POINTS  DISPLAY_WIDTH  // Capacity; the layout's chart width is used (see layout.h)
+
+// Large watchlists: the panel shows one page of slots at a time, and only
+// the current and next page need their sparklines in RAM (see sparkline_store.h)
+#define DISPLAY_PAGE_TICKERS      8
+#define SPARKLINE_CACHE_TICKERS   (2 * DISPLAY_PAGE_TICKERS)  // Resident entries without PSRAM
+#define SPARKLINE_PAGE_IN_PER_TICK 4     // Cache files read per fetch-task pass
+#define TICKER_FEED_PAGE          16     // Tickers per /api/v1/tickers.msgpack response
 
 // =================== TIMING ===================
 #define DEFAULT_BASE_TIME_MS      8000   // 8 seconds per timeframe
@@ -37,10 +76,173 @@
 #define SPARKLINE_7D_INTERVAL_MS  1800000 // 30 min
 #define SPARKLINE_30D_INTERVAL_MS 3600000 // 60 min
 #define SPARKLINE_90D_INTERVAL_MS 3600000 // 60 min
+#define FX_REFRESH_INTERVAL_MS    3600000 // 60 min per display currency, taken from the stock rotation
+
+// =================== CONFIG ===================
+// AppConfig is published as immutable snapshots (see config_store.h)
+#define CONFIG_SLOTS              4       // Current + lagging readers + one to fill
+#define WATCHLIST_SLOTS           2       // Current + one to fill (ticker slots are kept out of CONFIG_SLOTS)
+#define CONFIG_BODY_MAX           12288   // POST /api/config and /api/alerts body buffer (100 tickers ~10KB)
+#define CONFIG_RENDER_POLL_MS     250     // Render loop checks for a new config this often
 
 // =================== API ===================
+// Override with -D in platformio.ini to point at a local stand-in server
+// (plain http:// base URLs are fetched without TLS)
+#ifndef COINGECKO_BASE_URL
 #define COINGECKO_BASE_URL    "https://api.coingecko.com/api/v3"
+#endif
+#ifndef TWELVEDATA_BASE_URL
 #define TWELVEDATA_BASE_URL   "https://api.twelvedata.com"
+#endif
+#ifndef CMC_BASE_URL
+#define CMC_BASE_URL          "https://pro-api.coinmarketcap.com"
+#endif
+
+// =================== PROVIDER HEALTH ===================
+#define HEALTH_FAILURE_THRESHOLD  3       // Consecutive failures before the circuit opens
+#define HEALTH_BACKOFF_BASE_MS    15000   // First open period, doubled per re-open
+#define HEALTH_BACKOFF_MAX_MS     900000  // 15 min cap
+
+// =================== FETCH ENGINE ===================
+#define FETCH_MAX_JOBS            4      // Concurrent job slots (one per schedule stream + spare)
+#define FETCH_QUEUE_DEPTH         4      // Pending jobs per provider worker
+#define FETCH_PRICE_TIMEOUT_MS    10000  // Deadline for price requests
+#define FETCH_CHART_TIMEOUT_MS    15000  // Deadline for chart requests
+#define FETCH_PROVIDER_SPACING_MS 200    // Min gap between requests to one host
+#define FETCH_MIN_TLS_HEAP        40000  // Largest free block needed to start a TLS session
+#define FETCH_WORKER_STACK        8192
+#define FETCH_ARENA_SIZE          16384  // Per-provider JSON/scratch arena (90-point chart + filter)
+#define FETCH_URL_MAX             640    // Stack buffer for request URLs
+#define FETCH_READ_CHUNK          512    // Per-provider buffer the response body is read through
+// Provider requests send Accept-Encoding: gzip and inflate the body while it
+// is parsed. The inflater (~43KB) is shared by the provider workers and
+// allocated on first use, once the largest free block is this big.
+#ifndef FETCH_GZIP
+#define FETCH_GZIP                1
+#endif
+#define FETCH_GZIP_MIN_HEAP       (FETCH_MIN_TLS_HEAP + 44000)
+// Batch price calls are split so each URL (base + ids + key) fits FETCH_URL_MAX
+// and each response fits the arena; CoinGecko /coins/markets pages at 100
+#define FETCH_BATCH_MAX           32     // Tickers per batch price request
+#define FETCH_BATCH_IDS_LEN       384    // Comma-separated ids per batch request
+// The fetch task sleeps until its next deadline or a signal (see fetch_events.h);
+// this caps one sleep so time-based state (SNTP sync, market hours) is re-read
+#define FETCH_IDLE_MAX_MS         60000
+
+// =================== LAN RELAY ===================
+#define RELAY_MULTICAST_ADDR      239, 255, 42, 99
+#define RELAY_PORT                4299
+#define RELAY_HEARTBEAT_MS        2000    // Leader announce interval
+#define RELAY_LEADER_TIMEOUT_MS   15000   // Silence before a follower takes over
+#define RELAY_SNAPSHOT_MS         60000   // Full price + sparkline snapshot interval
+#define RELAY_QUEUE_DEPTH         (MAX_TICKERS * 2)  // Received prices waiting for the data manager (a snapshot's fit twice)
+#define RELAY_CHART_PENDING       16      // Received sparklines waiting for the fetch task to store them
+
+// =================== MARKET STREAM ===================
+// Live crypto prices over an exchange WebSocket (see market_stream.h).
+// Build with STREAM_HOST/PORT/TLS overridden to use a local stand-in.
+#ifndef STREAM_HOST
+#define STREAM_HOST               "stream.binance.com"
+#endif
+#ifndef STREAM_PORT
+#define STREAM_PORT               9443
+#endif
+#ifndef STREAM_TLS
+#define STREAM_TLS                1
+#endif
+#define STREAM_PATH               "/stream?streams="  // Combined stream; pairs are appended
+#define STREAM_QUOTE_ASSET        "USDT"  // Pair = ticker symbol + this
+#define STREAM_PAIR_LEN           16
+#define STREAM_PUBLISH_MS         1000    // Max rate of streamed TickerData updates
+#define STREAM_STALE_MS           30000   // No streamed price this long: the slot goes back to REST
+#define STREAM_PING_MS            10000   // Heartbeat
+#define STREAM_IDLE_TIMEOUT_MS    30000   // Nothing received (not even a pong): reconnect
+#define STREAM_READ_TIMEOUT_MS    5000    // Rest of a frame once it started; TLS handshake
+#define STREAM_BACKOFF_BASE_MS    2000    // First reconnect delay, doubled per failure
+#define STREAM_BACKOFF_MAX_MS     120000
+#define STREAM_STABLE_MS          60000   // A connection that lasted this long resets the backoff
+#define STREAM_IDLE_POLL_MS       500     // Worker sleep while off or backing off; longest socket wait while live
+#define STREAM_MSG_MAX            512     // Longest message kept (miniTicker is ~250 bytes)
+#define STREAM_ARENA_SIZE         2048
+#define STREAM_WORKER_STACK       8192
+
+// =================== EVENT LOG ===================
+#define LOG_RING_SIZE             128     // Retained events (power of two)
+#define LOG_MAX_ARGS              5       // 32-bit arguments per event
+#define LOG_TEXT_LEN              24      // Inline string argument (symbol, id list)
+#define LOG_SITE_BURST            16      // Events per call site per window
+#define LOG_SITE_WINDOW_MS        10000
+#ifndef LOG_SERIAL_MIRROR
+#define LOG_SERIAL_MIRROR         0       // 1 = also format + print each event (old behaviour)
+#endif
+
+// =================== TRACING ===================
+// Build with -DTRACE_ENABLED=1 to record task spans for GET /api/trace
+// (Chrome trace-event JSON). When 0 the TRACE_* macros compile to nothing.
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED             0
+#endif
+#define TRACE_RING_SIZE           512     // Events per core (power of two), 20 bytes each
+#define TRACE_MAX_TASKS           16      // Distinct tasks named in an export
+
+// =================== SIMULATION ===================
+// pio run -e sim builds a time-warp simulation of the fetch scheduler
+// instead of the ticker (see simulator.h)
+#ifndef SIM_BUILD
+#define SIM_BUILD                 0
+#endif
+#define SIM_SAMPLE_MS             60000   // Staleness sampling interval (virtual time)
+#define SIM_MAX_DAYS              45      // Virtual clock is 32-bit milliseconds
+#define SIM_START_EPOCH           1767571200  // Mon 2026-01-05 00:00 UTC (market calendar)
+
+// =================== POWER ===================
+// CPU clock and WiFi power save follow the fetch bursts (see power_manager.h).
+// 80MHz is the floor: WiFi and the HUB75 I2S clock need APB at 80MHz.
+#define POWER_CPU_ACTIVE_MHZ      240     // While any fetch is queued or running
+#define POWER_CPU_IDLE_MHZ        80
+#define POWER_QUIET_FETCH_SCALE   6       // Fetch intervals are stretched this much in quiet hours
+#define POWER_HISTORY_HOURS       24
+// Module draw estimates per state (ESP32 + radio, panel supply excluded)
+#define POWER_MA_ACTIVE           150     // 240MHz, radio always on
+#define POWER_MA_IDLE             40      // 80MHz, modem sleep (DTIM)
+#define POWER_MA_QUIET            25      // 80MHz, max modem sleep, panel DMA stopped
+#define NTP_SERVER_1              "pool.ntp.org"
+#define NTP_SERVER_2              "time.nist.gov"
+#define DEFAULT_TIMEZONE          "UTC0"  // POSIX TZ string
+#define CLOCK_VALID_AFTER         1600000000  // time() below this: SNTP has not set the clock
+
+// =================== MARKET CALENDAR ===================
+// Stock/forex fetches follow exchange sessions and candle closes
+// (see market_calendar.h); crypto keeps the plain intervals above.
+#define MARKET_SETTLE_S           90      // Wait after a candle closes before fetching it
+#define SPARKLINE_MIN_GAP_MS      15000   // Min gap between chart fetches (fill rate, candle bursts)
+
+// =================== OTA ===================
+// Resumable firmware / LittleFS uploads (see ota_update.h)
+#define OTA_IDLE_TIMEOUT_MS       600000  // Drop a session after 10 min without a chunk
+#define OTA_REBOOT_DELAY_MS       1000    // Lets the final reply reach the browser
+
+// =================== ALERTS ===================
+// Price alerts preempt the display rotation (see alert_engine.h)
+#define ALERT_MAX_RULES           16
+#define ALERT_HISTORY             16      // Price samples kept per move rule
+#define ALERT_QUEUE_DEPTH         4       // Fired alerts waiting for the display
+#define ALERT_RECENT              8       // Fired alerts listed by /api/alerts
+#define ALERT_COOLDOWN_MS         300000  // Min gap between firings of one rule
+#define ALERT_SHOW_MS             6000    // Alert screen time
+#define ALERT_FLASH_MS            250     // Flash half-period
+
+// =================== DATA AGE ===================
+// Provider timestamp -> panel tracking, the freshness SLO (see data_age.h)
+#define AGE_SLO_MS                60000   // Target age of a displayed price
+#define AGE_STALE_CRYPTO_MS       900000  // Crypto older than this gets the stale marker (3 REST rounds)
+#define AGE_STALE_MARKET_MS       1800000 // Stock/forex older than this while its market is open
+
+// =================== FRAME MIRROR ===================
+// Live copy of the panel for the web UI (see frame_mirror.h)
+#define MIRROR_POLL_MS            100     // Frame check rate while someone watches (caps the mirror at 10 fps)
+#define MIRROR_MAX_VIEWERS        2       // WebSocket clients; more are refused
+#define MIRROR_WORKER_STACK       6144
 
 // =================== WIFI ===================
 #define WIFI_AP_NAME          "CryptoTicker"
@@ -0,0 +1,96 @@
+#include "config_store.h"
+#include "fetch_events.h"
+#include <atomic>
+
+// The current snapshot, plus one per reader lagging a version behind, plus
+// one to fill while those drain
+static AppConfig slots[CONFIG_SLOTS];
+static std::atomic<AppConfig*> current(nullptr);
+static std::atomic<uint32_t> readerVersion[CONFIG_READER_COUNT];
+
+// The current watchlist plus one to fill; snapshots point into these
+static Watchlist watchlists[WATCHLIST_SLOTS];
+static Watchlist* currentList = nullptr;   // Writer only
+
+static void attachWatchlist(AppConfig* cfg, Watchlist* list) {
+  cfg->numTickers = list->numTickers;
+  cfg->tickers = list->tickers;
+}
+
+void initConfigStore(const AppConfig& initial, Watchlist* watchlist) {
+  watchlist->version = 1;
+  currentList = watchlist;
+  slots[0] = initial;
+  attachWatchlist(&slots[0], watchlist);
+  slots[0].version = 1;
+  for (int r = 0; r < CONFIG_READER_COUNT; r++) {
+    readerVersion[r].store(1, std::memory_order_relaxed);
+  }
+  current.store(&slots[0], std::memory_order_release);
+}
+
+const AppConfig* configAcquire(ConfigReader reader) {
+  AppConfig* cfg = current.load(std::memory_order_acquire);
+  // Versions only grow, so a stale value seen by the writer is conservative
+  readerVersion[reader].store(cfg->version, std::memory_order_release);
+  return cfg;
+}
+
+const AppConfig* configCurrent() {
+  return current.load(std::memory_order_acquire);
+}
+
+uint32_t configVersion() {
+  return current.load(std::memory_order_acquire)->version;
+}
+
+// Oldest version any reader may still be using
+static uint32_t oldestHeldVersion(const AppConfig* cur) {
+  uint32_t oldestHeld = cur->version;
+  for (int r = 0; r < CONFIG_READER_COUNT; r++) {
+    uint32_t v = readerVersion[r].load(std::memory_order_acquire);
+    if (v < oldestHeld) oldestHeld = v;
+  }
+  return oldestHeld;
+}
+
+Watchlist* configWatchlistBegin() {
+  AppConfig* cur = current.load(std::memory_order_relaxed);
+  if (!cur) return &watchlists[0];   // Boot: nothing published yet
+
+  // A watchlist is free once no snapshot a reader may hold points at it
+  uint32_t oldestHeld = oldestHeldVersion(cur);
+  for (int w = 0; w < WATCHLIST_SLOTS; w++) {
+    bool held = &watchlists[w] == currentList;
+    for (int i = 0; !held && i < CONFIG_SLOTS; i++) {
+      held = slots[i].tickers == watchlists[w].tickers && slots[i].version >= oldestHeld;
+    }
+    if (!held) return &watchlists[w];
+  }
+  return nullptr;
+}
+
+bool configPublish(const AppConfig& next, Watchlist* watchlist) {
+  AppConfig* cur = current.load(std::memory_order_relaxed);
+  uint32_t oldestHeld = oldestHeldVersion(cur);
+
+  AppConfig* slot = nullptr;
+  for (int i = 0; i < CONFIG_SLOTS; i++) {
+    if (&slots[i] != cur && slots[i].version < oldestHeld) {
+      slot = &slots[i];
+      break;
+    }
+  }
+  if (!slot) return false;
+
+  *slot = next;
+  if (watchlist && watchlist != currentList) {
+    watchlist->version = currentList->version + 1;
+    currentList = watchlist;
+  }
+  attachWatchlist(slot, currentList);
+  slot->version = cur->version + 1;
+  current.store(slot, std::memory_order_release);
+  signalFetchTask(FETCH_EVENT_CONFIG);
+  return true;
+}
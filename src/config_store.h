@@ -0,0 +1,51 @@
+#pragma once
+#include "ticker_types.h"
+
+// Versioned AppConfig snapshots, published RCU-style.
+// A writer fills a complete AppConfig off to the side and publishes it with
+// one atomic pointer store; a published snapshot is never modified again.
+// Each reader task takes the current snapshot at its own safe points and may
+// keep using that pointer until its next acquire, so it never sees a
+// half-applied update and never waits on a lock. A slot is refilled only
+// once every reader has acquired a version newer than the one it held.
+//
+//   Render loop: per screen (it polls configVersion() while holding one)
+//   Fetch task:  per pass
+//   Web server:  per request, on the writer's own task (configCurrent)
+//
+// The ticker slots live in a separate, separately versioned Watchlist that
+// snapshots point at (AppConfig::tickers). Only a watchlist change fills a
+// watchlist slot; a settings change publishes a snapshot sharing the
+// current one.
+
+enum ConfigReader : uint8_t {
+  CONFIG_READER_RENDER = 0,
+  CONFIG_READER_FETCH,
+  CONFIG_READER_COUNT
+};
+
+// Publish the boot config and watchlist (from configWatchlistBegin()) as
+// version 1; every reader starts out holding it
+void initConfigStore(const AppConfig& initial, Watchlist* watchlist);
+
+// Free watchlist slot to fill for the next configPublish(), or nullptr while
+// a lagging reader still holds a snapshot using it (retry shortly).
+// Writer only.
+Watchlist* configWatchlistBegin();
+
+// Current snapshot for a reader task, valid until that reader acquires again
+const AppConfig* configAcquire(ConfigReader reader);
+
+// Current snapshot for the writer's task (web handlers); valid until that
+// task publishes
+const AppConfig* configCurrent();
+
+// Version of the current snapshot
+uint32_t configVersion();
+
+// Copy next into a free slot, stamp its version and make it current. A
+// watchlist filled after configWatchlistBegin() replaces the ticker slots;
+// nullptr keeps the current ones. False when a lagging reader still holds
+// every spare slot (retry shortly).
+// Single writer: call from the web server task only (and setup).
+bool configPublish(const AppConfig& next, Watchlist* watchlist = nullptr);
@@ -0,0 +1,159 @@
+#include "data_age.h"
+#include "config.h"
+#include "app_clock.h"
+#include "market_calendar.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+// Histogram bucket upper bounds; the last bucket takes everything above
+static const uint32_t bucketMs[] = {
+  100, 250, 500, 1000, 2000, 5000, 10000, 30000, 60000,
+  120000, 300000, 600000, 1800000, 3600000, 21600000, 0xFFFFFFFF
+};
+static const int BUCKETS = sizeof(bucketMs) / sizeof(bucketMs[0]);
+
+struct Histogram {
+  uint32_t counts[BUCKETS];
+  uint32_t total;
+  uint32_t maxMs;
+};
+
+// Fetch task publishes, render loop marks frames, web server reads
+static SemaphoreHandle_t ageMutex = nullptr;
+static TickerAge ages[MAX_TICKERS];
+static Histogram histograms[AGE_STAGE_COUNT];
+static uint32_t withinSlo = 0;
+static uint32_t staleFrames = 0;
+
+static const char* stageNames[AGE_STAGE_COUNT] = {
+  "sourceToFetch", "fetchToPublish", "publishToPixels", "displayed"
+};
+
+static bool lock() {
+  return ageMutex && xSemaphoreTake(ageMutex, portMAX_DELAY) == pdTRUE;
+}
+
+static void unlock() {
+  xSemaphoreGive(ageMutex);
+}
+
+static void record(AgeStage stage, uint32_t ms) {
+  Histogram& h = histograms[stage];
+  int b = 0;
+  while (ms > bucketMs[b]) b++;
+  h.counts[b]++;
+  h.total++;
+  if (ms > h.maxMs) h.maxMs = ms;
+}
+
+static uint32_t percentile(const Histogram& h, uint32_t permille) {
+  if (h.total == 0) return 0;
+  uint32_t want = ((uint64_t)h.total * permille + 999) / 1000;
+  uint32_t seen = 0;
+  for (int b = 0; b < BUCKETS; b++) {
+    seen += h.counts[b];
+    if (seen >= want) return min(bucketMs[b], h.maxMs);
+  }
+  return h.maxMs;
+}
+
+// Caller holds the lock
+static uint32_t ageLocked(const TickerAge& a, uint32_t now) {
+  if (a.fetchedAt == 0) return 0;
+  uint32_t age = now - a.fetchedAt;
+  if (a.stageMs[AGE_SOURCE_TO_FETCH] > 0) age += a.stageMs[AGE_SOURCE_TO_FETCH];
+  return age;
+}
+
+void resetDataAge() {
+  if (!ageMutex) ageMutex = xSemaphoreCreateMutex();
+  if (!lock()) return;
+  memset(ages, 0, sizeof(ages));
+  unlock();
+}
+
+void agePublished(int idx, int64_t sourceMs, uint32_t fetchedAt) {
+  if (idx < 0 || idx >= MAX_TICKERS || !lock()) return;
+  uint32_t now = appMillis();
+  TickerAge& a = ages[idx];
+  a.sourceMs = sourceMs;
+  a.fetchedAt = fetchedAt;
+  a.publishedAt = now;
+  a.shownAt = 0;
+
+  // Wall time of the fetch, backed out from the monotonic clock
+  a.stageMs[AGE_SOURCE_TO_FETCH] = -1;
+  if (sourceMs > 0 && appTimeValid(appTime())) {
+    int64_t fetchWallMs = appWallMs() - (int64_t)(now - fetchedAt);
+    int64_t lag = fetchWallMs - sourceMs;
+    a.stageMs[AGE_SOURCE_TO_FETCH] = lag < 0 ? 0 : (int32_t)min(lag, (int64_t)INT32_MAX);
+    record(AGE_SOURCE_TO_FETCH, a.stageMs[AGE_SOURCE_TO_FETCH]);
+  }
+  a.stageMs[AGE_FETCH_TO_PUBLISH] = now - fetchedAt;
+  a.stageMs[AGE_PUBLISH_TO_PIXELS] = -1;
+  record(AGE_FETCH_TO_PUBLISH, a.stageMs[AGE_FETCH_TO_PUBLISH]);
+  unlock();
+}
+
+bool ageRendered(int idx, TickerType type) {
+  if (idx < 0 || idx >= MAX_TICKERS || !lock()) return false;
+  uint32_t now = appMillis();
+  TickerAge& a = ages[idx];
+  if (a.fetchedAt == 0) {
+    unlock();
+    return false;
+  }
+  if (a.shownAt == 0) {
+    a.shownAt = now;
+    a.stageMs[AGE_PUBLISH_TO_PIXELS] = now - a.publishedAt;
+    record(AGE_PUBLISH_TO_PIXELS, a.stageMs[AGE_PUBLISH_TO_PIXELS]);
+  }
+
+  uint32_t age = ageLocked(a, now);
+  record(AGE_DISPLAYED, age);
+  if (age <= AGE_SLO_MS) withinSlo++;
+
+  bool stale = type == TICKER_CRYPTO
+      ? age > AGE_STALE_CRYPTO_MS
+      : age > AGE_STALE_MARKET_MS && isMarketOpen(type, appTime());
+  if (stale) staleFrames++;
+  unlock();
+  return stale;
+}
+
+uint32_t priceAgeMs(int idx) {
+  if (idx < 0 || idx >= MAX_TICKERS || !lock()) return 0;
+  uint32_t age = ageLocked(ages[idx], appMillis());
+  unlock();
+  return age;
+}
+
+TickerAge getTickerAge(int idx) {
+  TickerAge a = {};
+  if (idx < 0 || idx >= MAX_TICKERS || !lock()) return a;
+  a = ages[idx];
+  unlock();
+  return a;
+}
+
+DataAgeStats getDataAgeStats() {
+  DataAgeStats s = {};
+  if (!lock()) return s;
+  for (int i = 0; i < AGE_STAGE_COUNT; i++) {
+    const Histogram& h = histograms[i];
+    AgePercentiles& p = s.stages[i];
+    p.count = h.total;
+    p.p50Ms = percentile(h, 500);
+    p.p90Ms = percentile(h, 900);
+    p.p99Ms = percentile(h, 990);
+    p.maxMs = h.maxMs;
+  }
+  s.withinSlo = withinSlo;
+  s.staleFrames = staleFrames;
+  unlock();
+  return s;
+}
+
+const char* getAgeStageName(AgeStage stage) {
+  return stage < AGE_STAGE_COUNT ? stageNames[stage] : "?";
+}
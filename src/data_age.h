@@ -0,0 +1,72 @@
+#pragma once
+#include <Arduino.h>
+#include "ticker_types.h"
+
+// End-to-end age of every displayed price: the freshness SLO.
+// Each published price is tracked through three stages:
+//   source -> fetch:   provider timestamp (CMC / CoinGecko last_updated,
+//                      exchange event time) to fetch completion. Unknown
+//                      for Twelve Data /price (no timestamp), relayed
+//                      prices and before SNTP has set the clock.
+//   fetch -> publish:  fetch completion to the TickerData write
+//   publish -> pixels: TickerData write to the first frame showing it
+// Every stage, and the age of the price in every rendered ticker frame,
+// feeds a fixed-bucket histogram; percentiles are read back from those
+// (so they are bucket upper bounds, not exact values).
+
+enum AgeStage : uint8_t {
+  AGE_SOURCE_TO_FETCH   = 0,
+  AGE_FETCH_TO_PUBLISH  = 1,
+  AGE_PUBLISH_TO_PIXELS = 2,
+  AGE_DISPLAYED         = 3,   // Price age when a frame was rendered
+  AGE_STAGE_COUNT
+};
+
+// One slot's current price
+struct TickerAge {
+  int64_t sourceMs;                   // Provider timestamp, UTC ms (0 = unknown)
+  uint32_t fetchedAt;                 // appMillis() at fetch completion (0 = no price yet)
+  uint32_t publishedAt;
+  uint32_t shownAt;                   // 0 until a frame showed it
+  int32_t stageMs[AGE_DISPLAYED];     // Per stage; -1 = unknown / not yet
+};
+
+struct AgePercentiles {
+  uint32_t count;
+  uint32_t p50Ms;
+  uint32_t p90Ms;
+  uint32_t p99Ms;
+  uint32_t maxMs;
+};
+
+struct DataAgeStats {
+  AgePercentiles stages[AGE_STAGE_COUNT];
+  uint32_t withinSlo;     // Rendered frames whose price was <= AGE_SLO_MS old
+  uint32_t staleFrames;   // Rendered frames past the stale threshold
+};
+
+// Forget all slots (first call in setup, then on watchlist changes); the
+// histograms keep running
+void resetDataAge();
+
+// A new price was written to TickerData slot idx (fetch task).
+// fetchedAt is when its fetch completed (or its relay/stream message
+// arrived), sourceMs the provider timestamp (0 = none).
+void agePublished(int idx, int64_t sourceMs, uint32_t fetchedAt);
+
+// Render loop: slot idx's price is about to be drawn. Records the frame
+// and returns true when the price is stale: older than AGE_STALE_CRYPTO_MS
+// for crypto, or AGE_STALE_MARKET_MS for stock/forex while its market is
+// open (closed markets legitimately show the last close).
+bool ageRendered(int idx, TickerType type);
+
+// Age of slot idx's price now: from the source timestamp if known, else
+// from the fetch. 0 if there is no price.
+uint32_t priceAgeMs(int idx);
+
+TickerAge getTickerAge(int idx);
+
+DataAgeStats getDataAgeStats();
+
+// "sourceToFetch", "fetchToPublish", "publishToPixels", "displayed"
+const char* getAgeStageName(AgeStage stage);
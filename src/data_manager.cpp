@@ -1,283 +1,759 @@
 #include "data_manager.h"
 #include "config.h"
 #include "api_client.h"
+#include "fetch_engine.h"
+#include "provider_health.h"
+#include "lan_relay.h"
+#include "event_log.h"
+#include "app_clock.h"
+#include "trace.h"
+#include "power_manager.h"
+#include "market_calendar.h"
+#include "ota_update.h"
+#include "sparkline_store.h"
+#include "alert_engine.h"
+#include "market_stream.h"
+#include "data_age.h"
+#include "fetch_events.h"
+#include "fx_rates.h"
 #include <Arduino.h>
-#include <LittleFS.h>
 
-static AppConfig* appConfig = nullptr;
+static const AppConfig* appConfig = nullptr;
 static TickerData* tickers = nullptr;
 
 // Timing tracking
 static unsigned long lastCryptoFetch = 0;
 static unsigned long lastStockFetch = 0;
-static unsigned long lastSparklineFetch = 0;
+static unsigned long lastSparklineFetch = 0;   // Last interval-driven chart fetch
+static unsigned long lastChartScan = 0;
+static unsigned long lastStreamPublish = 0;
+static unsigned long chartRetryMs = 0;         // Wait after lastChartScan before the next scan
+static unsigned long lastScale = 1;
+
+// Enabled slots per schedule stream, and enabled chart slots still empty
+// (kept up to date by applySparkline instead of rescanning every pass)
+static int numCryptoTickers = 0;
+static int numMarketTickers = 0;
+static int missingCharts = 0;
+
+// Display currencies whose USD rate is fetched (no forex slot quotes them),
+// as a Currency bitmask; one fetch takes one stock turn, or is an extra
+// Twelve Data call when there are no stock/forex slots (see fxDue)
+#define FX_JOB_SLOT 0xFF   // tickerIndex of a rate fetch
+static uint8_t fxFetchMask = 0;
+static unsigned long lastFxFetch[CURRENCY_COUNT];
 
 // Round-robin indices
+static int cryptoCursor = 0;   // Next slot for the crypto batch round (0 = round done)
 static int currentStockIndex = 0;
 static int currentSparklineTickerIndex = 0;
 static int currentSparklineTimeframe = 0; // 0=24h, 1=7d, 2=30d, 3=90d
 
-// Cache sparkline to LittleFS: /cache/<apiId>_<tf>.bin
-static String cachePath(const char* apiId, int tf) {
-  String path = "/cache/";
-  path += apiId;
-  path += "_";
-  path += String(tf);
-  path += ".bin";
-  return path;
+// Wall-clock time of the last successful stock/forex fetch (0 = unknown),
+// checked against the market calendar
+static time_t lastPriceAt[MAX_TICKERS];
+static time_t lastChartAt[MAX_TICKERS][TIMEFRAME_COUNT];
+static bool marketWasOpen[TICKER_FOREX + 1];
+
+// In-flight job per schedule stream (nullptr when idle)
+static FetchJob* cryptoJob = nullptr;
+static FetchJob* stockJob = nullptr;
+static FetchJob* sparklineJob = nullptr;
+
+// CoinGecko price rounds bring the 24H/7D charts along (allocated on the
+// first such round; one crypto job is in flight at a time)
+static BatchCharts* cryptoCharts = nullptr;
+static unsigned long batchChartAt[MAX_TICKERS];   // appMillis() of the slot's last batch chart (0 = none)
+
+// Change% timeframes the slot's latest quote supplied; the others come from
+// its charts
+static uint8_t quoteChangeMask[MAX_TICKERS];
+
+// Compute change% across a sparkline (first vs last point)
+static bool sparklineChange(const SparklineData* sp, float* outPct) {
+  if (!sp->valid || sp->len < 2 || sp->priceMax <= sp->priceMin || sp->priceMin <= 0) return false;
+  float range = priceToFloat(sp->priceMax - sp->priceMin);
+  float startPrice = priceToFloat(sp->priceMin) + (sp->points[0] / 255.0f) * range;
+  float endPrice = priceToFloat(sp->priceMin) + (sp->points[sp->len - 1] / 255.0f) * range;
+  *outPct = ((endPrice - startPrice) / startPrice) * 100.0f;
+  return true;
 }
 
-static void saveSparklineCache(const char* apiId, int tf, const SparklineData* sp) {
-  String path = cachePath(apiId, tf);
-  File f = LittleFS.open(path, "w");
-  if (!f) return;
-  f.write((uint8_t*)sp, sizeof(SparklineData));
-  f.close();
+// No price provider reports a 24h high/low; the 24H chart's extremes stand in
+static void applyRange(int idx, int tf, const SparklineData* sparkline) {
+  if (tf != TIMEFRAME_24H || !sparkline->valid) return;
+  tickers[idx].high24h = sparkline->priceMax;
+  tickers[idx].low24h = sparkline->priceMin;
 }
 
-static bool loadSparklineCache(const char* apiId, int tf, SparklineData* sp) {
-  String path = cachePath(apiId, tf);
-  File f = LittleFS.open(path, "r");
-  if (!f) return false;
-  if (f.size() != sizeof(SparklineData)) { f.close(); return false; }
-  f.read((uint8_t*)sp, sizeof(SparklineData));
-  f.close();
-  return sp->valid;
+// Enabled slots x timeframes without a valid sparkline
+static int countMissingCharts() {
+  int missing = 0;
+  for (int i = 0; i < appConfig->numTickers; i++) {
+    if (!appConfig->tickers[i].enabled) continue;
+    for (int tf = 0; tf < TIMEFRAME_COUNT; tf++) {
+      if (!sparklineValid(i, tf)) missing++;
+    }
+  }
+  return missing;
 }
 
-void initDataManager(AppConfig* config, TickerData* tickerData) {
+void initDataManager(const AppConfig* config, TickerData* tickerData) {
+  // Results of requests built from the previous config are discarded
+  cancelAllFetches();
+  cryptoJob = nullptr;
+  stockJob = nullptr;
+  sparklineJob = nullptr;
+
   appConfig = config;
   tickers = tickerData;
+  memset(lastPriceAt, 0, sizeof(lastPriceAt));
+  memset(lastChartAt, 0, sizeof(lastChartAt));
+  memset(batchChartAt, 0, sizeof(batchChartAt));
+  memset(quoteChangeMask, 0, sizeof(quoteChangeMask));
 
-  // Ensure cache directory exists
-  LittleFS.mkdir("/cache");
+  // Rejoin the relay group with the (possibly changed) watchlist
+  initLanRelay(config);
+
+  // Exchange stream for the crypto slots (REST covers the rest)
+  initMarketStream(config);
+
+  // Slots may have moved; their price ages start over
+  resetDataAge();
+
+  // Sparkline cache files follow the new watchlist
+  resetSparklineStore(config);
 
   // Copy symbol and type from config into ticker data
   for (int i = 0; i < config->numTickers; i++) {
     strlcpy(tickerData[i].symbol, config->tickers[i].symbol, MAX_SYMBOL_LEN);
     tickerData[i].type = config->tickers[i].type;
 
-    // Load cached sparklines
-    for (int tf = 0; tf < 4; tf++) {
-      if (loadSparklineCache(config->tickers[i].apiId, tf, &tickerData[i].sparklines[tf])) {
-        Serial.printf("[DataMgr] Loaded cached sparkline: %s tf=%d\n", config->tickers[i].symbol, tf);
+    // Find cached sparklines (only the display window stays resident)
+    for (int tf = 0; tf < TIMEFRAME_COUNT; tf++) {
+      SparklineData sparkline;
+      if (scanSparkline(i, tf, &sparkline, &lastChartAt[i][tf])) {
+        LOG_EVENT(EV_DM_CACHE_LOADED, config->tickers[i].symbol, tf);
+        applyRange(i, tf, &sparkline);
 
         // Compute change% from cached sparkline for stocks/forex
-        SparklineData* sp = &tickerData[i].sparklines[tf];
-        if (config->tickers[i].type != TICKER_CRYPTO && sp->valid && sp->len > 1) {
-          float range = sp->priceMax - sp->priceMin;
-          if (range > 0.0001f) {
-            float startPrice = sp->priceMin + (sp->points[0] / 255.0f) * range;
-            float endPrice = sp->priceMin + (sp->points[sp->len - 1] / 255.0f) * range;
-            if (startPrice > 0.0001f) {
-              tickerData[i].priceChange[tf] = ((endPrice - startPrice) / startPrice) * 100.0f;
-              if (tf == 0) tickerData[i].priceChange24h = tickerData[i].priceChange[tf];
-            }
-          }
+        float pct;
+        if (config->tickers[i].type != TICKER_CRYPTO && sparklineChange(&sparkline, &pct)) {
+          tickerData[i].priceChange[tf] = pct;
+          if (tf == 0) tickerData[i].priceChange24h = pct;
         }
       }
     }
   }
 
+  numCryptoTickers = 0;
+  numMarketTickers = 0;
+  for (int i = 0; i < config->numTickers; i++) {
+    if (!config->tickers[i].enabled) continue;
+    if (config->tickers[i].type == TICKER_CRYPTO) numCryptoTickers++;
+    else numMarketTickers++;
+  }
+  missingCharts = countMissingCharts();
+
+  // Rates stay cached across config changes; only the set to fetch moves
+  uint8_t fxNeeded = 0;
+  uint8_t fxQuoted = 0;
+  for (int i = 0; i < config->numTickers; i++) {
+    if (!config->tickers[i].enabled) continue;
+    fxNeeded |= 1 << getTickerCurrency(config, i);
+    if (config->tickers[i].type == TICKER_FOREX) fxQuoted |= 1 << fxPairCurrency(config->tickers[i].apiId);
+  }
+  fxFetchMask = fxNeeded & ~fxQuoted & ~(1 << CURRENCY_USD);
+
   lastCryptoFetch = 0;
   lastStockFetch = 0;
   lastSparklineFetch = 0;
+  lastChartScan = 0;
+  chartRetryMs = 0;
 
+  cryptoCursor = 0;
   currentStockIndex = 0;
   currentSparklineTickerIndex = 0;
   currentSparklineTimeframe = 0;
 
-  Serial.println("[DataMgr] Initialized");
+  LOG_EVENT(EV_DM_INIT, nullptr);
 }
 
 void forceRefresh() {
   lastCryptoFetch = 0;
   lastStockFetch = 0;
   lastSparklineFetch = 0;
-  Serial.println("[DataMgr] Forced refresh scheduled");
+  lastChartScan = 0;
+  cryptoCursor = 0;
+  memset(lastPriceAt, 0, sizeof(lastPriceAt));
+  memset(lastChartAt, 0, sizeof(lastChartAt));
+  LOG_EVENT(EV_DM_FORCE_REFRESH, nullptr);
 }
 
-void updateData() {
-  if (!appConfig || !tickers) {
-    return;
+void refreshPrices() {
+  lastCryptoFetch = 0;
+  lastStockFetch = 0;
+  cryptoCursor = 0;
+}
+
+// A price was written to slot idx: track its age and stamp lastPriceUpdate
+// (UTC seconds of the provider timestamp, else of the fetch; 0 before SNTP)
+static void notePrice(int idx, int64_t sourceMs, uint32_t fetchedAt) {
+  agePublished(idx, sourceMs, fetchedAt);
+  if (tickers[idx].type == TICKER_FOREX) {
+    // A USD pair in the watchlist is the rate of its display currency
+    setFxQuote(appConfig->tickers[idx].apiId, tickers[idx].currentPrice, FX_WATCHLIST);
+  }
+  time_t wall = appTime();
+  if (sourceMs > 0) {
+    tickers[idx].lastPriceUpdate = (uint32_t)(sourceMs / 1000);
+  } else {
+    tickers[idx].lastPriceUpdate = appTimeValid(wall) ? (uint32_t)(wall - (appMillis() - fetchedAt) / 1000) : 0;
+  }
+}
+
+static void applyQuote(int idx, const PriceQuote& q, uint32_t fetchedAt) {
+  tickers[idx].currentPrice = q.price;
+  for (int tf = 0; tf < TIMEFRAME_COUNT; tf++) {
+    if (q.changeMask & (1 << tf)) tickers[idx].priceChange[tf] = q.change[tf];
   }
+  if (q.changeMask & (1 << TIMEFRAME_24H)) tickers[idx].priceChange24h = q.change[TIMEFRAME_24H];
+  quoteChangeMask[idx] = q.changeMask;
+  tickers[idx].priceValid = true;
+  notePrice(idx, q.sourceMs, fetchedAt);
+}
 
-  unsigned long now = millis();
+static void applyPriceQuotes(const FetchJob* job) {
+  uint8_t changed[FETCH_BATCH_MAX];
+  int count = 0;
+  for (int n = 0; n < job->numTickers && n < FETCH_BATCH_MAX; n++) {
+    int idx = job->batchTickers[n];
+    if (!job->quotes[n].valid || idx >= appConfig->numTickers) continue;
+    applyQuote(idx, job->quotes[n], job->finishedAt);
+    changed[count++] = idx;
+  }
+  relayPublishPrices(tickers, changed, count);
+  evaluateAlerts(appConfig, tickers, changed, count, job->finishedAt);
+}
 
-  // 1. Fetch crypto prices (CMC preferred, CoinGecko fallback)
-  if (now - lastCryptoFetch >= CRYPTO_FETCH_INTERVAL_MS || lastCryptoFetch == 0) {
-    // Build comma-separated list of slugs/IDs
-    String cryptoSlugs = "";
-    int cryptoCount = 0;
-
-    for (int i = 0; i < appConfig->numTickers; i++) {
-      if (appConfig->tickers[i].enabled && appConfig->tickers[i].type == TICKER_CRYPTO) {
-        if (cryptoCount > 0) {
-          cryptoSlugs += ",";
+// Ticker state that follows a sparkline now in the store: 24h range, and
+// change% where the price source has none
+static void noteSparkline(int idx, int tf, const SparklineData* fresh) {
+  const TickerConfig* config = &appConfig->tickers[idx];
+  applyRange(idx, tf, fresh);
+
+  // Compute change% from sparkline data where the price source has none:
+  // stocks/forex, CoinGecko's 90d, and a streamed coin's 7d+ (it skips the
+  // REST rounds). The providers' own figures are more accurate.
+  bool chartChange = !(quoteChangeMask[idx] & (1 << tf));
+  float pct;
+  if (chartChange && sparklineChange(fresh, &pct)) {
+    tickers[idx].priceChange[tf] = pct;
+    if (tf == TIMEFRAME_24H) {
+      tickers[idx].priceChange24h = pct;
+    }
+    LOG_EVENT(EV_DM_CHANGE, config->symbol, getTimeframeDays((ChartTimeframe)tf), pct);
+  }
+
+  LOG_EVENT(EV_DM_SPARKLINE_UPDATED, config->symbol, getTimeframeDays((ChartTimeframe)tf));
+}
+
+// Store a new sparkline; returns false if it is identical to the current one
+static bool applySparkline(int idx, int tf, const SparklineData* fresh) {
+  SparklineData current;
+
+  // Identical charts are common (closed markets); skip the flash write
+  readSparkline(idx, tf, &current);
+  if (memcmp(&current, fresh, sizeof(SparklineData)) == 0) return false;
+
+  bool wasValid = sparklineValid(idx, tf);
+  writeSparkline(idx, tf, fresh);
+  if (appConfig->tickers[idx].enabled && wasValid != fresh->valid) missingCharts += fresh->valid ? -1 : 1;
+  noteSparkline(idx, tf, fresh);
+  return true;
+}
+
+// Charts that came with a CoinGecko price round
+static void applyBatchCharts(const FetchJob* job) {
+  for (int n = 0; n < job->numTickers && n < FETCH_BATCH_MAX; n++) {
+    int idx = job->batchTickers[n];
+    if (idx >= appConfig->numTickers) continue;
+    const SparklineData* charts[] = { &job->charts[n].day, &job->charts[n].week };
+    for (int tf = TIMEFRAME_24H; tf <= TIMEFRAME_7D; tf++) {
+      if (!charts[tf]->valid) continue;
+      batchChartAt[idx] = job->finishedAt;
+      lastChartAt[idx][tf] = appTime();
+      if (applySparkline(idx, tf, charts[tf])) relayPublishSparkline(idx, tf, charts[tf]);
+    }
+  }
+}
+
+// Streamed prices, coalesced: one entry per slot that changed since the
+// last call
+static void applyStreamQuotes() {
+  static StreamQuote quotes[FETCH_BATCH_MAX];
+  uint8_t changed[FETCH_BATCH_MAX];
+  int polled;
+  do {
+    polled = streamPoll(quotes, FETCH_BATCH_MAX);
+    int count = 0;
+    uint32_t oldest = 0;
+    for (int n = 0; n < polled; n++) {
+      int idx = quotes[n].tickerIndex;
+      if (idx >= appConfig->numTickers) continue;
+      applyQuote(idx, quotes[n].quote, quotes[n].receivedAt);
+      if (count == 0 || (int32_t)(quotes[n].receivedAt - oldest) < 0) oldest = quotes[n].receivedAt;
+      changed[count++] = idx;
+    }
+    if (count == 0) continue;
+    relayPublishPrices(tickers, changed, count);
+    evaluateAlerts(appConfig, tickers, changed, count, oldest);
+  } while (polled == FETCH_BATCH_MAX);
+}
+
+// Follower: apply prices and sparklines received from the relay leader
+static void applyRelayUpdate(const RelayUpdate& u) {
+  if (u.tickerIndex >= appConfig->numTickers) return;
+  if (u.kind == RELAY_UPDATE_PRICE) {
+    if (u.quote.valid) {
+      applyQuote(u.tickerIndex, u.quote, appMillis());
+      evaluateAlerts(appConfig, tickers, &u.tickerIndex, 1, appMillis());
+    }
+  } else if (u.kind == RELAY_UPDATE_SPARKLINE && u.timeframe < TIMEFRAME_COUNT) {
+    // The relay has stored it already
+    SparklineData stored;
+    readSparkline(u.tickerIndex, u.timeframe, &stored);
+    noteSparkline(u.tickerIndex, u.timeframe, &stored);
+  }
+}
+
+// Apply a finished fetch job to the ticker data (runs on the fetch task)
+static void handleCompletion(FetchJob* job) {
+  if (job == cryptoJob) cryptoJob = nullptr;
+  if (job == stockJob) stockJob = nullptr;
+  if (job == sparklineJob) sparklineJob = nullptr;
+
+  bool ok = job->outcome == FETCH_OK;
+  if (job->outcome == FETCH_CANCELLED || job->outcome == FETCH_REJECTED) {
+    // Nothing was fetched; the stream is retried on its next interval
+    releaseFetchJob(job);
+    return;
+  }
+
+  switch (job->kind) {
+    case FETCH_CMC_PRICES:
+    case FETCH_COINGECKO_PRICES:
+      if (ok) applyPriceQuotes(job);
+      if (ok && job->charts) applyBatchCharts(job);
+      LOG_EVENT(EV_DM_CRYPTO_UPDATED, nullptr, ok ? job->updated : 0, job->finishedAt - job->startedAt);
+      break;
+
+    case FETCH_STOCK_PRICE:
+      if (job->tickerIndex == FX_JOB_SLOT) {
+        if (ok) {
+          setFxQuote(job->ids, job->price, FX_FETCHED);
+          LOG_EVENT(EV_DM_FX_UPDATED, job->ids, priceToDouble(job->price));
+        } else {
+          LOG_EVENT(EV_DM_STOCK_FAILED, job->ids);
         }
-        cryptoSlugs += appConfig->tickers[i].apiId;
-        cryptoCount++;
+      } else if (ok && job->tickerIndex < appConfig->numTickers) {
+        uint8_t idx = job->tickerIndex;
+        tickers[idx].currentPrice = job->price;
+        tickers[idx].priceValid = true;
+        notePrice(idx, 0, job->finishedAt);   // Twelve Data /price has no timestamp
+        lastPriceAt[idx] = appTime();
+        relayPublishPrices(tickers, &idx, 1);
+        evaluateAlerts(appConfig, tickers, &idx, 1, job->finishedAt);
+        // Change% is computed from sparkline data (see sparkline fetch below)
+        LOG_EVENT(EV_DM_STOCK_UPDATED, appConfig->tickers[job->tickerIndex].symbol, priceToFloat(job->price));
+      } else {
+        LOG_EVENT(EV_DM_STOCK_FAILED, job->ids);
+      }
+      break;
+
+    case FETCH_CRYPTO_CHART:
+    case FETCH_STOCK_CHART:
+      if (ok && job->tickerIndex < appConfig->numTickers) {
+        lastChartAt[job->tickerIndex][job->timeframe] = appTime();
+        applySparkline(job->tickerIndex, job->timeframe, &job->sparkline);
+        relayPublishSparkline(job->tickerIndex, job->timeframe, &job->sparkline);
+      } else {
+        LOG_EVENT(EV_DM_SPARKLINE_FAILED, job->ids, job->days);
       }
+      break;
+  }
+
+  releaseFetchJob(job);
+}
+
+// Stock/forex prices only move while the market is open; one more fetch
+// after the close picks up the closing price. Until SNTP has set the clock
+// every ticker stays eligible.
+static bool priceDue(int idx, time_t wall) {
+  TickerType type = appConfig->tickers[idx].type;
+  if (type == TICKER_CRYPTO || !appTimeValid(wall) || !tickers[idx].priceValid) return true;
+  if (isMarketOpen(type, wall)) return true;
+  time_t close = lastMarketClose(type, wall - MARKET_SETTLE_S);
+  return lastPriceAt[idx] < close + MARKET_SETTLE_S;
+}
+
+// Populated stock/forex charts are refetched once per candle, just after
+// it closes (24H: hourly candles, longer timeframes: daily)
+static bool followsCandles(int idx, int tf, time_t wall) {
+  return appConfig->tickers[idx].type != TICKER_CRYPTO && appTimeValid(wall) &&
+         sparklineValid(idx, tf);
+}
+
+// Crypto 24H/7D charts ride along with CoinGecko price rounds; the chart
+// rotation only fetches them while those rounds do not deliver (CMC or
+// the stream prices the coin, or CoinGecko sent no sparkline)
+static bool batchChartFresh(int idx, int tf, unsigned long scale) {
+  if (appConfig->tickers[idx].type != TICKER_CRYPTO || tf > TIMEFRAME_7D) return false;
+  if (cryptoJob && cryptoJob->charts) return true;   // On its way
+  return batchChartAt[idx] != 0 && appMillis() - batchChartAt[idx] < 2 * CRYPTO_FETCH_INTERVAL_MS * scale;
+}
+
+static bool chartDue(int idx, int tf, time_t wall, bool intervalElapsed, unsigned long scale) {
+  if (batchChartFresh(idx, tf, scale)) return false;
+  if (!followsCandles(idx, tf, wall)) return intervalElapsed;
+  if (scale > 1 && !intervalElapsed) return false;   // Quiet hours stretch these too
+
+  TickerType type = appConfig->tickers[idx].type;
+  CandleInterval interval = tf == TIMEFRAME_24H ? CANDLE_1H : CANDLE_1DAY;
+  time_t close = lastCandleClose(type, interval, wall - MARKET_SETTLE_S);
+  return lastChartAt[idx][tf] < close + MARKET_SETTLE_S;
+}
+
+static void logMarketChanges(time_t wall) {
+  if (!appTimeValid(wall)) return;
+  for (int type = TICKER_STOCK; type <= TICKER_FOREX; type++) {
+    bool open = isMarketOpen((TickerType)type, wall);
+    if (open == marketWasOpen[type]) continue;
+    marketWasOpen[type] = open;
+    if (open) {
+      LOG_EVENT(EV_DM_MARKET_OPEN, getMarketName((TickerType)type));
+    } else {
+      time_t next = nextMarketOpen((TickerType)type, wall);
+      LOG_EVENT(EV_DM_MARKET_CLOSED, getMarketName((TickerType)type), next ? (unsigned long)((next - wall) / 60) : 0UL);
     }
+  }
+}
+
+// Time left until interval has passed since `since` (0 = due; a time of
+// 0 means never, which is due too)
+static uint32_t dueIn(unsigned long since, unsigned long interval, unsigned long now) {
+  if (since == 0 || now - since >= interval) return 0;
+  return interval - (now - since);
+}
+
+// Rate fetches: hourly per currency while the forex market is open (a
+// cached rate holds over the weekend), and at most every other stock turn
+// until the first rate arrives. Returns ms until the next one is due,
+// FETCH_WAIT_FOREVER if none is wanted; *due gets the currency (or -1).
+static uint32_t fxDue(time_t wall, unsigned long scale, unsigned long now, int* due) {
+  *due = -1;
+  uint32_t wait = FETCH_WAIT_FOREVER;
+  if (strlen(appConfig->twelveDataApiKey) == 0) return wait;
+  bool closed = appTimeValid(wall) && !isMarketOpen(TICKER_FOREX, wall);
+  for (int c = 0; c < CURRENCY_COUNT; c++) {
+    if (!(fxFetchMask & (1 << c))) continue;
+    bool known = getFxRate((Currency)c).source != FX_NONE;
+    uint32_t w;
+    if (known && closed) {
+      time_t open = nextMarketOpen(TICKER_FOREX, wall);
+      w = open > wall ? (uint32_t)min((time_t)(FETCH_WAIT_FOREVER / 1000), open - wall) * 1000 : FETCH_WAIT_FOREVER;
+    } else {
+      w = dueIn(lastFxFetch[c], known ? FX_REFRESH_INTERVAL_MS * scale : 2 * STOCK_FETCH_INTERVAL_MS, now);
+    }
+    if (w == 0 && *due < 0) *due = c;
+    wait = min(wait, w);
+  }
+  return wait;
+}
+
+// After a chart scan found nothing due: how long until one can be.
+// Candles close on the hour (UTC), so stock/forex charts are checked just
+// after each hour has settled.
+static uint32_t idleChartWait(time_t wall, bool intervalElapsed, unsigned long interval, unsigned long now) {
+  uint32_t wait = intervalElapsed ? FETCH_WAIT_FOREVER : dueIn(lastSparklineFetch, interval, now);
+  if (isProviderOpen(PROVIDER_COINGECKO)) wait = min(wait, providerRetryInMs(PROVIDER_COINGECKO));
+  if (isProviderOpen(PROVIDER_TWELVEDATA)) wait = min(wait, providerRetryInMs(PROVIDER_TWELVEDATA));
+  if (numMarketTickers > 0 && appTimeValid(wall)) {
+    time_t settled = wall - MARKET_SETTLE_S;
+    wait = min(wait, (uint32_t)((3600 - settled % 3600) * 1000));
+  }
+  return max(wait, (uint32_t)SPARKLINE_MIN_GAP_MS);
+}
+
+uint32_t updateData() {
+  if (!appConfig || !tickers) {
+    return FETCH_WAIT_FOREVER;
+  }
+  TRACE_SCOPE("updateData");
+
+  // 0. Apply whatever the provider workers have finished since last pass
+  FetchJob* done;
+  while ((done = pollFetchCompletion()) != nullptr) {
+    handleCompletion(done);
+  }
+
+  // LAN relay: followers take data from the leader instead of the APIs
+  RelayUpdate relayed;
+  bool relayedCharts = false;
+  while (relayPoll(&relayed)) {
+    applyRelayUpdate(relayed);
+    relayedCharts |= relayed.kind == RELAY_UPDATE_SPARKLINE;
+  }
+  // Stored without passing through applySparkline(); recount for the
+  // chart schedule in case this follower takes over
+  if (relayedCharts) missingCharts = countMissingCharts();
+  // Earliest deadline of this pass; in-flight jobs wake the task when done
+  uint32_t wait = relayTick(tickers, appConfig->numTickers);
+
+  // The stream is a fetch too: followers leave it to the leader, and OTA
+  // needs its TLS heap
+  setMarketStreamActive(relayShouldFetch() && !otaActive());
+  if (!relayShouldFetch()) {
+    return wait;
+  }
 
-    if (cryptoCount > 0) {
-      int updated = 0;
-      if (strlen(appConfig->cmcApiKey) > 0) {
-        // Use CoinMarketCap (gives per-timeframe change%)
-        Serial.printf("[DataMgr] CMC: fetching %d crypto tickers\n", cryptoCount);
-        updated = fetchCMCPrices(cryptoSlugs.c_str(), tickers, appConfig->numTickers, appConfig->tickers);
+  // Hold new fetches while an OTA upload needs the heap and the flash
+  // (its end signals the fetch task)
+  if (otaActive()) {
+    return wait;
+  }
+
+  unsigned long now = appMillis();
+  unsigned long scale = powerFetchScale();   // Stretched during quiet hours
+  time_t wall = appTime();
+  logMarketChanges(wall);
+  if (scale != lastScale) {
+    // Quiet hours started or ended: rescan the charts with the new intervals
+    lastScale = scale;
+    chartRetryMs = SPARKLINE_MIN_GAP_MS;
+  }
+
+  // 0b. Live crypto prices, published at most every STREAM_PUBLISH_MS
+  if (now - lastStreamPublish >= STREAM_PUBLISH_MS) {
+    lastStreamPublish = now;
+    applyStreamQuotes();
+  }
+  if (streamPending()) wait = min(wait, dueIn(lastStreamPublish, STREAM_PUBLISH_MS, now));
+
+  // 1. Fetch crypto prices (CMC preferred, CoinGecko fallback)
+  // Large watchlists go out as several batch requests, one after another;
+  // the interval is measured from the start of the round
+  // No free job (or a full provider queue): the next completion wakes us
+  bool cryptoStarved = false;
+  if (!cryptoJob && numCryptoTickers > 0 &&
+      (cryptoCursor > 0 || dueIn(lastCryptoFetch, CRYPTO_FETCH_INTERVAL_MS * scale, now) == 0)) {
+    FetchJob* job = acquireFetchJob();
+    cryptoStarved = !job;
+    if (job) {
+      if (cryptoCursor == 0) lastCryptoFetch = now;
+
+      // Build comma-separated list of slugs/IDs, as many as fit one request
+      int cryptoCount = 0;
+      size_t len = 0;
+      int i = cryptoCursor;
+
+      for (; i < appConfig->numTickers && cryptoCount < FETCH_BATCH_MAX; i++) {
+        const TickerConfig* config = &appConfig->tickers[i];
+        // Coins priced by the stream only come back here if it goes quiet
+        if (!config->enabled || config->type != TICKER_CRYPTO || streamPriceFresh(i)) continue;
+        size_t idLen = strlen(config->apiId);
+        if (len + idLen + 1 >= sizeof(job->ids)) break;
+        len += snprintf(job->ids + len, sizeof(job->ids) - len, "%s%s",
+                        cryptoCount > 0 ? "," : "", config->apiId);
+        job->batchTickers[cryptoCount++] = i;
+      }
+      cryptoCursor = i < appConfig->numTickers ? i : 0;
+
+      if (cryptoCount > 0) {
+        // Fall back to CoinGecko while CMC's circuit is open
+        bool useCMC = strlen(appConfig->cmcApiKey) > 0 && !isProviderOpen(PROVIDER_CMC);
+        job->kind = useCMC ? FETCH_CMC_PRICES : FETCH_COINGECKO_PRICES;
+        if (!useCMC) {
+          if (!cryptoCharts) cryptoCharts = (BatchCharts*)malloc(FETCH_BATCH_MAX * sizeof(BatchCharts));
+          job->charts = cryptoCharts;   // Without the buffer, the chart rotation keeps these too
+        }
+        job->numTickers = cryptoCount;
+        job->timeoutMs = FETCH_PRICE_TIMEOUT_MS;
+
+        // CMC gives per-timeframe change%; CoinGecko is the keyless fallback
+        LOG_EVENT(EV_DM_CRYPTO_FETCH, nullptr, fetchProvider(job->kind), cryptoCount);
+        if (submitFetch(job)) cryptoJob = job;
+        else cryptoStarved = true;
       } else {
-        // Fallback to CoinGecko
-        Serial.printf("[DataMgr] CoinGecko: fetching %d crypto tickers\n", cryptoCount);
-        updated = fetchCryptoPrices(cryptoSlugs.c_str(), tickers, appConfig->numTickers, appConfig->tickers);
+        releaseFetchJob(job);
       }
-      Serial.printf("[DataMgr] Updated %d/%d crypto tickers\n", updated, cryptoCount);
     }
-
-    lastCryptoFetch = now;
+  }
+  if (!cryptoJob && !cryptoStarved && numCryptoTickers > 0) {
+    wait = min(wait, cryptoCursor > 0 ? 0 : dueIn(lastCryptoFetch, CRYPTO_FETCH_INTERVAL_MS * scale, now));
   }
 
   // 2. Fetch stock/forex prices (round-robin, one per interval)
-  if (now - lastStockFetch >= STOCK_FETCH_INTERVAL_MS || lastStockFetch == 0) {
+  // Skipped entirely while Twelve Data is backing off, and per ticker while
+  // its market is closed
+  // A due display-currency rate takes the next turn
+  int fxTurn;
+  uint32_t fxWait = fxDue(wall, scale, now, &fxTurn);
+  bool stockStarved = false;
+  if (!stockJob && (numMarketTickers > 0 || fxTurn >= 0) && !isProviderOpen(PROVIDER_TWELVEDATA) &&
+      dueIn(lastStockFetch, STOCK_FETCH_INTERVAL_MS * scale, now) == 0) {
     // Find next enabled stock/forex ticker
     int startIndex = currentStockIndex;
-    bool found = false;
+    bool found = fxTurn >= 0;
 
-    do {
+    while (!found) {
       if (appConfig->tickers[currentStockIndex].enabled &&
-          appConfig->tickers[currentStockIndex].type != TICKER_CRYPTO) {
+          appConfig->tickers[currentStockIndex].type != TICKER_CRYPTO &&
+          priceDue(currentStockIndex, wall)) {
         found = true;
         break;
       }
       currentStockIndex = (currentStockIndex + 1) % appConfig->numTickers;
-    } while (currentStockIndex != startIndex);
+      if (currentStockIndex == startIndex) break;
+    }
 
-    if (found) {
+    FetchJob* job = found ? acquireFetchJob() : nullptr;
+    if (job && fxTurn >= 0) {
+      lastFxFetch[fxTurn] = now;
+      LOG_EVENT(EV_DM_FX_FETCH, getFxPair((Currency)fxTurn));
+
+      job->kind = FETCH_STOCK_PRICE;
+      job->tickerIndex = FX_JOB_SLOT;
+      strlcpy(job->ids, getFxPair((Currency)fxTurn), sizeof(job->ids));
+      strlcpy(job->apiKey, appConfig->twelveDataApiKey, sizeof(job->apiKey));
+      job->timeoutMs = FETCH_PRICE_TIMEOUT_MS;
+      if (submitFetch(job)) stockJob = job;
+    } else if (job) {
       const TickerConfig* config = &appConfig->tickers[currentStockIndex];
-      float price = 0;
 
-      Serial.printf("[DataMgr] Fetching stock: %s\n", config->symbol);
+      LOG_EVENT(EV_DM_STOCK_FETCH, config->symbol);
 
-      if (fetchStockPrice(config->apiId, appConfig->twelveDataApiKey, &price)) {
-        tickers[currentStockIndex].currentPrice = price;
-        tickers[currentStockIndex].priceValid = true;
-        // Change% is computed from sparkline data (see sparkline fetch below)
-
-        Serial.printf("[DataMgr] Updated %s: $%.2f\n", config->symbol, price);
-      } else {
-        Serial.printf("[DataMgr] Failed to fetch %s\n", config->symbol);
-      }
+      job->kind = FETCH_STOCK_PRICE;
+      job->tickerIndex = currentStockIndex;
+      strlcpy(job->ids, config->apiId, sizeof(job->ids));
+      strlcpy(job->apiKey, appConfig->twelveDataApiKey, sizeof(job->apiKey));
+      job->timeoutMs = FETCH_PRICE_TIMEOUT_MS;
+      if (submitFetch(job)) stockJob = job;
 
       currentStockIndex = (currentStockIndex + 1) % appConfig->numTickers;
     }
 
-    lastStockFetch = now;
+    if (!found || job) lastStockFetch = now;
+    stockStarved = found && !job;
+    if (job && fxTurn >= 0) fxWait = fxDue(wall, scale, now, &fxTurn);
   }
-
-  // 3. Fetch sparkline data (round-robin through all tickers and timeframes)
-  // Use fast interval (2s) until all sparklines are populated, then normal intervals
-  bool allPopulated = true;
-  for (int i = 0; i < appConfig->numTickers && allPopulated; i++) {
-    if (!appConfig->tickers[i].enabled) continue;
-    for (int tf = 0; tf < 4; tf++) {
-      if (!tickers[i].sparklines[tf].valid) { allPopulated = false; break; }
-    }
+  if (!stockJob && !stockStarved && (numMarketTickers > 0 || fxWait != FETCH_WAIT_FOREVER)) {
+    uint32_t turn = dueIn(lastStockFetch, STOCK_FETCH_INTERVAL_MS * scale, now);
+    if (numMarketTickers == 0) turn = max(turn, fxWait);   // Only a rate to fetch: an extra call, no turn
+    wait = min(wait, isProviderOpen(PROVIDER_TWELVEDATA) ? providerRetryInMs(PROVIDER_TWELVEDATA) : turn);
   }
-  unsigned long sparklineInterval = allPopulated ? SPARKLINE_24H_INTERVAL_MS : 15000;
-  if (now - lastSparklineFetch >= sparklineInterval || lastSparklineFetch == 0) {
-    // Find next enabled ticker
-    int startTicker = currentSparklineTickerIndex;
-    bool found = false;
-
-    do {
-      if (appConfig->tickers[currentSparklineTickerIndex].enabled) {
-        found = true;
+
+  // 3. Fetch sparkline data (round-robin through all ticker/timeframe slots)
+  // Interval-driven charts use the fill interval until every sparkline is
+  // populated, then the normal one; see chartDue for stock/forex
+  unsigned long sparklineInterval = missingCharts == 0 ? SPARKLINE_24H_INTERVAL_MS * scale : SPARKLINE_MIN_GAP_MS;
+  bool intervalElapsed = dueIn(lastSparklineFetch, sparklineInterval, now) == 0;
+  bool chartStarved = false;
+  if (!sparklineJob && dueIn(lastChartScan, chartRetryMs, now) == 0) {
+    int slots = appConfig->numTickers * TIMEFRAME_COUNT;
+    int slot = currentSparklineTickerIndex * TIMEFRAME_COUNT + currentSparklineTimeframe;
+    int pick = -1;
+    bool onScreenSoon = false;
+
+    // Find the next due slot whose chart provider is not backing off.
+    // An empty chart the display is about to show jumps the queue (without
+    // moving the round-robin position).
+    for (int n = 0; n < slots; n++, slot = (slot + 1) % slots) {
+      int idx = slot / TIMEFRAME_COUNT;
+      int tf = slot % TIMEFRAME_COUNT;
+      const TickerConfig* candidate = &appConfig->tickers[idx];
+      ApiProvider provider = candidate->type == TICKER_CRYPTO ? PROVIDER_COINGECKO : PROVIDER_TWELVEDATA;
+      if (!candidate->enabled || isProviderOpen(provider) || !chartDue(idx, tf, wall, intervalElapsed, scale)) {
+        continue;
+      }
+      if (!sparklineValid(idx, tf) && inSparklineWindow(idx)) {
+        pick = slot;
+        onScreenSoon = true;
         break;
       }
-      currentSparklineTickerIndex = (currentSparklineTickerIndex + 1) % appConfig->numTickers;
-    } while (currentSparklineTickerIndex != startTicker);
+      if (pick < 0) pick = slot;
+    }
+    bool found = pick >= 0;
+    int pickIdx = pick / TIMEFRAME_COUNT;
+    int pickTf = pick % TIMEFRAME_COUNT;
 
-    if (found) {
-      const TickerConfig* config = &appConfig->tickers[currentSparklineTickerIndex];
-      SparklineData* sparkline = nullptr;
+    FetchJob* job = found ? acquireFetchJob() : nullptr;
+    if (job) {
+      const TickerConfig* config = &appConfig->tickers[pickIdx];
       int days = 0;
       const char* interval = nullptr;
       int outputsize = 0;
 
       // Select sparkline based on current timeframe
-      switch (currentSparklineTimeframe) {
+      switch (pickTf) {
         case 0: // 24h
-          sparkline = &tickers[currentSparklineTickerIndex].sparklines[TIMEFRAME_24H];
           days = 1;
           interval = "1h";
           outputsize = 24;
           break;
         case 1: // 7d
-          sparkline = &tickers[currentSparklineTickerIndex].sparklines[TIMEFRAME_7D];
           days = 7;
           interval = "1day";
           outputsize = 7;
           break;
         case 2: // 30d
-          sparkline = &tickers[currentSparklineTickerIndex].sparklines[TIMEFRAME_30D];
           days = 30;
           interval = "1day";
           outputsize = 30;
           break;
         case 3: // 90d
-          sparkline = &tickers[currentSparklineTickerIndex].sparklines[TIMEFRAME_90D];
           days = 90;
           interval = "1day";
           outputsize = 90;
           break;
       }
 
-      Serial.printf("[DataMgr] Fetching sparkline for %s (%dd)\n", config->symbol, days);
+      LOG_EVENT(EV_DM_SPARKLINE_FETCH, config->symbol, days);
 
-      bool success = false;
+      job->tickerIndex = pickIdx;
+      job->timeframe = pickTf;
+      job->timeoutMs = FETCH_CHART_TIMEOUT_MS;
+      strlcpy(job->ids, config->apiId, sizeof(job->ids));
       if (config->type == TICKER_CRYPTO) {
-        success = fetchCryptoChart(config->apiId, days, sparkline);
+        job->kind = FETCH_CRYPTO_CHART;
+        job->days = days;
       } else {
-        success = fetchStockChart(config->apiId, appConfig->twelveDataApiKey, interval, outputsize, sparkline);
+        job->kind = FETCH_STOCK_CHART;
+        job->days = outputsize;
+        strlcpy(job->apiKey, appConfig->twelveDataApiKey, sizeof(job->apiKey));
+        strlcpy(job->interval, interval, sizeof(job->interval));
       }
-
-      if (success) {
-        saveSparklineCache(config->apiId, currentSparklineTimeframe, sparkline);
-
-        // Compute change% from sparkline data for stocks/forex
-        // (crypto uses CMC's per-timeframe change% which is more accurate)
-        if (config->type != TICKER_CRYPTO && sparkline->valid && sparkline->len > 1) {
-          float range = sparkline->priceMax - sparkline->priceMin;
-          if (range > 0.0001f) {
-            float startPrice = sparkline->priceMin + (sparkline->points[0] / 255.0f) * range;
-            float endPrice = sparkline->priceMin + (sparkline->points[sparkline->len - 1] / 255.0f) * range;
-            if (startPrice > 0.0001f) {
-              float pct = ((endPrice - startPrice) / startPrice) * 100.0f;
-              tickers[currentSparklineTickerIndex].priceChange[currentSparklineTimeframe] = pct;
-              if (currentSparklineTimeframe == 0) {
-                tickers[currentSparklineTickerIndex].priceChange24h = pct;
-              }
-              Serial.printf("[DataMgr] %s %dd change: %.1f%%\n", config->symbol, days, pct);
-            }
-          }
-        }
-
-        Serial.printf("[DataMgr] Updated + cached sparkline for %s (%dd)\n", config->symbol, days);
-      } else {
-        Serial.printf("[DataMgr] Failed to fetch sparkline for %s (%dd)\n", config->symbol, days);
+      if (submitFetch(job)) sparklineJob = job;
+      if (!followsCandles(pickIdx, pickTf, wall)) {
+        lastSparklineFetch = now;
       }
 
-      // Move to next timeframe
-      currentSparklineTimeframe++;
-      if (currentSparklineTimeframe >= 4) {
-        currentSparklineTimeframe = 0;
-        // Move to next ticker after completing all timeframes
-        currentSparklineTickerIndex = (currentSparklineTickerIndex + 1) % appConfig->numTickers;
+      // Round-robin continues after the slot it picked
+      if (!onScreenSoon) {
+        int next = (pick + 1) % slots;
+        currentSparklineTickerIndex = next / TIMEFRAME_COUNT;
+        currentSparklineTimeframe = next % TIMEFRAME_COUNT;
       }
     }
 
-    lastSparklineFetch = now;
+    if (!found || job) lastChartScan = now;
+    chartStarved = found && !job;
+    chartRetryMs = found ? SPARKLINE_MIN_GAP_MS : idleChartWait(wall, intervalElapsed, sparklineInterval, now);
+  }
+  if (!sparklineJob && !chartStarved) {
+    wait = min(wait, dueIn(lastChartScan, chartRetryMs, now));
   }
+  return wait;
 }
 
 String getDataStatus() {
@@ -285,7 +761,7 @@ String getDataStatus() {
     return "Not initialized";
   }
 
-  unsigned long now = millis();
+  unsigned long now = appMillis();
   String status = "";
 
   status += "Crypto: ";
@@ -294,7 +770,8 @@ String getDataStatus() {
   status += (now - lastStockFetch) / 1000;
   status += "s ago | Chart: ";
   status += (now - lastSparklineFetch) / 1000;
-  status += "s ago";
+  status += "s ago | In flight: ";
+  status += fetchInFlight(PROVIDER_CMC) + fetchInFlight(PROVIDER_COINGECKO) + fetchInFlight(PROVIDER_TWELVEDATA);
 
   return status;
 }
@@ -1,15 +1,21 @@
 #pragma once
 #include "ticker_types.h"
 
-// Initialize with config and ticker data array
-void initDataManager(AppConfig* config, TickerData* tickerData);
+// Initialize with a config snapshot (kept until the next init; call from
+// the fetch task, which holds that snapshot) and the ticker data array
+void initDataManager(const AppConfig* config, TickerData* tickerData);
 
-// Call this regularly from the fetch task (Core 0)
-// Handles scheduling of all API fetches based on intervals
-void updateData();
+// One fetch task pass (Core 0): apply finished fetches, relay and stream
+// updates, and start whatever is due. Returns ms until the next fetch is
+// due; finished fetches and new updates signal the task (see fetch_events.h).
+uint32_t updateData();
 
-// Force an immediate refresh of all data
+// Force an immediate refresh of all data (fetch task; other tasks signal
+// FETCH_EVENT_REFRESH)
 void forceRefresh();
 
+// Fetch prices now, e.g. after WiFi came back; charts keep their schedule
+void refreshPrices();
+
 // Get a string showing fetch status for debug
 String getDataStatus();
@@ -1,24 +1,120 @@
 #include "display_renderer.h"
 #include "config.h"
+#include "trace.h"
+#include "event_log.h"
+#include "layout.h"
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <esp_heap_caps.h>
+#include <math.h>
 
 // Static display instance
 static MatrixPanel_I2S_DMA* dma_display = nullptr;
 
-// Colors computed at runtime via dma_display->color565()
-static uint16_t COLOR_WHITE;
-static uint16_t COLOR_GREEN;
-static uint16_t COLOR_RED;
-static uint16_t COLOR_BRIGHT_GREEN;
-static uint16_t COLOR_BRIGHT_RED;
-static uint16_t COLOR_DIM_GRAY;
+// Where frames are drawn: the panel, or a capture canvas (see beginCapture)
+static Adafruit_GFX* target = nullptr;
+static SemaphoreHandle_t renderMutex = nullptr;
 
-static void initColors() {
-    COLOR_WHITE       = dma_display->color565(255, 255, 255);
-    COLOR_GREEN       = dma_display->color565(0, 255, 0);
-    COLOR_RED         = dma_display->color565(255, 0, 0);
-    COLOR_BRIGHT_GREEN = dma_display->color565(180, 255, 180);
-    COLOR_BRIGHT_RED   = dma_display->color565(255, 180, 180);
-    COLOR_DIM_GRAY    = dma_display->color565(60, 60, 60);
+// Serializes whole frames between the display loop and captures
+class RenderLock {
+public:
+    RenderLock() { if (renderMutex) xSemaphoreTakeRecursive(renderMutex, portMAX_DELAY); }
+    ~RenderLock() { if (renderMutex) xSemaphoreGiveRecursive(renderMutex); }
+};
+
+// Same RGB565 packing as MatrixPanel_I2S_DMA::color565(), usable before
+// (or without) a panel
+static uint16_t color565(uint8_t r, uint8_t g, uint8_t b) {
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+// Colors are kept as 8-bit RGB and only reduced to the panel's depth when
+// a pixel is written (see putPixel)
+struct Rgb {
+    uint8_t r, g, b;
+};
+
+static const Rgb COLOR_WHITE        = {255, 255, 255};
+static const Rgb COLOR_GREEN        = {0, 255, 0};
+static const Rgb COLOR_RED          = {255, 0, 0};
+static const Rgb COLOR_DIM_GREEN    = {0, 128, 0};
+static const Rgb COLOR_DIM_RED      = {128, 0, 0};
+static const Rgb COLOR_BRIGHT_GREEN = {180, 255, 180};
+static const Rgb COLOR_BRIGHT_RED   = {255, 180, 180};
+static const Rgb COLOR_DIM_GRAY     = {60, 60, 60};
+static const Rgb COLOR_AMBER        = {255, 140, 0};
+
+// ============================================================
+// Display quality: color depth, gamma and dithering
+// ============================================================
+
+static uint8_t colorDepth = DISPLAY_MIN_COLOR_DEPTH;
+static uint8_t panelBrightness = DEFAULT_BRIGHTNESS;
+static bool panelOff = false;     // Blanked by setDisplayPower(false)
+static bool doubleBuffered = true;
+static DisplayProbe probes[DISPLAY_PROBE_SLOTS];
+static int probeCount = 0;
+static int selectedProbe = -1;
+static uint32_t dmaBudgetBytes = 0;
+
+// Linear 8-bit input -> panel duty cycle in 1/65536ths. Replaces the
+// library's CIE1931 table (built with NO_CIE1931), so the fractional part
+// survives for dithering instead of being truncated to the bit depth.
+static uint16_t gammaLut[256];
+
+// 4x4 Bayer thresholds in 1/16ths of an output level
+static const uint8_t bayer4[4][4] = {
+    { 0,  8,  2, 10},
+    {12,  4, 14,  6},
+    { 3, 11,  1,  9},
+    {15,  7, 13,  5},
+};
+
+// Advanced once per redraw; stepping by 7 (coprime with 16) walks every
+// pixel through all 16 thresholds, so each averages to its exact level
+static uint8_t ditherPhase = 0;
+
+static void initGammaLut() {
+    for (int i = 0; i < 256; i++) {
+        gammaLut[i] = (uint16_t)lroundf(powf(i / 255.0f, DISPLAY_GAMMA) * 65535.0f);
+    }
+}
+
+// Gamma-correct one channel and reduce it to colorDepth bits, adding the
+// dither threshold before truncating. Returns an 8-bit value whose top
+// colorDepth bits are what the panel will show.
+static uint8_t quantize(uint8_t v, uint8_t threshold) {
+    uint32_t level = gammaLut[v] >> (12 - colorDepth);   // colorDepth.4 fixed point
+    uint32_t q = (level + threshold) >> 4;
+    uint32_t maxQ = (1u << colorDepth) - 1;
+    if (q > maxQ) q = maxQ;
+    return (uint8_t)(q << (8 - colorDepth));
+}
+
+static uint8_t ditherThreshold(int16_t x, int16_t y) {
+#if DISPLAY_DITHER_FPS > 0
+    return (bayer4[y & 3][x & 3] + ditherPhase * 7) & 15;
+#else
+    return bayer4[y & 3][x & 3];
+#endif
+}
+
+// Write one pixel to the current target. The panel gets gamma-corrected,
+// dithered output; capture canvases get the plain RGB565 color so goldens
+// do not depend on the selected depth or dither phase.
+static void putPixel(int16_t x, int16_t y, const Rgb& c) {
+    if (target != dma_display) {
+        target->drawPixel(x, y, color565(c.r, c.g, c.b));
+        return;
+    }
+    uint8_t t = ditherThreshold(x, y);
+    dma_display->drawPixelRGB888(x, y, quantize(c.r, t), quantize(c.g, t), quantize(c.b, t));
+}
+
+// RGB565 for Adafruit_GFX primitives (no dithering; used for full-scale colors)
+static uint16_t targetColor(const Rgb& c) {
+    if (target != dma_display) return color565(c.r, c.g, c.b);
+    return color565(quantize(c.r, 8), quantize(c.g, 8), quantize(c.b, 8));
 }
 
 // ============================================================
@@ -80,8 +176,22 @@ static const uint8_t FONT5X7[][7] = {
     {0x11,0x11,0x0A,0x04,0x0A,0x11,0x11}, // X
     {0x11,0x11,0x0A,0x04,0x04,0x04,0x04}, // Y
     {0x1F,0x01,0x02,0x04,0x08,0x10,0x1F}, // Z
+    // Index 44-47: currency signs, drawn from GLYPH_* codes
+    {0x07,0x08,0x1E,0x08,0x1E,0x08,0x07}, // Euro
+    {0x06,0x09,0x08,0x1C,0x08,0x08,0x1F}, // Pound
+    {0x11,0x0A,0x1F,0x04,0x1F,0x04,0x04}, // Yen
+    {0x0F,0x08,0x08,0x0E,0x08,0x1C,0x08}, // Franc (CHF)
 };
 
+// Non-ASCII glyphs, as single chars in the strings passed to drawText()
+#define GLYPH_EURO   '\x80'
+#define GLYPH_POUND  '\x81'
+#define GLYPH_YEN    '\x82'
+#define GLYPH_FRANC  '\x83'
+
+// Price prefix per Currency
+static const char currencyGlyph[CURRENCY_COUNT] = { '$', GLYPH_EURO, GLYPH_POUND, GLYPH_FRANC, GLYPH_YEN };
+
 // Map ASCII char to font index
 static int fontIndex(char c) {
     if (c == ' ')  return 0;
@@ -94,30 +204,44 @@ static int fontIndex(char c) {
     if (c == '/')  return 7;
     if (c >= '0' && c <= '9') return 8 + (c - '0');
     if (c >= 'A' && c <= 'Z') return 18 + (c - 'A');
+    if (c == GLYPH_EURO)  return 44;
+    if (c == GLYPH_POUND) return 45;
+    if (c == GLYPH_YEN)   return 46;
+    if (c == GLYPH_FRANC) return 47;
     return -1;
 }
 
+// Text is drawn at the layout's scale (each font dot is scale x scale
+// pixels) and clipped at textClip; advances below are in unscaled pixels
+static int textScale = 1;
+static int textClip = DISPLAY_WIDTH;
+
 // Draw single 5x7 character at (x,y) top-left, returns next x
-static int drawChar(int x, int y, char c, uint16_t color, int advance = 6) {
+static int drawChar(int x, int y, char c, const Rgb& color, int advance = 6) {
+    const int s = textScale;
     int idx = fontIndex(c);
-    if (idx < 0) return x + advance;
-    if (c == ' ') return x + advance;
+    if (idx < 0) return x + advance * s;
+    if (c == ' ') return x + advance * s;
     const uint8_t* glyph = FONT5X7[idx];
     for (int row = 0; row < 7; row++) {
         uint8_t bits = glyph[row];
         for (int col = 0; col < 5; col++) {
             if (bits & (0x10 >> col)) {
-                dma_display->drawPixel(x + col, y + row, color);
+                for (int dy = 0; dy < s; dy++) {
+                    for (int dx = 0; dx < s; dx++) {
+                        putPixel(x + col * s + dx, y + row * s + dy, color);
+                    }
+                }
             }
         }
     }
-    return x + advance;
+    return x + advance * s;
 }
 
 // Draw text string, returns x after last char
-static int drawText(int x, int y, const char* text, uint16_t color, int advance = 6) {
+static int drawText(int x, int y, const char* text, const Rgb& color, int advance = 6) {
     while (*text) {
-        if (x + 5 > 64) break;
+        if (x + 5 * textScale > textClip) break;
         x = drawChar(x, y, *text, color, advance);
         text++;
     }
@@ -128,7 +252,7 @@ static int drawText(int x, int y, const char* text, uint16_t color, int advance
 static int textWidth(const char* text, int advance = 6) {
     int len = strlen(text);
     if (len == 0) return 0;
-    return len * advance - 1;
+    return (len * advance - 1) * textScale;
 }
 
 // Get advance for price char (tight on both sides of '.')
@@ -138,40 +262,93 @@ static int priceAdv(char c, char next) {
     return 6;
 }
 
-// Calculate pixel width of price string (tighter '.' spacing)
-static int priceWidth(const char* text) {
-    int len = strlen(text);
-    if (len == 0) return 0;
-    int w = 0;
-    for (int i = 0; i < len - 1; i++) {
-        w += priceAdv(text[i], text[i + 1]);
-    }
-    w += 5; // last char: just char width, no trailing gap
-    return w;
-}
-
 // Draw price string with tighter '.' spacing
-static int drawPrice(int x, int y, const char* text, uint16_t color) {
+static int drawPrice(int x, int y, const char* text, const Rgb& color) {
     while (*text) {
         char next = *(text + 1);
         int adv = next ? priceAdv(*text, next) : 6;
-        if (x + 5 > 64) break;
+        if (x + 5 * textScale > textClip) break;
         x = drawChar(x, y, *text, color, adv);
         text++;
     }
     return x;
 }
 
-// ============================================================
+// Last frame shown on the panel, redrawn with a new dither phase while held
+enum FrameKind : uint8_t { FRAME_NONE, FRAME_TICKER, FRAME_LOADING, FRAME_ERROR, FRAME_ALERT };
+static FrameKind lastKind = FRAME_NONE;
+static TickerData lastTicker;
+static SparklineData lastSparkline;
+static ChartTimeframe lastTimeframe = TIMEFRAME_24H;
+static char lastMessage[48];
+static bool lastStale = false;
+static bool lastAlertUp = true;
+static bool lastAlertFlash = false;
+
+// Bumped for every new frame flipped onto the panel (not dither redraws),
+// blanking and power changes; read by the web mirror (see frame_mirror.h)
+static volatile uint32_t shownSerial = 0;
+static bool redrawing = false;
+
+// Task blocked in holdFrame(), woken early by wakeDisplay()
+static volatile TaskHandle_t holdingTask = nullptr;
+
+static void rememberFrame(FrameKind kind, const TickerData* ticker, const SparklineData* sparkline,
+                          ChartTimeframe timeframe, const char* message) {
+    if (target != dma_display) return;   // Captured frames never reach the panel
+    lastKind = kind;
+    lastTimeframe = timeframe;
+    if (ticker && ticker != &lastTicker) lastTicker = *ticker;
+    if (sparkline && sparkline != &lastSparkline) lastSparkline = *sparkline;
+    if (message && message != lastMessage) strlcpy(lastMessage, message, sizeof(lastMessage));
+}
 
-bool initDisplay(uint8_t brightness) {
-    if (dma_display) {
-        dma_display->setBrightness8(brightness);
+// Start/finish a frame on the current target
+static void beginFrame() {
+    if (target == dma_display) {
         dma_display->clearScreen();
-        return true;
+    } else {
+        target->fillScreen(0);
     }
+}
+
+static void endFrame() {
+    if (target != dma_display) return;
+    if (doubleBuffered) dma_display->flipDMABuffer();
+    if (!redrawing) shownSerial++;
+}
+
+// ============================================================
+
+// Approximate DMA use of one configuration: each scan row holds a 16-bit
+// word per column per bit plane, plus the linked-list descriptors that
+// repeat the higher planes for binary-coded modulation (2^(depth-1) per row)
+static uint32_t estimateDmaBytes(uint8_t depth, bool doubleBuffer) {
+    uint32_t scanRows = PANEL_HEIGHT / 2;
+    uint32_t planeBytes = (uint32_t)depth * DISPLAY_WIDTH * 2;
+    uint32_t descriptorBytes = (1u << (depth - 1)) * 12;
+    return scanRows * (planeBytes + descriptorBytes) * (doubleBuffer ? 2 : 1);
+}
+
+// DMA memory the panel may use without starving WiFi/TLS
+static uint32_t dmaBudget() {
+    size_t dmaFree = heap_caps_get_free_size(MALLOC_CAP_DMA);
+    uint32_t available = dmaFree > DISPLAY_DMA_RESERVE ? dmaFree - DISPLAY_DMA_RESERVE : 0;
+    return min((uint32_t)DISPLAY_DMA_BUDGET, available);
+}
+
+static void initProbe(DisplayProbe* probe, uint8_t depth, bool doubleBuffer) {
+    probe->depth = depth;
+    probe->doubleBuffered = doubleBuffer;
+    probe->started = false;
+    probe->refreshHz = 0;
+    probe->dmaBytes = 0;
+    probe->estimatedBytes = estimateDmaBytes(depth, doubleBuffer);
+}
 
-    HUB75_I2S_CFG mxconfig(PANEL_WIDTH, PANEL_HEIGHT);
+// Bring the panel up at one color depth and record what it costs
+static MatrixPanel_I2S_DMA* startPanel(uint8_t depth, bool doubleBuffer, DisplayProbe* probe) {
+    HUB75_I2S_CFG mxconfig(PANEL_WIDTH, PANEL_HEIGHT, PANEL_CHAIN);
 
     mxconfig.gpio.r1 = R1_PIN;
     mxconfig.gpio.g1 = G1_PIN;
@@ -183,76 +360,276 @@ bool initDisplay(uint8_t brightness) {
     mxconfig.gpio.b = B_PIN;
     mxconfig.gpio.c = C_PIN;
     mxconfig.gpio.d = D_PIN;
+#if PANEL_HEIGHT >= 64
+    mxconfig.gpio.e = E_PIN;
+#endif
     mxconfig.gpio.lat = LAT_PIN;
     mxconfig.gpio.oe = OE_PIN;
     mxconfig.gpio.clk = CLK_PIN;
 
     mxconfig.driver = HUB75_I2S_CFG::SHIFTREG;
-    mxconfig.setPixelColorDepthBits(3);
-    mxconfig.double_buff = true;
+    mxconfig.setPixelColorDepthBits(depth);
+    // Plain binary-coded modulation: keep the library from stretching the
+    // low bit planes to hit a refresh target, depth is traded here instead
+    mxconfig.min_refresh_rate = 1;
+    mxconfig.double_buff = doubleBuffer;
     mxconfig.latch_blanking = 4;
     mxconfig.clkphase = false;
 
-    dma_display = new MatrixPanel_I2S_DMA(mxconfig);
-    if (!dma_display) return false;
+    initProbe(probe, depth, doubleBuffer);
 
-    if (!dma_display->begin()) {
-        delete dma_display;
-        dma_display = nullptr;
-        return false;
+    MatrixPanel_I2S_DMA* panel = new MatrixPanel_I2S_DMA(mxconfig);
+    if (!panel) return nullptr;
+
+    size_t dmaFree = heap_caps_get_free_size(MALLOC_CAP_DMA);
+    if (!panel->begin()) {
+        delete panel;
+        return nullptr;
     }
 
-    initColors();
+    // The library derives the refresh rate from the I2S clock and the DMA
+    // descriptor chain it just built
+    probe->started = true;
+    probe->refreshHz = panel->calculated_refresh_rate;
+    probe->dmaBytes = dmaFree - heap_caps_get_free_size(MALLOC_CAP_DMA);
+    return panel;
+}
+
+bool initDisplay(uint8_t brightness) {
+    panelBrightness = brightness;
+    if (panelOff) return true;    // Applied when the panel is powered back on
+    if (dma_display) {
+        RenderLock lock;
+        dma_display->setBrightness8(brightness);
+        dma_display->clearScreen();
+        return true;
+    }
+
+    if (!renderMutex) renderMutex = xSemaphoreCreateRecursiveMutex();
+    initGammaLut();
+
+    // Deepest color that fits the DMA budget and keeps refresh above the
+    // flicker floor; the shallowest depth is accepted at any refresh rate
+    dmaBudgetBytes = dmaBudget();
+    probeCount = 0;
+    for (int depth = DISPLAY_MAX_COLOR_DEPTH; depth >= DISPLAY_MIN_COLOR_DEPTH; depth--) {
+        DisplayProbe& probe = probes[probeCount++];
+        if (estimateDmaBytes(depth, true) > dmaBudgetBytes) {
+            initProbe(&probe, depth, true);
+            LOG_EVENT(EV_DISPLAY_OVER_BUDGET, nullptr, depth, (unsigned)probe.estimatedBytes, (unsigned)dmaBudgetBytes);
+            continue;
+        }
+
+        MatrixPanel_I2S_DMA* panel = startPanel(depth, true, &probe);
+        if (!panel) {
+            LOG_EVENT(EV_DISPLAY_FAILED, nullptr, depth);
+            continue;
+        }
+        LOG_EVENT(EV_DISPLAY_PROBE, nullptr, depth, (unsigned)probe.refreshHz, (unsigned)probe.dmaBytes);
+
+        bool fits = probe.dmaBytes <= dmaBudgetBytes;
+        if ((fits && probe.refreshHz >= DISPLAY_MIN_REFRESH_HZ) || depth == DISPLAY_MIN_COLOR_DEPTH) {
+            dma_display = panel;
+            colorDepth = depth;
+            doubleBuffered = true;
+            selectedProbe = probeCount - 1;
+            break;
+        }
+        delete panel;   // Releases its DMA buffers before the next probe
+    }
+
+    // Large chains may not fit even the shallowest depth twice: draw into
+    // the displayed buffer instead (frames are cleared and redrawn in place)
+    if (!dma_display) {
+        DisplayProbe& probe = probes[probeCount++];
+        dma_display = startPanel(DISPLAY_MIN_COLOR_DEPTH, false, &probe);
+        if (!dma_display) {
+            LOG_EVENT(EV_DISPLAY_FAILED, nullptr, DISPLAY_MIN_COLOR_DEPTH);
+            return false;
+        }
+        LOG_EVENT(EV_DISPLAY_PROBE, nullptr, DISPLAY_MIN_COLOR_DEPTH, (unsigned)probe.refreshHz, (unsigned)probe.dmaBytes);
+        colorDepth = DISPLAY_MIN_COLOR_DEPTH;
+        doubleBuffered = false;
+        selectedProbe = probeCount - 1;
+    }
+
+    LOG_EVENT(EV_DISPLAY_SELECTED, nullptr, (int)colorDepth,
+              (unsigned)probes[selectedProbe].refreshHz, (unsigned)DISPLAY_MIN_REFRESH_HZ);
+
+    target = dma_display;
     dma_display->setBrightness8(brightness);
     dma_display->clearScreen();
-    dma_display->flipDMABuffer();
+    endFrame();
 
     return true;
 }
 
 void setDisplayBrightness(uint8_t brightness) {
+    panelBrightness = brightness;
     if (dma_display) dma_display->setBrightness8(brightness);
 }
 
 MatrixPanel_I2S_DMA* getDisplay() { return dma_display; }
 
 void clearDisplay() {
-    if (dma_display) dma_display->clearScreen();
+    RenderLock lock;
+    if (dma_display && target == dma_display) {
+        dma_display->clearScreen();
+        lastKind = FRAME_NONE;
+        shownSerial++;
+    }
 }
 
-void formatPrice(float price, char* buffer, size_t bufferSize) {
-    if (price >= 10000) {
-        snprintf(buffer, bufferSize, "$%.0f", price);
-    } else if (price >= 100) {
-        snprintf(buffer, bufferSize, "$%.1f", price);
-    } else if (price >= 1) {
-        snprintf(buffer, bufferSize, "$%.2f", price);
-    } else {
-        snprintf(buffer, bufferSize, "$%.4f", price);
+void beginCapture(Adafruit_GFX* canvas) {
+    if (renderMutex) xSemaphoreTakeRecursive(renderMutex, portMAX_DELAY);
+    target = canvas;
+}
+
+void endCapture() {
+    target = dma_display;
+    if (renderMutex) xSemaphoreGiveRecursive(renderMutex);
+}
+
+static void redrawLastFrame() {
+    redrawing = true;
+    switch (lastKind) {
+        case FRAME_TICKER:  renderTickerScreen(lastTicker, lastSparkline, lastTimeframe, lastStale); break;
+        case FRAME_LOADING: renderLoadingScreen(lastMessage); break;
+        case FRAME_ERROR:   renderErrorScreen(lastMessage); break;
+        case FRAME_ALERT:
+            renderAlertScreen(lastTicker.symbol, lastTicker.currentPrice, lastMessage, lastAlertUp, lastAlertFlash);
+            break;
+        default: break;
     }
+    redrawing = false;
+}
+
+uint32_t getShownFrameSerial() {
+    return shownSerial;
 }
 
-void renderTickerScreen(const TickerData& ticker, ChartTimeframe timeframe) {
-    if (!dma_display) return;
+uint32_t captureShownFrame(Adafruit_GFX* canvas) {
+    beginCapture(canvas);
+    uint32_t serial = shownSerial;
+    canvas->fillScreen(0);
+    if (!panelOff) redrawLastFrame();
+    endCapture();
+    return serial;
+}
+
+bool holdFrame(uint32_t ms) {
+    uint32_t start = millis();
+    holdingTask = xTaskGetCurrentTaskHandle();
+    bool woken = false;
+#if DISPLAY_DITHER_FPS > 0
+    const uint32_t frameMs = 1000 / DISPLAY_DITHER_FPS;
+    while (dma_display && lastKind != FRAME_NONE && millis() - start + frameMs < ms) {
+        woken = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(frameMs)) > 0;
+        if (woken) break;
+        RenderLock lock;
+        ditherPhase++;
+        redrawLastFrame();
+    }
+#endif
+    uint32_t elapsed = millis() - start;
+    if (!woken && elapsed < ms) woken = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms - elapsed)) > 0;
+    return !woken;
+}
 
+void wakeDisplay() {
+    TaskHandle_t task = holdingTask;
+    if (task) xTaskNotifyGive(task);
+}
+
+void setDisplayPower(bool on) {
+    RenderLock lock;
+    if (!on) {
+        if (!dma_display) return;
+        // Stop refresh and free the DMA buffers; renders become no-ops
+        dma_display->stopDMAoutput();
+        delete dma_display;
+        dma_display = nullptr;
+        target = nullptr;
+        panelOff = true;
+        shownSerial++;
+        return;
+    }
+
+    if (!panelOff) return;
+    panelOff = false;
+    DisplayProbe probe;
+    dma_display = startPanel(colorDepth, doubleBuffered, &probe);
+    if (!dma_display) {
+        LOG_EVENT(EV_DISPLAY_FAILED, nullptr, (int)colorDepth);
+        return;
+    }
+    target = dma_display;
+    dma_display->setBrightness8(panelBrightness);
     dma_display->clearScreen();
+    endFrame();
+    redrawLastFrame();
+}
+
+bool isDisplayOn() {
+    return dma_display != nullptr;
+}
 
-    // 5x7 font, 6px advance
-    // Layout for 64x32:
+DisplayQuality getDisplayQuality() {
+    DisplayQuality q;
+    memset(&q, 0, sizeof(q));
+    q.minRefreshHz = DISPLAY_MIN_REFRESH_HZ;
+    q.ditherFps = DISPLAY_DITHER_FPS;
+    q.gamma = DISPLAY_GAMMA;
+    q.panelOn = dma_display != nullptr;
+    q.width = DISPLAY_WIDTH;
+    q.height = DISPLAY_HEIGHT;
+    q.chain = PANEL_CHAIN;
+    q.dmaBudget = dmaBudgetBytes;
+    q.probeCount = probeCount;
+    for (int i = 0; i < probeCount; i++) q.probes[i] = probes[i];
+    if (selectedProbe >= 0) {
+        q.colorDepth = colorDepth;
+        q.doubleBuffered = doubleBuffered;
+        q.refreshHz = probes[selectedProbe].refreshHz;
+        q.dmaBytes = probes[selectedProbe].dmaBytes;
+    }
+    return q;
+}
+
+// Header price text and its drawn width (see formatPriceLabel()); maxW is
+// the room left beside the symbol, in screen pixels
+static int formatPrice(Price price, Currency currency, char* buffer, int maxW) {
+    char glyph = currency < CURRENCY_COUNT ? currencyGlyph[currency] : '$';
+    return formatPriceLabel(price, glyph, buffer, maxW / textScale) * textScale;
+}
+
+void renderTickerScreen(const TickerData& ticker, const SparklineData& sparkline, ChartTimeframe timeframe,
+                        bool stale) {
+    RenderLock lock;
+    if (!target) return;
+    TRACE_SCOPE("render");
+    rememberFrame(FRAME_TICKER, &ticker, &sparkline, timeframe, nullptr);
+    if (target == dma_display) lastStale = stale;
+
+    beginFrame();
+
+    // Regions come from the panel geometry (see layout.h); on 64x32:
     //   Row 0-6:   Symbol (left) + Price (right)
     //   Row 8-14:  Change% (left) + Timeframe (right)
     //   Row 16-31: Sparkline (16 rows)
+    const ScreenLayout& L = getScreenLayout();
+    textScale = L.textScale;
 
     // Line 1: Symbol left, Price right
-    drawText(0, 0, ticker.symbol, COLOR_WHITE);
+    const LayoutRect& header = L.header;
+    textClip = header.x + header.w;
+    int symbolEnd = drawText(header.x, header.y, ticker.symbol, COLOR_WHITE);
 
-    char priceStr[16];
-    formatPrice(ticker.currentPrice, priceStr, sizeof(priceStr));
-    int priceW = priceWidth(priceStr);
-    drawPrice(63 - priceW, 0, priceStr, COLOR_WHITE);
+    char priceStr[PRICE_TEXT_LEN + 1];
+    int priceW = formatPrice(ticker.currentPrice, ticker.currency, priceStr, textClip - 1 - symbolEnd);
+    drawPrice(textClip - 1 - priceW, header.y, priceStr, stale ? COLOR_AMBER : COLOR_WHITE);
 
     // Use per-timeframe change% (from CMC API), fallback to 24h
-    const SparklineData& sparkline = ticker.sparklines[timeframe];
     float changePercent = ticker.priceChange[timeframe];
     if (changePercent == 0.0f && timeframe != TIMEFRAME_24H) {
         changePercent = ticker.priceChange24h;
@@ -260,15 +637,16 @@ void renderTickerScreen(const TickerData& ticker, ChartTimeframe timeframe) {
 
     // Line 2: Change% (left, tight 5px advance) + Timeframe (right)
     bool isPositive = changePercent >= 0;
-    uint16_t changeColor = isPositive ? COLOR_GREEN : COLOR_RED;
+    const Rgb& changeColor = isPositive ? COLOR_GREEN : COLOR_RED;
 
     char changeStr[16];
-    snprintf(changeStr, sizeof(changeStr), "%s%.1f%%",
-             isPositive ? "+" : "", changePercent);
+    formatChange(changePercent, changeStr);
 
     // Draw change% with tight spacing around +/- . and %
+    const LayoutRect& sub = L.subheader;
+    textClip = sub.x + sub.w;
     {
-        int cx = 0;
+        int cx = sub.x;
         const char* p = changeStr;
         while (*p) {
             char next = *(p + 1);
@@ -277,52 +655,107 @@ void renderTickerScreen(const TickerData& ticker, ChartTimeframe timeframe) {
             if (*p == '.') adv = 4;                  // dot tight
             if (next == '.' || next == '%') adv = 4; // before dot/% tight
             if (!next) adv = 6;                      // last char
-            if (cx + 5 > 64) break;
-            cx = drawChar(cx, 8, *p, changeColor, adv);
+            if (cx + 5 * textScale > textClip) break;
+            cx = drawChar(cx, sub.y, *p, changeColor, adv);
             p++;
         }
     }
 
     const char* tfLabel = getTimeframeLabel(timeframe);
     int tfW = textWidth(tfLabel);
-    drawText(63 - tfW, 8, tfLabel, changeColor);
+    drawText(textClip - 1 - tfW, sub.y, tfLabel, changeColor);
 
-    // Sparkline: row 16-31 (16 rows)
+    // Sparkline: chart region, one data point per column
     if (sparkline.valid && sparkline.len > 0) {
         drawSparkline(sparkline.points, sparkline.len,
-                     0, 16, 64, 16, isPositive);
+                     L.chart.x, L.chart.y, L.chart.w, L.chart.h, isPositive);
     }
 
-    dma_display->flipDMABuffer();
+    endFrame();
 }
 
 void renderLoadingScreen(const char* message) {
-    if (!dma_display) return;
-    dma_display->clearScreen();
-    drawText(1, 12, message, COLOR_WHITE);
-    dma_display->flipDMABuffer();
+    RenderLock lock;
+    if (!target) return;
+    rememberFrame(FRAME_LOADING, nullptr, nullptr, TIMEFRAME_24H, message);
+    beginFrame();
+    const ScreenLayout& L = getScreenLayout();
+    textScale = L.textScale;
+    textClip = L.width;
+    drawText(L.message.x, L.message.y, message, COLOR_WHITE);
+    endFrame();
+}
+
+void renderAlertScreen(const char* symbol, Price price, const char* detail, bool up, bool flashOn) {
+    RenderLock lock;
+    if (!target) return;
+    TRACE_SCOPE("renderAlert");
+    rememberFrame(FRAME_ALERT, nullptr, nullptr, TIMEFRAME_24H, detail);
+    if (target == dma_display) {
+        if (symbol != lastTicker.symbol) strlcpy(lastTicker.symbol, symbol, sizeof(lastTicker.symbol));
+        lastTicker.currentPrice = price;
+        lastTicker.currency = CURRENCY_USD;
+        lastAlertUp = up;
+        lastAlertFlash = flashOn;
+    }
+
+    beginFrame();
+    const ScreenLayout& L = getScreenLayout();
+    textScale = L.textScale;
+
+    // Flash: alternate a solid background with colored text on black
+    const Rgb& accent = up ? COLOR_GREEN : COLOR_RED;
+    if (flashOn) {
+        target->fillRect(0, 0, L.width, L.height, targetColor(up ? COLOR_DIM_GREEN : COLOR_DIM_RED));
+    }
+    const Rgb& textColor = flashOn ? COLOR_WHITE : accent;
+
+    // Same header as the ticker screen, the rule on the second line
+    const LayoutRect& header = L.header;
+    textClip = header.x + header.w;
+    int symbolEnd = drawText(header.x, header.y, symbol, COLOR_WHITE);
+    char priceStr[PRICE_TEXT_LEN + 1];
+    int priceW = formatPrice(price, CURRENCY_USD, priceStr, textClip - 1 - symbolEnd);
+    drawPrice(textClip - 1 - priceW, header.y, priceStr, COLOR_WHITE);
+
+    const LayoutRect& sub = L.subheader;
+    textClip = sub.x + sub.w;
+    drawText(sub.x, sub.y, detail, textColor);
+
+    // "ALERT" where the chart would be
+    const LayoutRect& chart = L.chart;
+    int lineH = 7 * L.textScale;
+    if (chart.h >= lineH) {
+        textClip = chart.x + chart.w;
+        int w = textWidth("ALERT");
+        drawText(chart.x + (chart.w - w) / 2, chart.y + (chart.h - lineH) / 2, "ALERT", textColor);
+    }
+
+    endFrame();
 }
 
 void renderErrorScreen(const char* message) {
-    if (!dma_display) return;
-    dma_display->clearScreen();
-    drawText(1, 2, "ERROR", COLOR_RED);
-    drawText(1, 16, message, COLOR_WHITE);
-    dma_display->flipDMABuffer();
+    RenderLock lock;
+    if (!target) return;
+    rememberFrame(FRAME_ERROR, nullptr, nullptr, TIMEFRAME_24H, message);
+    beginFrame();
+    const ScreenLayout& L = getScreenLayout();
+    textScale = L.textScale;
+    textClip = L.width;
+    drawText(L.errorTitle.x, L.errorTitle.y, "ERROR", COLOR_RED);
+    drawText(L.errorMessage.x, L.errorMessage.y, message, COLOR_WHITE);
+    endFrame();
 }
 
 void drawSparkline(const uint8_t* data, uint8_t len, int x, int y, int w, int h, bool positive) {
-    if (!dma_display || !data || len == 0 || w == 0 || h == 0) return;
+    if (!target || !data || len == 0 || w == 0 || h == 0) return;
 
     // Line (the curve): full brightness
-    uint16_t lineColor = positive ?
-        dma_display->color565(0, 255, 0) :
-        dma_display->color565(255, 0, 0);
+    const Rgb& lineColor = positive ? COLOR_GREEN : COLOR_RED;
+    uint16_t lineColor565 = targetColor(lineColor);
 
-    // Fill (area under curve): dimmer
-    uint16_t fillColor = positive ?
-        dma_display->color565(0, 128, 0) :
-        dma_display->color565(128, 0, 0);
+    // Fill (area under curve): dimmer, dithered on the panel
+    const Rgb& fillColor = positive ? COLOR_DIM_GREEN : COLOR_DIM_RED;
 
     uint8_t minVal = 255;
     uint8_t maxVal = 0;
@@ -343,7 +776,7 @@ void drawSparkline(const uint8_t* data, uint8_t len, int x, int y, int w, int h,
         int pixelY = y + h - 1 - scaledValue;
 
         for (int fillY = y + h - 1; fillY > pixelY; fillY--) {
-            dma_display->drawPixel(x + i, fillY, fillColor);
+            putPixel(x + i, fillY, fillColor);
         }
     }
 
@@ -356,7 +789,7 @@ void drawSparkline(const uint8_t* data, uint8_t len, int x, int y, int w, int h,
         int pixelY = y + h - 1 - scaledValue;
 
         // Draw data point
-        dma_display->drawPixel(x + i, pixelY, lineColor);
+        putPixel(x + i, pixelY, lineColor);
 
         // Draw connecting line to previous point
         if (i > 0) {
@@ -364,7 +797,7 @@ void drawSparkline(const uint8_t* data, uint8_t len, int x, int y, int w, int h,
             if (prevDataIdx >= len) prevDataIdx = len - 1;
             int prevScaledValue = ((data[prevDataIdx] - minVal) * (h - 1)) / range;
             int prevPixelY = y + h - 1 - prevScaledValue;
-            dma_display->drawLine(x + i - 1, prevPixelY, x + i, pixelY, lineColor);
+            target->drawLine(x + i - 1, prevPixelY, x + i, pixelY, lineColor565);
         }
     }
 }
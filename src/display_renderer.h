@@ -2,8 +2,43 @@
 
 #include <ESP32-HUB75-MatrixPanel-I2S-DMA.h>
 #include "ticker_types.h"
+#include "config.h"
 
-// Initialize the display hardware
+// Every depth plus the single-buffered fallback
+#define DISPLAY_PROBE_SLOTS (DISPLAY_MAX_COLOR_DEPTH - DISPLAY_MIN_COLOR_DEPTH + 2)
+
+// One configuration tried by the display quality controller
+struct DisplayProbe {
+    uint8_t depth;           // Bits per channel
+    bool doubleBuffered;
+    bool started;            // False if skipped as over budget or begin() failed
+    uint16_t refreshHz;      // Panel refresh at this depth
+    uint32_t dmaBytes;       // DMA-capable heap taken by the panel buffers
+    uint32_t estimatedBytes; // Pre-start estimate checked against the budget
+};
+
+// Chosen display configuration and what each probed depth cost
+struct DisplayQuality {
+    uint16_t width;        // Whole chain, in pixels
+    uint16_t height;
+    uint8_t chain;         // Panel modules, left to right
+    uint8_t colorDepth;    // 0 if the panel never started
+    bool doubleBuffered;
+    uint16_t refreshHz;
+    uint32_t dmaBytes;
+    uint32_t dmaBudget;    // Limit the depth was chosen under
+    uint16_t minRefreshHz; // Flicker floor the depth was chosen against
+    bool panelOn;          // False while blanked by setDisplayPower()
+    uint16_t ditherFps;    // Temporal dither redraw rate (0 = spatial only)
+    float gamma;
+    int probeCount;
+    DisplayProbe probes[DISPLAY_PROBE_SLOTS];
+};
+
+// Initialize the display hardware (PANEL_CHAIN modules of
+// PANEL_WIDTH x PANEL_HEIGHT). Probes color depths from
+// DISPLAY_MAX_COLOR_DEPTH down and keeps the deepest one that fits the DMA
+// budget and refreshes at DISPLAY_MIN_REFRESH_HZ or faster.
 bool initDisplay(uint8_t brightness);
 
 // Set brightness (0-255)
@@ -17,7 +52,12 @@ MatrixPanel_I2S_DMA* getDisplay();
 //   Row 0-6:   Symbol (left) + Price (right)
 //   Row 8-14:  Change% (left, tight) + Timeframe (right)
 //   Row 16-31: Sparkline chart (64 wide x 16 tall)
-void renderTickerScreen(const TickerData& ticker, ChartTimeframe timeframe);
+// Larger displays scale and rearrange these regions (see layout.h)
+// sparkline is the chart for this timeframe (see sparkline_store.h)
+// stale: draw the price in amber (data older than its threshold, see data_age.h)
+// Prices are shown in ticker.currency (see fx_rates.h for the conversion)
+void renderTickerScreen(const TickerData& ticker, const SparklineData& sparkline, ChartTimeframe timeframe,
+                        bool stale = false);
 
 // Render a "loading" screen
 void renderLoadingScreen(const char* message);
@@ -25,6 +65,10 @@ void renderLoadingScreen(const char* message);
 // Render an error screen
 void renderErrorScreen(const char* message);
 
+// Render a price alert: symbol + price, the rule that fired (e.g.
+// "ABOVE 70000") and a banner. Call with flashOn alternating to flash it.
+void renderAlertScreen(const char* symbol, Price price, const char* detail, bool up, bool flashOn);
+
 // Draw a sparkline chart
 // data: array of uint8_t values (0 = bottom, max = top)
 // x, y: top-left corner of chart area
@@ -34,3 +78,35 @@ void drawSparkline(const uint8_t* data, uint8_t len, int x, int y, int w, int h,
 
 // Clear the display
 void clearDisplay();
+
+// Keep the current frame up for ms. While waiting, the frame is redrawn at
+// DISPLAY_DITHER_FPS with a new dither phase so dim colors average out to
+// their gamma-correct level instead of collapsing to one bit-depth step.
+// Returns false if wakeDisplay() cut the wait short.
+bool holdFrame(uint32_t ms);
+
+// Wake the task in holdFrame() (any task; used when an alert fires)
+void wakeDisplay();
+
+// Blank the panel and stop DMA refresh (quiet hours), or bring it back at
+// the selected depth and redraw the last frame
+void setDisplayPower(bool on);
+bool isDisplayOn();
+
+// Selected color depth, refresh rate and DMA use (for /api/status)
+DisplayQuality getDisplayQuality();
+
+// Redirect rendering into an offscreen canvas (see frame_capture.h).
+// Holds the render lock until endCapture(), so the display loop cannot
+// draw into the canvas or interleave with a captured frame.
+void beginCapture(Adafruit_GFX* canvas);
+void endCapture();
+
+// Changes whenever a different frame reaches the panel (new screen, clear,
+// power change); temporal dither redraws of the same frame keep it
+uint32_t getShownFrameSerial();
+
+// Re-render the frame the panel is showing into canvas (plain RGB565, no
+// dither, black while the panel is off). Returns the serial it matches.
+// Holds the render lock for one frame's draw time.
+uint32_t captureShownFrame(Adafruit_GFX* canvas);
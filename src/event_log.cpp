@@ -0,0 +1,323 @@
+#include "event_log.h"
+#include "api_client.h"
+#include "provider_health.h"
+#include <freertos/FreeRTOS.h>
+#include <atomic>
+
+struct LogEventInfo {
+  const char* tag;
+  LogLevel level;
+  const char* format;
+};
+
+// Indexed by LogEventId
+static const LogEventInfo eventInfo[] = {
+  { "API",     LOG_INFO,  "Client initialized" },
+  { "API",     LOG_INFO,  "CoinGecko API key set" },
+  { "API",     LOG_INFO,  "CMC API key set" },
+  { "API",     LOG_WARN,  "%P: no ids or API key" },
+  { "API",     LOG_INFO,  "CMC fetching: %s" },
+  { "API",     LOG_INFO,  "Fetching crypto prices: %s" },
+  { "API",     LOG_INFO,  "Fetching chart for %s (%dd)" },
+  { "API",     LOG_INFO,  "Fetching stock price: %s" },
+  { "API",     LOG_INFO,  "Fetching stock chart: %s (%d points)" },
+  { "API",     LOG_WARN,  "%P HTTP error: %d" },
+  { "API",     LOG_WARN,  "%P JSON parse error: %s" },
+  { "API",     LOG_WARN,  "CMC API error %d: %s" },
+  { "API",     LOG_DEBUG, "CMC %s: $%.2f (24h:%.1f%% 7d:%.1f%% 30d:%.1f%% 90d:%.1f%%)" },
+  { "API",     LOG_INFO,  "CMC credits used: %d" },
+  { "API",     LOG_DEBUG, "Updated %s: $%.2f (%.2f%%)" },
+  { "API",     LOG_DEBUG, "%s price: $%.2f" },
+  { "API",     LOG_WARN,  "No price field in response for %s" },
+  { "API",     LOG_WARN,  "%P: insufficient chart data (%d points)" },
+  { "API",     LOG_ERROR, "%P fetch arena exhausted" },
+  { "API",     LOG_DEBUG, "Chart data: %d points, range $%.2f - $%.2f" },
+  { "API",     LOG_WARN,  "%P gzip body: %s" },
+  { "API",     LOG_DEBUG, "%P %s: %u bytes read, %u parsed, %ums" },
+
+  { "DataMgr", LOG_INFO,  "Initialized" },
+  { "DataMgr", LOG_INFO,  "Forced refresh scheduled" },
+  { "DataMgr", LOG_DEBUG, "Loaded cached sparkline: %s tf=%d" },
+  { "DataMgr", LOG_INFO,  "%P: fetching %d crypto tickers" },
+  { "DataMgr", LOG_INFO,  "Fetching stock: %s" },
+  { "DataMgr", LOG_INFO,  "Fetching sparkline for %s (%dd)" },
+  { "DataMgr", LOG_INFO,  "Updated %d crypto tickers in %ums" },
+  { "DataMgr", LOG_DEBUG, "Updated %s: $%.2f" },
+  { "DataMgr", LOG_WARN,  "Failed to fetch %s" },
+  { "DataMgr", LOG_DEBUG, "Updated + cached sparkline for %s (%dd)" },
+  { "DataMgr", LOG_WARN,  "Failed to fetch sparkline for %s (%dd)" },
+  { "DataMgr", LOG_DEBUG, "%s %dd change: %.1f%%" },
+  { "DataMgr", LOG_INFO,  "%s market open" },
+  { "DataMgr", LOG_INFO,  "%s market closed, reopens in %u min" },
+  { "DataMgr", LOG_INFO,  "Fetching %s for the display currency" },
+  { "DataMgr", LOG_DEBUG, "Rate %s: %.5f" },
+
+  { "Fetch",   LOG_INFO,  "Engine started" },
+  { "Fetch",   LOG_WARN,  "%P job expired before start" },
+  { "Fetch",   LOG_WARN,  "%P queue full" },
+  { "Health",  LOG_WARN,  "%P circuit open for %us (HTTP %d)" },
+  { "Relay",   LOG_INFO,  "Node %08x listening (watchlist %08x)" },
+  { "Relay",   LOG_WARN,  "Multicast listen failed, fetching locally" },
+  { "Relay",   LOG_INFO,  "Yielding to leader %08x" },
+  { "Relay",   LOG_WARN,  "No leader heard, taking over fetching" },
+  { "Relay",   LOG_INFO,  "Stopped" },
+
+  { "Display", LOG_INFO,  "%d-bit: %uHz, %u DMA bytes" },
+  { "Display", LOG_INFO,  "Using %d-bit color at %uHz (floor %uHz)" },
+  { "Display", LOG_ERROR, "Panel init failed at %d-bit" },
+  { "Display", LOG_INFO,  "%d-bit skipped: ~%u DMA bytes over budget %u" },
+
+  { "Power",   LOG_DEBUG, "State %s, CPU %dMHz" },
+  { "Power",   LOG_INFO,  "Quiet hours %s, fetch intervals x%d" },
+
+  { "OTA",     LOG_INFO,  "%s update started (%u bytes)" },
+  { "OTA",     LOG_WARN,  "Upload resumed at %u bytes (resume %u)" },
+  { "OTA",     LOG_INFO,  "%s verified: %u bytes from %u uploaded in %ums" },
+  { "OTA",     LOG_ERROR, "Update failed: %s (%u bytes in, %u written)" },
+
+  { "Store",   LOG_INFO,  "Sparklines cached in %s, %d tickers resident" },
+
+  { "Alert",   LOG_INFO,  "%d rules active" },
+  { "Alert",   LOG_WARN,  "%s at $%.2f" },
+  { "Alert",   LOG_INFO,  "%s on screen %ums after the price arrived" },
+
+  { "Stream",  LOG_INFO,  "Connected to %s, %d pairs" },
+  { "Stream",  LOG_WARN,  "Dropped: %s, retry in %ums" },
+};
+
+static_assert(sizeof(eventInfo) / sizeof(eventInfo[0]) == EV_COUNT, "eventInfo must cover every LogEventId");
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "LOG_RING_SIZE must be a power of two");
+
+// Ring slot. seq is 0 while empty or being written, and seq+1 of the event
+// once published; readers check it before and after copying (seqlock).
+struct LogEntry {
+  std::atomic<uint32_t> seq;
+  uint32_t timeMs;
+  uint16_t id;
+  uint8_t core;
+  uint8_t suppressed;
+  uint32_t args[LOG_MAX_ARGS];
+  char text[LOG_TEXT_LEN];
+};
+
+static LogEntry ring[LOG_RING_SIZE];
+static std::atomic<uint32_t> head(0);
+static std::atomic<uint32_t> suppressedTotal(0);
+
+// Record cost, in hundredths of a microsecond (the sum wraps after a few
+// million events)
+static std::atomic<uint32_t> recordUs100(0);
+static std::atomic<uint32_t> recordMaxUs100(0);
+static std::atomic<uint32_t> mirrorUs100(0);
+static std::atomic<uint32_t> mirrorCount(0);
+
+// Converted per sample: the power manager changes the CPU clock at runtime,
+// so a cycle count only has a duration at the clock it was taken at
+static uint32_t cyclesToUs100(uint32_t cycles) {
+  uint32_t mhz = ESP.getCpuFreqMHz();
+  return mhz ? (uint32_t)((uint64_t)cycles * 100 / mhz) : 0;
+}
+
+// Fixed window per call site. Sites shared between tasks may let a few
+// extra events through; the limit only has to stop runaway loops.
+static bool siteAllows(LogSite* site, uint8_t* outSuppressed) {
+  uint32_t now = millis();
+  if (now - site->windowStart >= LOG_SITE_WINDOW_MS) {
+    site->windowStart = now;
+    site->count = 0;
+  }
+  if (site->count >= LOG_SITE_BURST) {
+    if (site->suppressed < UINT16_MAX) site->suppressed++;
+    suppressedTotal++;
+    return false;
+  }
+  site->count++;
+  *outSuppressed = site->suppressed > 255 ? 255 : site->suppressed;
+  site->suppressed = 0;
+  return true;
+}
+
+void logEventRecord(LogSite* site, LogEventId id, const char* text,
+                    LogArg a0, LogArg a1, LogArg a2, LogArg a3, LogArg a4) {
+  uint32_t t0 = ESP.getCycleCount();
+
+  uint8_t suppressed = 0;
+  if (id >= EV_COUNT || !siteAllows(site, &suppressed)) return;
+
+  uint32_t seq = head++;
+  LogEntry& e = ring[seq & (LOG_RING_SIZE - 1)];
+
+  e.seq.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  e.timeMs = millis();
+  e.id = id;
+  e.core = (uint8_t)xPortGetCoreID();
+  e.suppressed = suppressed;
+  e.args[0] = a0.bits;
+  e.args[1] = a1.bits;
+  e.args[2] = a2.bits;
+  e.args[3] = a3.bits;
+  e.args[4] = a4.bits;
+  if (text) {
+    strlcpy(e.text, text, LOG_TEXT_LEN);
+  } else {
+    e.text[0] = '\0';
+  }
+  e.seq.store(seq + 1, std::memory_order_release);
+
+  uint32_t us100 = cyclesToUs100(ESP.getCycleCount() - t0);
+  recordUs100 += us100;
+  uint32_t prevMax = recordMaxUs100;
+  while (us100 > prevMax && !recordMaxUs100.compare_exchange_weak(prevMax, us100)) {}
+
+#if LOG_SERIAL_MIRROR
+  // Old-style console output, timed separately so both costs can be compared
+  uint32_t m0 = ESP.getCycleCount();
+  LogRecord rec;
+  if (readLogRecord(seq, &rec)) {
+    char line[160];
+    formatLogRecord(rec, line, sizeof(line));
+    Serial.println(line);
+  }
+  mirrorUs100 += cyclesToUs100(ESP.getCycleCount() - m0);
+  mirrorCount++;
+#endif
+}
+
+uint32_t logHeadSeq() {
+  return head;
+}
+
+bool readLogRecord(uint32_t seq, LogRecord* out) {
+  const LogEntry& e = ring[seq & (LOG_RING_SIZE - 1)];
+  uint32_t before = e.seq.load(std::memory_order_acquire);
+  if (before != seq + 1) return false;
+
+  out->seq = seq;
+  out->timeMs = e.timeMs;
+  out->id = (LogEventId)e.id;
+  out->core = e.core;
+  out->suppressed = e.suppressed;
+  memcpy(out->args, e.args, sizeof(out->args));
+  memcpy(out->text, e.text, sizeof(out->text));
+  out->text[LOG_TEXT_LEN - 1] = '\0';
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return e.seq.load(std::memory_order_relaxed) == before && out->id < EV_COUNT;
+}
+
+LogLevel getLogLevel(LogEventId id) {
+  return id < EV_COUNT ? eventInfo[id].level : LOG_ERROR;
+}
+
+// Append to buf at *pos, keeping room for the terminator
+static void appendFormatted(char* buf, size_t len, size_t* pos, int written) {
+  if (written <= 0) return;
+  size_t room = len - *pos - 1;
+  *pos += (size_t)written < room ? (size_t)written : room;
+}
+
+size_t formatLogRecord(const LogRecord& rec, char* buf, size_t len) {
+  if (len == 0) return 0;
+  const LogEventInfo& info = eventInfo[rec.id < EV_COUNT ? rec.id : 0];
+  size_t pos = 0;
+  int argIndex = 0;
+
+  appendFormatted(buf, len, &pos, snprintf(buf, len, "[%s] ", info.tag));
+
+  for (const char* f = info.format; *f && pos + 1 < len; ) {
+    if (*f != '%') {
+      buf[pos++] = *f++;
+      continue;
+    }
+
+    // Copy one conversion spec ("%.2f", "%08x", ...) and apply it to the next argument
+    char spec[12];
+    size_t n = 0;
+    spec[n++] = *f++;
+    while (*f && strchr("-+ #0123456789.", *f) && n < sizeof(spec) - 2) spec[n++] = *f++;
+    char conv = *f ? *f++ : '\0';
+    spec[n++] = conv;
+    spec[n] = '\0';
+
+    uint32_t arg = argIndex < LOG_MAX_ARGS ? rec.args[argIndex] : 0;
+    char* dst = buf + pos;
+    size_t room = len - pos;
+    int written = 0;
+
+    switch (conv) {
+      case '%':
+        written = snprintf(dst, room, "%%");
+        break;
+      case 's':
+        written = snprintf(dst, room, spec, rec.text);
+        break;
+      case 'P':
+        spec[n - 1] = 's';
+        written = snprintf(dst, room, spec, arg < PROVIDER_COUNT ? getProviderName((ApiProvider)arg) : "?");
+        argIndex++;
+        break;
+      case 'f': case 'e': case 'g': {
+        float v;
+        memcpy(&v, &arg, sizeof(v));
+        written = snprintf(dst, room, spec, (double)v);
+        argIndex++;
+        break;
+      }
+      case 'd': case 'i':
+        written = snprintf(dst, room, spec, (int)(int32_t)arg);
+        argIndex++;
+        break;
+      case 'u': case 'x': case 'X':
+        written = snprintf(dst, room, spec, (unsigned)arg);
+        argIndex++;
+        break;
+      default:
+        break;
+    }
+    appendFormatted(buf, len, &pos, written);
+  }
+
+  if (rec.suppressed && pos + 1 < len) {
+    appendFormatted(buf, len, &pos,
+                    snprintf(buf + pos, len - pos, " (+%u suppressed)", (unsigned)rec.suppressed));
+  }
+
+  buf[pos] = '\0';
+  return pos;
+}
+
+uint32_t writeLogText(Print& out, uint32_t since, LogLevel minLevel) {
+  static const char levelChars[] = "DIWE";
+  uint32_t end = head;
+
+  // Older events have been overwritten
+  uint32_t start = since;
+  if (end - start > LOG_RING_SIZE) start = end - LOG_RING_SIZE;
+
+  char line[160];
+  LogRecord rec;
+  for (uint32_t seq = start; seq != end; seq++) {
+    if (!readLogRecord(seq, &rec)) continue;
+    if (getLogLevel(rec.id) < minLevel) continue;
+    out.printf("%10lu.%03lu %c c%u ", (unsigned long)(rec.timeMs / 1000), (unsigned long)(rec.timeMs % 1000),
+               levelChars[getLogLevel(rec.id)], (unsigned)rec.core);
+    formatLogRecord(rec, line, sizeof(line));
+    out.print(line);
+    out.print("\n");
+  }
+  return end;
+}
+
+LogStats getLogStats() {
+  LogStats s;
+  uint32_t recorded = head;
+  s.recorded = recorded;
+  s.suppressed = suppressedTotal;
+  s.overwritten = recorded > LOG_RING_SIZE ? recorded - LOG_RING_SIZE : 0;
+  s.avgRecordUs100 = recorded ? recordUs100 / recorded : 0;
+  s.maxRecordUs100 = recordMaxUs100;
+  uint32_t mirrored = mirrorCount;
+  s.avgMirrorUs100 = mirrored ? mirrorUs100 / mirrored : 0;
+  return s;
+}
@@ -0,0 +1,175 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// Structured event log.
+// A call site records an event id plus a few 32-bit arguments into a
+// lock-free RAM ring; nothing is formatted (and nothing touches the UART)
+// until the log is read through GET /api/logs. Every call site is
+// rate-limited on its own, so one failing loop cannot flush the ring.
+//
+//   LOG_EVENT(EV_API_HTTP_ERROR, nullptr, PROVIDER_CMC, httpCode);
+//
+// Formats live in a table in event_log.cpp. They use printf conversions
+// taken from the arguments in order, plus:
+//   %s  the event's inline text (copied at record time, LOG_TEXT_LEN max)
+//   %P  an ApiProvider argument, printed as the provider name
+
+enum LogEventId : uint16_t {
+  // api_client
+  EV_API_INIT,
+  EV_API_CG_KEY_SET,
+  EV_API_CMC_KEY_SET,
+  EV_API_NO_IDS,
+  EV_API_CMC_FETCH,
+  EV_API_CG_FETCH,
+  EV_API_CHART_FETCH,
+  EV_API_STOCK_FETCH,
+  EV_API_STOCK_CHART_FETCH,
+  EV_API_HTTP_ERROR,
+  EV_API_PARSE_ERROR,
+  EV_API_CMC_ERROR,
+  EV_API_CMC_QUOTE,
+  EV_API_CMC_CREDITS,
+  EV_API_CG_QUOTE,
+  EV_API_STOCK_QUOTE,
+  EV_API_NO_PRICE,
+  EV_API_NO_CHART_DATA,
+  EV_API_ARENA_EXHAUSTED,
+  EV_API_CHART_DATA,
+  EV_API_GZIP_ERROR,
+  EV_API_BODY,
+
+  // data_manager
+  EV_DM_INIT,
+  EV_DM_FORCE_REFRESH,
+  EV_DM_CACHE_LOADED,
+  EV_DM_CRYPTO_FETCH,
+  EV_DM_STOCK_FETCH,
+  EV_DM_SPARKLINE_FETCH,
+  EV_DM_CRYPTO_UPDATED,
+  EV_DM_STOCK_UPDATED,
+  EV_DM_STOCK_FAILED,
+  EV_DM_SPARKLINE_UPDATED,
+  EV_DM_SPARKLINE_FAILED,
+  EV_DM_CHANGE,
+  EV_DM_MARKET_OPEN,
+  EV_DM_MARKET_CLOSED,
+  EV_DM_FX_FETCH,
+  EV_DM_FX_UPDATED,
+
+  // fetch_engine / provider_health / lan_relay
+  EV_FETCH_STARTED,
+  EV_FETCH_EXPIRED,
+  EV_FETCH_QUEUE_FULL,
+  EV_HEALTH_OPEN,
+  EV_RELAY_LISTENING,
+  EV_RELAY_LISTEN_FAILED,
+  EV_RELAY_YIELD,
+  EV_RELAY_TAKEOVER,
+  EV_RELAY_STOPPED,
+
+  // display_renderer
+  EV_DISPLAY_PROBE,
+  EV_DISPLAY_SELECTED,
+  EV_DISPLAY_FAILED,
+  EV_DISPLAY_OVER_BUDGET,
+
+  // power_manager
+  EV_POWER_STATE,
+  EV_POWER_QUIET,
+
+  // ota_update
+  EV_OTA_BEGIN,
+  EV_OTA_RESUMED,
+  EV_OTA_DONE,
+  EV_OTA_FAILED,
+
+  // sparkline_store
+  EV_STORE_INIT,
+
+  // alert_engine
+  EV_ALERT_RULES,
+  EV_ALERT_FIRED,
+  EV_ALERT_SHOWN,
+
+  // market_stream
+  EV_STREAM_CONNECTED,
+  EV_STREAM_DROPPED,
+
+  EV_COUNT
+};
+
+enum LogLevel : uint8_t {
+  LOG_DEBUG = 0,   // Per-ticker detail
+  LOG_INFO  = 1,
+  LOG_WARN  = 2,
+  LOG_ERROR = 3
+};
+
+// One argument slot; floats are stored as their bit pattern
+struct LogArg {
+  uint32_t bits;
+  LogArg(int v) : bits((uint32_t)v) {}
+  LogArg(unsigned v) : bits(v) {}
+  LogArg(long v) : bits((uint32_t)v) {}
+  LogArg(unsigned long v) : bits((uint32_t)v) {}
+  LogArg(float v) { memcpy(&bits, &v, sizeof(bits)); }
+  LogArg(double v) { float f = (float)v; memcpy(&bits, &f, sizeof(bits)); }
+};
+
+// Per-call-site rate limiter state (one static instance per LOG_EVENT)
+struct LogSite {
+  uint32_t windowStart;
+  uint16_t count;
+  uint16_t suppressed;   // Dropped since the last recorded event
+};
+
+// A published event, as copied out by readers
+struct LogRecord {
+  uint32_t seq;
+  uint32_t timeMs;
+  LogEventId id;
+  uint8_t core;
+  uint8_t suppressed;    // Events this site dropped just before this one (saturates at 255)
+  uint32_t args[LOG_MAX_ARGS];
+  char text[LOG_TEXT_LEN];
+};
+
+struct LogStats {
+  uint32_t recorded;       // Events written to the ring since boot
+  uint32_t suppressed;     // Events dropped by call-site rate limits
+  uint32_t overwritten;    // Events lost to ring wrap-around
+  uint32_t avgRecordUs100; // Mean record cost, hundredths of a microsecond
+  uint32_t maxRecordUs100;
+  uint32_t avgMirrorUs100; // Mean format + Serial cost (LOG_SERIAL_MIRROR builds only)
+};
+
+#define LOG_EVENT(id, text, ...) \
+  do { \
+    static LogSite logSite_; \
+    logEventRecord(&logSite_, (id), (text), ##__VA_ARGS__); \
+  } while (0)
+
+// Record an event (use LOG_EVENT). Safe from any task; never blocks.
+void logEventRecord(LogSite* site, LogEventId id, const char* text,
+                    LogArg a0 = LogArg(0), LogArg a1 = LogArg(0), LogArg a2 = LogArg(0),
+                    LogArg a3 = LogArg(0), LogArg a4 = LogArg(0));
+
+// Sequence number the next event will get
+uint32_t logHeadSeq();
+
+// Copy out event seq. Returns false if it was overwritten or is still being written.
+bool readLogRecord(uint32_t seq, LogRecord* out);
+
+// Format one record as a "[Tag] message" line (no newline)
+size_t formatLogRecord(const LogRecord& rec, char* buf, size_t len);
+
+// Level of an event id
+LogLevel getLogLevel(LogEventId id);
+
+// Write retained events with seq >= since as text lines, oldest first.
+// Returns the sequence number to pass as `since` on the next read.
+uint32_t writeLogText(Print& out, uint32_t since, LogLevel minLevel);
+
+LogStats getLogStats();
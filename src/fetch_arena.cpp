@@ -0,0 +1,77 @@
+#include "fetch_arena.h"
+
+// Each block is preceded by its size so reallocate() can copy the old
+// contents; only the most recent block can grow in place or be freed
+struct BlockHeader {
+  size_t size;
+};
+
+static inline size_t alignUp(size_t n) {
+  return (n + 7) & ~(size_t)7;
+}
+
+static const size_t HEADER_SIZE = alignUp(sizeof(BlockHeader));
+static const size_t NO_BLOCK = (size_t)-1;
+
+FetchArena::FetchArena(uint8_t* buffer, size_t capacity)
+  : base(buffer), cap(capacity), top(0), last(NO_BLOCK), peak(0), failed(0) {}
+
+void FetchArena::reset() {
+  top = 0;
+  last = NO_BLOCK;
+}
+
+void FetchArena::rewind(size_t mark) {
+  if (mark >= top) return;
+  top = mark;
+  last = NO_BLOCK;
+}
+
+void* FetchArena::alloc(size_t size) {
+  size_t need = HEADER_SIZE + alignUp(size);
+  if (top + need > cap) {
+    failed++;
+    return nullptr;
+  }
+  BlockHeader* hdr = (BlockHeader*)(base + top);
+  hdr->size = size;
+  last = top;
+  top += need;
+  if (top > peak) peak = top;
+  return base + last + HEADER_SIZE;
+}
+
+void* FetchArena::allocate(size_t size) {
+  return alloc(size);
+}
+
+void FetchArena::deallocate(void* ptr) {
+  // Only the newest block is actually released; the rest goes on reset()
+  if (ptr && last != NO_BLOCK && (uint8_t*)ptr == base + last + HEADER_SIZE) {
+    top = last;
+    last = NO_BLOCK;
+  }
+}
+
+void* FetchArena::reallocate(void* ptr, size_t newSize) {
+  if (!ptr) return alloc(newSize);
+
+  BlockHeader* hdr = (BlockHeader*)((uint8_t*)ptr - HEADER_SIZE);
+
+  // Newest block: grow or shrink in place
+  if (last != NO_BLOCK && (uint8_t*)hdr == base + last) {
+    size_t newTop = last + HEADER_SIZE + alignUp(newSize);
+    if (newTop > cap) {
+      failed++;
+      return nullptr;
+    }
+    hdr->size = newSize;
+    top = newTop;
+    if (top > peak) peak = top;
+    return ptr;
+  }
+
+  void* moved = alloc(newSize);
+  if (moved) memcpy(moved, ptr, min(hdr->size, newSize));
+  return moved;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Fixed, preallocated bump arena for one fetch.
+// Holds the JsonDocument pool (through ArduinoJson's Allocator interface),
+// the response filter and any scratch arrays. reset() at the start of every
+// request returns it to empty, so steady-state fetching never touches the
+// general heap and cannot fragment it.
+class FetchArena : public ArduinoJson::Allocator {
+public:
+  FetchArena(uint8_t* buffer, size_t capacity);
+
+  // Drop everything allocated since the last reset
+  void reset();
+
+  // Drop everything allocated after mark (an earlier used() value), e.g.
+  // one array element's document when a response is parsed piecewise
+  void rewind(size_t mark);
+
+  // Raw scratch allocation (nullptr when the arena is exhausted)
+  void* alloc(size_t size);
+
+  // ArduinoJson::Allocator
+  void* allocate(size_t size) override;
+  void deallocate(void* ptr) override;
+  void* reallocate(void* ptr, size_t newSize) override;
+
+  size_t used() const { return top; }
+  size_t capacity() const { return cap; }
+  size_t highWater() const { return peak; }
+  uint32_t failures() const { return failed; }
+
+private:
+  uint8_t* base;
+  size_t cap;
+  size_t top;       // Offset of the next free byte
+  size_t last;      // Offset of the most recent block's header (for in-place growth)
+  size_t peak;
+  uint32_t failed;
+};
@@ -0,0 +1,265 @@
+#include "fetch_engine.h"
+#include "config.h"
+#include "provider_health.h"
+#include "event_log.h"
+#include "app_clock.h"
+#include "trace.h"
+#include "fetch_events.h"
+#if SIM_BUILD
+#include "simulator.h"
+#endif
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <atomic>
+
+static FetchJob jobs[FETCH_MAX_JOBS];
+static QueueHandle_t providerQueues[PROVIDER_COUNT] = {};
+static QueueHandle_t completionQueue = nullptr;
+static std::atomic<uint32_t> generation(0);
+static std::atomic<int> inFlight[PROVIDER_COUNT];
+static std::atomic<uint32_t> largestBlockLow(UINT32_MAX);
+
+#if TRACE_ENABLED
+static const char* jobSpans[PROVIDER_COUNT] = { "cmc.job", "coingecko.job", "twelvedata.job" };
+#endif
+
+ApiProvider fetchProvider(FetchKind kind) {
+  switch (kind) {
+    case FETCH_CMC_PRICES:       return PROVIDER_CMC;
+    case FETCH_COINGECKO_PRICES: return PROVIDER_COINGECKO;
+    case FETCH_CRYPTO_CHART:     return PROVIDER_COINGECKO;
+    case FETCH_STOCK_PRICE:      return PROVIDER_TWELVEDATA;
+    case FETCH_STOCK_CHART:      return PROVIDER_TWELVEDATA;
+    default:                     return PROVIDER_COINGECKO;
+  }
+}
+
+static void finishJob(FetchJob* job, FetchOutcome outcome) {
+  ApiProvider provider = fetchProvider(job->kind);
+  job->outcome = (job->generation != generation) ? FETCH_CANCELLED : outcome;
+  job->finishedAt = appMillis();
+  job->state = FETCH_DONE;
+  inFlight[provider]--;
+  xQueueSend(completionQueue, &job, portMAX_DELAY);
+  signalFetchTask(FETCH_EVENT_WORK);
+}
+
+static bool runJob(FetchJob* job, uint32_t timeoutMs) {
+  switch (job->kind) {
+    case FETCH_CMC_PRICES:
+      job->updated = fetchCMCPrices(job->ids, job->quotes, job->numTickers, timeoutMs);
+      return job->updated > 0;
+    case FETCH_COINGECKO_PRICES:
+      job->updated = fetchCryptoPrices(job->ids, job->quotes, job->numTickers, job->charts, timeoutMs);
+      return job->updated > 0;
+    case FETCH_CRYPTO_CHART:
+      return fetchCryptoChart(job->ids, job->days, &job->sparkline, timeoutMs);
+    case FETCH_STOCK_PRICE:
+      return fetchStockPrice(job->ids, job->apiKey, &job->price, timeoutMs);
+    case FETCH_STOCK_CHART:
+      return fetchStockChart(job->ids, job->apiKey, job->interval, job->days, &job->sparkline, timeoutMs);
+  }
+  return false;
+}
+
+// One worker per provider: takes jobs off its queue and runs them in order.
+// Blocking inside a worker only delays that provider's own queue.
+static void providerWorker(void* param) {
+  ApiProvider provider = (ApiProvider)(uintptr_t)param;
+  uint32_t lastRequestAt = 0;
+
+  while (true) {
+    FetchJob* job = nullptr;
+    if (xQueueReceive(providerQueues[provider], &job, portMAX_DELAY) != pdTRUE) continue;
+
+    if (job->generation != generation) {
+      finishJob(job, FETCH_CANCELLED);
+      continue;
+    }
+
+    // Circuit open: fail fast without spending a TLS handshake
+    if (!providerAllowsRequest(provider)) {
+      finishJob(job, FETCH_REJECTED);
+      continue;
+    }
+
+    // Pace requests to the same host without holding up other providers
+    uint32_t sinceLast = appMillis() - lastRequestAt;
+    if (lastRequestAt != 0 && sinceLast < FETCH_PROVIDER_SPACING_MS) {
+      vTaskDelay(pdMS_TO_TICKS(FETCH_PROVIDER_SPACING_MS - sinceLast));
+    }
+
+    // A TLS session needs a large contiguous block; wait for another
+    // provider to finish rather than failing the handshake
+    if (ESP.getMaxAllocHeap() < FETCH_MIN_TLS_HEAP) {
+      TRACE_SCOPE("tlsHeapWait");
+      while (ESP.getMaxAllocHeap() < FETCH_MIN_TLS_HEAP && (int32_t)(job->deadline - appMillis()) > 0) {
+        vTaskDelay(pdMS_TO_TICKS(50));
+      }
+    }
+
+    int32_t remaining = (int32_t)(job->deadline - appMillis());
+    if (remaining <= 0) {
+      LOG_EVENT(EV_FETCH_EXPIRED, nullptr, provider);
+      finishJob(job, FETCH_EXPIRED);
+      continue;
+    }
+
+    job->state = FETCH_RUNNING;
+    job->startedAt = appMillis();
+    TRACE_BEGIN(jobSpans[provider]);
+    bool ok = runJob(job, (uint32_t)remaining);
+    TRACE_END(jobSpans[provider]);
+    lastRequestAt = appMillis();
+
+    // Fragmentation drift shows up as a falling largest-free-block floor
+    uint32_t largest = ESP.getMaxAllocHeap();
+    TRACE_COUNTER("heap.largestBlock", largest);
+    if (largest < largestBlockLow) largestBlockLow = largest;
+
+    finishJob(job, ok ? FETCH_OK : FETCH_FAILED);
+  }
+}
+
+#if SIM_BUILD
+// Simulation: jobs run inline against the fixture transport and are handed
+// back once the virtual clock passes their simulated completion time
+static bool simReported[FETCH_MAX_JOBS];
+
+static void simRunJob(FetchJob* job) {
+  ApiProvider provider = fetchProvider(job->kind);
+  job->state = FETCH_RUNNING;
+  job->startedAt = appMillis();
+  uint32_t latency = 0;
+
+  if (!providerAllowsRequest(provider)) {
+    job->outcome = FETCH_REJECTED;
+  } else {
+    job->outcome = runJob(job, job->timeoutMs) ? FETCH_OK : FETCH_FAILED;
+    latency = simLastLatency(provider);
+  }
+
+  job->finishedAt = job->startedAt + latency;
+  simReported[job - jobs] = false;
+  job->state = FETCH_DONE;
+}
+#endif
+
+void initFetchEngine() {
+  if (completionQueue) return;
+
+  initProviderHealth();
+
+#if SIM_BUILD
+  for (int i = 0; i < FETCH_MAX_JOBS; i++) {
+    jobs[i].state = FETCH_IDLE;
+  }
+  // Non-null marks the engine as started; no workers are needed
+  completionQueue = xQueueCreate(1, sizeof(FetchJob*));
+  return;
+#endif
+
+  for (int i = 0; i < FETCH_MAX_JOBS; i++) {
+    jobs[i].state = FETCH_IDLE;
+  }
+
+  completionQueue = xQueueCreate(FETCH_MAX_JOBS, sizeof(FetchJob*));
+
+  for (int p = 0; p < PROVIDER_COUNT; p++) {
+    providerQueues[p] = xQueueCreate(FETCH_QUEUE_DEPTH, sizeof(FetchJob*));
+
+    char name[16];
+    snprintf(name, sizeof(name), "fetch_%s", getProviderName((ApiProvider)p));
+    xTaskCreatePinnedToCore(
+        providerWorker,
+        name,
+        FETCH_WORKER_STACK,
+        (void*)(uintptr_t)p,
+        1,
+        NULL,
+        0
+    );
+  }
+
+  LOG_EVENT(EV_FETCH_STARTED, nullptr);
+}
+
+FetchJob* acquireFetchJob() {
+  for (int i = 0; i < FETCH_MAX_JOBS; i++) {
+    if (jobs[i].state == FETCH_IDLE) {
+      FetchJob* job = &jobs[i];
+      memset(job, 0, sizeof(FetchJob));
+      job->state = FETCH_QUEUED;
+      return job;
+    }
+  }
+  return nullptr;
+}
+
+bool submitFetch(FetchJob* job) {
+  ApiProvider provider = fetchProvider(job->kind);
+
+  job->generation = generation;
+  job->deadline = appMillis() + job->timeoutMs;
+  job->outcome = FETCH_FAILED;
+
+  inFlight[provider]++;
+#if SIM_BUILD
+  simRunJob(job);
+  return true;
+#endif
+  if (xQueueSend(providerQueues[provider], &job, 0) != pdTRUE) {
+    inFlight[provider]--;
+    job->state = FETCH_IDLE;
+    LOG_EVENT(EV_FETCH_QUEUE_FULL, nullptr, provider);
+    return false;
+  }
+  return true;
+}
+
+FetchJob* pollFetchCompletion() {
+#if SIM_BUILD
+  for (int i = 0; i < FETCH_MAX_JOBS; i++) {
+    FetchJob* job = &jobs[i];
+    if (job->state != FETCH_DONE || simReported[i]) continue;
+    if ((int32_t)(appMillis() - job->finishedAt) < 0) continue;
+    if (job->generation != generation) job->outcome = FETCH_CANCELLED;
+    simReported[i] = true;
+    inFlight[fetchProvider(job->kind)]--;
+    simObserveCompletion(job);
+    return job;
+  }
+  return nullptr;
+#endif
+  FetchJob* job = nullptr;
+  if (completionQueue && xQueueReceive(completionQueue, &job, 0) == pdTRUE) {
+    return job;
+  }
+  return nullptr;
+}
+
+void releaseFetchJob(FetchJob* job) {
+  if (job) job->state = FETCH_IDLE;
+}
+
+void cancelAllFetches() {
+  generation++;
+
+  // Queued jobs are reported back immediately; running ones are marked
+  // cancelled by their worker when the request returns
+  for (int p = 0; p < PROVIDER_COUNT; p++) {
+    FetchJob* job = nullptr;
+    while (providerQueues[p] && xQueueReceive(providerQueues[p], &job, 0) == pdTRUE) {
+      finishJob(job, FETCH_CANCELLED);
+    }
+  }
+}
+
+int fetchInFlight(ApiProvider provider) {
+  return inFlight[provider];
+}
+
+uint32_t getLargestBlockLowWater() {
+  uint32_t low = largestBlockLow;
+  return low == UINT32_MAX ? ESP.getMaxAllocHeap() : low;
+}
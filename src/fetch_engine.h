@@ -0,0 +1,93 @@
+#pragma once
+#include <Arduino.h>
+#include "ticker_types.h"
+#include "api_client.h"
+
+// Asynchronous fetch engine.
+// Each provider host has its own worker task (Core 0) and TLS connection, so
+// requests to different providers run in parallel. Jobs live in a fixed pool
+// of slots and move through FETCH_QUEUED -> FETCH_RUNNING -> FETCH_DONE; the
+// data manager submits jobs and polls for completions without blocking.
+
+enum FetchKind : uint8_t {
+  FETCH_CMC_PRICES       = 0,
+  FETCH_COINGECKO_PRICES = 1,
+  FETCH_CRYPTO_CHART     = 2,
+  FETCH_STOCK_PRICE      = 3,
+  FETCH_STOCK_CHART      = 4
+};
+
+enum FetchState : uint8_t {
+  FETCH_IDLE    = 0,
+  FETCH_QUEUED  = 1,
+  FETCH_RUNNING = 2,
+  FETCH_DONE    = 3
+};
+
+enum FetchOutcome : uint8_t {
+  FETCH_OK        = 0,
+  FETCH_FAILED    = 1,  // HTTP/parse error reported by the API client
+  FETCH_EXPIRED   = 2,  // Deadline passed before the request could start
+  FETCH_CANCELLED = 3,  // cancelAllFetches() was called while queued/running
+  FETCH_REJECTED  = 4   // Provider circuit is open; no request was sent
+};
+
+struct FetchJob {
+  // Request (filled by submitter)
+  FetchKind kind;
+  uint8_t tickerIndex;       // Chart/stock jobs: ticker slot
+  uint8_t timeframe;         // Chart jobs: ChartTimeframe
+  uint32_t timeoutMs;        // Relative deadline, measured from submit
+  char ids[FETCH_BATCH_IDS_LEN];  // Batch ids, coin id or symbol
+  char interval[8];          // Twelve Data interval ("1h", "1day")
+  int days;                  // CoinGecko chart days / Twelve Data outputsize
+  char apiKey[64];           // Twelve Data key (stock jobs); a copy, the config may be swapped mid-fetch
+  int numTickers;            // Batch jobs: entries in ids / batchTickers
+  uint8_t batchTickers[FETCH_BATCH_MAX];  // Batch jobs: ticker slot per id
+  BatchCharts* charts;       // CoinGecko price jobs: chart per id, or nullptr (submitter's buffer)
+
+  // Bookkeeping (owned by the engine)
+  volatile FetchState state;
+  uint32_t generation;
+  uint32_t deadline;         // Absolute millis()
+  uint32_t startedAt;
+  uint32_t finishedAt;
+
+  // Result (valid once state == FETCH_DONE)
+  FetchOutcome outcome;
+  int updated;
+  Price price;
+  PriceQuote quotes[FETCH_BATCH_MAX];  // Indexed like batchTickers
+  SparklineData sparkline;
+};
+
+// Start one worker task per provider (call once, after initApiClient())
+void initFetchEngine();
+
+// Provider that serves a given job kind
+ApiProvider fetchProvider(FetchKind kind);
+
+// Claim a free job slot; returns nullptr if all slots are busy.
+// Fill in the request fields, then pass it to submitFetch().
+FetchJob* acquireFetchJob();
+
+// Queue a claimed job on its provider's worker. Returns false (and frees the
+// slot) if the provider queue is full.
+bool submitFetch(FetchJob* job);
+
+// Non-blocking: return the next finished job, or nullptr.
+// The caller must releaseFetchJob() it after applying the result.
+FetchJob* pollFetchCompletion();
+
+// Return a finished job's slot to the pool
+void releaseFetchJob(FetchJob* job);
+
+// Drop all queued jobs and mark running ones as cancelled; their results
+// are reported with outcome FETCH_CANCELLED
+void cancelAllFetches();
+
+// Number of jobs currently queued or running on a provider
+int fetchInFlight(ApiProvider provider);
+
+// Lowest largest-free-heap-block seen after any fetch since boot
+uint32_t getLargestBlockLowWater();
@@ -0,0 +1,66 @@
+#include "fetch_events.h"
+#include "config.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static TaskHandle_t fetchTaskHandle = nullptr;
+static uint32_t earlyEvents = 0;        // Signalled before registerFetchTask()
+static portMUX_TYPE eventsMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Fetch task writes, web server reads
+static FetchWakeStats stats = {};
+static uint32_t passStartedAt = 0;
+
+static const char* eventNames[FETCH_EVENT_COUNT] = { "work", "config", "refresh", "wifi" };
+
+void registerFetchTask() {
+  portENTER_CRITICAL(&eventsMux);
+  fetchTaskHandle = xTaskGetCurrentTaskHandle();
+  uint32_t pending = earlyEvents;
+  earlyEvents = 0;
+  portEXIT_CRITICAL(&eventsMux);
+
+  if (pending) xTaskNotify(fetchTaskHandle, pending, eSetBits);
+  passStartedAt = millis();
+}
+
+void signalFetchTask(uint32_t events) {
+  portENTER_CRITICAL(&eventsMux);
+  TaskHandle_t task = fetchTaskHandle;
+  if (!task) earlyEvents |= events;
+  portEXIT_CRITICAL(&eventsMux);
+
+  if (task) xTaskNotify(task, events, eSetBits);
+}
+
+uint32_t waitFetchEvents(uint32_t timeoutMs) {
+  timeoutMs = min(timeoutMs, (uint32_t)FETCH_IDLE_MAX_MS);
+  uint32_t start = millis();
+  uint32_t events = 0;
+  if (xTaskNotifyWait(0, 0xFFFFFFFFu, &events, pdMS_TO_TICKS(timeoutMs)) != pdTRUE) events = 0;
+  uint32_t now = millis();
+
+  portENTER_CRITICAL(&eventsMux);
+  stats.busyMs += start - passStartedAt;
+  stats.sleptMs += now - start;
+  stats.lastWaitMs = timeoutMs;
+  if (events == 0) stats.deadlines++;
+  for (int b = 0; b < FETCH_EVENT_COUNT; b++) {
+    if (events & (1u << b)) stats.events[b]++;
+  }
+  portEXIT_CRITICAL(&eventsMux);
+
+  passStartedAt = now;
+  return events;
+}
+
+FetchWakeStats getFetchWakeStats() {
+  portENTER_CRITICAL(&eventsMux);
+  FetchWakeStats s = stats;
+  portEXIT_CRITICAL(&eventsMux);
+  return s;
+}
+
+const char* getFetchEventName(int bit) {
+  return bit >= 0 && bit < FETCH_EVENT_COUNT ? eventNames[bit] : "?";
+}
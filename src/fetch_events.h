@@ -0,0 +1,43 @@
+#pragma once
+#include <Arduino.h>
+
+// Wake-ups for the fetch task (Core 0).
+// Each pass, the fetch task's hooks (updateData, powerTick, otaTick, ...)
+// return how long until they have something due. The task then blocks in
+// waitFetchEvents() until the nearest of those deadlines, or until another
+// task signals an event. Events are bits of the fetch task's notification
+// value, so repeated signals before it wakes coalesce into one pass.
+
+enum FetchEvent : uint32_t {
+  FETCH_EVENT_WORK    = 1 << 0,   // Fetch finished, relay update, streamed price, OTA or display window change
+  FETCH_EVENT_CONFIG  = 1 << 1,   // New config snapshot published
+  FETCH_EVENT_REFRESH = 1 << 2,   // Refetch everything (forceRefresh)
+  FETCH_EVENT_WIFI    = 1 << 3    // WiFi (re)connected
+};
+#define FETCH_EVENT_COUNT   4
+
+// "Nothing scheduled" from a hook; the wait is still capped at FETCH_IDLE_MAX_MS
+#define FETCH_WAIT_FOREVER  0xFFFFFFFFu
+
+struct FetchWakeStats {
+  uint32_t events[FETCH_EVENT_COUNT];  // Passes started by each event (one pass may count several)
+  uint32_t deadlines;                  // Passes started by a deadline
+  uint32_t lastWaitMs;                 // Timeout of the latest wait
+  uint64_t sleptMs;                    // Time blocked in waitFetchEvents()
+  uint64_t busyMs;                     // Time spent in passes
+};
+
+// Fetch task, once before its first wait. Events signalled earlier are kept.
+void registerFetchTask();
+
+// Wake the fetch task (any task, not ISRs)
+void signalFetchTask(uint32_t events);
+
+// Fetch task: block up to timeoutMs (capped at FETCH_IDLE_MAX_MS) and
+// return the events that arrived, 0 if the deadline passed
+uint32_t waitFetchEvents(uint32_t timeoutMs);
+
+FetchWakeStats getFetchWakeStats();
+
+// "work", "config", "refresh", "wifi"
+const char* getFetchEventName(int bit);
@@ -0,0 +1,280 @@
+#include "frame_capture.h"
+#include "display_renderer.h"
+#include "config.h"
+#include "layout.h"
+#include <Adafruit_GFX.h>
+#include <LittleFS.h>
+#include <math.h>
+
+#define SUITE_FIXED_FRAMES 2   // loading + error
+#define FRAMES_PER_TICKER  (TIMEFRAME_COUNT * 2)
+
+static const char* goldenDir = "/golden";
+
+// Canvas that counts every pixel write issued by the renderer
+class CaptureCanvas : public GFXcanvas16 {
+public:
+  CaptureCanvas() : GFXcanvas16(DISPLAY_WIDTH, DISPLAY_HEIGHT), touched(0) {}
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+    touched++;
+    GFXcanvas16::drawPixel(x, y, color);
+  }
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override {
+    touched += h > 0 ? h : -h;
+    GFXcanvas16::drawFastVLine(x, y, h, color);
+  }
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override {
+    touched += w > 0 ? w : -w;
+    GFXcanvas16::drawFastHLine(x, y, w, color);
+  }
+
+  uint32_t touched;
+};
+
+// Synthetic prices spanning every formatPriceLabel() branch
+static const Price suitePrices[] = {
+  6725012000000LL, 348055000000LL, 15231000000LL, 8417000000LL, 16230000LL, 16890000000LL,
+  158720000000LL, 49833000000LL, 57104000000LL, 22187000000LL, 108420000LL
+};
+
+int frameSuiteSize() {
+  return SUITE_FIXED_FRAMES + DEFAULT_TICKER_COUNT * FRAMES_PER_TICKER;
+}
+
+void frameSuiteName(int index, char* buf, size_t len) {
+  if (index == 0) { strlcpy(buf, "loading", len); return; }
+  if (index == 1) { strlcpy(buf, "error", len); return; }
+
+  int n = index - SUITE_FIXED_FRAMES;
+  int slot = n / FRAMES_PER_TICKER;
+  int tf = (n % FRAMES_PER_TICKER) / 2;
+  bool up = (n % 2) == 0;
+  snprintf(buf, len, "%s_%s_%s", getDefaultTicker(slot).symbol,
+           getTimeframeLabel((ChartTimeframe)tf), up ? "up" : "down");
+}
+
+int findSuiteFrame(const char* name) {
+  char buf[32];
+  for (int i = 0; i < frameSuiteSize(); i++) {
+    frameSuiteName(i, buf, sizeof(buf));
+    if (strcasecmp(buf, name) == 0) return i;
+  }
+  return -1;
+}
+
+// Deterministic ticker for a suite slot: fixed price, change% whose sign
+// follows the polarity, and a sine sparkline that differs per slot/timeframe
+static void buildSuiteTicker(int slot, int tf, bool up, TickerData* out, SparklineData* sp) {
+  TickerConfig config = getDefaultTicker(slot);
+  memset(out, 0, sizeof(TickerData));
+  strlcpy(out->symbol, config.symbol, MAX_SYMBOL_LEN);
+  out->type = config.type;
+  out->currentPrice = suitePrices[slot % (sizeof(suitePrices) / sizeof(suitePrices[0]))];
+  out->priceValid = true;
+
+  float magnitude = 0.7f + tf * 2.3f + slot * 0.45f;
+  for (int t = 0; t < TIMEFRAME_COUNT; t++) {
+    out->priceChange[t] = up ? magnitude : -magnitude;
+  }
+  out->priceChange24h = out->priceChange[TIMEFRAME_24H];
+
+  memset(sp, 0, sizeof(SparklineData));
+  const int points = getSparklinePoints();
+  for (int k = 0; k < points; k++) {
+    float phase = k * 0.09f * (slot + 1) * 64 / points + tf;
+    float trend = (up ? 1 : -1) * (k - points / 2) * 1.5f * 64 / points;
+    int v = (int)(128 + 80 * sinf(phase) + trend);
+    sp->points[k] = (uint8_t)constrain(v, 0, 255);
+  }
+  sp->len = points;
+  sp->priceMin = out->currentPrice / 10 * 9;
+  sp->priceMax = out->currentPrice / 10 * 11;
+  sp->valid = true;
+}
+
+static FrameStats renderSuiteFrame(int index, CaptureCanvas& canvas) {
+  TickerData ticker;
+  SparklineData sparkline;
+  if (index >= SUITE_FIXED_FRAMES) {
+    int n = index - SUITE_FIXED_FRAMES;
+    buildSuiteTicker(n / FRAMES_PER_TICKER, (n % FRAMES_PER_TICKER) / 2, (n % 2) == 0, &ticker, &sparkline);
+  }
+
+  beginCapture(&canvas);
+  canvas.touched = 0;
+  uint32_t t0 = micros();
+  if (index == 0) {
+    renderLoadingScreen("Connecting WiFi...");
+  } else if (index == 1) {
+    renderErrorScreen("No WiFi");
+  } else {
+    int n = index - SUITE_FIXED_FRAMES;
+    renderTickerScreen(ticker, sparkline, (ChartTimeframe)((n % FRAMES_PER_TICKER) / 2));
+  }
+  uint32_t elapsed = micros() - t0;
+  endCapture();
+
+  FrameStats stats;
+  stats.renderUs = elapsed;
+  stats.pixelsTouched = canvas.touched;   // The clear (fillScreen) is not counted
+  stats.litPixels = 0;
+  stats.hash = 2166136261u;
+  const uint16_t* px = canvas.getBuffer();
+  for (int i = 0; i < DISPLAY_WIDTH * DISPLAY_HEIGHT; i++) {
+    if (px[i]) stats.litPixels++;
+    stats.hash = (stats.hash ^ (px[i] & 0xFF)) * 16777619u;
+    stats.hash = (stats.hash ^ (px[i] >> 8)) * 16777619u;
+  }
+  return stats;
+}
+
+// Goldens live in one file per display geometry (LittleFS allocates a 4KB
+// block per file): records of [nameLen:u8][name][runs:u16 LE] followed by
+// `runs` runs of [count:u8][rgb565:u16 LE], in suite order
+#define GOLDEN_PATH_FMT "/golden/suite_%dx%d.bin"
+
+static int countRuns(const uint16_t* px, int total) {
+  int runs = 0;
+  for (int i = 0; i < total; ) {
+    int run = 1;
+    while (i + run < total && run < 255 && px[i + run] == px[i]) run++;
+    runs++;
+    i += run;
+  }
+  return runs;
+}
+
+static void writeGolden(File& f, const char* name, const uint16_t* px) {
+  const int total = DISPLAY_WIDTH * DISPLAY_HEIGHT;
+  uint8_t nameLen = (uint8_t)strlen(name);
+  uint16_t runs = (uint16_t)countRuns(px, total);
+  f.write(&nameLen, 1);
+  f.write((const uint8_t*)name, nameLen);
+  uint8_t runsLE[2] = { (uint8_t)(runs & 0xFF), (uint8_t)(runs >> 8) };
+  f.write(runsLE, 2);
+
+  for (int i = 0; i < total; ) {
+    uint16_t color = px[i];
+    int run = 1;
+    while (i + run < total && run < 255 && px[i + run] == color) run++;
+    uint8_t rec[3] = { (uint8_t)run, (uint8_t)(color & 0xFF), (uint8_t)(color >> 8) };
+    f.write(rec, sizeof(rec));
+    i += run;
+  }
+}
+
+// Position f at the runs of the named record; returns its run count or -1.
+// Tries the current position first (suite order), then scans from the start.
+static int seekGolden(File& f, const char* name) {
+  for (int pass = 0; pass < 2; pass++) {
+    if (pass == 1) f.seek(0);
+    while (f.available()) {
+      uint8_t nameLen;
+      char recName[64];
+      uint8_t runsLE[2];
+      if (f.read(&nameLen, 1) != 1) break;
+      if (nameLen >= sizeof(recName) || f.read((uint8_t*)recName, nameLen) != nameLen) break;
+      recName[nameLen] = '\0';
+      if (f.read(runsLE, 2) != 2) break;
+      int runs = runsLE[0] | (runsLE[1] << 8);
+      if (strcmp(recName, name) == 0) return runs;
+      f.seek(f.position() + runs * 3);
+      if (pass == 0) break;   // Out of order: fall back to a full scan
+    }
+  }
+  return -1;
+}
+
+// Count pixels that differ from the golden; -1 if there is no golden
+static int diffGolden(File& f, const char* name, const uint16_t* px) {
+  if (!f) return -1;
+  int runs = seekGolden(f, name);
+  if (runs < 0) return -1;
+
+  const int total = DISPLAY_WIDTH * DISPLAY_HEIGHT;
+  int pos = 0;
+  int diff = 0;
+  uint8_t rec[3];
+  for (int r = 0; r < runs && f.read(rec, sizeof(rec)) == sizeof(rec); r++) {
+    uint16_t color = rec[1] | (rec[2] << 8);
+    for (int k = 0; k < rec[0] && pos < total; k++, pos++) {
+      if (px[pos] != color) diff++;
+    }
+  }
+  // A truncated golden counts its missing pixels as different
+  return diff + (total - pos);
+}
+
+void writeFrameSuiteReport(Print& out, bool record) {
+  CaptureCanvas canvas;
+  if (!canvas.getBuffer()) {
+    out.print("{\"error\":\"no memory for capture canvas\"}");
+    return;
+  }
+  char goldenPath[32];
+  snprintf(goldenPath, sizeof(goldenPath), GOLDEN_PATH_FMT, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+  File golden;
+  if (record) {
+    LittleFS.mkdir(goldenDir);
+    golden = LittleFS.open(goldenPath, "w");
+  } else {
+    golden = LittleFS.open(goldenPath, "r");
+  }
+
+  int passed = 0, failed = 0, missing = 0;
+  uint32_t totalUs = 0;
+  char name[32];
+
+  out.print("{\"frames\":[");
+  for (int i = 0; i < frameSuiteSize(); i++) {
+    FrameStats stats = renderSuiteFrame(i, canvas);
+    frameSuiteName(i, name, sizeof(name));
+    totalUs += stats.renderUs;
+
+    const char* status;
+    int diff = 0;
+    if (record) {
+      if (golden) writeGolden(golden, name, canvas.getBuffer());
+      status = golden ? "recorded" : "write-failed";
+    } else {
+      diff = diffGolden(golden, name, canvas.getBuffer());
+      if (diff < 0) { status = "missing"; missing++; diff = 0; }
+      else if (diff == 0) { status = "pass"; passed++; }
+      else { status = "fail"; failed++; }
+    }
+
+    out.printf("%s{\"name\":\"%s\",\"status\":\"%s\",\"diffPixels\":%d,\"hash\":\"%08lx\","
+               "\"pixelsTouched\":%lu,\"litPixels\":%lu,\"renderUs\":%lu}",
+               i ? "," : "", name, status, diff, (unsigned long)stats.hash,
+               (unsigned long)stats.pixelsTouched, (unsigned long)stats.litPixels,
+               (unsigned long)stats.renderUs);
+    yield();
+  }
+  if (golden) golden.close();
+  out.printf("],\"recorded\":%s,\"passed\":%d,\"failed\":%d,\"missing\":%d,\"totalRenderUs\":%lu}",
+             record ? "true" : "false", passed, failed, missing, (unsigned long)totalUs);
+}
+
+bool writeFramePPM(Print& out, int index) {
+  if (index < 0 || index >= frameSuiteSize()) return false;
+  CaptureCanvas canvas;
+  if (!canvas.getBuffer()) return false;
+  renderSuiteFrame(index, canvas);
+
+  out.printf("P6\n%d %d\n255\n", DISPLAY_WIDTH, DISPLAY_HEIGHT);
+  const uint16_t* px = canvas.getBuffer();
+  uint8_t row[DISPLAY_WIDTH * 3];
+  for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+    for (int x = 0; x < DISPLAY_WIDTH; x++) {
+      uint16_t c = px[y * DISPLAY_WIDTH + x];
+      // Expand 565 to 888, replicating high bits into the low ones
+      uint8_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+      row[x * 3]     = (r << 3) | (r >> 2);
+      row[x * 3 + 1] = (g << 2) | (g >> 4);
+      row[x * 3 + 2] = (b << 3) | (b >> 2);
+    }
+    out.write(row, sizeof(row));
+  }
+  return true;
+}
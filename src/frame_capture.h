@@ -0,0 +1,36 @@
+#pragma once
+#include <Arduino.h>
+#include "ticker_types.h"
+
+// Offscreen frame capture and golden-image regression suite.
+// The real renderer (display_renderer.cpp) draws into a display-sized
+// RGB565 canvas instead of the panel. A fixed suite covers the loading and error
+// screens plus every default ticker x timeframe x polarity with synthetic,
+// deterministic data. Each frame reports a hash, pixels touched (draw
+// calls that hit the canvas), lit pixels and render time. Frames are
+// compared pixel by pixel against RLE goldens in LittleFS, one file per
+// display geometry (/golden/suite_64x32.bin).
+
+struct FrameStats {
+  uint32_t hash;           // FNV-1a over the RGB565 framebuffer
+  uint32_t pixelsTouched;  // Pixel writes issued by the renderer
+  uint32_t litPixels;      // Non-black pixels in the result
+  uint32_t renderUs;
+};
+
+// Number of frames in the suite
+int frameSuiteSize();
+
+// Name of suite frame index ("loading", "error", "BTC_24H_up", ...)
+void frameSuiteName(int index, char* buf, size_t len);
+
+// Index of a named suite frame (any case), or -1
+int findSuiteFrame(const char* name);
+
+// Render every suite frame and compare with its golden. With record set,
+// goldens are (re)written from the current renderer instead.
+// Writes a JSON report to out.
+void writeFrameSuiteReport(Print& out, bool record);
+
+// Render one suite frame and write it as a binary PPM (P6) image
+bool writeFramePPM(Print& out, int index);
@@ -0,0 +1,210 @@
+#include "frame_mirror.h"
+#include "display_renderer.h"
+#include "trace.h"
+#include <Adafruit_GFX.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static const int TOTAL_PIXELS = DISPLAY_WIDTH * DISPLAY_HEIGHT;
+
+static TaskHandle_t mirrorTask = nullptr;
+static MirrorSink mirrorSink = nullptr;
+static volatile int viewers = 0;
+static volatile bool keyWanted = true;
+
+static portMUX_TYPE mirrorMux = portMUX_INITIALIZER_UNLOCKED;
+static MirrorStatus status = {};
+
+// Value of pixel i as encoded: the color, or its XOR with the base frame
+static inline uint16_t pixelValue(const uint16_t* px, const uint16_t* prev, int i) {
+  return prev ? px[i] ^ prev[i] : px[i];
+}
+
+static int runLength(const uint16_t* px, const uint16_t* prev, int i) {
+  uint16_t v = pixelValue(px, prev, i);
+  int run = 1;
+  while (i + run < TOTAL_PIXELS && run < 255 && pixelValue(px, prev, i + run) == v) run++;
+  return run;
+}
+
+static int paletteIndex(const uint16_t* palette, int colors, uint16_t v) {
+  for (int k = 0; k < colors; k++) {
+    if (palette[k] == v) return k;
+  }
+  return -1;
+}
+
+static uint8_t* putU16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+  return p + 2;
+}
+
+static uint8_t* putU32(uint8_t* p, uint32_t v) {
+  for (int k = 0; k < 4; k++) p[k] = (v >> (8 * k)) & 0xFF;
+  return p + 4;
+}
+
+size_t encodeMirrorFrame(const uint16_t* px, const uint16_t* prev, uint32_t serial, uint32_t base, uint8_t* out) {
+  // Pass 1: palette of the run values (a screen has a few dozen colors)
+  uint16_t palette[MIRROR_PALETTE_MAX];
+  int colors = 0;
+  bool raw = false;
+  for (int i = 0; i < TOTAL_PIXELS && !raw; ) {
+    uint16_t v = pixelValue(px, prev, i);
+    if (paletteIndex(palette, colors, v) < 0) {
+      if (colors == MIRROR_PALETTE_MAX) raw = true;
+      else palette[colors++] = v;
+    }
+    i += runLength(px, prev, i);
+  }
+
+  uint8_t* p = out;
+  *p++ = 'M';
+  *p++ = (prev ? MIRROR_DELTA : 0) | (raw ? MIRROR_RAW : 0);
+  p = putU16(p, DISPLAY_WIDTH);
+  p = putU16(p, DISPLAY_HEIGHT);
+  p = putU32(p, serial);
+  p = putU32(p, prev ? base : 0);
+  *p++ = raw ? 0 : (uint8_t)colors;
+  if (!raw) {
+    for (int k = 0; k < colors; k++) p = putU16(p, palette[k]);
+  }
+
+  // Pass 2: the runs
+  for (int i = 0; i < TOTAL_PIXELS; ) {
+    uint16_t v = pixelValue(px, prev, i);
+    int run = runLength(px, prev, i);
+    *p++ = (uint8_t)run;
+    if (raw) p = putU16(p, v);
+    else *p++ = (uint8_t)paletteIndex(palette, colors, v);
+    i += run;
+  }
+  return p - out;
+}
+
+bool writeMirrorKeyframe(Print& out) {
+  GFXcanvas16 canvas(DISPLAY_WIDTH, DISPLAY_HEIGHT);
+  uint8_t* frame = (uint8_t*)malloc(MIRROR_FRAME_MAX);
+  if (!canvas.getBuffer() || !frame) {
+    free(frame);
+    return false;
+  }
+  uint32_t serial = captureShownFrame(&canvas);
+  size_t len = encodeMirrorFrame(canvas.getBuffer(), nullptr, serial, 0, frame);
+  out.write(frame, len);
+  free(frame);
+  return true;
+}
+
+// Buffers exist only while someone watches
+struct MirrorBuffers {
+  GFXcanvas16* canvas;
+  uint16_t* prev;       // Last frame sent, what deltas are taken against
+  uint8_t* frame;
+};
+
+static void freeBuffers(MirrorBuffers& b) {
+  delete b.canvas;
+  free(b.prev);
+  free(b.frame);
+  b = MirrorBuffers();
+}
+
+static bool allocBuffers(MirrorBuffers& b) {
+  b.canvas = new GFXcanvas16(DISPLAY_WIDTH, DISPLAY_HEIGHT);
+  b.prev = (uint16_t*)malloc(TOTAL_PIXELS * sizeof(uint16_t));
+  b.frame = (uint8_t*)malloc(MIRROR_FRAME_MAX);
+  if (b.canvas && b.canvas->getBuffer() && b.prev && b.frame) return true;
+  freeBuffers(b);
+  return false;
+}
+
+static void mirrorWorker(void* param) {
+  MirrorBuffers buffers = MirrorBuffers();
+  bool havePrev = false;
+  uint32_t prevShown = 0;   // Panel serial of the frame in buffers.prev
+  uint32_t sent = 0;        // Stream serial of the last frame sent
+
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MIRROR_POLL_MS));
+    if (viewers == 0) {
+      if (buffers.canvas) freeBuffers(buffers);
+      havePrev = false;
+      continue;
+    }
+    bool key = keyWanted || !havePrev;
+    if (!key && getShownFrameSerial() == prevShown) continue;
+    if (!buffers.canvas && !allocBuffers(buffers)) continue;
+
+    TRACE_SCOPE("mirror");
+    uint32_t t0 = micros();
+    uint32_t shown = captureShownFrame(buffers.canvas);
+    uint32_t t1 = micros();
+    const uint16_t* px = buffers.canvas->getBuffer();
+    if (!key && memcmp(px, buffers.prev, TOTAL_PIXELS * sizeof(uint16_t)) == 0) {
+      prevShown = shown;   // Same picture under a new serial
+      continue;
+    }
+
+    keyWanted = false;
+    size_t len = encodeMirrorFrame(px, key ? nullptr : buffers.prev, sent + 1, sent, buffers.frame);
+    uint32_t t2 = micros();
+    bool ok = mirrorSink && mirrorSink(buffers.frame, len);
+
+    portENTER_CRITICAL(&mirrorMux);
+    status.captureUs = t1 - t0;
+    status.encodeUs = t2 - t1;
+    if (ok) {
+      status.frames++;
+      if (key) status.keyframes++;
+      status.lastBytes = len;
+      status.totalBytes += len;
+    } else {
+      status.refused++;
+    }
+    portEXIT_CRITICAL(&mirrorMux);
+
+    if (!ok) {
+      // Viewers still hold the old base; retry the same change next poll
+      if (key) keyWanted = true;
+      continue;
+    }
+    sent++;
+    memcpy(buffers.prev, px, TOTAL_PIXELS * sizeof(uint16_t));
+    havePrev = true;
+    prevShown = shown;
+  }
+}
+
+void startFrameMirror(MirrorSink sink) {
+  mirrorSink = sink;
+  if (mirrorTask) return;
+  xTaskCreatePinnedToCore(
+      mirrorWorker,
+      "mirror",
+      MIRROR_WORKER_STACK,
+      NULL,
+      1,
+      &mirrorTask,
+      0
+  );
+}
+
+void setMirrorViewers(int count) {
+  viewers = count;
+  if (mirrorTask) xTaskNotifyGive(mirrorTask);
+}
+
+void requestMirrorKeyframe() {
+  keyWanted = true;
+  if (mirrorTask) xTaskNotifyGive(mirrorTask);
+}
+
+MirrorStatus getMirrorStatus() {
+  portENTER_CRITICAL(&mirrorMux);
+  MirrorStatus s = status;
+  portEXIT_CRITICAL(&mirrorMux);
+  s.viewers = viewers;
+  return s;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// Live mirror of the panel for the web UI.
+// The render loop only bumps a frame serial (see getShownFrameSerial); a
+// worker task (Core 0) polls it every MIRROR_POLL_MS while someone
+// watches, re-renders the shown frame offscreen (captureShownFrame) and
+// hands the encoded frame to a sink, the /ws/mirror WebSocket. Each frame
+// costs the display loop one offscreen draw's worth of render lock.
+//
+// Encoded frame, little endian:
+//   [0]      'M'
+//   [1]      flags: MIRROR_DELTA, MIRROR_RAW
+//   [2..5]   width, height (u16)
+//   [6..9]   serial (u32), counts sent frames
+//   [10..13] base (u32): serial a delta applies to, 0 for a keyframe
+//   [14]     palette size N (0 with MIRROR_RAW), then N RGB565 (u16)
+//   runs in row-major order until width * height pixels are covered:
+//     [count u8][palette index u8], or [count u8][rgb565 u16] with MIRROR_RAW
+// A delta's values are XORed with the base frame, so unchanged pixels are
+// long runs of 0. A text screen is a few hundred bytes as a keyframe and
+// usually less than one hundred as a delta.
+
+#define MIRROR_DELTA          0x01   // XOR against the base frame
+#define MIRROR_RAW            0x02   // More than MIRROR_PALETTE_MAX values: inline colors
+#define MIRROR_PALETTE_MAX    255
+#define MIRROR_HEADER_BYTES   15
+#define MIRROR_FRAME_MAX      (MIRROR_HEADER_BYTES + DISPLAY_WIDTH * DISPLAY_HEIGHT * 3)
+
+// Delivers one encoded frame to every viewer; false if it cannot be sent
+// now (a client's queue is full), in which case it is retried later
+typedef bool (*MirrorSink)(const uint8_t* frame, size_t len);
+
+struct MirrorStatus {
+  uint8_t viewers;
+  uint32_t frames;        // Sent, keyframes included
+  uint32_t keyframes;
+  uint32_t refused;       // Frames the sink could not take
+  uint32_t lastBytes;
+  uint32_t totalBytes;
+  uint32_t captureUs;     // Last capture: render lock held this long
+  uint32_t encodeUs;
+};
+
+// Start the worker; frames go to sink
+void startFrameMirror(MirrorSink sink);
+
+// Viewer count changed (0 stops capturing and frees the buffers)
+void setMirrorViewers(int viewers);
+
+// Next frame is a keyframe (new viewer, or a viewer lost its base)
+void requestMirrorKeyframe();
+
+// Encode px (RGB565, DISPLAY_WIDTH x DISPLAY_HEIGHT) into out, which holds
+// at least MIRROR_FRAME_MAX bytes. With prev, a delta against it.
+// Returns the encoded length.
+size_t encodeMirrorFrame(const uint16_t* px, const uint16_t* prev, uint32_t serial, uint32_t base, uint8_t* out);
+
+// One-shot keyframe of the current panel for GET /api/mirror
+bool writeMirrorKeyframe(Print& out);
+
+MirrorStatus getMirrorStatus();
@@ -0,0 +1,76 @@
+#include "fx_rates.h"
+#include "app_clock.h"
+#include <freertos/FreeRTOS.h>
+
+// Pair fetched for each currency, in the orientation the market quotes it
+static const char* pairs[CURRENCY_COUNT] = { "", "EUR/USD", "GBP/USD", "USD/CHF", "USD/JPY" };
+
+// Fetch task writes, render loop and web server read
+static FxRate rates[CURRENCY_COUNT];
+static portMUX_TYPE fxMux = portMUX_INITIALIZER_UNLOCKED;
+
+const char* getFxPair(Currency c) {
+  return c < CURRENCY_COUNT ? pairs[c] : "";
+}
+
+Currency fxPairCurrency(const char* symbol) {
+  if (!symbol || strlen(symbol) != 7 || symbol[3] != '/') return CURRENCY_USD;
+  const char* code;
+  if (strncmp(symbol, "USD", 3) == 0) code = symbol + 4;
+  else if (strcmp(symbol + 4, "USD") == 0) code = symbol;
+  else return CURRENCY_USD;
+
+  char buf[4];
+  memcpy(buf, code, 3);
+  buf[3] = '\0';
+  return (Currency)parseCurrency(buf, CURRENCY_USD);
+}
+
+void setFxQuote(const char* symbol, Price pairPrice, FxSource source) {
+  Currency c = fxPairCurrency(symbol);
+  if (c == CURRENCY_USD || pairPrice <= 0) return;
+  double price = priceToDouble(pairPrice);
+  FxRate r;
+  r.perUsd = priceFromDouble(strncmp(symbol, "USD", 3) == 0 ? price : 1.0 / price);
+  r.updatedAt = appMillis();
+  r.source = source;
+  portENTER_CRITICAL(&fxMux);
+  rates[c] = r;
+  portEXIT_CRITICAL(&fxMux);
+}
+
+bool fxConvert(Price usd, Currency c, Price* out) {
+  if (c == CURRENCY_USD) {
+    *out = usd;
+    return true;
+  }
+  if (c >= CURRENCY_COUNT) return false;
+  portENTER_CRITICAL(&fxMux);
+  Price perUsd = rates[c].perUsd;
+  portEXIT_CRITICAL(&fxMux);
+  if (perUsd <= 0) return false;
+  *out = priceFromDouble(priceToDouble(usd) * priceToDouble(perUsd));
+  return true;
+}
+
+void fxConvertTicker(TickerData* ticker, SparklineData* sparkline, Currency c) {
+  ticker->currency = CURRENCY_USD;
+  if (c == CURRENCY_USD || !fxConvert(ticker->currentPrice, c, &ticker->currentPrice)) return;
+  fxConvert(ticker->high24h, c, &ticker->high24h);
+  fxConvert(ticker->low24h, c, &ticker->low24h);
+  if (sparkline) {
+    // The points are relative to min/max, so the curve itself is unchanged
+    fxConvert(sparkline->priceMin, c, &sparkline->priceMin);
+    fxConvert(sparkline->priceMax, c, &sparkline->priceMax);
+  }
+  ticker->currency = c;
+}
+
+FxRate getFxRate(Currency c) {
+  FxRate r = {};
+  if (c >= CURRENCY_COUNT) return r;
+  portENTER_CRITICAL(&fxMux);
+  r = rates[c];
+  portEXIT_CRITICAL(&fxMux);
+  return r;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <Arduino.h>
+#include "ticker_types.h"
+
+// Display-currency conversion.
+// Prices, 24h high/low and sparkline min/max are fetched once, in USD, and
+// converted on the device with one cached USD rate per display currency, so
+// showing EUR costs no extra price or chart calls. A rate comes from a
+// forex slot in the watchlist quoting that currency against USD (EUR/USD,
+// USD/CHF, ...) when there is one; otherwise the data manager fetches the
+// pair through Twelve Data every FX_REFRESH_INTERVAL_MS. With stock/forex
+// slots in the watchlist that fetch takes one of their turns. A
+// crypto-only watchlist has no turns to give, so there it is an extra
+// Twelve Data call per currency per hour while the forex market is open
+// (and needs the Twelve Data key). Relay followers make no API calls and
+// only get rates from watchlist pairs. Until a rate is known, prices are
+// shown in USD.
+
+enum FxSource : uint8_t {
+  FX_NONE      = 0,
+  FX_WATCHLIST = 1,   // Price of a forex slot
+  FX_FETCHED   = 2    // Pair fetched for the display currency alone
+};
+
+struct FxRate {
+  Price perUsd;          // Units of the currency per USD
+  uint32_t updatedAt;    // appMillis() of the quote (0 = never)
+  FxSource source;
+};
+
+// Twelve Data symbol of the pair quoting c against USD ("EUR/USD", "USD/JPY")
+const char* getFxPair(Currency c);
+
+// Currency a forex symbol gives the rate of (either orientation), or
+// CURRENCY_USD if it is not a USD pair of a display currency
+Currency fxPairCurrency(const char* symbol);
+
+// Store the price of a USD pair (either orientation, see fxPairCurrency);
+// other symbols are ignored
+void setFxQuote(const char* symbol, Price pairPrice, FxSource source);
+
+// Convert a USD price; false (out untouched) while c has no rate
+bool fxConvert(Price usd, Currency c, Price* out);
+
+// Ticker data in its display currency: the price fields are converted and
+// currency set, or left in USD while the rate is unknown
+void fxConvertTicker(TickerData* ticker, SparklineData* sparkline, Currency c);
+
+FxRate getFxRate(Currency c);
@@ -0,0 +1,254 @@
+#include "gzip_inflater.h"
+#include "esp32/rom/miniz.h"
+#include "esp32/rom/crc.h"
+
+#define GZIP_HEADER_LEN     10
+#define GZIP_TRAILER_LEN    8
+#define GZIP_METHOD_DEFLATE 8
+
+// Header FLG bits (RFC 1952 2.3.1); the top three are reserved
+#define GZIP_FHCRC          0x02
+#define GZIP_FEXTRA         0x04
+#define GZIP_FNAME          0x08
+#define GZIP_FCOMMENT       0x10
+#define GZIP_FRESERVED      0xE0
+
+enum GzipPhase : uint8_t {
+  PHASE_HEADER,
+  PHASE_EXTRA_LEN,
+  PHASE_EXTRA,
+  PHASE_NAME,
+  PHASE_COMMENT,
+  PHASE_HEADER_CRC,
+  PHASE_DEFLATE,
+  PHASE_TRAILER
+};
+
+struct GzipInflater {
+  tinfl_decompressor tinfl;
+  uint8_t* dict;           // TINFL_LZ_DICT_SIZE, separate so neither block is huge
+  size_t dictPos;
+  GzipSink sink;
+  void* ctx;
+  GzipPhase phase;
+  GzipResult result;       // Sticky once not GZIP_MORE
+  uint8_t flags;
+  uint8_t field[GZIP_HEADER_LEN];   // Fixed-size header/trailer bytes so far
+  uint8_t fieldLen;
+  uint16_t extraLeft;
+  uint32_t crc;
+  uint32_t outBytes;
+};
+
+static uint32_t readLe32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Gather `need` bytes of a fixed-size field that may straddle feeds
+static bool collect(GzipInflater* z, const uint8_t** data, size_t* len, uint8_t need) {
+  while (z->fieldLen < need && *len > 0) {
+    z->field[z->fieldLen++] = **data;
+    (*data)++;
+    (*len)--;
+  }
+  if (z->fieldLen < need) return false;
+  z->fieldLen = 0;
+  return true;
+}
+
+// Skip a NUL-terminated header string; true once the NUL is consumed
+static bool skipString(const uint8_t** data, size_t* len) {
+  while (*len > 0) {
+    uint8_t c = **data;
+    (*data)++;
+    (*len)--;
+    if (c == 0) return true;
+  }
+  return false;
+}
+
+// First optional header field present after `phase`, else the deflate data
+static GzipPhase nextHeaderPhase(uint8_t flags, GzipPhase phase) {
+  if (phase < PHASE_EXTRA_LEN && (flags & GZIP_FEXTRA)) return PHASE_EXTRA_LEN;
+  if (phase < PHASE_NAME && (flags & GZIP_FNAME)) return PHASE_NAME;
+  if (phase < PHASE_COMMENT && (flags & GZIP_FCOMMENT)) return PHASE_COMMENT;
+  if (phase < PHASE_HEADER_CRC && (flags & GZIP_FHCRC)) return PHASE_HEADER_CRC;
+  return PHASE_DEFLATE;
+}
+
+static void finish(GzipInflater* z, GzipResult result) {
+  z->result = result;
+}
+
+// One tinfl call over the input into the free end of the dictionary. The
+// new bytes (*out, *outLen) stay there until the next call overwrites them.
+static tinfl_status inflateStep(GzipInflater* z, const uint8_t** data, size_t* len,
+                                const uint8_t** out, size_t* outLen) {
+  size_t inBytes = *len;
+  size_t outBytes = TINFL_LZ_DICT_SIZE - z->dictPos;
+  uint8_t* next = z->dict + z->dictPos;
+  tinfl_status status = tinfl_decompress(&z->tinfl, *data, &inBytes, z->dict, next, &outBytes,
+                                         TINFL_FLAG_HAS_MORE_INPUT);
+  *data += inBytes;
+  *len -= inBytes;
+
+  *out = next;
+  *outLen = outBytes;
+  if (outBytes > 0) {
+    z->crc = crc32_le(z->crc, next, outBytes);
+    z->outBytes += outBytes;
+    z->dictPos = (z->dictPos + outBytes) & (TINFL_LZ_DICT_SIZE - 1);
+  }
+
+  if (status < TINFL_STATUS_DONE) {
+    finish(z, GZIP_BAD_DATA);
+  } else if (status == TINFL_STATUS_DONE) {
+    // The ROM tinfl may have read whole trailer bytes ahead into its bit
+    // buffer (it ends byte-aligned); those start the trailer
+    while (z->tinfl.m_num_bits >= 8 && z->fieldLen < GZIP_TRAILER_LEN) {
+      z->field[z->fieldLen++] = (uint8_t)z->tinfl.m_bit_buf;
+      z->tinfl.m_bit_buf >>= 8;
+      z->tinfl.m_num_bits -= 8;
+    }
+    z->phase = PHASE_TRAILER;
+  }
+  return status;
+}
+
+// Run tinfl over the input, handing each stretch of new dictionary bytes
+// to the sink before it can be overwritten
+static void inflateSome(GzipInflater* z, const uint8_t** data, size_t* len) {
+  for (;;) {
+    const uint8_t* out;
+    size_t outBytes;
+    tinfl_status status = inflateStep(z, data, len, &out, &outBytes);
+    if (outBytes > 0 && z->result == GZIP_MORE && !z->sink(out, outBytes, z->ctx)) {
+      finish(z, GZIP_SINK_FAILED);
+      return;
+    }
+    // TINFL_STATUS_HAS_MORE_OUTPUT: the dictionary wrapped, go again
+    if (status != TINFL_STATUS_HAS_MORE_OUTPUT) return;
+  }
+}
+
+// Header, optional header fields and trailer: consume what the current
+// phase needs from the input
+static void readFraming(GzipInflater* z, const uint8_t** data, size_t* len) {
+  switch (z->phase) {
+    case PHASE_HEADER:
+      if (!collect(z, data, len, GZIP_HEADER_LEN)) break;
+      if (!isGzip(z->field, GZIP_HEADER_LEN) || z->field[2] != GZIP_METHOD_DEFLATE ||
+          (z->field[3] & GZIP_FRESERVED)) {
+        finish(z, GZIP_BAD_HEADER);
+        break;
+      }
+      z->flags = z->field[3];
+      z->phase = nextHeaderPhase(z->flags, PHASE_HEADER);
+      break;
+    case PHASE_EXTRA_LEN:
+      if (!collect(z, data, len, 2)) break;
+      z->extraLeft = z->field[0] | (z->field[1] << 8);
+      z->phase = PHASE_EXTRA;
+      break;
+    case PHASE_EXTRA: {
+      size_t n = *len < z->extraLeft ? *len : z->extraLeft;
+      *data += n;
+      *len -= n;
+      z->extraLeft -= n;
+      if (z->extraLeft == 0) z->phase = nextHeaderPhase(z->flags, PHASE_EXTRA);
+      break;
+    }
+    case PHASE_NAME:
+    case PHASE_COMMENT:
+      if (skipString(data, len)) z->phase = nextHeaderPhase(z->flags, z->phase);
+      break;
+    case PHASE_HEADER_CRC:
+      // Optional header CRC16 is skipped; the trailer covers the payload
+      if (collect(z, data, len, 2)) z->phase = PHASE_DEFLATE;
+      break;
+    case PHASE_DEFLATE:
+      break;
+    case PHASE_TRAILER:
+      if (!collect(z, data, len, GZIP_TRAILER_LEN)) break;
+      if (readLe32(z->field) != z->crc || readLe32(z->field + 4) != z->outBytes) {
+        finish(z, GZIP_BAD_CHECKSUM);
+        break;
+      }
+      finish(z, GZIP_DONE);
+      break;
+  }
+}
+
+GzipInflater* gzipBegin(GzipSink sink, void* ctx) {
+  GzipInflater* z = (GzipInflater*)malloc(sizeof(GzipInflater));
+  if (!z) return nullptr;
+  z->dict = (uint8_t*)malloc(TINFL_LZ_DICT_SIZE);
+  if (!z->dict) {
+    free(z);
+    return nullptr;
+  }
+  gzipReset(z, sink, ctx);
+  return z;
+}
+
+void gzipReset(GzipInflater* z, GzipSink sink, void* ctx) {
+  tinfl_init(&z->tinfl);
+  z->dictPos = 0;
+  z->sink = sink;
+  z->ctx = ctx;
+  z->phase = PHASE_HEADER;
+  z->result = GZIP_MORE;
+  z->flags = 0;
+  z->fieldLen = 0;
+  z->extraLeft = 0;
+  z->crc = 0;
+  z->outBytes = 0;
+}
+
+GzipResult gzipFeed(GzipInflater* z, const uint8_t* data, size_t len) {
+  while (z->result == GZIP_MORE && len > 0) {
+    if (z->phase == PHASE_DEFLATE) inflateSome(z, &data, &len);
+    else readFraming(z, &data, &len);
+  }
+  return z->result;
+}
+
+GzipResult gzipInflate(GzipInflater* z, const uint8_t** data, size_t* len,
+                       const uint8_t** out, size_t* outLen) {
+  *outLen = 0;
+  while (z->result == GZIP_MORE) {
+    if (z->phase != PHASE_DEFLATE) {
+      if (*len == 0) break;
+      readFraming(z, data, len);
+      continue;
+    }
+    // Called even without input: tinfl may still owe output from the
+    // last call if it stopped at the end of the dictionary
+    tinfl_status status = inflateStep(z, data, len, out, outLen);
+    if (*outLen > 0 || status == TINFL_STATUS_NEEDS_MORE_INPUT) break;
+  }
+  if (z->result > GZIP_DONE) *outLen = 0;
+  return z->result;
+}
+
+uint32_t gzipOutputBytes(const GzipInflater* z) {
+  return z->outBytes;
+}
+
+void gzipEnd(GzipInflater* z) {
+  if (!z) return;
+  free(z->dict);
+  free(z);
+}
+
+const char* getGzipResultName(GzipResult result) {
+  switch (result) {
+    case GZIP_MORE:         return "incomplete";
+    case GZIP_DONE:         return "ok";
+    case GZIP_BAD_HEADER:   return "not a gzip stream";
+    case GZIP_BAD_DATA:     return "corrupt deflate data";
+    case GZIP_BAD_CHECKSUM: return "gzip CRC/length mismatch";
+    case GZIP_SINK_FAILED:  return "output rejected";
+    default:                return "?";
+  }
+}
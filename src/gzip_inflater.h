@@ -0,0 +1,52 @@
+#pragma once
+#include <Arduino.h>
+
+// Streaming gzip (RFC 1952) decoder on the ROM's tinfl. Compressed bytes go
+// in through gzipFeed() in chunks of any size; inflated bytes come out
+// through the sink as the 32KB LZ dictionary fills, or are read in place
+// with gzipInflate() by a reader that takes them at its own pace. The
+// trailer's CRC-32 and length are checked at the end. Working memory
+// (~43KB: tinfl state + dictionary) is taken from the heap by gzipBegin()
+// and freed by gzipEnd().
+
+// Return false to stop inflating (gzipFeed then reports GZIP_SINK_FAILED)
+typedef bool (*GzipSink)(const uint8_t* data, size_t len, void* ctx);
+
+enum GzipResult : uint8_t {
+  GZIP_MORE = 0,        // Everything consumed; feed more
+  GZIP_DONE,            // Trailer verified; bytes after it are ignored
+  GZIP_BAD_HEADER,
+  GZIP_BAD_DATA,
+  GZIP_BAD_CHECKSUM,
+  GZIP_SINK_FAILED
+};
+
+struct GzipInflater;
+
+// nullptr when the heap cannot supply the working memory
+GzipInflater* gzipBegin(GzipSink sink, void* ctx);
+
+// Start a new stream on the same working memory
+void gzipReset(GzipInflater* z, GzipSink sink, void* ctx);
+
+// Once a result other than GZIP_MORE is returned, it is returned again
+GzipResult gzipFeed(GzipInflater* z, const uint8_t* data, size_t len);
+
+// Pull mode (sink unused, may be nullptr): consume input from *data/*len
+// until some output is ready at *out/*outLen, inside the dictionary and
+// valid until the next call. *outLen is 0 once the input has run out
+// (call again with more) or a result other than GZIP_MORE is returned.
+GzipResult gzipInflate(GzipInflater* z, const uint8_t** data, size_t* len,
+                       const uint8_t** out, size_t* outLen);
+
+// Inflated bytes so far
+uint32_t gzipOutputBytes(const GzipInflater* z);
+
+void gzipEnd(GzipInflater* z);
+
+const char* getGzipResultName(GzipResult result);
+
+// gzip magic (1f 8b) at the start of a buffer
+inline bool isGzip(const uint8_t* data, size_t len) {
+  return len >= 2 && data[0] == 0x1F && data[1] == 0x8B;
+}
@@ -0,0 +1,380 @@
+#include "lan_relay.h"
+#include "event_log.h"
+#include "config.h"
+#include "sparkline_store.h"
+#include "fetch_events.h"
+#include <AsyncUDP.h>
+#include <freertos/queue.h>
+
+static AsyncUDP udp;
+static QueueHandle_t updateQueue = nullptr;
+static portMUX_TYPE relayMux = portMUX_INITIALIZER_UNLOCKED;
+static const IPAddress groupAddr(RELAY_MULTICAST_ADDR);
+
+static RelayStatus status = {};
+static uint32_t watchlistHash = 0;
+static uint32_t takeoverDeadline = 0;   // LISTENING/FOLLOWER: promote after this
+static uint32_t lastLeaderSeq = 0;
+static uint32_t txSeq = 0;
+static uint32_t lastHeartbeat = 0;
+static uint32_t lastSnapshot = 0;
+static uint32_t lastSnapshotRequest = 0;
+static volatile bool snapshotRequested = false;
+// Follower: received sparklines waiting for the fetch task to store them
+// (the flash write must not run on the AsyncUDP task). A newer chart for a
+// slot/timeframe already waiting replaces it. Guarded by relayMux.
+struct PendingChart {
+  bool used;
+  uint8_t index;
+  uint8_t timeframe;
+  SparklineData chart;
+};
+static PendingChart pendingCharts[RELAY_CHART_PENDING];
+// Hash of the last chart taken per slot/timeframe (0 = none), so unchanged
+// charts in every snapshot are dropped without touching the store
+static uint32_t chartHashes[MAX_TICKERS][TIMEFRAME_COUNT];
+
+static void writeHeader(uint8_t* buf, RelayMsgType type, uint16_t count) {
+  // Sent from the fetch task and (snapshot requests) the AsyncUDP task
+  portENTER_CRITICAL(&relayMux);
+  uint32_t seq = ++txSeq;
+  portEXIT_CRITICAL(&relayMux);
+  relayWriteHeader(buf, type, count, seq, status.nodeId, watchlistHash);
+}
+
+static void sendPacket(const uint8_t* buf, size_t len) {
+  if (udp.writeTo(buf, len, groupAddr, RELAY_PORT) == len) {
+    status.packetsSent++;
+  }
+}
+
+// FNV-1a over one wire chart, never 0
+static uint32_t hashChart(const WireSparkline& ws, const uint8_t* points) {
+  uint32_t h = 2166136261u;
+  auto mix = [&h](const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < len; i++) { h ^= p[i]; h *= 16777619u; }
+  };
+  mix(&ws, sizeof(ws));
+  mix(points, ws.len);
+  return h | 1;
+}
+
+// Hand one received sparkline to the fetch task. Returns false if it was
+// dropped because every pending entry is taken.
+static bool queueSparkline(const WireSparkline& ws, const uint8_t* points) {
+  uint32_t hash = hashChart(ws, points);
+  bool queued = true;
+  portENTER_CRITICAL(&relayMux);
+  if (chartHashes[ws.index][ws.timeframe] != hash) {
+    PendingChart* entry = nullptr;
+    for (int i = 0; i < RELAY_CHART_PENDING; i++) {
+      PendingChart& p = pendingCharts[i];
+      if (p.used && p.index == ws.index && p.timeframe == ws.timeframe) {
+        entry = &p;
+        break;
+      }
+      if (!p.used && !entry) entry = &p;
+    }
+    if (entry) {
+      entry->used = true;
+      entry->index = ws.index;
+      entry->timeframe = ws.timeframe;
+      SparklineData& chart = entry->chart;
+      memset(&chart, 0, sizeof(chart));
+      chart.len = ws.len;
+      chart.priceMin = ws.priceMin;
+      chart.priceMax = ws.priceMax;
+      memcpy(chart.points, points, ws.len);
+      chart.valid = ws.len > 0;
+      chartHashes[ws.index][ws.timeframe] = hash;
+    } else {
+      queued = false;
+    }
+  }
+  portEXIT_CRITICAL(&relayMux);
+  return queued;
+}
+
+// Returns false if a price or sparkline was dropped for lack of room
+static bool handleLeaderPacket(const RelayHeader& hdr, const uint8_t* body, size_t bodyLen) {
+  bool queued = true;
+  if (hdr.type == MSG_PRICES) {
+    WirePrice wp;
+    for (int i = 0; i < hdr.count && relayReadPrice(body, bodyLen, i, &wp); i++) {
+      if (wp.index >= MAX_TICKERS) continue;
+      RelayUpdate u = {};
+      u.kind = RELAY_UPDATE_PRICE;
+      u.tickerIndex = wp.index;
+      u.quote.price = wp.price;
+      memcpy(u.quote.change, wp.change, sizeof(wp.change));
+      u.quote.changeMask = wp.flags & 0x0F;
+      u.quote.valid = (wp.flags & 0x80) != 0;
+      if (xQueueSend(updateQueue, &u, 0) != pdTRUE) queued = false;
+    }
+  } else if (hdr.type == MSG_SPARKLINES) {
+    size_t off = 0;
+    WireSparkline ws;
+    const uint8_t* points;
+    for (int i = 0; i < hdr.count && relayNextSparkline(body, bodyLen, &off, &ws, &points); i++) {
+      if (ws.index < MAX_TICKERS && ws.timeframe < TIMEFRAME_COUNT && !queueSparkline(ws, points)) {
+        queued = false;
+      }
+    }
+  }
+  return queued;
+}
+
+// Runs on the AsyncUDP task
+static void onPacket(AsyncUDPPacket& packet) {
+  RelayHeader hdr;
+  if (!relayReadHeader(packet.data(), packet.length(), &hdr)) return;
+  if (hdr.senderId == status.nodeId || hdr.watchlistHash != watchlistHash) return;
+
+  const uint8_t* body = packet.data() + sizeof(hdr);
+  size_t bodyLen = packet.length() - sizeof(hdr);
+  uint32_t now = millis();
+  bool fromLeader = false;
+  bool wantSnapshot = false;
+  bool wake = false;      // The fetch task has something to do
+  bool yielded = false;   // Logged once out of the critical section
+
+  portENTER_CRITICAL(&relayMux);
+  status.packetsReceived++;
+
+  if (hdr.type == MSG_SNAPSHOT_REQUEST) {
+    if (status.role == RELAY_LEADER) snapshotRequested = wake = true;
+  } else {
+    // Anything else is sent by a leader (see relayAcceptsLeader)
+    if (relayAcceptsLeader(status.role, status.nodeId, hdr.senderId)) {
+      if (status.role != RELAY_FOLLOWER || status.leaderId != hdr.senderId) {
+        wantSnapshot = true;
+        lastLeaderSeq = 0;
+      }
+      yielded = status.role == RELAY_LEADER;
+      // Became a follower (stop fetching), or data to apply
+      wake = status.role != RELAY_FOLLOWER || hdr.type != MSG_HEARTBEAT;
+      status.role = RELAY_FOLLOWER;
+      status.leaderId = hdr.senderId;
+      status.lastLeaderSeenMs = now;
+      takeoverDeadline = now + relayTakeoverDelay(status.nodeId);
+
+      if (lastLeaderSeq != 0 && hdr.seq != lastLeaderSeq + 1) {
+        status.sequenceGaps += hdr.seq - lastLeaderSeq - 1;
+        wantSnapshot = true;
+      }
+      lastLeaderSeq = hdr.seq;
+      fromLeader = true;
+    }
+  }
+  portEXIT_CRITICAL(&relayMux);
+
+  if (yielded) LOG_EVENT(EV_RELAY_YIELD, nullptr, hdr.senderId);
+  if (fromLeader && !handleLeaderPacket(hdr, body, bodyLen)) {
+    // Lost prices leave no gap in the sequence; fetch them again
+    portENTER_CRITICAL(&relayMux);
+    status.queueDrops++;
+    portEXIT_CRITICAL(&relayMux);
+    wantSnapshot = true;
+  }
+  if (wake) signalFetchTask(FETCH_EVENT_WORK);
+
+  if (wantSnapshot && now - lastSnapshotRequest > RELAY_HEARTBEAT_MS) {
+    lastSnapshotRequest = now;
+    uint8_t buf[sizeof(RelayHeader)];
+    writeHeader(buf, MSG_SNAPSHOT_REQUEST, 0);
+    sendPacket(buf, sizeof(buf));
+  }
+}
+
+void initLanRelay(const AppConfig* config) {
+  stopLanRelay();
+  if (!config->lanRelay) return;
+
+  if (!updateQueue) {
+    updateQueue = xQueueCreate(RELAY_QUEUE_DEPTH, sizeof(RelayUpdate));
+  }
+
+  status = {};
+  if (updateQueue) xQueueReset(updateQueue);
+  memset(pendingCharts, 0, sizeof(pendingCharts));
+  memset(chartHashes, 0, sizeof(chartHashes));
+  status.nodeId = (uint32_t)ESP.getEfuseMac();
+  watchlistHash = relayWatchlistHash(config);
+
+  if (!udp.listenMulticast(groupAddr, RELAY_PORT)) {
+    LOG_EVENT(EV_RELAY_LISTEN_FAILED, nullptr);
+    return;
+  }
+  udp.onPacket(onPacket);
+
+  portENTER_CRITICAL(&relayMux);
+  status.role = RELAY_LISTENING;
+  takeoverDeadline = millis() + relayTakeoverDelay(status.nodeId);
+  portEXIT_CRITICAL(&relayMux);
+
+  LOG_EVENT(EV_RELAY_LISTENING, nullptr, status.nodeId, watchlistHash);
+}
+
+void stopLanRelay() {
+  if (status.role == RELAY_OFF) return;
+  udp.close();
+  portENTER_CRITICAL(&relayMux);
+  status.role = RELAY_OFF;
+  portEXIT_CRITICAL(&relayMux);
+  LOG_EVENT(EV_RELAY_STOPPED, nullptr);
+}
+
+bool relayShouldFetch() {
+  RelayRole role = status.role;
+  return role == RELAY_OFF || role == RELAY_LEADER;
+}
+
+static void sendSnapshot(const TickerData* tickers, int numTickers) {
+  uint8_t indices[MAX_TICKERS];
+  int count = 0;
+  for (int i = 0; i < numTickers && i < MAX_TICKERS; i++) {
+    if (tickers[i].priceValid) indices[count++] = i;
+  }
+  relayPublishPrices(tickers, indices, count);
+
+  // Pack as many sparklines per datagram as fit
+  uint8_t buf[RELAY_MAX_PACKET];
+  size_t off = sizeof(RelayHeader);
+  uint16_t entries = 0;
+  for (int i = 0; i < numTickers && i < MAX_TICKERS; i++) {
+    for (int tf = 0; tf < TIMEFRAME_COUNT; tf++) {
+      SparklineData sp;
+      if (!readSparkline(i, tf, &sp)) continue;
+      if (off + relaySparklineSize(sp) > sizeof(buf)) {
+        writeHeader(buf, MSG_SPARKLINES, entries);
+        sendPacket(buf, off);
+        off = sizeof(RelayHeader);
+        entries = 0;
+      }
+      off += relayPutSparkline(buf + off, i, tf, sp);
+      entries++;
+    }
+  }
+  if (entries > 0) {
+    writeHeader(buf, MSG_SPARKLINES, entries);
+    sendPacket(buf, off);
+  }
+}
+
+uint32_t relayTick(const TickerData* tickers, int numTickers) {
+  if (status.role == RELAY_OFF) return FETCH_WAIT_FOREVER;
+  uint32_t now = millis();
+
+  // Leader silent (or none found at startup): take over
+  bool promoted = false;
+  portENTER_CRITICAL(&relayMux);
+  if ((status.role == RELAY_LISTENING || status.role == RELAY_FOLLOWER) &&
+      (int32_t)(now - takeoverDeadline) >= 0) {
+    status.role = RELAY_LEADER;
+    status.leaderId = status.nodeId;
+    promoted = true;
+  }
+  portEXIT_CRITICAL(&relayMux);
+
+  if (promoted) {
+    // Our own fetches write the store from now on
+    portENTER_CRITICAL(&relayMux);
+    memset(chartHashes, 0, sizeof(chartHashes));
+    portEXIT_CRITICAL(&relayMux);
+    LOG_EVENT(EV_RELAY_TAKEOVER, nullptr);
+    lastSnapshot = 0;
+  }
+
+  if (status.role != RELAY_LEADER) {
+    int32_t untilTakeover = (int32_t)(takeoverDeadline - now);
+    return untilTakeover > 0 ? untilTakeover : 0;
+  }
+
+  if (now - lastHeartbeat >= RELAY_HEARTBEAT_MS || promoted) {
+    uint8_t buf[sizeof(RelayHeader)];
+    writeHeader(buf, MSG_HEARTBEAT, 0);
+    sendPacket(buf, sizeof(buf));
+    lastHeartbeat = now;
+  }
+
+  if (snapshotRequested || lastSnapshot == 0 || now - lastSnapshot >= RELAY_SNAPSHOT_MS) {
+    snapshotRequested = false;
+    sendSnapshot(tickers, numTickers);
+    lastSnapshot = now;
+  }
+  return min(RELAY_HEARTBEAT_MS - (now - lastHeartbeat), RELAY_SNAPSHOT_MS - (now - lastSnapshot));
+}
+
+void relayPublishPrices(const TickerData* tickers, const uint8_t* indices, int count) {
+  if (status.role != RELAY_LEADER || count <= 0) return;
+
+  uint8_t buf[RELAY_MAX_PACKET];
+  const int perPacket = RELAY_PRICES_PER_PACKET;
+
+  for (int start = 0; start < count; start += perPacket) {
+    int n = min(perPacket, count - start);
+    for (int k = 0; k < n; k++) {
+      WirePrice wp = relayWirePrice(indices[start + k], tickers[indices[start + k]]);
+      memcpy(buf + sizeof(RelayHeader) + k * sizeof(WirePrice), &wp, sizeof(wp));
+    }
+    writeHeader(buf, MSG_PRICES, n);
+    sendPacket(buf, sizeof(RelayHeader) + n * sizeof(WirePrice));
+  }
+}
+
+void relayPublishSparkline(uint8_t tickerIndex, uint8_t timeframe, const SparklineData* sparkline) {
+  if (status.role != RELAY_LEADER || !sparkline->valid) return;
+
+  uint8_t buf[sizeof(RelayHeader) + sizeof(WireSparkline) + SPARKLINE_POINTS];
+  size_t len = relayPutSparkline(buf + sizeof(RelayHeader), tickerIndex, timeframe, *sparkline);
+  writeHeader(buf, MSG_SPARKLINES, 1);
+  sendPacket(buf, sizeof(RelayHeader) + len);
+}
+
+bool relayPoll(RelayUpdate* out) {
+  if (updateQueue && xQueueReceive(updateQueue, out, 0) == pdTRUE) return true;
+
+  // Store waiting sparklines here on the fetch task; identical ones (a
+  // restart with the cache already filled) skip the flash write
+  static SparklineData fresh;
+  for (int i = 0; i < RELAY_CHART_PENDING; i++) {
+    portENTER_CRITICAL(&relayMux);
+    PendingChart& p = pendingCharts[i];
+    bool found = p.used;
+    if (found) {
+      *out = {};
+      out->kind = RELAY_UPDATE_SPARKLINE;
+      out->tickerIndex = p.index;
+      out->timeframe = p.timeframe;
+      fresh = p.chart;
+      p.used = false;
+    }
+    portEXIT_CRITICAL(&relayMux);
+    if (!found) continue;
+
+    SparklineData current;
+    readSparkline(out->tickerIndex, out->timeframe, &current);
+    if (memcmp(&current, &fresh, sizeof(SparklineData)) == 0) continue;
+    writeSparkline(out->tickerIndex, out->timeframe, &fresh);
+    return true;
+  }
+  return false;
+}
+
+RelayStatus getRelayStatus() {
+  portENTER_CRITICAL(&relayMux);
+  RelayStatus snapshot = status;
+  portEXIT_CRITICAL(&relayMux);
+  return snapshot;
+}
+
+const char* getRelayRoleName(RelayRole role) {
+  switch (role) {
+    case RELAY_OFF:       return "off";
+    case RELAY_LISTENING: return "listening";
+    case RELAY_FOLLOWER:  return "follower";
+    case RELAY_LEADER:    return "leader";
+    default: return "?";
+  }
+}
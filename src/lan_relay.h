@@ -0,0 +1,70 @@
+#pragma once
+#include <Arduino.h>
+#include "ticker_types.h"
+#include "api_client.h"
+#include "relay_wire.h"
+
+// LAN price relay over UDP multicast.
+// Tickers sharing a watchlist elect one leader (lowest node id wins). The
+// leader fetches from the APIs as usual and multicasts price/sparkline
+// deltas plus a periodic full snapshot; followers make no API calls and
+// apply what they receive. A follower that hears nothing from the leader
+// for RELAY_LEADER_TIMEOUT_MS promotes itself.
+
+enum RelayUpdateKind : uint8_t {
+  RELAY_UPDATE_PRICE     = 0,
+  RELAY_UPDATE_SPARKLINE = 1
+};
+
+// One received update for the data manager. Prices are queued; a received
+// sparkline waits in a small pending buffer (the latest per slot/timeframe)
+// and is written to the sparkline store by relayPoll(), which then reports
+// only its slot.
+struct RelayUpdate {
+  RelayUpdateKind kind;
+  uint8_t tickerIndex;
+  uint8_t timeframe;    // RELAY_UPDATE_SPARKLINE
+  PriceQuote quote;     // RELAY_UPDATE_PRICE
+};
+
+struct RelayStatus {
+  RelayRole role;
+  uint32_t nodeId;
+  uint32_t leaderId;
+  uint32_t lastLeaderSeenMs;   // millis() of last packet from the leader
+  uint32_t packetsSent;
+  uint32_t packetsReceived;
+  uint32_t sequenceGaps;       // Missed leader packets (healed by snapshots)
+  uint32_t queueDrops;         // Packets with prices or charts lost to full buffers (healed by snapshots)
+};
+
+// Start (or restart after a config change) the relay for this watchlist.
+// Does nothing if config->lanRelay is false.
+void initLanRelay(const AppConfig* config);
+
+// Leave the multicast group and fetch locally again
+void stopLanRelay();
+
+// False while this device is a follower (or still listening for a leader)
+bool relayShouldFetch();
+
+// Periodic work, called from the fetch task: leader heartbeats and
+// snapshots, follower takeover on leader silence. Returns ms until it is
+// due again (see fetch_events.h).
+uint32_t relayTick(const TickerData* tickers, int numTickers);
+
+// Leader only: broadcast fresh prices for the given ticker slots
+void relayPublishPrices(const TickerData* tickers, const uint8_t* indices, int count);
+
+// Leader only: broadcast one refreshed sparkline
+void relayPublishSparkline(uint8_t tickerIndex, uint8_t timeframe, const SparklineData* sparkline);
+
+// Follower: next received update, non-blocking. Returns false if none.
+// Stores received sparklines as it goes (fetch task only), so a
+// RELAY_UPDATE_SPARKLINE slot is already in the sparkline store.
+bool relayPoll(RelayUpdate* out);
+
+RelayStatus getRelayStatus();
+
+// "off", "listening", "follower", "leader"
+const char* getRelayRoleName(RelayRole role);
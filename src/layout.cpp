@@ -0,0 +1,58 @@
+#include "layout.h"
+
+#define BASE_WIDTH  64
+#define BASE_HEIGHT 32
+#define LINE_PITCH  8    // 7px glyph + 1px gap, at scale 1
+
+static_assert(SPARKLINE_POINTS <= 255, "SparklineData::len is 8-bit; chain at most 255 columns");
+
+static ScreenLayout screen;
+static bool screenReady = false;
+
+static LayoutRect rect(int x, int y, int w, int h) {
+  LayoutRect r = { (int16_t)x, (int16_t)y, (int16_t)w, (int16_t)h };
+  return r;
+}
+
+void computeLayout(int width, int height, ScreenLayout* out) {
+  int s = min(width / BASE_WIDTH, height / BASE_HEIGHT);
+  if (s < 1) s = 1;
+  int lineH = 7 * s;
+  int pitch = LINE_PITCH * s;
+
+  out->width = width;
+  out->height = height;
+  out->textScale = s;
+
+  int textW = BASE_WIDTH * s;
+  out->sideBySide = width - textW >= 2 * height;
+
+  if (out->sideBySide) {
+    // Both text lines centred vertically in the column
+    int top = (height - pitch - lineH) / 2;
+    out->header = rect(0, top, textW, lineH);
+    out->subheader = rect(0, top + pitch, textW, lineH);
+    out->chart = rect(textW, 0, width - textW, height);
+  } else {
+    out->header = rect(0, 0, width, lineH);
+    out->subheader = rect(0, pitch, width, lineH);
+    out->chart = rect(0, 2 * pitch, width, height - 2 * pitch);
+  }
+
+  // Same positions as the original 64x32 screens, scaled and centred
+  out->message = rect(s, (height - lineH) / 2, width - s, lineH);
+  out->errorTitle = rect(s, 2 * s, width - s, lineH);
+  out->errorMessage = rect(s, height / 2, width - s, lineH);
+}
+
+const ScreenLayout& getScreenLayout() {
+  if (!screenReady) {
+    computeLayout(DISPLAY_WIDTH, DISPLAY_HEIGHT, &screen);
+    screenReady = true;
+  }
+  return screen;
+}
+
+int getSparklinePoints() {
+  return min((int)getScreenLayout().chart.w, SPARKLINE_POINTS);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// Screen layout computed from the display geometry, so the renderer works
+// on any chain of panels instead of a fixed 64x32 grid.
+//   Text scale: the 5x7 font is drawn at s x s pixels per dot, where s is
+//               how many times 64x32 fits in the display (128x64 -> 2).
+//   Stacked:    symbol/price and change/timeframe lines on top, chart below
+//               (64x32, 64x64, 128x64).
+//   Side by side: when the space right of a 64*s text column is at least
+//               twice the display height, the chart takes that space at
+//               full height (128x32, 192x32).
+// The chart width is also the sparkline resolution (getSparklinePoints).
+
+struct LayoutRect {
+  int16_t x, y, w, h;
+};
+
+struct ScreenLayout {
+  int16_t width, height;
+  uint8_t textScale;
+  bool sideBySide;
+  LayoutRect header;        // Symbol (left) + price (right)
+  LayoutRect subheader;     // Change% (left) + timeframe (right)
+  LayoutRect chart;
+  LayoutRect message;       // Loading screen text
+  LayoutRect errorTitle;
+  LayoutRect errorMessage;
+};
+
+// Lay out a width x height display
+void computeLayout(int width, int height, ScreenLayout* out);
+
+// Layout for this build's DISPLAY_WIDTH x DISPLAY_HEIGHT
+const ScreenLayout& getScreenLayout();
+
+// Points per sparkline: one per chart column, capped at SPARKLINE_POINTS
+int getSparklinePoints();
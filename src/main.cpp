@@ -5,19 +5,34 @@
 #include "wifi_manager.h"
 #include "web_server.h"
 #include "api_client.h"
+#include "fetch_engine.h"
 #include "data_manager.h"
+#include "power_manager.h"
+#include "ota_update.h"
+#include "config_store.h"
+#include "sparkline_store.h"
+#include "alert_engine.h"
+#include "data_age.h"
+#include "fetch_events.h"
+#include "fx_rates.h"
+#include "trace.h"
+#include "simulator.h"
 #include <LittleFS.h>
 #include <ArduinoJson.h>
 
 // Global variables
-AppConfig appConfig;
 TickerData tickerData[MAX_TICKERS];
-volatile bool configChanged = false;
 SemaphoreHandle_t dataMutex = nullptr;
 
+// Config version the render loop last applied (setup applies version 1)
+static uint32_t renderedConfigVersion = 1;
+
+// First watchlist slot of the page on screen. Pages of DISPLAY_PAGE_TICKERS
+// rotate, and only this page and the next need sparklines in RAM.
+static int pageStart = 0;
+
 // Function prototypes
-void loadConfig();
-void onConfigChanged();
+void loadConfig(AppConfig& appConfig, Watchlist& watchlist);
 void fetchTask(void* param);
 
 void setup() {
@@ -32,11 +47,15 @@ void setup() {
     }
     Serial.println("LittleFS mounted");
 
-    // Load configuration
-    loadConfig();
+    // Load configuration and publish it as the first snapshot
+    AppConfig bootConfig = {};
+    Watchlist* bootList = configWatchlistBegin();
+    loadConfig(bootConfig, *bootList);
+    initConfigStore(bootConfig, bootList);
+    const AppConfig* config = configCurrent();
 
     // Initialize display
-    initDisplay(appConfig.brightness);
+    initDisplay(config->brightness);
     renderLoadingScreen("Connecting WiFi...");
 
     // Initialize WiFi
@@ -53,18 +72,41 @@ void setup() {
 
     // Initialize API client
     initApiClient();
-    if (strlen(appConfig.coinGeckoApiKey) > 0) {
-        setCoinGeckoApiKey(appConfig.coinGeckoApiKey);
+    if (strlen(config->coinGeckoApiKey) > 0) {
+        setCoinGeckoApiKey(config->coinGeckoApiKey);
     }
-    if (strlen(appConfig.cmcApiKey) > 0) {
-        setCMCApiKey(appConfig.cmcApiKey);
+    if (strlen(config->cmcApiKey) > 0) {
+        setCMCApiKey(config->cmcApiKey);
     }
 
-    // Initialize data manager
-    initDataManager(&appConfig, tickerData);
+    // Start per-provider fetch workers (Core 0)
+    initFetchEngine();
+
+    // Sparklines: PSRAM when present, else a flash-backed page cache
+    initSparklineStore();
+
+    // Price alert rules (/alerts.json)
+    initAlertEngine();
+
+    // Initialize data manager (version 1 is held for the fetch task until
+    // its first pass)
+    initDataManager(config, tickerData);
+
+    // OTA sessions (uploads arrive through the web server)
+    initOtaUpdate();
 
     // Initialize web server
-    initWebServer(&appConfig, tickerData, onConfigChanged);
+    initWebServer(tickerData);
+
+#if SIM_BUILD
+    // Simulation firmware: no live fetching; run once at boot, again on POST /api/sim
+    renderLoadingScreen("Simulating");
+    requestSimulation();
+    return;
+#endif
+
+    // SNTP + CPU/WiFi power states (driven from the fetch task)
+    initPowerManager(config);
 
     // Create mutex for thread-safe data access
     dataMutex = xSemaphoreCreateMutex();
@@ -87,17 +129,71 @@ void setup() {
     Serial.printf("Setup complete - Free heap: %d bytes, largest block: %d bytes\n",
                   ESP.getFreeHeap(), ESP.getMaxAllocHeap());
 
-    // Force initial data refresh
-    forceRefresh();
+    // Force initial data refresh (on the fetch task, which owns the schedule)
+    signalFetchTask(FETCH_EVENT_REFRESH);
+}
+
+// Hold the current screen, cut short once a new config is published or an
+// alert fires so loop() can start over with it
+static bool holdScreen(uint32_t ms, uint32_t version) {
+    uint32_t start = millis();
+    while (true) {
+        uint32_t elapsed = millis() - start;
+        if (elapsed >= ms) return true;
+        if (configVersion() != version || alertPending()) return false;
+        holdFrame(min(ms - elapsed, (uint32_t)CONFIG_RENDER_POLL_MS));
+    }
+}
+
+// Show every queued alert, flashing for ALERT_SHOW_MS, before the rotation
+// resumes. Alerts fired while the panel is off are dropped from the queue
+// (they stay in /api/alerts).
+static void showAlerts() {
+    AlertEvent alert;
+    while (takeAlert(&alert)) {
+        if (!isDisplayOn()) continue;
+        bool flashOn = true;
+        for (uint32_t shown = 0; shown < ALERT_SHOW_MS; shown += ALERT_FLASH_MS) {
+            renderAlertScreen(alert.symbol, alert.price, alert.detail, alert.up, flashOn);
+            if (shown == 0) alertShown(alert);
+            flashOn = !flashOn;
+            // A newer alert takes over the screen straight away
+            if (!holdFrame(ALERT_FLASH_MS) && alertPending()) break;
+        }
+    }
 }
 
 void loop() {
+    // Safe point: one config snapshot for the whole cycle
+    const AppConfig* config = configAcquire(CONFIG_READER_RENDER);
+    if (config->version != renderedConfigVersion) {
+        initDisplay(config->brightness);
+        renderedConfigVersion = config->version;
+        pageStart = 0;
+    }
+
+#if SIM_BUILD
+    simulatorLoop(config);
+    delay(100);
+    return;
+#endif
+
+    // Alerts preempt the rotation; the interrupted page starts over after
+    showAlerts();
+
     // Main display loop runs on Core 1
-    // Fixed cycle: ticker1 24H > 7D > 30D > 90D > ticker2 24H > 7D > ...
+    // Fixed cycle: ticker1 24H > 7D > 30D > 90D > ticker2 24H > 7D > ...,
+    // one page of the watchlist per pass
+    if (pageStart >= config->numTickers) pageStart = 0;
+    int pageEnd = min(pageStart + DISPLAY_PAGE_TICKERS, (int)config->numTickers);
+
+    // The fetch task pages this window's sparklines in ahead of time
+    setSparklineWindow(pageStart, 2 * DISPLAY_PAGE_TICKERS);
+
     bool anyEnabled = false;
 
-    for (int i = 0; i < appConfig.numTickers; i++) {
-        if (!appConfig.tickers[i].enabled) {
+    for (int i = pageStart; i < pageEnd; i++) {
+        if (!config->tickers[i].enabled) {
             continue;
         }
 
@@ -105,74 +201,105 @@ void loop() {
 
         // Thread-safe copy of ticker data
         TickerData localTicker;
+        TRACE_BEGIN("dataMutex.wait");
         if (xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
+            TRACE_END("dataMutex.wait");
             localTicker = tickerData[i];
             xSemaphoreGive(dataMutex);
         }
 
         // Always show all 4 timeframes in order
-        for (int tf = 0; tf < 4; tf++) {
-            renderTickerScreen(localTicker, (ChartTimeframe)tf);
-            delay(appConfig.baseTimeMs * appConfig.tickers[i].timeMultiplier);
+        for (int tf = 0; tf < TIMEFRAME_COUNT; tf++) {
+            SparklineData sparkline;
+            readSparkline(i, tf, &sparkline);
+            bool stale = ageRendered(i, localTicker.type) && config->staleMarker;
+
+            // Fetched in USD; converted here with the cached rate
+            TickerData shown = localTicker;
+            fxConvertTicker(&shown, &sparkline, getTickerCurrency(config, i));
+            renderTickerScreen(shown, sparkline, (ChartTimeframe)tf, stale);
+            if (!holdScreen(config->baseTimeMs * config->tickers[i].timeMultiplier, config->version)) {
+                return;
+            }
         }
     }
+    pageStart = pageEnd;
+
+    // Pages with nothing enabled are skipped; say so if that is every page
+    for (int i = 0; i < config->numTickers && !anyEnabled; i++) {
+        anyEnabled = config->tickers[i].enabled;
+    }
 
     // If no tickers enabled, show loading screen
     if (!anyEnabled) {
         renderLoadingScreen("No tickers\nenabled");
-        delay(2000);
+        holdScreen(2000, config->version);
     }
 }
 
 void fetchTask(void* param) {
     Serial.println("Fetch task started on core " + String(xPortGetCoreID()));
+    uint32_t appliedConfigVersion = 1;
+    uint32_t events = 0;
+    registerFetchTask();
 
     while (true) {
-        // Update data from APIs
-        updateData();
-
-        // Check if config changed
-        if (configChanged) {
+        // Safe point: the snapshot stays valid until the next pass acquires
+        const AppConfig* config = configAcquire(CONFIG_READER_FETCH);
+        if (config->version != appliedConfigVersion) {
+            TRACE_SCOPE("configReload");
             Serial.println("Config changed, reinitializing data manager");
 
             // Reinitialize data manager with new config
-            initDataManager(&appConfig, tickerData);
+            initDataManager(config, tickerData);
 
             // Update API keys if changed
-            if (strlen(appConfig.coinGeckoApiKey) > 0) {
-                setCoinGeckoApiKey(appConfig.coinGeckoApiKey);
+            if (strlen(config->coinGeckoApiKey) > 0) {
+                setCoinGeckoApiKey(config->coinGeckoApiKey);
             }
-            if (strlen(appConfig.cmcApiKey) > 0) {
-                setCMCApiKey(appConfig.cmcApiKey);
+            if (strlen(config->cmcApiKey) > 0) {
+                setCMCApiKey(config->cmcApiKey);
             }
 
+            // Timezone, quiet hours and low-power setting
+            initPowerManager(config);
+
             // Force refresh with new config
             forceRefresh();
 
-            configChanged = false;
+            appliedConfigVersion = config->version;
+        } else if (events & FETCH_EVENT_REFRESH) {
+            forceRefresh();
+        } else if (events & FETCH_EVENT_WIFI) {
+            // Prices went stale while offline
+            refreshPrices();
         }
 
-        // Small delay to prevent task starvation
-        vTaskDelay(pdMS_TO_TICKS(100));
-    }
-}
+        // Apply finished fetches and schedule new ones (never blocks on HTTP)
+        uint32_t wait = updateData();
+
+        // Clock down / let WiFi sleep when nothing is in flight
+        wait = min(wait, powerTick());
 
-void onConfigChanged() {
-    Serial.println("Config changed callback");
+        // OTA idle timeout and the restart after a verified update
+        wait = min(wait, otaTick());
 
-    // Update display brightness immediately
-    initDisplay(appConfig.brightness);
+        // Read the next display pages' sparklines back from flash; more
+        // pages than one pass's budget go again right away
+        if (sparklineStoreTick()) wait = 0;
 
-    // Signal fetch task to reload
-    configChanged = true;
+        // Sleep until the nearest deadline or until another task signals
+        events = waitFetchEvents(wait);
+    }
 }
 
-void loadConfig() {
+void loadConfig(AppConfig& appConfig, Watchlist& watchlist) {
     File f = LittleFS.open("/config.json", "r");
 
     if (!f) {
         Serial.println("Config file not found, using defaults");
         appConfig = getDefaultConfig();
+        getDefaultWatchlist(&watchlist);
         return;
     }
 
@@ -183,13 +310,14 @@ void loadConfig() {
     if (error) {
         Serial.println("Failed to parse config, using defaults");
         appConfig = getDefaultConfig();
+        getDefaultWatchlist(&watchlist);
         return;
     }
 
     // Load config from JSON
     appConfig.brightness = doc["brightness"] | 128;
     appConfig.baseTimeMs = doc["baseTimeMs"] | 3000;
-    appConfig.numTickers = doc["numTickers"] | 0;
+    watchlist.numTickers = doc["numTickers"] | 0;
 
     strlcpy(appConfig.twelveDataApiKey,
             doc["twelveDataApiKey"] | "",
@@ -203,28 +331,40 @@ void loadConfig() {
             doc["cmcApiKey"] | "",
             sizeof(appConfig.cmcApiKey));
 
+    appConfig.lanRelay = doc["lanRelay"] | false;
+    appConfig.lowPower = doc["lowPower"] | true;
+    appConfig.marketStream = doc["marketStream"] | true;
+    appConfig.staleMarker = doc["staleMarker"] | true;
+    appConfig.currency = (Currency)parseCurrency(doc["currency"] | "USD", CURRENCY_USD);
+    strlcpy(appConfig.timezone,
+            doc["timezone"] | DEFAULT_TIMEZONE,
+            sizeof(appConfig.timezone));
+    appConfig.quietStartHour = doc["quietStartHour"] | 0;
+    appConfig.quietEndHour = doc["quietEndHour"] | 0;
+
     if (!doc["tickers"].isNull()) {
         JsonArray tickers = doc["tickers"];
-        appConfig.numTickers = min((int)tickers.size(), MAX_TICKERS);
+        watchlist.numTickers = min((int)tickers.size(), MAX_TICKERS);
 
-        for (int i = 0; i < appConfig.numTickers; i++) {
+        for (int i = 0; i < watchlist.numTickers; i++) {
             JsonObject t = tickers[i];
-            strlcpy(appConfig.tickers[i].symbol,
+            strlcpy(watchlist.tickers[i].symbol,
                     t["symbol"] | "",
-                    sizeof(appConfig.tickers[i].symbol));
+                    sizeof(watchlist.tickers[i].symbol));
 
-            strlcpy(appConfig.tickers[i].apiId,
+            strlcpy(watchlist.tickers[i].apiId,
                     t["apiId"] | "",
-                    sizeof(appConfig.tickers[i].apiId));
+                    sizeof(watchlist.tickers[i].apiId));
 
-            appConfig.tickers[i].type = (TickerType)(t["type"] | 0);
-            appConfig.tickers[i].timeMultiplier = t["timeMultiplier"] | 1;
-            appConfig.tickers[i].enabled = t["enabled"] | true;
+            watchlist.tickers[i].type = (TickerType)(t["type"] | 0);
+            watchlist.tickers[i].timeMultiplier = t["timeMultiplier"] | 1;
+            watchlist.tickers[i].enabled = t["enabled"] | true;
+            watchlist.tickers[i].currency = parseCurrency(t["currency"] | "", CURRENCY_DEFAULT);
         }
     }
 
     Serial.printf("Config loaded: %d tickers, brightness %d\n",
-                  appConfig.numTickers, appConfig.brightness);
+                  watchlist.numTickers, appConfig.brightness);
 
     // Load API keys from secrets.json (gitignored, separate from config)
     File sf = LittleFS.open("/secrets.json", "r");
@@ -0,0 +1,226 @@
+#include "market_calendar.h"
+
+#define HOUR_S              3600
+#define DAY_S               86400
+#define LOOKBACK_DAYS       14     // Longest search for a session (covers any holiday run)
+#define STOCK_OPEN_S        (9 * HOUR_S + 30 * 60)
+#define STOCK_CLOSE_S       (16 * HOUR_S)
+#define STOCK_EARLY_CLOSE_S (13 * HOUR_S)
+#define FOREX_ROLL_S        (17 * HOUR_S)   // Weekly open (Sunday) and close (Friday)
+
+// NYSE/Nasdaq full-day closures and 13:00 early closes, New York dates
+struct MarketHoliday {
+  uint32_t date;      // YYYYMMDD
+  bool earlyClose;
+};
+
+static const MarketHoliday nyseHolidays[] = {
+  { 20250101, false }, { 20250109, false }, { 20250120, false }, { 20250217, false },
+  { 20250418, false }, { 20250526, false }, { 20250619, false }, { 20250703, true  },
+  { 20250704, false }, { 20250901, false }, { 20251127, false }, { 20251128, true  },
+  { 20251224, true  }, { 20251225, false },
+
+  { 20260101, false }, { 20260119, false }, { 20260216, false }, { 20260403, false },
+  { 20260525, false }, { 20260619, false }, { 20260703, false }, { 20260907, false },
+  { 20261126, false }, { 20261127, true  }, { 20261224, true  }, { 20261225, false },
+
+  { 20270101, false }, { 20270118, false }, { 20270215, false }, { 20270326, false },
+  { 20270531, false }, { 20270618, false }, { 20270705, false }, { 20270906, false },
+  { 20271125, false }, { 20271126, true  }, { 20271224, false },
+
+  { 20280117, false }, { 20280221, false }, { 20280414, false }, { 20280529, false },
+  { 20280619, false }, { 20280704, false }, { 20280904, false }, { 20281123, false },
+  { 20281124, true  }, { 20281225, false },
+};
+
+// Days since 1970-01-01 (proleptic Gregorian, H. Hinnant's algorithm)
+static int32_t daysFromCivil(int y, int m, int d) {
+  y -= m <= 2;
+  int32_t era = (y >= 0 ? y : y - 399) / 400;
+  int32_t yoe = y - era * 400;
+  int32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  int32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+static void civilFromDays(int32_t z, int* y, int* m, int* d) {
+  z += 719468;
+  int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+  int32_t doe = z - era * 146097;
+  int32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  int32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  int32_t mp = (5 * doy + 2) / 153;
+  *d = doy - (153 * mp + 2) / 5 + 1;
+  *m = mp < 10 ? mp + 3 : mp - 9;
+  *y = yoe + era * 400 + (*m <= 2);
+}
+
+// 0 = Sunday (1970-01-01 was a Thursday)
+static int weekday(int32_t day) {
+  return (int)((day % 7 + 11) % 7);
+}
+
+static int32_t nthSunday(int y, int m, int n) {
+  int32_t first = daysFromCivil(y, m, 1);
+  return first + (7 - weekday(first)) % 7 + 7 * (n - 1);
+}
+
+// US DST: second Sunday of March 02:00 EST to first Sunday of November 02:00 EDT
+static bool newYorkDst(time_t utc) {
+  int y, m, d;
+  civilFromDays((int32_t)(utc / DAY_S), &y, &m, &d);
+  time_t start = (time_t)nthSunday(y, 3, 2) * DAY_S + 7 * HOUR_S;
+  time_t end = (time_t)nthSunday(y, 11, 1) * DAY_S + 6 * HOUR_S;
+  return utc >= start && utc < end;
+}
+
+static time_t newYorkLocal(time_t utc) {
+  return utc - (newYorkDst(utc) ? 4 : 5) * HOUR_S;
+}
+
+static int32_t newYorkDay(time_t utc) {
+  return (int32_t)(newYorkLocal(utc) / DAY_S);
+}
+
+// UTC time of a New York wall-clock time (sessions never fall in the
+// repeated or skipped DST hour)
+static time_t newYorkToUtc(int32_t day, int32_t secondOfDay) {
+  time_t local = (time_t)day * DAY_S + secondOfDay;
+  time_t utc = local + 5 * HOUR_S;
+  return newYorkDst(utc) ? local + 4 * HOUR_S : utc;
+}
+
+// Regular session of a New York day; false on weekends and holidays
+static bool stockSession(int32_t day, time_t* open, time_t* close) {
+  int wd = weekday(day);
+  if (wd == 0 || wd == 6) return false;
+
+  int y, m, d;
+  civilFromDays(day, &y, &m, &d);
+  uint32_t date = (uint32_t)y * 10000 + m * 100 + d;
+  int32_t closeS = STOCK_CLOSE_S;
+  for (size_t i = 0; i < sizeof(nyseHolidays) / sizeof(nyseHolidays[0]); i++) {
+    if (nyseHolidays[i].date != date) continue;
+    if (!nyseHolidays[i].earlyClose) return false;
+    closeS = STOCK_EARLY_CLOSE_S;
+  }
+
+  *open = newYorkToUtc(day, STOCK_OPEN_S);
+  *close = newYorkToUtc(day, closeS);
+  return true;
+}
+
+static bool forexOpen(time_t t) {
+  time_t local = newYorkLocal(t);
+  int wd = weekday((int32_t)(local / DAY_S));
+  int32_t s = (int32_t)(local % DAY_S);
+  if (wd == 6) return false;
+  if (wd == 5) return s < FOREX_ROLL_S;
+  if (wd == 0) return s >= FOREX_ROLL_S;
+  return true;
+}
+
+bool isMarketOpen(TickerType type, time_t t) {
+  switch (type) {
+    case TICKER_STOCK: {
+      time_t open, close;
+      return stockSession(newYorkDay(t), &open, &close) && t >= open && t < close;
+    }
+    case TICKER_FOREX:
+      return forexOpen(t);
+    default:
+      return true;
+  }
+}
+
+// Stock candles run hourly from the open, the last one cut short by the close
+static time_t stockCandleClose(CandleInterval interval, time_t t) {
+  int32_t today = newYorkDay(t);
+  for (int32_t day = today; day > today - LOOKBACK_DAYS; day--) {
+    time_t open, close;
+    if (!stockSession(day, &open, &close) || open >= t) continue;
+    if (t >= close) return close;
+    if (interval == CANDLE_1H && t - open >= HOUR_S) {
+      return open + (t - open) / HOUR_S * HOUR_S;
+    }
+  }
+  return 0;
+}
+
+// Forex and crypto candles are aligned to UTC; one counts if the market
+// traded during any hour of it
+static time_t alignedCandleClose(TickerType type, CandleInterval interval, time_t t) {
+  time_t period = interval == CANDLE_1H ? HOUR_S : DAY_S;
+  time_t stop = t - (time_t)LOOKBACK_DAYS * DAY_S;
+  for (time_t end = t - t % period; end > stop; end -= period) {
+    for (time_t h = end - period; h < end; h += HOUR_S) {
+      if (isMarketOpen(type, h)) return end;
+    }
+  }
+  return 0;
+}
+
+time_t lastCandleClose(TickerType type, CandleInterval interval, time_t t) {
+  if (type == TICKER_STOCK) return stockCandleClose(interval, t);
+  return alignedCandleClose(type, interval, t);
+}
+
+time_t lastMarketClose(TickerType type, time_t t) {
+  if (type == TICKER_STOCK) return stockCandleClose(CANDLE_1DAY, t);
+  if (type != TICKER_FOREX) return 0;
+
+  int32_t today = newYorkDay(t);
+  for (int32_t day = today; day > today - 8; day--) {
+    if (weekday(day) != 5) continue;
+    time_t close = newYorkToUtc(day, FOREX_ROLL_S);
+    if (close <= t) return close;
+  }
+  return 0;
+}
+
+time_t nextMarketOpen(TickerType type, time_t t) {
+  if (isMarketOpen(type, t)) return t;
+
+  int32_t today = newYorkDay(t);
+  for (int32_t day = today; day < today + LOOKBACK_DAYS; day++) {
+    time_t open, close;
+    if (type == TICKER_STOCK) {
+      if (stockSession(day, &open, &close) && open > t) return open;
+    } else if (weekday(day) == 0) {
+      open = newYorkToUtc(day, FOREX_ROLL_S);
+      if (open > t) return open;
+    }
+  }
+  return 0;
+}
+
+const char* getMarketName(TickerType type) {
+  switch (type) {
+    case TICKER_CRYPTO: return "crypto";
+    case TICKER_STOCK:  return "stock";
+    case TICKER_FOREX:  return "forex";
+    default:            return "?";
+  }
+}
+
+bool parseIsoTime(const char* text, int64_t* outMs) {
+  if (!text) return false;
+  int y, mo, d, h, mi, s, n = 0;
+  if (sscanf(text, "%4d-%2d-%2dT%2d:%2d:%2d%n", &y, &mo, &d, &h, &mi, &s, &n) != 6) return false;
+  if (mo < 1 || mo > 12 || d < 1 || d > 31 || h > 23 || mi > 59 || s > 60) return false;
+
+  // Fraction: first three digits are milliseconds
+  int ms = 0;
+  const char* p = text + n;
+  if (*p == '.') {
+    int scale = 100;
+    for (p++; *p >= '0' && *p <= '9'; p++) {
+      ms += (*p - '0') * scale;
+      scale /= 10;
+    }
+  }
+  if (*p != 'Z' && *p != '\0' && strncmp(p, "+00:00", 6) != 0) return false;
+
+  *outMs = ((int64_t)daysFromCivil(y, mo, d) * 86400 + h * 3600 + mi * 60 + s) * 1000 + ms;
+  return true;
+}
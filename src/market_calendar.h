@@ -0,0 +1,37 @@
+#pragma once
+#include <Arduino.h>
+#include <time.h>
+#include "ticker_types.h"
+
+// Trading sessions per TickerType, so stock/forex fetches are only spent
+// when the data can change.
+//   Crypto: always open
+//   Stock:  NYSE/Nasdaq regular hours, 09:30-16:00 New York time, Mon-Fri,
+//           minus the holiday table (13:00 close on early-close days)
+//   Forex:  Sunday 17:00 to Friday 17:00 New York time
+// New York time follows the US DST rule, independent of the configured
+// timezone. Dates past the end of the holiday table count as normal
+// trading days. All times are UTC seconds.
+
+enum CandleInterval : uint8_t {
+  CANDLE_1H   = 0,   // Twelve Data "1h": stock candles start at the 09:30 open
+  CANDLE_1DAY = 1    // Stock: the session close; forex/crypto: 00:00 UTC
+};
+
+bool isMarketOpen(TickerType type, time_t t);
+
+// Close time of the latest candle that ended at or before t (0 if none
+// in the last two weeks)
+time_t lastCandleClose(TickerType type, CandleInterval interval, time_t t);
+
+// Latest open -> closed transition at or before t (0 for crypto)
+time_t lastMarketClose(TickerType type, time_t t);
+
+// Start of the next session after t, or t while the market is open
+time_t nextMarketOpen(TickerType type, time_t t);
+
+const char* getMarketName(TickerType type);
+
+// ISO 8601 UTC timestamp as CMC and CoinGecko send it
+// ("2026-01-05T14:30:00.123Z", fraction optional) to UTC milliseconds
+bool parseIsoTime(const char* text, int64_t* outMs);
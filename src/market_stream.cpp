@@ -0,0 +1,488 @@
+#include "market_stream.h"
+#include "config.h"
+#include "fetch_arena.h"
+#include "event_log.h"
+#include "app_clock.h"
+#include "trace.h"
+#include "fetch_events.h"
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <lwip/sockets.h>
+#include <ctype.h>
+
+// RFC 6455 opcodes
+enum : uint8_t {
+  WS_CONTINUATION = 0x0,
+  WS_TEXT         = 0x1,
+  WS_BINARY       = 0x2,
+  WS_CLOSE        = 0x8,
+  WS_PING         = 0x9,
+  WS_PONG         = 0xA
+};
+
+struct StreamSlot {
+  char pair[STREAM_PAIR_LEN];   // "BTCUSDT" as the exchange reports it; "" = not streamed
+  PriceQuote quote;
+  uint32_t receivedAt;          // 0 = no price yet
+  bool dirty;                   // Changed since the last streamPoll()
+};
+
+// The worker writes slots and status; the fetch task and web server read
+static SemaphoreHandle_t streamMutex = nullptr;
+static TaskHandle_t streamTask = nullptr;
+
+static StreamSlot slots[MAX_TICKERS];
+static int numSlots = 0;
+static uint32_t subscription = 0;          // Hash of the pair list
+static volatile bool enabled = false;      // config->marketStream
+static volatile bool active = false;       // setMarketStreamActive()
+static volatile bool resubscribe = false;  // Pairs changed: reconnect with the new list
+static StreamStatus status = {};
+static uint32_t connectedAt = 0;
+static volatile bool pending = false;      // Some slot is dirty
+
+#if STREAM_TLS
+static WiFiClientSecure client;
+#else
+static WiFiClient client;
+#endif
+
+// Worker only: the message being assembled and the arena it is parsed in
+static char message[STREAM_MSG_MAX + 1];
+static size_t messageLen = 0;
+static bool messageOverflow = false;
+static uint8_t arenaBuffer[STREAM_ARENA_SIZE] __attribute__((aligned(8)));
+static FetchArena arena(arenaBuffer, STREAM_ARENA_SIZE);
+
+static const char* stateNames[] = { "off", "connecting", "live", "backoff" };
+
+static bool lock() {
+  return streamMutex && xSemaphoreTake(streamMutex, portMAX_DELAY) == pdTRUE;
+}
+
+static void unlock() {
+  xSemaphoreGive(streamMutex);
+}
+
+static void setState(StreamState state) {
+  if (!lock()) return;
+  status.state = state;
+  unlock();
+}
+
+static bool shouldConnect() {
+  return enabled && active && status.pairs > 0 && WiFi.status() == WL_CONNECTED;
+}
+
+// ---- socket helpers ----
+
+// Read exactly len bytes; false on disconnect or STREAM_READ_TIMEOUT_MS
+static bool readBytes(uint8_t* buf, size_t len) {
+  uint32_t start = millis();
+  size_t got = 0;
+  while (got < len) {
+    int n = client.read(buf + got, len - got);
+    if (n > 0) {
+      got += n;
+      continue;
+    }
+    if (!client.connected() || millis() - start > STREAM_READ_TIMEOUT_MS) return false;
+    vTaskDelay(1);
+  }
+  return true;
+}
+
+static bool skipBytes(uint64_t len) {
+  uint8_t scratch[64];
+  while (len > 0) {
+    size_t n = len < sizeof(scratch) ? (size_t)len : sizeof(scratch);
+    if (!readBytes(scratch, n)) return false;
+    len -= n;
+  }
+  return true;
+}
+
+// Client frames are always masked; payloads here are control-sized
+static bool sendFrame(uint8_t opcode, const uint8_t* payload, size_t len) {
+  uint8_t frame[6 + 125];
+  if (len > 125) return false;
+  frame[0] = 0x80 | opcode;
+  frame[1] = 0x80 | (uint8_t)len;
+  uint32_t mask = esp_random();
+  memcpy(frame + 2, &mask, 4);
+  for (size_t i = 0; i < len; i++) frame[6 + i] = payload[i] ^ frame[2 + (i & 3)];
+  return client.write(frame, 6 + len) == 6 + len;
+}
+
+static void base64Encode(const uint8_t* in, size_t len, char* out) {
+  static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  size_t o = 0;
+  for (size_t i = 0; i < len; i += 3) {
+    uint32_t v = (uint32_t)in[i] << 16;
+    if (i + 1 < len) v |= (uint32_t)in[i + 1] << 8;
+    if (i + 2 < len) v |= in[i + 2];
+    out[o++] = table[(v >> 18) & 63];
+    out[o++] = table[(v >> 12) & 63];
+    out[o++] = i + 1 < len ? table[(v >> 6) & 63] : '=';
+    out[o++] = i + 2 < len ? table[v & 63] : '=';
+  }
+  out[o] = '\0';
+}
+
+// Upgrade request; the pairs go in the path (combined stream), written
+// piecewise so a 64-pair list needs no buffer
+static bool sendHandshake() {
+  uint8_t nonce[16];
+  for (int i = 0; i < 16; i += 4) {
+    uint32_t r = esp_random();
+    memcpy(nonce + i, &r, 4);
+  }
+  char key[25];
+  base64Encode(nonce, sizeof(nonce), key);
+
+  client.print("GET " STREAM_PATH);
+  bool first = true;
+  if (!lock()) return false;
+  for (int i = 0; i < numSlots; i++) {
+    if (!slots[i].pair[0]) continue;
+    char stream[STREAM_PAIR_LEN + 16];
+    size_t n = 0;
+    if (!first) stream[n++] = '/';
+    for (const char* c = slots[i].pair; *c; c++) stream[n++] = tolower(*c);
+    strlcpy(stream + n, "@miniTicker", sizeof(stream) - n);
+    client.print(stream);
+    first = false;
+  }
+  unlock();
+  client.printf(" HTTP/1.1\r\nHost: %s:%d\r\n", STREAM_HOST, STREAM_PORT);
+  client.print("Upgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Version: 13\r\n");
+  client.printf("Sec-WebSocket-Key: %s\r\n\r\n", key);
+  return client.connected();
+}
+
+// Status line must be 101; the rest of the headers are skipped (a read-only
+// public feed gains nothing from checking Sec-WebSocket-Accept)
+static bool readHandshake() {
+  char line[64];
+  size_t n = 0;
+  bool statusLine = true;
+  bool upgraded = false;
+  while (true) {
+    uint8_t c;
+    if (!readBytes(&c, 1)) return false;
+    if (c == '\r') continue;
+    if (c != '\n') {
+      if (n < sizeof(line) - 1) line[n++] = c;
+      continue;
+    }
+    line[n] = '\0';
+    if (n == 0) return upgraded;   // End of headers
+    if (statusLine) {
+      upgraded = strncmp(line, "HTTP/1.1 101", 12) == 0;
+      statusLine = false;
+    }
+    n = 0;
+  }
+}
+
+// ---- messages ----
+
+// {"stream":"btcusdt@miniTicker","data":{"E":1767623400123,"s":"BTCUSDT","c":"67012.10","o":"65877.00",...}}
+static void handleMessage() {
+  TRACE_SCOPE("stream.parse");
+  arena.reset();
+  JsonDocument filter(&arena);
+  filter["data"]["s"] = true;
+  filter["data"]["c"] = true;
+  filter["data"]["o"] = true;
+  filter["data"]["E"] = true;
+  JsonDocument doc(&arena);
+  if (deserializeJson(doc, (const char*)message, messageLen, DeserializationOption::Filter(filter))) return;
+
+  JsonObjectConst data = doc["data"];
+  const char* symbol = data["s"] | "";
+  Price price, open;
+  if (!parsePrice(data["c"] | "", &price) || price <= 0) return;
+  bool haveOpen = parsePrice(data["o"] | "", &open) && open > 0;
+  int64_t eventMs = data["E"] | (int64_t)0;   // Exchange event time
+
+  uint32_t now = appMillis();
+  if (!lock()) return;
+  bool matched = false;
+  for (int i = 0; i < numSlots; i++) {
+    StreamSlot& slot = slots[i];
+    if (strcmp(slot.pair, symbol) != 0) continue;
+    matched = true;
+    slot.quote.price = price;
+    slot.quote.valid = true;
+    slot.quote.sourceMs = eventMs;
+    if (haveOpen) {
+      slot.quote.change[TIMEFRAME_24H] = priceToFloat(price - open) / priceToFloat(open) * 100.0f;
+      slot.quote.changeMask = 1 << TIMEFRAME_24H;
+    }
+    slot.receivedAt = now;
+    slot.dirty = true;
+  }
+  status.messages++;
+  status.lastMessageMs = now;
+  // First price since the last poll: the data manager schedules a publish
+  bool first = matched && !pending;
+  if (matched) pending = true;
+  unlock();
+  if (first) signalFetchTask(FETCH_EVENT_WORK);
+}
+
+// One frame; returns why the connection should end, or nullptr
+static const char* readFrame() {
+  uint8_t header[2];
+  if (!readBytes(header, 2)) return "read failed";
+  bool fin = header[0] & 0x80;
+  uint8_t opcode = header[0] & 0x0F;
+  if (header[1] & 0x80) return "masked frame";   // Servers never mask
+  uint64_t len = header[1] & 0x7F;
+  if (len >= 126) {
+    uint8_t ext[8];
+    int bytes = len == 126 ? 2 : 8;
+    if (!readBytes(ext, bytes)) return "read failed";
+    len = 0;
+    for (int i = 0; i < bytes; i++) len = (len << 8) | ext[i];
+  }
+
+  switch (opcode) {
+    case WS_TEXT:
+    case WS_CONTINUATION:
+      if (opcode == WS_TEXT) {
+        messageLen = 0;
+        messageOverflow = false;
+      }
+      // Oversized messages (not a ticker update) are dropped whole
+      if (messageOverflow || messageLen + len > STREAM_MSG_MAX) {
+        messageOverflow = true;
+        if (!skipBytes(len)) return "read failed";
+      } else {
+        if (!readBytes((uint8_t*)message + messageLen, (size_t)len)) return "read failed";
+        messageLen += (size_t)len;
+      }
+      if (fin && !messageOverflow) {
+        message[messageLen] = '\0';
+        handleMessage();
+      }
+      return nullptr;
+
+    case WS_PING: {
+      uint8_t payload[125];
+      if (len > sizeof(payload)) return "bad ping";
+      if (!readBytes(payload, (size_t)len)) return "read failed";
+      return sendFrame(WS_PONG, payload, (size_t)len) ? nullptr : "write failed";
+    }
+
+    case WS_CLOSE:
+      skipBytes(len);
+      return "closed by server";
+
+    default:   // Pong, binary
+      return skipBytes(len) ? nullptr : "read failed";
+  }
+}
+
+// Sleep on the socket until bytes arrive or timeoutMs passes. False if the
+// connection has no socket to wait on.
+static bool waitReadable(uint32_t timeoutMs) {
+  int fd = client.fd();
+  if (fd < 0) return false;
+  fd_set readable;
+  FD_ZERO(&readable);
+  FD_SET(fd, &readable);
+  struct timeval tv;
+  tv.tv_sec = timeoutMs / 1000;
+  tv.tv_usec = (timeoutMs % 1000) * 1000;
+  return select(fd + 1, &readable, nullptr, nullptr, &tv) >= 0;
+}
+
+// Connect, subscribe and read until told to stop or the link fails.
+// Returns nullptr for a deliberate stop, else the reason it failed.
+static const char* runConnection() {
+#if STREAM_TLS
+  client.setInsecure();   // Same as the REST clients: no CA store
+  client.setHandshakeTimeout(STREAM_READ_TIMEOUT_MS / 1000);
+#endif
+  if (!client.connect(STREAM_HOST, STREAM_PORT)) return "connect failed";
+  if (!sendHandshake()) return "write failed";
+  if (!readHandshake()) return "upgrade refused";
+
+  uint32_t now = millis();
+  if (lock()) {
+    status.state = STREAM_LIVE;
+    status.connects++;
+    connectedAt = now;
+    unlock();
+  }
+  LOG_EVENT(EV_STREAM_CONNECTED, STREAM_HOST, (int)status.pairs);
+
+  messageLen = 0;
+  messageOverflow = false;
+  uint32_t lastRx = now;
+  uint32_t lastPing = now;
+  while (shouldConnect() && !resubscribe) {
+    now = millis();
+    if (now - lastRx > STREAM_IDLE_TIMEOUT_MS) return "no data";
+    if (now - lastPing >= STREAM_PING_MS) {
+      if (!sendFrame(WS_PING, nullptr, 0)) return "write failed";
+      lastPing = now;
+    }
+    // available() first: TLS may hold decrypted bytes the socket no longer shows
+    if (client.available() <= 0) {
+      if (!client.connected()) return "closed";
+      // Until the next ping or the idle deadline; capped so a stop or
+      // resubscribe is still seen within STREAM_IDLE_POLL_MS
+      uint32_t wait = min(STREAM_PING_MS - (now - lastPing), STREAM_IDLE_TIMEOUT_MS - (now - lastRx));
+      if (!waitReadable(min(wait, (uint32_t)STREAM_IDLE_POLL_MS))) return "closed";
+      continue;
+    }
+    const char* error = readFrame();
+    if (error) return error;
+    lastRx = millis();
+  }
+
+  sendFrame(WS_CLOSE, nullptr, 0);
+  return nullptr;
+}
+
+static void streamWorker(void* param) {
+  uint32_t backoff = STREAM_BACKOFF_BASE_MS;
+  while (true) {
+    if (!shouldConnect()) {
+      setState(STREAM_OFF);
+      vTaskDelay(pdMS_TO_TICKS(STREAM_IDLE_POLL_MS));
+      continue;
+    }
+
+    const char* error = nullptr;
+    uint32_t start = millis();
+    resubscribe = false;
+    if (ESP.getMaxAllocHeap() < FETCH_MIN_TLS_HEAP) {
+      error = "low heap";
+    } else {
+      setState(STREAM_CONNECTING);
+      error = runConnection();
+    }
+    bool wasLive = status.state == STREAM_LIVE;
+    client.stop();
+    if (lock()) {
+      if (wasLive) status.disconnects++;
+      connectedAt = 0;
+      unlock();
+    }
+    if (!error) {
+      backoff = STREAM_BACKOFF_BASE_MS;
+      continue;
+    }
+
+    // A connection that held for a while starts the backoff over
+    if (millis() - start >= STREAM_STABLE_MS) backoff = STREAM_BACKOFF_BASE_MS;
+    LOG_EVENT(EV_STREAM_DROPPED, error, backoff);
+    if (lock()) {
+      status.state = STREAM_BACKOFF;
+      status.backoffMs = backoff;
+      unlock();
+    }
+    uint32_t waitStart = millis();
+    while (millis() - waitStart < backoff && !resubscribe) {
+      vTaskDelay(pdMS_TO_TICKS(STREAM_IDLE_POLL_MS));
+    }
+    backoff = min(backoff * 2, (uint32_t)STREAM_BACKOFF_MAX_MS);
+  }
+}
+
+// ---- public API ----
+
+void initMarketStream(const AppConfig* config) {
+  if (!streamMutex) streamMutex = xSemaphoreCreateMutex();
+  if (!lock()) return;
+
+  // Slots follow the watchlist; a stablecoin quoted in itself has no pair
+  uint32_t hash = 2166136261u;
+  int pairs = 0;
+  numSlots = min((int)config->numTickers, MAX_TICKERS);
+  for (int i = 0; i < numSlots; i++) {
+    const TickerConfig& t = config->tickers[i];
+    StreamSlot& slot = slots[i];
+    memset(&slot, 0, sizeof(slot));
+    if (!t.enabled || t.type != TICKER_CRYPTO || !t.symbol[0] || strcmp(t.symbol, STREAM_QUOTE_ASSET) == 0) continue;
+    if (strlen(t.symbol) + strlen(STREAM_QUOTE_ASSET) >= sizeof(slot.pair)) continue;
+    for (int c = 0; t.symbol[c]; c++) slot.pair[c] = toupper(t.symbol[c]);
+    strlcat(slot.pair, STREAM_QUOTE_ASSET, sizeof(slot.pair));
+    for (const char* c = slot.pair; *c; c++) hash = (hash ^ (uint8_t)*c) * 16777619u;
+    hash = (hash ^ '/') * 16777619u;
+    pairs++;
+  }
+  if (hash != subscription) resubscribe = true;
+  subscription = hash;
+  status.pairs = pairs;
+  enabled = config->marketStream;
+  unlock();
+
+#if SIM_BUILD
+  return;   // Simulated time has no live market
+#endif
+  if (!streamTask) {
+    xTaskCreatePinnedToCore(
+        streamWorker,
+        "stream",
+        STREAM_WORKER_STACK,
+        NULL,
+        1,
+        &streamTask,
+        0
+    );
+  }
+}
+
+void setMarketStreamActive(bool on) {
+  active = on;
+}
+
+int streamPoll(StreamQuote* out, int max) {
+  if (!lock()) return 0;
+  int n = 0;
+  for (int i = 0; i < numSlots && n < max; i++) {
+    StreamSlot& slot = slots[i];
+    if (!slot.dirty) continue;
+    out[n].tickerIndex = i;
+    out[n].quote = slot.quote;
+    out[n].receivedAt = slot.receivedAt;
+    slot.dirty = false;
+    n++;
+  }
+  if (n < max) pending = false;
+  status.published += n;
+  unlock();
+  return n;
+}
+
+bool streamPending() {
+  return pending;
+}
+
+bool streamPriceFresh(int tickerIndex) {
+  if (tickerIndex < 0 || tickerIndex >= numSlots) return false;
+  uint32_t at = slots[tickerIndex].receivedAt;
+  return at != 0 && appMillis() - at < STREAM_STALE_MS;
+}
+
+StreamStatus getStreamStatus() {
+  StreamStatus s = {};
+  if (!lock()) return s;
+  s = status;
+  s.connectedMs = connectedAt ? millis() - connectedAt : 0;
+  unlock();
+  return s;
+}
+
+const char* getStreamStateName(StreamState state) {
+  return state <= STREAM_BACKOFF ? stateNames[state] : "?";
+}
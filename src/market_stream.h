@@ -0,0 +1,66 @@
+#pragma once
+#include <Arduino.h>
+#include "ticker_types.h"
+#include "api_client.h"
+
+// Live crypto prices from an exchange WebSocket ticker stream.
+// A worker task (Core 0) keeps one connection to Binance's combined stream
+// (<symbol>usdt@miniTicker per crypto slot), answers pings, sends its own
+// heartbeat and reconnects with backoff. Every message overwrites the slot's
+// latest price; the data manager collects the changed slots at most every
+// STREAM_PUBLISH_MS, so bursts coalesce into one TickerData update.
+// Slots the stream has not priced within STREAM_STALE_MS (unlisted coins, a
+// dropped connection) stay on the REST batch rounds; charts are always REST.
+//
+// STREAM_HOST/PORT/TLS point the client elsewhere, e.g. at the recorded-stream
+// stand-in in tools/stream_replay.py (pio run -e stream_replay).
+
+enum StreamState : uint8_t {
+  STREAM_OFF        = 0,  // Disabled, no crypto slots, or relay follower / OTA
+  STREAM_CONNECTING = 1,
+  STREAM_LIVE       = 2,
+  STREAM_BACKOFF    = 3   // Waiting to reconnect
+};
+
+// Latest streamed price for one slot
+struct StreamQuote {
+  uint8_t tickerIndex;
+  PriceQuote quote;        // price + 24h change
+  uint32_t receivedAt;     // millis() of the message
+};
+
+struct StreamStatus {
+  StreamState state;
+  uint8_t pairs;             // Subscribed slots
+  uint32_t connects;
+  uint32_t disconnects;
+  uint32_t messages;         // Ticker messages parsed
+  uint32_t published;        // Slot updates handed to the data manager
+  uint32_t lastMessageMs;    // millis() of the last message (0 = none yet)
+  uint32_t connectedMs;      // Time in the current connection
+  uint32_t backoffMs;        // Current reconnect delay
+};
+
+// Start the worker (first call) and subscribe to this watchlist's crypto
+// slots; reconnects if the subscription changed. Fetch task only.
+void initMarketStream(const AppConfig* config);
+
+// Whether the stream may hold a connection right now (config switch, relay
+// role, OTA); dropping it frees the TLS heap. Fetch task only.
+void setMarketStreamActive(bool active);
+
+// Slots priced since the last poll, one entry each (coalesced). Returns the
+// count. Fetch task only.
+int streamPoll(StreamQuote* out, int max);
+
+// Some slot was priced since the last poll (the worker signals
+// FETCH_EVENT_WORK when this becomes true)
+bool streamPending();
+
+// Slot has a streamed price younger than STREAM_STALE_MS
+bool streamPriceFresh(int tickerIndex);
+
+StreamStatus getStreamStatus();
+
+// "off", "connecting", "live", "backoff"
+const char* getStreamStateName(StreamState state);
@@ -0,0 +1,280 @@
+#include "ota_update.h"
+#include "gzip_inflater.h"
+#include "api_client.h"
+#include "event_log.h"
+#include "config.h"
+#include "fetch_events.h"
+#include <Update.h>
+#include <LittleFS.h>
+#include <mbedtls/sha256.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#define SHA256_LEN 32
+
+// Chunks arrive on the web server task, otaTick() runs on the fetch task
+static SemaphoreHandle_t otaMutex = nullptr;
+
+static OtaStatus status = {};
+static GzipInflater* inflater = nullptr;
+static mbedtls_sha256_context sha;
+static bool shaStarted = false;
+static bool checkDigest = false;
+static uint8_t expectedDigest[SHA256_LEN];
+static uint32_t startedAt = 0;
+static uint32_t lastActivity = 0;
+static uint32_t chunkEnd = 0;       // End of the chunk request in progress
+static uint32_t rebootAt = 0;
+
+static bool lock() {
+  return otaMutex && xSemaphoreTake(otaMutex, portMAX_DELAY) == pdTRUE;
+}
+
+static void unlock() {
+  xSemaphoreGive(otaMutex);
+}
+
+static int hexNibble(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+static bool parseDigest(const char* hex, uint8_t* out) {
+  if (strlen(hex) != SHA256_LEN * 2) return false;
+  for (int i = 0; i < SHA256_LEN; i++) {
+    int hi = hexNibble(hex[2 * i]);
+    int lo = hexNibble(hex[2 * i + 1]);
+    if (hi < 0 || lo < 0) return false;
+    out[i] = (uint8_t)(hi << 4 | lo);
+  }
+  return true;
+}
+
+// Inflated (or raw) image bytes: hash, then flash
+static bool writeImage(const uint8_t* data, size_t len, void* ctx) {
+  mbedtls_sha256_update_ret(&sha, data, len);
+  if (Update.write((uint8_t*)data, len) != len) return false;
+  status.written += len;
+  return true;
+}
+
+static void releaseSession() {
+  if (inflater) releaseUploadInflater();
+  inflater = nullptr;
+  if (shaStarted) mbedtls_sha256_free(&sha);
+  shaStarted = false;
+}
+
+// Caller holds the lock
+static void failSession(const char* reason) {
+  if (Update.isRunning()) Update.abort();
+  releaseSession();
+  status.state = OTA_FAILED;
+  status.elapsedMs = millis() - startedAt;
+  strlcpy(status.error, reason, sizeof(status.error));
+  if (status.target == OTA_FILESYSTEM && !LittleFS.begin()) {
+    strlcpy(status.error, "filesystem unmountable, upload it again", sizeof(status.error));
+  }
+  LOG_EVENT(EV_OTA_FAILED, reason, status.received, status.written);
+  signalFetchTask(FETCH_EVENT_WORK);   // Fetches resume
+}
+
+void initOtaUpdate() {
+  if (!otaMutex) otaMutex = xSemaphoreCreateMutex();
+}
+
+bool otaBegin(OtaTarget target, uint32_t uploadSize, const char* sha256Hex) {
+  if (!lock()) return false;
+  if (status.state == OTA_RECEIVING) failSession("superseded by a new upload");
+
+  status = OtaStatus();
+  status.target = target;
+  status.uploadSize = uploadSize;
+  startedAt = lastActivity = millis();
+  chunkEnd = 0;
+
+  checkDigest = sha256Hex && *sha256Hex;
+  if (checkDigest && !parseDigest(sha256Hex, expectedDigest)) {
+    failSession("sha256 must be 64 hex digits");
+    unlock();
+    return false;
+  }
+
+  // LittleFS is rewritten underneath itself: unmount until it is done
+  if (target == OTA_FILESYSTEM) LittleFS.end();
+  if (!Update.begin(UPDATE_SIZE_UNKNOWN, target == OTA_FILESYSTEM ? U_SPIFFS : U_FLASH)) {
+    failSession(Update.errorString());
+    unlock();
+    return false;
+  }
+
+  mbedtls_sha256_init(&sha);
+  mbedtls_sha256_starts_ret(&sha, 0);
+  shaStarted = true;
+  status.state = OTA_RECEIVING;
+  LOG_EVENT(EV_OTA_BEGIN, getOtaTargetName(target), uploadSize);
+  unlock();
+  signalFetchTask(FETCH_EVENT_WORK);   // Pause fetches, raise the clock
+  return true;
+}
+
+void otaChunkStart(uint32_t offset, uint32_t length) {
+  if (!lock()) return;
+  if (status.state == OTA_RECEIVING) {
+    if (chunkEnd > status.received) {
+      status.resumes++;
+      LOG_EVENT(EV_OTA_RESUMED, nullptr, status.received, status.resumes);
+    }
+    chunkEnd = offset + length;
+    lastActivity = millis();
+  }
+  unlock();
+}
+
+OtaChunkResult otaWrite(uint32_t offset, const uint8_t* data, size_t len) {
+  if (!lock()) return OTA_CHUNK_NO_SESSION;
+  OtaChunkResult result = OTA_CHUNK_OK;
+
+  if (status.state != OTA_RECEIVING) {
+    result = status.state == OTA_FAILED ? OTA_CHUNK_FAILED : OTA_CHUNK_NO_SESSION;
+  } else if (offset > status.received) {
+    result = OTA_CHUNK_WRONG_OFFSET;
+  } else {
+    // Skip whatever a resent chunk repeats
+    uint32_t repeat = status.received - offset;
+    if (repeat < len) {
+      data += repeat;
+      len -= repeat;
+
+      if (status.uploadSize && status.received + len > status.uploadSize) {
+        failSession("upload longer than declared");
+      } else if (status.received == 0 && len < 2) {
+        failSession("first chunk too short");
+      } else {
+        bool busy = false;
+        if (status.received == 0) {
+          status.compressed = isGzip(data, len);
+          if (status.compressed) inflater = claimUploadInflater(writeImage, nullptr, &busy);
+        }
+
+        if (busy) {
+          // A fetch from before the pause still inflates: take nothing, the
+          // client resends from "received"
+        } else if (status.compressed && !inflater) {
+          failSession("no memory for the inflater");
+        } else if (status.compressed) {
+          status.received += len;
+          GzipResult r = gzipFeed(inflater, data, len);
+          if (r == GZIP_SINK_FAILED) {
+            failSession(Update.errorString());
+          } else if (r != GZIP_MORE && r != GZIP_DONE) {
+            failSession(getGzipResultName(r));
+          }
+        } else {
+          status.received += len;
+          if (!writeImage(data, len, nullptr)) failSession(Update.errorString());
+        }
+      }
+      if (status.state == OTA_FAILED) result = OTA_CHUNK_FAILED;
+    }
+    lastActivity = millis();
+  }
+
+  unlock();
+  return result;
+}
+
+bool otaFinish() {
+  if (!lock()) return false;
+  if (status.state != OTA_RECEIVING) {
+    // A repeated finish after success is still a success
+    bool ok = status.state == OTA_VERIFIED;
+    unlock();
+    return ok;
+  }
+
+  // Incomplete uploads keep the session so the client can carry on
+  if (status.uploadSize && status.received < status.uploadSize) {
+    snprintf(status.error, sizeof(status.error), "incomplete: %u of %u bytes",
+             (unsigned)status.received, (unsigned)status.uploadSize);
+    unlock();
+    return false;
+  }
+  if (status.compressed && gzipFeed(inflater, nullptr, 0) != GZIP_DONE) {
+    strlcpy(status.error, "gzip stream incomplete", sizeof(status.error));
+    unlock();
+    return false;
+  }
+
+  uint8_t digest[SHA256_LEN];
+  mbedtls_sha256_finish_ret(&sha, digest);
+  if (checkDigest && memcmp(digest, expectedDigest, SHA256_LEN) != 0) {
+    failSession("SHA-256 mismatch");
+  } else if (!Update.end(true)) {
+    failSession(Update.errorString());
+  } else {
+    releaseSession();
+    status.state = OTA_VERIFIED;
+    status.error[0] = '\0';
+    status.elapsedMs = millis() - startedAt;
+    rebootAt = millis() + OTA_REBOOT_DELAY_MS;
+    LOG_EVENT(EV_OTA_DONE, getOtaTargetName(status.target), status.written, status.received,
+              status.elapsedMs);
+    signalFetchTask(FETCH_EVENT_WORK);   // otaTick() schedules the restart
+  }
+
+  bool ok = status.state == OTA_VERIFIED;
+  unlock();
+  return ok;
+}
+
+void otaAbort(const char* reason) {
+  if (!lock()) return;
+  if (status.state == OTA_RECEIVING) failSession(reason);
+  unlock();
+}
+
+uint32_t otaTick() {
+  if (!lock()) return FETCH_WAIT_FOREVER;
+  uint32_t now = millis();
+  if (status.state == OTA_RECEIVING && now - lastActivity >= OTA_IDLE_TIMEOUT_MS) {
+    failSession("idle timeout");
+  }
+  bool restart = status.state == OTA_VERIFIED && (int32_t)(now - rebootAt) >= 0;
+  uint32_t wait = FETCH_WAIT_FOREVER;
+  if (status.state == OTA_RECEIVING) wait = OTA_IDLE_TIMEOUT_MS - (now - lastActivity);
+  else if (status.state == OTA_VERIFIED && !restart) wait = rebootAt - now;
+  unlock();
+
+  if (restart) ESP.restart();
+  return wait;
+}
+
+bool otaActive() {
+  return status.state == OTA_RECEIVING;
+}
+
+OtaStatus getOtaStatus() {
+  OtaStatus s = {};
+  if (!lock()) return s;
+  s = status;
+  if (s.state == OTA_RECEIVING) s.elapsedMs = millis() - startedAt;
+  unlock();
+  return s;
+}
+
+const char* getOtaStateName(OtaState state) {
+  switch (state) {
+    case OTA_IDLE:      return "idle";
+    case OTA_RECEIVING: return "receiving";
+    case OTA_VERIFIED:  return "verified";
+    case OTA_FAILED:    return "failed";
+    default:            return "?";
+  }
+}
+
+const char* getOtaTargetName(OtaTarget target) {
+  return target == OTA_FILESYSTEM ? "filesystem" : "firmware";
+}
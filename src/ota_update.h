@@ -0,0 +1,83 @@
+#pragma once
+#include <Arduino.h>
+
+// Resumable, verified OTA into the inactive app slot or the LittleFS
+// partition, from a raw or gzip-compressed image (detected by its magic;
+// inflated on the fly, see gzip_inflater.h).
+//
+//   POST /api/ota/begin?target=firmware|filesystem&size=<upload bytes>&sha256=<hex>
+//   POST /api/ota/chunk?offset=<upload bytes already sent>   (octet-stream body)
+//   GET  /api/ota                                            (status; "received" is the resume offset)
+//   POST /api/ota/finish
+//
+// Chunks must arrive in order. If one is cut off, read "received" back and
+// continue from there: the session (inflater state included) stays in RAM
+// until it is finished, aborted, or idle for OTA_IDLE_TIMEOUT_MS. The
+// SHA-256 is of the uncompressed image and is checked before the boot slot
+// is switched. A filesystem image is written in place, so one that fails
+// the check leaves the partition to be uploaded again.
+
+enum OtaTarget : uint8_t {
+  OTA_FIRMWARE   = 0,
+  OTA_FILESYSTEM = 1
+};
+
+enum OtaState : uint8_t {
+  OTA_IDLE = 0,
+  OTA_RECEIVING,
+  OTA_VERIFIED,     // Image written and checked; rebooting shortly
+  OTA_FAILED
+};
+
+enum OtaChunkResult : uint8_t {
+  OTA_CHUNK_OK = 0,
+  OTA_CHUNK_WRONG_OFFSET,   // Not contiguous with "received"; resend from there
+  OTA_CHUNK_NO_SESSION,
+  OTA_CHUNK_FAILED          // Session aborted (see OtaStatus.error)
+};
+
+struct OtaStatus {
+  OtaState state;
+  OtaTarget target;
+  bool compressed;
+  uint32_t uploadSize;      // Declared upload length (0 = unknown)
+  uint32_t received;        // Upload bytes accepted so far
+  uint32_t written;         // Image bytes written to flash
+  uint32_t resumes;         // Chunks that restarted after a cut-off one
+  uint32_t elapsedMs;
+  char error[48];
+};
+
+// Create the session lock (call once at boot)
+void initOtaUpdate();
+
+// Start a session, aborting any previous one. uploadSize may be 0 when the
+// length is unknown (finish then trusts the gzip trailer / the caller);
+// sha256Hex may be null or empty to skip the digest check.
+bool otaBegin(OtaTarget target, uint32_t uploadSize, const char* sha256Hex);
+
+// A request carrying upload bytes [offset, offset + length) is starting.
+// Counts a resume when the previous chunk request never completed.
+void otaChunkStart(uint32_t offset, uint32_t length);
+
+// Upload bytes at `offset`. Bytes already received are skipped, so a chunk
+// resent after a lost reply is harmless.
+OtaChunkResult otaWrite(uint32_t offset, const uint8_t* data, size_t len);
+
+// Check completeness and the digest, then commit (firmware: switch the boot
+// slot). On success the device restarts OTA_REBOOT_DELAY_MS later.
+bool otaFinish();
+
+void otaAbort(const char* reason);
+
+// Fetch task hook: idle timeout and the post-update restart. Returns ms
+// until it is due again (see fetch_events.h).
+uint32_t otaTick();
+
+// A session is receiving (fetches are paused to leave heap for it)
+bool otaActive();
+
+OtaStatus getOtaStatus();
+
+const char* getOtaStateName(OtaState state);
+const char* getOtaTargetName(OtaTarget target);
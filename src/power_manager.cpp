@@ -0,0 +1,191 @@
+#include "power_manager.h"
+#include "fetch_engine.h"
+#include "display_renderer.h"
+#include "event_log.h"
+#include "ota_update.h"
+#include "trace.h"
+#include "fetch_events.h"
+#include <WiFi.h>
+#include <time.h>
+
+#define POWER_HOUR_MS 3600000UL
+
+static const uint16_t stateMa[POWER_STATE_COUNT] = {
+  POWER_MA_ACTIVE, POWER_MA_IDLE, POWER_MA_QUIET
+};
+
+// Copied from the config snapshot (getPowerStatus() runs on the web task)
+static bool configured = false;
+static bool lowPower = false;
+static uint8_t quietStartHour = 0;
+static uint8_t quietEndHour = 0;
+static PowerState state = POWER_ACTIVE;
+static bool quiet = false;
+static uint32_t transitions = 0;
+
+// Time accounting: hours[] is a ring, hourIndex the hour being filled
+static uint32_t lastAccount = 0;
+static uint32_t hourMs = 0;
+static int hourIndex = 0;
+static int hoursFilled = 1;
+static PowerHour hours[POWER_HISTORY_HOURS];
+static uint64_t totalMs[POWER_STATE_COUNT];
+static portMUX_TYPE powerMux = portMUX_INITIALIZER_UNLOCKED;
+
+const char* getPowerStateName(PowerState s) {
+  switch (s) {
+    case POWER_ACTIVE: return "active";
+    case POWER_IDLE:   return "idle";
+    case POWER_QUIET:  return "quiet";
+    default:           return "?";
+  }
+}
+
+static bool lowPowerEnabled() {
+  return configured && lowPower;
+}
+
+// With scaling off the CPU and radio never leave their full-power settings
+static uint16_t estimateMa(PowerState s) {
+  return lowPowerEnabled() ? stateMa[s] : POWER_MA_ACTIVE;
+}
+
+// Charge the time since the last call to the current state, splitting it
+// across hour boundaries
+static void accountTime(uint32_t now) {
+  portENTER_CRITICAL(&powerMux);
+  uint32_t elapsed = now - lastAccount;
+  lastAccount = now;
+  totalMs[state] += elapsed;
+  while (elapsed > 0) {
+    uint32_t step = min(elapsed, (uint32_t)(POWER_HOUR_MS - hourMs));
+    hours[hourIndex].ms[state] += step;
+    hourMs += step;
+    elapsed -= step;
+    if (hourMs >= POWER_HOUR_MS) {
+      hourIndex = (hourIndex + 1) % POWER_HISTORY_HOURS;
+      memset(&hours[hourIndex], 0, sizeof(PowerHour));
+      hourMs = 0;
+      if (hoursFilled < POWER_HISTORY_HOURS) hoursFilled++;
+    }
+  }
+  portEXIT_CRITICAL(&powerMux);
+}
+
+static bool clockValid() {
+  return time(nullptr) > CLOCK_VALID_AFTER;
+}
+
+static bool inQuietHours() {
+  if (!configured || quietStartHour == quietEndHour || !clockValid()) return false;
+
+  time_t now = time(nullptr);
+  struct tm local;
+  localtime_r(&now, &local);
+  int start = quietStartHour;
+  int end = quietEndHour;
+  // Windows may wrap past midnight (e.g. 23 -> 7)
+  return start < end ? (local.tm_hour >= start && local.tm_hour < end)
+                     : (local.tm_hour >= start || local.tm_hour < end);
+}
+
+// Quiet hours start and end on the hour, local time
+static uint32_t msToNextHour() {
+  time_t now = time(nullptr);
+  struct tm local;
+  localtime_r(&now, &local);
+  return ((59 - local.tm_min) * 60 + (60 - local.tm_sec)) * 1000UL;
+}
+
+static void applyState(PowerState s) {
+  bool scale = lowPowerEnabled();
+
+  uint32_t mhz = (s == POWER_ACTIVE || !scale) ? POWER_CPU_ACTIVE_MHZ : POWER_CPU_IDLE_MHZ;
+  if (getCpuFrequencyMhz() != mhz) {
+    setCpuFrequencyMhz(mhz);
+    TRACE_CLOCK_CHANGED();
+  }
+
+  // Keep the radio awake during a burst so TLS round trips are not held
+  // back to the next DTIM beacon
+  wifi_ps_type_t ps = WIFI_PS_MIN_MODEM;
+  if (scale) {
+    if (s == POWER_ACTIVE) ps = WIFI_PS_NONE;
+    else if (s == POWER_QUIET) ps = WIFI_PS_MAX_MODEM;
+  }
+  WiFi.setSleep(ps);
+}
+
+void initPowerManager(const AppConfig* cfg) {
+  lowPower = cfg->lowPower;
+  quietStartHour = cfg->quietStartHour;
+  quietEndHour = cfg->quietEndHour;
+  configured = true;
+  configTzTime(cfg->timezone, NTP_SERVER_1, NTP_SERVER_2);
+
+  if (lastAccount == 0) lastAccount = millis();
+  applyState(state);
+}
+
+uint32_t powerTick() {
+  if (!configured) return FETCH_WAIT_FOREVER;
+
+  bool nowQuiet = inQuietHours();
+  if (nowQuiet != quiet) {
+    quiet = nowQuiet;
+    setDisplayPower(!quiet);
+    LOG_EVENT(EV_POWER_QUIET, quiet ? "start" : "end", quiet ? POWER_QUIET_FETCH_SCALE : 1);
+  }
+
+  int inFlight = 0;
+  for (int p = 0; p < PROVIDER_COUNT; p++) {
+    inFlight += fetchInFlight((ApiProvider)p);
+  }
+  // An OTA upload also wants the full clock and the radio awake
+  if (otaActive()) inFlight++;
+  PowerState next = inFlight > 0 ? POWER_ACTIVE : (quiet ? POWER_QUIET : POWER_IDLE);
+
+  accountTime(millis());
+  if (next != state) {
+    portENTER_CRITICAL(&powerMux);
+    state = next;
+    transitions++;
+    portEXIT_CRITICAL(&powerMux);
+
+    applyState(next);
+    LOG_EVENT(EV_POWER_STATE, getPowerStateName(next), (int)getCpuFrequencyMhz());
+  }
+
+  // Before SNTP has synced, FETCH_IDLE_MAX_MS brings the next check
+  bool hasQuietHours = quietStartHour != quietEndHour && clockValid();
+  return hasQuietHours ? msToNextHour() : FETCH_WAIT_FOREVER;
+}
+
+uint32_t powerFetchScale() {
+  return quiet ? POWER_QUIET_FETCH_SCALE : 1;
+}
+
+PowerStatus getPowerStatus() {
+  accountTime(millis());
+
+  PowerStatus s;
+  memset(&s, 0, sizeof(s));
+  s.cpuMhz = getCpuFrequencyMhz();
+  s.lowPower = lowPowerEnabled();
+  s.timeValid = clockValid();
+  s.quietHours = quiet;
+  for (int i = 0; i < POWER_STATE_COUNT; i++) {
+    s.estimatedMa[i] = estimateMa((PowerState)i);
+  }
+
+  portENTER_CRITICAL(&powerMux);
+  s.state = state;
+  s.transitions = transitions;
+  memcpy(s.totalMs, totalMs, sizeof(totalMs));
+  s.hourCount = hoursFilled;
+  for (int i = 0; i < hoursFilled; i++) {
+    s.hours[i] = hours[(hourIndex - i + POWER_HISTORY_HOURS) % POWER_HISTORY_HOURS];
+  }
+  portEXIT_CRITICAL(&powerMux);
+  return s;
+}
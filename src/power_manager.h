@@ -0,0 +1,54 @@
+#pragma once
+#include <Arduino.h>
+#include "ticker_types.h"
+
+// Power manager (driven from the fetch task).
+//   ACTIVE: a fetch is queued or running; full CPU clock, radio always on
+//   IDLE:   between fetch bursts; CPU at POWER_CPU_IDLE_MHZ, WiFi modem sleep
+//   QUIET:  inside the configured quiet hours with nothing in flight; panel
+//           DMA stopped, max modem sleep, fetch intervals stretched
+// With lowPower off the states are still tracked, but the clock and WiFi
+// power save are left at their defaults. Local time comes from SNTP; quiet
+// hours never start before the clock has synced.
+
+enum PowerState : uint8_t {
+  POWER_ACTIVE = 0,
+  POWER_IDLE   = 1,
+  POWER_QUIET  = 2,
+  POWER_STATE_COUNT
+};
+
+// Time spent in each state during one wall-clock hour of uptime
+struct PowerHour {
+  uint32_t ms[POWER_STATE_COUNT];
+};
+
+struct PowerStatus {
+  PowerState state;
+  uint32_t cpuMhz;
+  bool lowPower;
+  bool timeValid;               // SNTP has set the clock
+  bool quietHours;
+  uint32_t transitions;
+  uint64_t totalMs[POWER_STATE_COUNT];
+  uint16_t estimatedMa[POWER_STATE_COUNT];
+  int hourCount;                // Valid entries in hours[], newest first
+  PowerHour hours[POWER_HISTORY_HOURS];
+};
+
+// Start SNTP with the configured timezone and apply the power settings.
+// Call again after the config changes.
+void initPowerManager(const AppConfig* config);
+
+// Fetch task hook (after updateData): pick the state for the current
+// fetch load and time of day, and account the time since the last call.
+// Returns ms until quiet hours may start or end (see fetch_events.h).
+uint32_t powerTick();
+
+// Multiplier for the data manager's fetch intervals (1 outside quiet hours)
+uint32_t powerFetchScale();
+
+// Snapshot for /api/status
+PowerStatus getPowerStatus();
+
+const char* getPowerStateName(PowerState state);
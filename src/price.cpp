@@ -0,0 +1,195 @@
+#include "price.h"
+
+#define MAX_MANTISSA_DIGITS 18   // Always fits a uint64
+
+static const uint64_t pow10u64[20] = {
+  1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+  100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+  10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+  100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+bool parsePrice(const char* text, Price* out) {
+  if (!text) return false;
+  const char* p = text;
+  bool negative = *p == '-';
+  if (*p == '-' || *p == '+') p++;
+
+  // Up to 18 significant digits; further integer digits only scale
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int exp10 = 0;
+  bool any = false;
+  for (; *p >= '0' && *p <= '9'; p++) {
+    any = true;
+    if (digits < MAX_MANTISSA_DIGITS) {
+      mantissa = mantissa * 10 + (*p - '0');
+      if (mantissa) digits++;
+    } else {
+      exp10++;
+    }
+  }
+  if (*p == '.') {
+    for (p++; *p >= '0' && *p <= '9'; p++) {
+      any = true;
+      if (digits < MAX_MANTISSA_DIGITS) {
+        mantissa = mantissa * 10 + (*p - '0');
+        if (mantissa) digits++;
+        exp10--;
+      }
+    }
+  }
+  if (!any) return false;
+
+  if (*p == 'e' || *p == 'E') {
+    p++;
+    bool expNegative = *p == '-';
+    if (*p == '-' || *p == '+') p++;
+    if (*p < '0' || *p > '9') return false;
+    int e = 0;
+    for (; *p >= '0' && *p <= '9'; p++) {
+      if (e < 1000) e = e * 10 + (*p - '0');
+    }
+    exp10 += expNegative ? -e : e;
+  }
+  if (*p != '\0') return false;
+
+  // mantissa * 10^(exp10 + PRICE_DECIMALS), rounded half away from zero
+  int shift = exp10 + PRICE_DECIMALS;
+  uint64_t units;
+  if (mantissa == 0) {
+    units = 0;
+  } else if (shift >= 0) {
+    if (shift > 18 || mantissa > (uint64_t)INT64_MAX / pow10u64[shift]) return false;
+    units = mantissa * pow10u64[shift];
+  } else if (-shift > 19) {
+    units = 0;
+  } else {
+    uint64_t div = pow10u64[-shift];
+    units = mantissa / div;
+    if (mantissa % div >= div - div / 2) units++;
+  }
+  if (units > (uint64_t)INT64_MAX) return false;
+
+  *out = negative ? -(Price)units : (Price)units;
+  return true;
+}
+
+Price priceFromDouble(double value) {
+  double scaled = value * PRICE_SCALE;
+  if (!(scaled > -9.2e18 && scaled < 9.2e18)) return 0;   // Also NaN
+  return (Price)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+float priceToFloat(Price price) {
+  Price whole = price / PRICE_SCALE;
+  int32_t frac = (int32_t)(price - whole * PRICE_SCALE);
+  return (float)whole + (float)frac * (1.0f / PRICE_SCALE);
+}
+
+double priceToDouble(Price price) {
+  Price whole = price / PRICE_SCALE;
+  int32_t frac = (int32_t)(price - whole * PRICE_SCALE);
+  return (double)whole + (double)frac / PRICE_SCALE;
+}
+
+// Decimal digits of v, at least minDigits (zero-padded); 32-bit divides
+// once v fits, which is every whole-dollar part below $4.29e9
+static char* appendDigits(char* p, uint64_t v, int minDigits) {
+  char tmp[20];
+  int n = 0;
+  while (v > UINT32_MAX) {
+    tmp[n++] = '0' + v % 10;
+    v /= 10;
+  }
+  uint32_t v32 = (uint32_t)v;
+  do {
+    tmp[n++] = '0' + v32 % 10;
+    v32 /= 10;
+  } while (v32 || n < minDigits);
+  while (n) *p++ = tmp[--n];
+  return p;
+}
+
+int formatPriceFixed(Price price, int decimals, char* out) {
+  char* p = out;
+  uint64_t units = (uint64_t)price;
+  if (price < 0) {
+    *p++ = '-';
+    units = 0 - units;
+  }
+
+  uint64_t step = pow10u64[PRICE_DECIMALS - decimals];
+  uint64_t rounded = step > 1 ? (units + step / 2) / step : units;
+  if (decimals == 0) {
+    p = appendDigits(p, rounded, 1);
+  } else {
+    uint32_t fracDiv = (uint32_t)pow10u64[decimals];
+    uint64_t whole = rounded / fracDiv;
+    p = appendDigits(p, whole, 1);
+    *p++ = '.';
+    p = appendDigits(p, (uint32_t)(rounded - whole * fracDiv), decimals);
+  }
+  *p = '\0';
+  return p - out;
+}
+
+int formatPriceDecimal(Price price, char* out) {
+  int len = formatPriceFixed(price, PRICE_DECIMALS, out);
+  while (out[len - 1] == '0') len--;
+  if (out[len - 1] == '.') len--;
+  out[len] = '\0';
+  return len;
+}
+
+int priceDecimals(Price magnitude) {
+  if (magnitude >= 10000 * PRICE_SCALE) return 0;
+  if (magnitude >= 100 * PRICE_SCALE) return 1;
+  if (magnitude >= PRICE_SCALE) return 2;
+  if (magnitude >= PRICE_SCALE / 100) return 4;
+  int zeros = 2;
+  for (Price digit = PRICE_SCALE / 1000; magnitude < digit && zeros < PRICE_DECIMALS - 3; digit /= 10) {
+    zeros++;
+  }
+  return zeros + 3;
+}
+
+int formatPriceLabel(Price price, char prefix, char* out, int maxW) {
+  Price magnitude = price < 0 ? -price : price;
+  int decimals = priceDecimals(magnitude);
+  out[0] = prefix;
+  int len = 1 + formatPriceFixed(price, decimals, out + 1);
+  int width = 6 * len - 1 - (decimals ? 4 : 0);
+  if (width <= maxW || decimals > 0) return width;
+
+  static const char suffixes[] = "KMB";
+  int unit = -1;
+  while (unit < 2 && magnitude >= 9995 * PRICE_SCALE / 10) {
+    magnitude /= 1000;
+    price /= 1000;
+    unit++;
+  }
+  if (unit < 0) return width;
+  decimals = magnitude >= 9995 * PRICE_SCALE / 100 ? 0 : magnitude >= 9995 * PRICE_SCALE / 1000 ? 1 : 2;
+  len = 1 + formatPriceFixed(price, decimals, out + 1);
+  out[len++] = suffixes[unit];
+  out[len] = '\0';
+  return 6 * len - 1 - (decimals ? 4 : 0);
+}
+
+void formatChange(float percent, char* out) {
+  char* p = out;
+  *p++ = percent >= 0 ? '+' : '-';
+  uint32_t tenths = (uint32_t)lroundf(fminf(fabsf(percent), 999999.0f) * 10.0f);
+  char digits[10];
+  int n = 0;
+  do {
+    digits[n++] = '0' + tenths % 10;
+    tenths /= 10;
+  } while (tenths || n < 2);
+  while (n > 1) *p++ = digits[--n];
+  *p++ = '.';
+  *p++ = digits[0];
+  *p++ = '%';
+  *p = '\0';
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <Arduino.h>
+
+// Fixed-point decimal prices: an int64 count of 10^-PRICE_DECIMALS dollars.
+// Parsed straight from the decimal text, so sub-cent coins and large prices
+// keep every digit the provider sent (float's 24-bit mantissa keeps ~7), and
+// formatting needs no float or double math.
+typedef int64_t Price;
+
+#define PRICE_DECIMALS  8
+#define PRICE_SCALE     100000000LL
+#define PRICE_TEXT_LEN  24     // Longest formatPriceDecimal() output + NUL
+
+// Parse a JSON-style decimal ("123.45", "-0.5", "1.234e-05"), rounding half
+// away from zero at PRICE_DECIMALS. False on malformed text or overflow.
+bool parsePrice(const char* text, Price* out);
+
+// Nearest Price to a double (for providers whose JSON numbers arrive parsed)
+Price priceFromDouble(double value);
+
+// Approximate values for ratios, chart scaling and logs
+float priceToFloat(Price price);
+double priceToDouble(Price price);
+
+// "[-]whole[.frac]" rounded half away from zero to `decimals` places (0..8),
+// integer math only. Returns the length.
+int formatPriceFixed(Price price, int decimals, char* out);
+
+// Exact decimal text without trailing zeros ("67250.12", "0.00001234");
+// valid as a JSON number. Returns the length.
+int formatPriceDecimal(Price price, char* out);
+
+// Decimals the display shows for a price of this magnitude: 0 from 10000,
+// 1 from 100, 2 from 1, 4 from a cent, and below that three significant
+// digits (up to PRICE_DECIMALS) instead of a run of zeros.
+int priceDecimals(Price magnitude);
+
+// Display text for a price: `prefix` (the currency glyph) then the price at
+// priceDecimals() ("$67250", "$152.3", "$0.1623", "$0.0000123"). Returns
+// its width in unscaled font pixels (6px per char, 4px for '.' and the char
+// before it, 5px for the last). A whole-number price wider than maxW is
+// shortened to three digits and a K/M/B suffix ("10.2M"). Integer math
+// only; out needs PRICE_TEXT_LEN + 1 bytes.
+int formatPriceLabel(Price price, char prefix, char* out, int maxW);
+
+// Change% as "+1.2%" / "-0.4%" without going through double printf
+void formatChange(float percent, char* out);
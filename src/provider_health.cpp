@@ -0,0 +1,115 @@
+#include "provider_health.h"
+#include "event_log.h"
+#include "app_clock.h"
+#include "config.h"
+
+static ProviderHealth health[PROVIDER_COUNT];
+static portMUX_TYPE healthMux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char* providerNames[PROVIDER_COUNT] = { "cmc", "coingecko", "twelvedata" };
+
+void initProviderHealth() {
+  portENTER_CRITICAL(&healthMux);
+  memset(health, 0, sizeof(health));
+  portEXIT_CRITICAL(&healthMux);
+}
+
+// Backoff for the Nth consecutive open: base * 2^(n-1), capped, with jitter
+// in [50%, 100%] so a fleet of tickers does not retry in lockstep
+static uint32_t backoffMs(uint8_t openCount) {
+  uint32_t backoff = HEALTH_BACKOFF_BASE_MS;
+  for (int i = 1; i < openCount && backoff < HEALTH_BACKOFF_MAX_MS; i++) {
+    backoff *= 2;
+  }
+  if (backoff > HEALTH_BACKOFF_MAX_MS) backoff = HEALTH_BACKOFF_MAX_MS;
+  return backoff / 2 + random(backoff / 2 + 1);
+}
+
+bool providerAllowsRequest(ApiProvider provider) {
+  bool allowed = true;
+  portENTER_CRITICAL(&healthMux);
+  ProviderHealth& h = health[provider];
+  if (h.state == CIRCUIT_OPEN) {
+    if ((int32_t)(appMillis() - h.openUntil) >= 0) {
+      h.state = CIRCUIT_HALF_OPEN;
+    } else {
+      h.totalRejected++;
+      allowed = false;
+    }
+  }
+  portEXIT_CRITICAL(&healthMux);
+  return allowed;
+}
+
+bool isProviderOpen(ApiProvider provider) {
+  portENTER_CRITICAL(&healthMux);
+  const ProviderHealth& h = health[provider];
+  bool open = h.state == CIRCUIT_OPEN && (int32_t)(appMillis() - h.openUntil) < 0;
+  portEXIT_CRITICAL(&healthMux);
+  return open;
+}
+
+uint32_t providerRetryInMs(ApiProvider provider) {
+  portENTER_CRITICAL(&healthMux);
+  const ProviderHealth& h = health[provider];
+  int32_t left = h.state == CIRCUIT_OPEN ? (int32_t)(h.openUntil - appMillis()) : 0;
+  portEXIT_CRITICAL(&healthMux);
+  return left > 0 ? left : 0;
+}
+
+void recordProviderResult(ApiProvider provider, int httpCode, uint32_t retryAfterMs) {
+  // 2xx and non-throttling 4xx (bad symbol, bad key) mean the host is
+  // healthy; 429, 5xx and transport errors count against it
+  bool failure = httpCode == 429 || httpCode >= 500 || httpCode <= 0;
+  bool opened = false;
+  uint32_t openFor = 0;
+
+  portENTER_CRITICAL(&healthMux);
+  ProviderHealth& h = health[provider];
+  h.totalRequests++;
+  h.lastHttpStatus = httpCode;
+
+  if (!failure) {
+    h.state = CIRCUIT_CLOSED;
+    h.consecutiveFailures = 0;
+    h.openCount = 0;
+  } else {
+    h.totalFailures++;
+    if (h.consecutiveFailures < 255) h.consecutiveFailures++;
+
+    if (httpCode == 429 || h.state == CIRCUIT_HALF_OPEN ||
+        h.consecutiveFailures >= HEALTH_FAILURE_THRESHOLD) {
+      if (h.openCount < 255) h.openCount++;
+      openFor = backoffMs(h.openCount);
+      if (retryAfterMs > openFor) openFor = retryAfterMs;
+      h.state = CIRCUIT_OPEN;
+      h.openUntil = appMillis() + openFor;
+      opened = true;
+    }
+  }
+  portEXIT_CRITICAL(&healthMux);
+
+  if (opened) {
+    LOG_EVENT(EV_HEALTH_OPEN, nullptr, provider, openFor / 1000, httpCode);
+  }
+}
+
+ProviderHealth getProviderHealth(ApiProvider provider) {
+  portENTER_CRITICAL(&healthMux);
+  ProviderHealth snapshot = health[provider];
+  portEXIT_CRITICAL(&healthMux);
+  return snapshot;
+}
+
+const char* getProviderName(ApiProvider provider) {
+  return provider < PROVIDER_COUNT ? providerNames[provider] : "?";
+}
+
+const char* getCircuitStateName(CircuitState state) {
+  switch (state) {
+    case CIRCUIT_CLOSED:    return "closed";
+    case CIRCUIT_OPEN:      return "open";
+    case CIRCUIT_HALF_OPEN: return "half-open";
+    default: return "?";
+  }
+}
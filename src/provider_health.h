@@ -0,0 +1,55 @@
+#pragma once
+#include <Arduino.h>
+#include "api_client.h"
+
+// Per-provider health tracking with exponential backoff and a circuit breaker.
+//   CLOSED:    requests flow normally; consecutive failures are counted
+//   OPEN:      requests are rejected without touching the network until the
+//              backoff (or the server's Retry-After) expires
+//   HALF_OPEN: one probe request is let through; success closes the
+//              circuit, failure re-opens it with a doubled backoff
+// HTTP 429 opens the circuit immediately.
+
+enum CircuitState : uint8_t {
+  CIRCUIT_CLOSED    = 0,
+  CIRCUIT_OPEN      = 1,
+  CIRCUIT_HALF_OPEN = 2
+};
+
+struct ProviderHealth {
+  CircuitState state;
+  uint8_t consecutiveFailures;
+  uint8_t openCount;          // Re-opens since last close (drives the backoff)
+  int lastHttpStatus;
+  uint32_t openUntil;         // millis() when OPEN may move to HALF_OPEN
+  uint32_t totalRequests;
+  uint32_t totalFailures;
+  uint32_t totalRejected;     // Requests skipped while OPEN
+};
+
+// Reset all providers to CLOSED
+void initProviderHealth();
+
+// Gate a request about to be sent. Moves OPEN -> HALF_OPEN once the
+// backoff has expired. Returns false if the request must not be sent.
+bool providerAllowsRequest(ApiProvider provider);
+
+// True while the provider is OPEN and still backing off (read-only check)
+bool isProviderOpen(ApiProvider provider);
+
+// Time left in the backoff, 0 unless isProviderOpen()
+uint32_t providerRetryInMs(ApiProvider provider);
+
+// Record the outcome of a request that reached the network
+// httpCode: HTTP status, or negative HTTPClient error for transport failures
+// retryAfterMs: server-supplied Retry-After (0 if absent)
+void recordProviderResult(ApiProvider provider, int httpCode, uint32_t retryAfterMs);
+
+// Snapshot of a provider's health (for the status API)
+ProviderHealth getProviderHealth(ApiProvider provider);
+
+// Short name ("cmc", "coingecko", "twelvedata")
+const char* getProviderName(ApiProvider provider);
+
+// "closed", "open", "half-open"
+const char* getCircuitStateName(CircuitState state);
@@ -0,0 +1,71 @@
+#include "relay_wire.h"
+
+uint32_t relayWatchlistHash(const AppConfig* config) {
+  uint32_t h = 2166136261u;
+  auto mix = [&h](const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < len; i++) { h ^= p[i]; h *= 16777619u; }
+  };
+  mix(&config->numTickers, sizeof(config->numTickers));
+  for (int i = 0; i < config->numTickers; i++) {
+    mix(config->tickers[i].apiId, strlen(config->tickers[i].apiId));
+    mix(&config->tickers[i].type, sizeof(config->tickers[i].type));
+  }
+  return h;
+}
+
+void relayWriteHeader(uint8_t* buf, RelayMsgType type, uint16_t count, uint32_t seq,
+                      uint32_t senderId, uint32_t watchlistHash) {
+  RelayHeader hdr;
+  hdr.magic = RELAY_MAGIC;
+  hdr.version = RELAY_VERSION;
+  hdr.type = type;
+  hdr.count = count;
+  hdr.seq = seq;
+  hdr.senderId = senderId;
+  hdr.watchlistHash = watchlistHash;
+  memcpy(buf, &hdr, sizeof(hdr));
+}
+
+bool relayReadHeader(const uint8_t* data, size_t len, RelayHeader* out) {
+  if (len < sizeof(RelayHeader)) return false;
+  memcpy(out, data, sizeof(RelayHeader));
+  return out->magic == RELAY_MAGIC && out->version == RELAY_VERSION;
+}
+
+WirePrice relayWirePrice(uint8_t index, const TickerData& ticker) {
+  WirePrice wp;
+  wp.index = index;
+  wp.flags = (ticker.priceValid ? 0x80 : 0) | ((1 << TIMEFRAME_COUNT) - 1);
+  wp.price = ticker.currentPrice;
+  memcpy(wp.change, ticker.priceChange, sizeof(wp.change));
+  return wp;
+}
+
+bool relayReadPrice(const uint8_t* body, size_t len, int i, WirePrice* out) {
+  if (i < 0 || (i + 1) * sizeof(WirePrice) > len) return false;
+  memcpy(out, body + i * sizeof(WirePrice), sizeof(WirePrice));
+  return true;
+}
+
+size_t relaySparklineSize(const SparklineData& sparkline) {
+  return sizeof(WireSparkline) + sparkline.len;
+}
+
+size_t relayPutSparkline(uint8_t* buf, uint8_t index, uint8_t timeframe, const SparklineData& sparkline) {
+  WireSparkline ws = { index, timeframe, sparkline.len, sparkline.priceMin, sparkline.priceMax };
+  memcpy(buf, &ws, sizeof(ws));
+  memcpy(buf + sizeof(ws), sparkline.points, sparkline.len);
+  return sizeof(ws) + sparkline.len;
+}
+
+bool relayNextSparkline(const uint8_t* body, size_t len, size_t* off, WireSparkline* out,
+                        const uint8_t** points) {
+  if (*off + sizeof(WireSparkline) > len) return false;
+  memcpy(out, body + *off, sizeof(WireSparkline));
+  size_t start = *off + sizeof(WireSparkline);
+  if (out->len > SPARKLINE_POINTS || start + out->len > len) return false;
+  *points = body + start;
+  *off = start + out->len;
+  return true;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <Arduino.h>
+#include "ticker_types.h"
+
+// LAN relay wire format and election rule (see lan_relay.h), free of
+// network and RTOS code so tools/relay_check can run them on the host.
+// Little-endian, packed. Every datagram starts with a RelayHeader followed
+// by `count` entries of the message's entry type.
+
+#define RELAY_MAGIC       0x31525443  // "CTR1"
+#define RELAY_VERSION     2           // 2: fixed-point prices
+#define RELAY_MAX_PACKET  1200        // Stay under a typical WiFi MTU
+
+enum RelayRole : uint8_t {
+  RELAY_OFF       = 0,
+  RELAY_LISTENING = 1,  // Startup: waiting to hear an existing leader
+  RELAY_FOLLOWER  = 2,
+  RELAY_LEADER    = 3
+};
+
+enum RelayMsgType : uint8_t {
+  MSG_HEARTBEAT        = 0,
+  MSG_PRICES           = 1,  // WirePrice entries
+  MSG_SPARKLINES       = 2,  // WireSparkline header + len point bytes each
+  MSG_SNAPSHOT_REQUEST = 3   // Follower joined or saw a sequence gap
+};
+
+struct __attribute__((packed)) RelayHeader {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t type;
+  uint16_t count;
+  uint32_t seq;
+  uint32_t senderId;
+  uint32_t watchlistHash;
+};
+
+struct __attribute__((packed)) WirePrice {
+  uint8_t index;
+  uint8_t flags;        // bit7: valid, bits0-3: change mask
+  int64_t price;        // Price units (see price.h)
+  float change[TIMEFRAME_COUNT];
+};
+
+struct __attribute__((packed)) WireSparkline {
+  uint8_t index;
+  uint8_t timeframe;
+  uint8_t len;
+  int64_t priceMin;
+  int64_t priceMax;
+  // followed by len point bytes
+};
+
+// Most WirePrice entries in one datagram
+#define RELAY_PRICES_PER_PACKET ((RELAY_MAX_PACKET - sizeof(RelayHeader)) / sizeof(WirePrice))
+
+// FNV-1a over the slot layout; followers only accept a leader whose
+// watchlist maps the same ticker to the same slot
+uint32_t relayWatchlistHash(const AppConfig* config);
+
+// Header at the start of buf
+void relayWriteHeader(uint8_t* buf, RelayMsgType type, uint16_t count, uint32_t seq,
+                      uint32_t senderId, uint32_t watchlistHash);
+
+// Header of a received datagram; false if it is too short or not ours
+bool relayReadHeader(const uint8_t* data, size_t len, RelayHeader* out);
+
+// Entry for one ticker slot (all change% sent)
+WirePrice relayWirePrice(uint8_t index, const TickerData& ticker);
+
+// Entry i of a MSG_PRICES body; false past the end of the body
+bool relayReadPrice(const uint8_t* body, size_t len, int i, WirePrice* out);
+
+// Bytes a MSG_SPARKLINES entry for this chart takes
+size_t relaySparklineSize(const SparklineData& sparkline);
+
+// Write one MSG_SPARKLINES entry at buf; returns its size
+size_t relayPutSparkline(uint8_t* buf, uint8_t index, uint8_t timeframe, const SparklineData& sparkline);
+
+// Entry at *off of a MSG_SPARKLINES body: the entry header and its points
+// (inside body), with *off moved past it. False at the end of the body or
+// on a malformed entry.
+bool relayNextSparkline(const uint8_t* body, size_t len, size_t* off, WireSparkline* out,
+                        const uint8_t** points);
+
+// Whether a node in `role` follows leader traffic from senderId. Lowest
+// node id wins a contested election; a higher-id leader is ignored and
+// demotes itself on our next heartbeat.
+inline bool relayAcceptsLeader(RelayRole role, uint32_t nodeId, uint32_t senderId) {
+  return role != RELAY_LEADER || senderId < nodeId;
+}
+
+// Silence before a listener/follower promotes itself, spread by node id so
+// followers do not all promote on the same tick
+inline uint32_t relayTakeoverDelay(uint32_t nodeId) {
+  return RELAY_LEADER_TIMEOUT_MS + (nodeId % 2000);
+}
@@ -0,0 +1,95 @@
+#include "response_body.h"
+
+ResponseBody::ResponseBody()
+  : src(nullptr), inflater(nullptr), inNext(in), inLen(0), out(in), outLen(0),
+    wire(0), body(0), result(GZIP_MORE) {
+  // The source's own timeout bounds each read; Stream::timedRead() must
+  // not wait again on top of it
+  setTimeout(0);
+}
+
+void ResponseBody::begin(Stream* source) {
+  src = source;
+  inflater = nullptr;
+  inNext = in;
+  inLen = 0;
+  out = in;
+  outLen = 0;
+  wire = 0;
+  body = 0;
+  result = GZIP_MORE;
+}
+
+void ResponseBody::beginGzip(Stream* source, GzipInflater* z) {
+  begin(source);
+  gzipReset(z, nullptr, nullptr);
+  inflater = z;
+}
+
+void ResponseBody::end() {
+  src = nullptr;
+  inLen = 0;
+  outLen = 0;
+}
+
+// Next piece of the source into `in`: what is already buffered, but at
+// least one byte (waiting up to the source's timeout)
+bool ResponseBody::readSource() {
+  if (!src) return false;
+  int avail = src->available();
+  size_t want = avail > 0 ? min((size_t)avail, sizeof(in)) : 1;
+  size_t n = src->readBytes((char*)in, want);
+  if (n == 0) return false;
+  wire += n;
+  inNext = in;
+  inLen = n;
+  return true;
+}
+
+// Make outLen > 0; false at the end of the body, on a read timeout or on
+// corrupt gzip data
+bool ResponseBody::fill() {
+  while (outLen == 0) {
+    if (!inflater) {
+      if (!readSource()) return false;
+      out = inNext;
+      outLen = inLen;
+      inLen = 0;
+      break;
+    }
+    if (result != GZIP_MORE) return false;
+    result = gzipInflate(inflater, &inNext, &inLen, &out, &outLen);
+    if (outLen == 0 && result == GZIP_MORE && !readSource()) return false;
+  }
+  body += outLen;
+  return true;
+}
+
+int ResponseBody::available() {
+  if (outLen > 0) return outLen;
+  if (inflater) return (inLen > 0 || (src && src->available() > 0)) ? 1 : 0;
+  return src ? src->available() : 0;
+}
+
+int ResponseBody::read() {
+  if (outLen == 0 && !fill()) return -1;
+  outLen--;
+  return *out++;
+}
+
+int ResponseBody::peek() {
+  if (outLen == 0 && !fill()) return -1;
+  return *out;
+}
+
+size_t ResponseBody::readBytes(char* buffer, size_t length) {
+  size_t done = 0;
+  while (done < length && (outLen > 0 || fill())) {
+    size_t n = min(length - done, outLen);
+    memcpy(buffer + done, out, n);
+    out += n;
+    outLen -= n;
+    done += n;
+  }
+  return done;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "gzip_inflater.h"
+
+// Response body as the JSON parser reads it.
+// Wraps the connection (or simulation fixture) stream, reading it in
+// FETCH_READ_CHUNK pieces and counting the bytes taken off it. A gzip body
+// is inflated on the way through: the parser reads inflated bytes in place
+// from the inflater's dictionary, so neither the compressed nor the
+// inflated body is ever held whole.
+class ResponseBody : public Stream {
+public:
+  ResponseBody();
+
+  // Read src as is
+  void begin(Stream* src);
+
+  // Inflate a gzip body from src with z (reset here)
+  void beginGzip(Stream* src, GzipInflater* z);
+
+  // Drop the source; reads return -1 until the next begin
+  void end();
+
+  bool gzipped() const { return inflater != nullptr; }
+
+  // Bytes read off the source, and what they inflated to (the same when
+  // not gzipped)
+  uint32_t wireBytes() const { return wire; }
+  uint32_t bodyBytes() const { return body; }
+
+  // GZIP_MORE while the gzip body is unfinished or not gzipped
+  GzipResult gzipResult() const { return result; }
+
+  // Stream
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t readBytes(char* buffer, size_t length) override;
+  size_t write(uint8_t) override { return 0; }
+
+private:
+  bool readSource();
+  bool fill();
+
+  Stream* src;
+  GzipInflater* inflater;
+  uint8_t in[FETCH_READ_CHUNK];
+  const uint8_t* inNext;      // Unconsumed source bytes in `in`
+  size_t inLen;
+  const uint8_t* out;         // Unread body bytes (in `in` or the dictionary)
+  size_t outLen;
+  uint32_t wire;
+  uint32_t body;
+  GzipResult result;
+};
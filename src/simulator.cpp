@@ -0,0 +1,359 @@
+#include "simulator.h"
+
+#if SIM_BUILD
+
+#include "app_clock.h"
+#include "data_manager.h"
+#include "provider_health.h"
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+#include <HTTPClient.h>
+#include <utility>
+
+#define SIM_SERIES 5           // price + one per timeframe
+#define SIM_BUCKETS 7
+
+static const uint32_t bucketLimitsMin[SIM_BUCKETS - 1] = { 5, 15, 60, 180, 360, 1440 };
+static const char* seriesNames[SIM_SERIES] = { "price", "24h", "7d", "30d", "90d" };
+
+struct SimProviderStats {
+  uint32_t requests;
+  uint32_t failures;
+  uint32_t throttled;
+  uint32_t credits;
+};
+
+struct SimSeriesStats {
+  uint32_t lastOk;             // Virtual ms of the last successful update (0 = never)
+  uint32_t samples;
+  uint32_t sumMin;
+  uint32_t maxMin;
+  uint32_t hist[SIM_BUCKETS];
+};
+
+struct SimRequest {
+  char url[FETCH_URL_MAX];
+  uint32_t timeoutMs;
+  uint32_t latencyMs;
+  File body;
+};
+
+static uint32_t virtualNow = 0;
+static uint32_t rngState = 1;
+static SimSettings current;
+static SimRequest requests[PROVIDER_COUNT];
+static SimProviderStats providerStats[PROVIDER_COUNT];
+static SimSeriesStats series[MAX_TICKERS][SIM_SERIES];
+static AppConfig simConfig;
+static TickerData simTickers[MAX_TICKERS];
+// Replaced by the simulation task, copied by the web server
+static String report = "{}";
+static SemaphoreHandle_t reportMutex = nullptr;
+static volatile bool runRequested = false;
+
+uint32_t appMillis() {
+  return virtualNow;
+}
+
+time_t appTime() {
+  return (time_t)current.startEpoch + virtualNow / 1000;
+}
+
+int64_t appWallMs() {
+  return (int64_t)current.startEpoch * 1000 + virtualNow;
+}
+
+// xorshift32: deterministic for a given seed
+static uint32_t nextRandom() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+void loadSimSettings(SimSettings* out) {
+  memset(out, 0, sizeof(SimSettings));
+  out->days = 7;
+  out->stepMs = 1000;
+  out->seed = 1;
+  out->startEpoch = SIM_START_EPOCH;
+  out->retryAfterS = 60;
+  out->useCmc = true;
+  out->useTwelveData = true;
+  for (int p = 0; p < PROVIDER_COUNT; p++) {
+    out->latencyMs[p] = 800;
+    out->jitterMs[p] = 400;
+  }
+
+  File f = LittleFS.open("/sim/sim.json", "r");
+  if (!f) return;
+  JsonDocument doc;
+  DeserializationError error = deserializeJson(doc, f);
+  f.close();
+  if (error) {
+    Serial.printf("[Sim] sim.json parse error: %s\n", error.c_str());
+    return;
+  }
+
+  out->days = min((uint32_t)(doc["days"] | out->days), (uint32_t)SIM_MAX_DAYS);
+  out->stepMs = max((uint32_t)(doc["stepMs"] | out->stepMs), (uint32_t)100);
+  out->seed = doc["seed"] | out->seed;
+  out->startEpoch = doc["startEpoch"] | out->startEpoch;
+  out->retryAfterS = doc["retryAfterS"] | out->retryAfterS;
+  out->useCmc = doc["useCmc"] | out->useCmc;
+  out->useTwelveData = doc["useTwelveData"] | out->useTwelveData;
+
+  for (int p = 0; p < PROVIDER_COUNT; p++) {
+    JsonObject o = doc["providers"][getProviderName((ApiProvider)p)];
+    if (o.isNull()) continue;
+    out->latencyMs[p] = o["latencyMs"] | out->latencyMs[p];
+    out->jitterMs[p] = o["jitterMs"] | out->jitterMs[p];
+    out->failPermille[p] = o["failPermille"] | out->failPermille[p];
+    out->throttlePermille[p] = o["throttlePermille"] | out->throttlePermille[p];
+  }
+}
+
+// /sim/<provider>_<last path segment>.json
+static void fixturePath(ApiProvider provider, const char* url, char* out, size_t len) {
+  const char* end = strchr(url, '?');
+  if (!end) end = url + strlen(url);
+  const char* start = end;
+  while (start > url && *(start - 1) != '/') start--;
+  snprintf(out, len, "/sim/%s_%.*s.json", getProviderName(provider), (int)(end - start), start);
+}
+
+// CMC bills one credit per 100 symbols in a quotes call
+static uint32_t requestCredits(ApiProvider provider, const char* url) {
+  if (provider != PROVIDER_CMC) return 1;
+  const char* ids = strstr(url, "slug=");
+  if (!ids) return 1;
+  uint32_t count = 1;
+  for (const char* c = ids; *c && *c != '&'; c++) {
+    if (*c == ',') count++;
+  }
+  return 1 + (count - 1) / 100;
+}
+
+void simBeginRequest(ApiProvider provider, const char* url, uint32_t timeoutMs) {
+  SimRequest& r = requests[provider];
+  if (r.body) r.body.close();
+  strlcpy(r.url, url, sizeof(r.url));
+  r.timeoutMs = timeoutMs;
+  r.latencyMs = 0;
+}
+
+int simSendRequest(ApiProvider provider, uint32_t* retryAfterMs) {
+  SimRequest& r = requests[provider];
+  SimProviderStats& st = providerStats[provider];
+  st.requests++;
+  *retryAfterMs = 0;
+
+  uint32_t jitter = current.jitterMs[provider];
+  r.latencyMs = current.latencyMs[provider] + (jitter ? nextRandom() % (jitter + 1) : 0);
+  if (r.latencyMs >= r.timeoutMs) {
+    r.latencyMs = r.timeoutMs;
+    st.failures++;
+    return HTTPC_ERROR_READ_TIMEOUT;
+  }
+
+  uint32_t roll = nextRandom() % 1000;
+  if (roll < current.throttlePermille[provider]) {
+    st.throttled++;
+    *retryAfterMs = current.retryAfterS * 1000;
+    return 429;
+  }
+  if (roll < (uint32_t)current.throttlePermille[provider] + current.failPermille[provider]) {
+    st.failures++;
+    return 503;
+  }
+
+  char path[64];
+  fixturePath(provider, r.url, path, sizeof(path));
+  r.body = LittleFS.open(path, "r");
+  if (!r.body) {
+    Serial.printf("[Sim] Missing fixture %s\n", path);
+    st.failures++;
+    return 404;
+  }
+
+  st.credits += requestCredits(provider, r.url);
+  return 200;
+}
+
+Stream& simResponseStream(ApiProvider provider) {
+  return requests[provider].body;
+}
+
+void simEndRequest(ApiProvider provider) {
+  if (requests[provider].body) requests[provider].body.close();
+}
+
+uint32_t simLastLatency(ApiProvider provider) {
+  return requests[provider].latencyMs;
+}
+
+void simObserveCompletion(const FetchJob* job) {
+  if (job->outcome != FETCH_OK) return;
+
+  switch (job->kind) {
+    case FETCH_CMC_PRICES:
+    case FETCH_COINGECKO_PRICES:
+      for (int n = 0; n < job->numTickers && n < FETCH_BATCH_MAX; n++) {
+        if (job->quotes[n].valid) series[job->batchTickers[n]][0].lastOk = job->finishedAt;
+      }
+      break;
+    case FETCH_STOCK_PRICE:
+      if (job->tickerIndex < MAX_TICKERS) series[job->tickerIndex][0].lastOk = job->finishedAt;
+      break;
+    case FETCH_CRYPTO_CHART:
+    case FETCH_STOCK_CHART:
+      if (job->tickerIndex < MAX_TICKERS && job->timeframe < TIMEFRAME_COUNT) {
+        series[job->tickerIndex][1 + job->timeframe].lastOk = job->finishedAt;
+      }
+      break;
+  }
+}
+
+// Age of every enabled series right now (never-updated series age from t=0)
+static void sampleStaleness() {
+  for (int i = 0; i < simConfig.numTickers; i++) {
+    if (!simConfig.tickers[i].enabled) continue;
+    for (int s = 0; s < SIM_SERIES; s++) {
+      SimSeriesStats& st = series[i][s];
+      uint32_t ageMin = (virtualNow - st.lastOk) / 60000;
+      int bucket = 0;
+      while (bucket < SIM_BUCKETS - 1 && ageMin >= bucketLimitsMin[bucket]) bucket++;
+      st.hist[bucket]++;
+      st.samples++;
+      st.sumMin += ageMin;
+      if (ageMin > st.maxMin) st.maxMin = ageMin;
+    }
+  }
+}
+
+static void buildReport(uint32_t wallMs, uint32_t virtualMs) {
+  JsonDocument doc;
+  doc["days"] = current.days;
+  doc["stepMs"] = current.stepMs;
+  doc["seed"] = current.seed;
+  doc["startEpoch"] = current.startEpoch;
+  doc["virtualMs"] = virtualMs;
+  doc["wallMs"] = wallMs;
+
+  float days = virtualMs / 86400000.0f;
+  JsonArray providers = doc["providers"].to<JsonArray>();
+  for (int p = 0; p < PROVIDER_COUNT; p++) {
+    ProviderHealth h = getProviderHealth((ApiProvider)p);
+    const SimProviderStats& st = providerStats[p];
+    JsonObject o = providers.add<JsonObject>();
+    o["name"] = getProviderName((ApiProvider)p);
+    o["requests"] = st.requests;
+    o["requestsPerDay"] = days > 0 ? st.requests / days : 0;
+    o["failures"] = st.failures;
+    o["throttled"] = st.throttled;
+    o["rejected"] = h.totalRejected;
+    o["credits"] = st.credits;
+    o["creditsPerDay"] = days > 0 ? st.credits / days : 0;
+  }
+
+  JsonArray buckets = doc["bucketsMin"].to<JsonArray>();
+  for (int b = 0; b < SIM_BUCKETS - 1; b++) buckets.add(bucketLimitsMin[b]);
+
+  JsonArray tickers = doc["tickers"].to<JsonArray>();
+  for (int i = 0; i < simConfig.numTickers; i++) {
+    if (!simConfig.tickers[i].enabled) continue;
+    JsonObject t = tickers.add<JsonObject>();
+    t["symbol"] = simConfig.tickers[i].symbol;
+    JsonArray sArr = t["series"].to<JsonArray>();
+    for (int s = 0; s < SIM_SERIES; s++) {
+      const SimSeriesStats& st = series[i][s];
+      JsonObject o = sArr.add<JsonObject>();
+      o["name"] = seriesNames[s];
+      o["meanMin"] = st.samples ? (float)st.sumMin / st.samples : 0;
+      o["maxMin"] = st.maxMin;
+      JsonArray hist = o["hist"].to<JsonArray>();
+      for (int b = 0; b < SIM_BUCKETS; b++) hist.add(st.hist[b]);
+    }
+  }
+
+  // Serialize outside the lock; readers only wait for the swap
+  String fresh;
+  serializeJson(doc, fresh);
+  xSemaphoreTake(reportMutex, portMAX_DELAY);
+  report = std::move(fresh);
+  xSemaphoreGive(reportMutex);
+}
+
+void runSimulation(const AppConfig* config, const SimSettings& settings) {
+  current = settings;
+  rngState = settings.seed ? settings.seed : 1;
+  randomSeed(rngState);   // Backoff jitter in provider_health
+
+  memset(providerStats, 0, sizeof(providerStats));
+  memset(series, 0, sizeof(series));
+  memset(simTickers, 0, sizeof(simTickers));
+
+  // Work on a copy so the device config is never touched
+  simConfig = *config;
+  simConfig.lanRelay = false;
+  simConfig.marketStream = false;
+  strlcpy(simConfig.cmcApiKey, settings.useCmc ? "sim" : "", sizeof(simConfig.cmcApiKey));
+  strlcpy(simConfig.twelveDataApiKey, settings.useTwelveData ? "sim" : "", sizeof(simConfig.twelveDataApiKey));
+  setCMCApiKey(simConfig.cmcApiKey);
+
+  Serial.printf("[Sim] %lu days, step %lums, seed %lu, %d tickers\n",
+                (unsigned long)settings.days, (unsigned long)settings.stepMs,
+                (unsigned long)settings.seed, simConfig.numTickers);
+
+  // Start one step in: the data manager treats a fetch time of 0 as "never"
+  virtualNow = settings.stepMs;
+  initProviderHealth();
+  initDataManager(&simConfig, simTickers);
+  forceRefresh();
+
+  uint32_t wallStart = millis();
+  uint32_t endMs = settings.days * 86400000UL;
+  uint32_t nextSample = virtualNow;
+  uint32_t steps = 0;
+
+  while (virtualNow < endMs) {
+    updateData();
+    if ((int32_t)(virtualNow - nextSample) >= 0) {
+      sampleStaleness();
+      nextSample += SIM_SAMPLE_MS;
+    }
+    virtualNow += settings.stepMs;
+
+    // Let the idle task run so the task watchdog stays quiet
+    if (++steps % 2000 == 0) vTaskDelay(1);
+  }
+
+  uint32_t wallMs = millis() - wallStart;
+  buildReport(wallMs, virtualNow);
+  Serial.printf("[Sim] Done in %lums\n", (unsigned long)wallMs);
+  Serial.println(report);
+}
+
+void requestSimulation() {
+  // First called from setup(), before the web server can read the report
+  if (!reportMutex) reportMutex = xSemaphoreCreateMutex();
+  runRequested = true;
+}
+
+void simulatorLoop(const AppConfig* config) {
+  if (!runRequested) return;
+  runRequested = false;
+  SimSettings settings;
+  loadSimSettings(&settings);
+  runSimulation(config, settings);
+}
+
+String getSimReport() {
+  if (!reportMutex) return report;
+  xSemaphoreTake(reportMutex, portMAX_DELAY);
+  String copy = report;
+  xSemaphoreGive(reportMutex);
+  return copy;
+}
+
+#endif
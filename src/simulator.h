@@ -0,0 +1,62 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+#if SIM_BUILD
+
+#include "ticker_types.h"
+#include "api_client.h"
+#include "fetch_engine.h"
+
+// Time-warp simulation of the fetch scheduler (pio run -e sim).
+// appMillis() becomes a virtual clock, the fetch engine runs jobs inline,
+// and the API client reads recorded responses from LittleFS
+// (/sim/<provider>_<endpoint>.json, e.g. /sim/coingecko_market_chart.json)
+// instead of the network. updateData() then runs unchanged, stepping the
+// clock, so days of scheduling take seconds. The report counts calls and
+// credits per provider and samples how stale each ticker's price and
+// sparklines get. appTime() starts at startEpoch, so stock/forex fetches
+// follow the market calendar through simulated nights and weekends.
+
+struct SimSettings {
+  uint32_t days;
+  uint32_t stepMs;                          // Virtual time per updateData() call
+  uint32_t seed;
+  uint32_t startEpoch;                      // Wall clock (UTC) at virtual time 0
+  uint32_t latencyMs[PROVIDER_COUNT];       // Base response time
+  uint32_t jitterMs[PROVIDER_COUNT];        // Added uniformly in [0, jitter]
+  uint16_t failPermille[PROVIDER_COUNT];    // HTTP 503 rate
+  uint16_t throttlePermille[PROVIDER_COUNT];// HTTP 429 rate
+  uint32_t retryAfterS;                     // Retry-After sent with 429s
+  bool useCmc;                              // Pretend a CMC key is configured
+  bool useTwelveData;                       // Pretend a Twelve Data key is configured
+};
+
+// Read /sim/sim.json; missing fields keep their defaults
+void loadSimSettings(SimSettings* out);
+
+// Run a full simulation on the calling task (blocks for the wall time it takes)
+void runSimulation(const AppConfig* config, const SimSettings& settings);
+
+// Ask the main loop to (re)run the simulation with the current settings
+void requestSimulation();
+
+// Main loop hook: runs a requested simulation
+void simulatorLoop(const AppConfig* config);
+
+// Copy of the last report as JSON ("{}" before the first run)
+String getSimReport();
+
+// Fixture transport (used by the API client in place of HTTPClient)
+void simBeginRequest(ApiProvider provider, const char* url, uint32_t timeoutMs);
+int simSendRequest(ApiProvider provider, uint32_t* retryAfterMs);
+Stream& simResponseStream(ApiProvider provider);
+void simEndRequest(ApiProvider provider);
+
+// Simulated duration of the provider's last request
+uint32_t simLastLatency(ApiProvider provider);
+
+// Fetch engine hook: a job is being handed back to the data manager
+void simObserveCompletion(const FetchJob* job);
+
+#endif
@@ -0,0 +1,305 @@
+#include "sparkline_store.h"
+#include "event_log.h"
+#include "app_clock.h"
+#include "fetch_events.h"
+#include <LittleFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#define TF_BITS ((1 << TIMEFRAME_COUNT) - 1)
+
+struct ResidentEntry {
+  int16_t idx;               // Watchlist slot, -1 = free
+  uint8_t loaded;            // Bit per timeframe: sparklines[tf] is current
+  uint32_t lastUse;          // Access stamp for LRU eviction
+  SparklineData sparklines[TIMEFRAME_COUNT];
+};
+
+// Render loop, fetch task and web server all read; the fetch task writes.
+// Flash I/O happens under the lock too, so a read never sees a half-written
+// cache file.
+static SemaphoreHandle_t storeMutex = nullptr;
+
+static ResidentEntry* entries = nullptr;
+static int capacity = 0;
+static bool directMapped = false;   // Entry i belongs to slot i (PSRAM / sim)
+static bool inPsram = false;
+
+static int numSlots = 0;
+static uint32_t keys[MAX_TICKERS];        // Hash of each slot's apiId (cache file name)
+static uint8_t validMask[MAX_TICKERS];    // Bit per timeframe: a valid sparkline exists
+static int windowFirst = 0;
+static int windowCount = 0;
+static uint32_t useClock = 0;
+
+static SparklineStoreStats stats = {};
+
+static bool lock() {
+  return storeMutex && xSemaphoreTake(storeMutex, portMAX_DELAY) == pdTRUE;
+}
+
+static void unlock() {
+  xSemaphoreGive(storeMutex);
+}
+
+// FNV-1a: fixed-length file names however long the apiId is
+static uint32_t hashId(const char* id) {
+  uint32_t h = 2166136261u;
+  while (*id) {
+    h ^= (uint8_t)*id++;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static void cachePath(uint32_t key, int tf, char* path, size_t size) {
+  snprintf(path, size, "/cache/%08lx_%d.bin", (unsigned long)key, tf);
+}
+
+static void saveCacheFile(uint32_t key, int tf, const SparklineData* sp) {
+#if SIM_BUILD
+  return;  // Simulated days would otherwise rewrite flash thousands of times
+#endif
+  char path[32];
+  cachePath(key, tf, path, sizeof(path));
+  File f = LittleFS.open(path, "w");
+  if (!f) return;
+  f.write((const uint8_t*)sp, sizeof(SparklineData));
+  f.close();
+  stats.flashWrites++;
+}
+
+static bool loadCacheFile(uint32_t key, int tf, SparklineData* sp, time_t* fetchedAt) {
+  memset(sp, 0, sizeof(SparklineData));
+#if SIM_BUILD
+  return false;  // Every simulation starts from empty sparklines
+#endif
+  char path[32];
+  cachePath(key, tf, path, sizeof(path));
+  File f = LittleFS.open(path, "r");
+  if (!f) return false;
+  stats.flashReads++;
+  if (f.size() != sizeof(SparklineData)) { f.close(); return false; }
+  f.read((uint8_t*)sp, sizeof(SparklineData));
+  if (fetchedAt) {
+    time_t written = f.getLastWrite();
+    *fetchedAt = appTimeValid(written) ? written : 0;
+  }
+  f.close();
+  if (!sp->valid) memset(sp, 0, sizeof(SparklineData));
+  return sp->valid;
+}
+
+static bool windowHas(int idx) {
+  if (numSlots == 0 || windowCount == 0) return false;
+  return (idx - windowFirst + numSlots) % numSlots < windowCount;
+}
+
+static ResidentEntry* findEntry(int idx) {
+  if (directMapped) return entries[idx].idx == idx ? &entries[idx] : nullptr;
+  for (int i = 0; i < capacity; i++) {
+    if (entries[i].idx == idx) return &entries[i];
+  }
+  return nullptr;
+}
+
+// Entry for a slot that may stay resident: direct-mapped, or in the window.
+// Evicts the least recently used entry outside the window if needed.
+static ResidentEntry* claimEntry(int idx) {
+  ResidentEntry* e = findEntry(idx);
+  if (e) return e;
+
+  if (directMapped) {
+    e = &entries[idx];
+  } else {
+    if (!windowHas(idx)) return nullptr;
+    for (int i = 0; i < capacity; i++) {
+      if (entries[i].idx < 0) { e = &entries[i]; break; }
+      if (windowHas(entries[i].idx)) continue;
+      if (!e || entries[i].lastUse < e->lastUse) e = &entries[i];
+    }
+    if (!e) return nullptr;
+    if (e->idx >= 0) {
+      stats.evictions++;
+      stats.resident--;
+    }
+  }
+
+  e->idx = idx;
+  e->loaded = 0;
+  e->lastUse = ++useClock;
+  stats.resident++;
+  return e;
+}
+
+// Resident copy if current, else the cache file; caller holds the lock
+static bool readLocked(int idx, int tf, SparklineData* out, time_t* fetchedAt) {
+  uint8_t bit = 1 << tf;
+  ResidentEntry* e = findEntry(idx);
+  if (e && (e->loaded & bit)) {
+    e->lastUse = ++useClock;
+    stats.hits++;
+    *out = e->sparklines[tf];
+    return out->valid;
+  }
+  if (!(validMask[idx] & bit)) {
+    memset(out, 0, sizeof(SparklineData));
+    return false;
+  }
+
+  bool ok = loadCacheFile(keys[idx], tf, out, fetchedAt);
+  if (!ok) validMask[idx] &= ~bit;
+
+  e = claimEntry(idx);
+  if (e) {
+    e->sparklines[tf] = *out;
+    e->loaded |= bit;
+  }
+  return ok;
+}
+
+void initSparklineStore() {
+  if (storeMutex) return;
+  storeMutex = xSemaphoreCreateMutex();
+
+#if SIM_BUILD
+  // No flash cache in simulation: keep every slot resident
+  entries = (ResidentEntry*)calloc(MAX_TICKERS, sizeof(ResidentEntry));
+  directMapped = entries != nullptr;
+#else
+  if (psramFound()) {
+    entries = (ResidentEntry*)ps_calloc(MAX_TICKERS, sizeof(ResidentEntry));
+    directMapped = inPsram = entries != nullptr;
+  }
+#endif
+  if (!entries) {
+    entries = (ResidentEntry*)calloc(SPARKLINE_CACHE_TICKERS, sizeof(ResidentEntry));
+  }
+  capacity = !entries ? 0 : directMapped ? MAX_TICKERS : SPARKLINE_CACHE_TICKERS;
+  for (int i = 0; i < capacity; i++) entries[i].idx = -1;
+
+  stats.psram = inPsram;
+  stats.capacity = capacity;
+  LittleFS.mkdir("/cache");
+  LOG_EVENT(EV_STORE_INIT, inPsram ? "PSRAM" : "flash", capacity);
+}
+
+void resetSparklineStore(const AppConfig* config) {
+  if (!lock()) return;
+  numSlots = min((int)config->numTickers, MAX_TICKERS);
+  for (int i = 0; i < numSlots; i++) {
+    keys[i] = hashId(config->tickers[i].apiId);
+    validMask[i] = TF_BITS;
+  }
+  for (int i = numSlots; i < MAX_TICKERS; i++) validMask[i] = 0;
+  for (int i = 0; i < capacity; i++) entries[i].idx = -1;
+  stats.resident = 0;
+  unlock();
+}
+
+bool scanSparkline(int idx, int tf, SparklineData* out, time_t* fetchedAt) {
+  *fetchedAt = 0;
+  if (idx < 0 || tf < 0 || tf >= TIMEFRAME_COUNT || !lock()) return false;
+  bool ok = false;
+  if (idx < numSlots) {
+    // Forget any resident copy so the file decides
+    ResidentEntry* e = findEntry(idx);
+    if (e) e->loaded &= ~(1 << tf);
+    validMask[idx] |= 1 << tf;
+    ok = readLocked(idx, tf, out, fetchedAt);
+  } else {
+    memset(out, 0, sizeof(SparklineData));
+  }
+  unlock();
+  return ok;
+}
+
+bool readSparkline(int idx, int tf, SparklineData* out) {
+  if (idx < 0 || tf < 0 || tf >= TIMEFRAME_COUNT || !lock()) {
+    memset(out, 0, sizeof(SparklineData));
+    return false;
+  }
+  bool ok = false;
+  if (idx < numSlots) {
+    ok = readLocked(idx, tf, out, nullptr);
+  } else {
+    memset(out, 0, sizeof(SparklineData));
+  }
+  unlock();
+  return ok;
+}
+
+bool sparklineValid(int idx, int tf) {
+  if (idx < 0 || idx >= MAX_TICKERS || tf < 0 || tf >= TIMEFRAME_COUNT) return false;
+  return (validMask[idx] >> tf) & 1;
+}
+
+void writeSparkline(int idx, int tf, const SparklineData* sparkline) {
+  if (idx < 0 || tf < 0 || tf >= TIMEFRAME_COUNT || !lock()) return;
+  if (idx < numSlots) {
+    uint8_t bit = 1 << tf;
+    ResidentEntry* e = claimEntry(idx);
+    if (e) {
+      e->sparklines[tf] = *sparkline;
+      e->loaded |= bit;
+      e->lastUse = ++useClock;
+    }
+    if (sparkline->valid) {
+      validMask[idx] |= bit;
+    } else {
+      validMask[idx] &= ~bit;
+    }
+    saveCacheFile(keys[idx], tf, sparkline);
+  }
+  unlock();
+}
+
+void setSparklineWindow(int first, int count) {
+  if (!lock()) return;
+  first = first < 0 ? 0 : first;
+  count = constrain(count, 0, capacity);
+  bool moved = first != windowFirst || count != windowCount;
+  windowFirst = first;
+  windowCount = count;
+  unlock();
+  if (moved) signalFetchTask(FETCH_EVENT_WORK);   // Page the new slots in
+}
+
+bool inSparklineWindow(int idx) {
+  if (!lock()) return false;
+  bool in = windowHas(idx);
+  unlock();
+  return in;
+}
+
+bool sparklineStoreTick() {
+#if SIM_BUILD
+  return false;  // Everything is resident; nothing on flash to page in
+#endif
+  int budget = SPARKLINE_PAGE_IN_PER_TICK;
+  SparklineData scratch;
+  for (int n = 0; n < windowCount && budget > 0; n++) {
+    if (!lock()) return false;
+    // The window may move or shrink between passes; re-read it each time
+    if (n < windowCount && n < numSlots) {
+      int idx = (windowFirst + n) % numSlots;
+      ResidentEntry* e = findEntry(idx);
+      uint8_t missing = validMask[idx] & ~(e ? e->loaded : 0);
+      for (int tf = 0; tf < TIMEFRAME_COUNT && budget > 0; tf++) {
+        if (!(missing & (1 << tf))) continue;
+        readLocked(idx, tf, &scratch, nullptr);
+        budget--;
+      }
+    }
+    unlock();
+  }
+  return budget == 0;   // Possibly more to read
+}
+
+SparklineStoreStats getSparklineStoreStats() {
+  SparklineStoreStats s = {};
+  if (!lock()) return s;
+  s = stats;
+  unlock();
+  return s;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "ticker_types.h"
+
+// Sparkline storage for watchlists larger than internal RAM can hold.
+// Per-ticker hot state (price, change%) stays in TickerData; the charts live
+// here, persisted in /cache/<key>_<tf>.bin on LittleFS and cached in RAM:
+//
+//   PSRAM found: every watchlist slot has a resident entry in one PSRAM block
+//   No PSRAM:    SPARKLINE_CACHE_TICKERS entries in internal RAM, least
+//                recently used evicted first (the file stays on flash)
+//
+// The render loop marks the slots it will show soon (the window); those are
+// never evicted and the fetch task pages them in ahead of time. Reads outside
+// the window go to flash without displacing anything. All calls are
+// thread-safe and readers get a copy.
+
+struct SparklineStoreStats {
+  bool psram;             // Entries live in PSRAM (one per slot)
+  uint16_t capacity;      // Resident ticker entries
+  uint16_t resident;      // Entries in use
+  uint32_t hits;          // Reads served from RAM
+  uint32_t flashReads;    // Reads (incl. page-ins) served from flash
+  uint32_t evictions;
+  uint32_t flashWrites;
+};
+
+// Allocate the resident entries (call once in setup)
+void initSparklineStore();
+
+// Drop everything resident and key the flash cache by this watchlist. Every
+// slot counts as possibly cached until scanSparkline() or a read settles it.
+void resetSparklineStore(const AppConfig* config);
+
+// Post-reset pass: read one slot's cache file and record whether it exists.
+// *fetchedAt is the file's write time (0 if written before SNTP synced).
+bool scanSparkline(int idx, int tf, SparklineData* out, time_t* fetchedAt);
+
+// Copy of a sparkline; false (and out->valid false) when there is none
+bool readSparkline(int idx, int tf, SparklineData* out);
+
+// A valid sparkline exists for this slot (RAM or flash); never touches flash
+bool sparklineValid(int idx, int tf);
+
+// Store a sparkline: updates the resident copy (if any) and the cache file
+void writeSparkline(int idx, int tf, const SparklineData* sparkline);
+
+// Slots [first, first + count) (wrapping) are about to be shown; count is
+// clamped to the capacity
+void setSparklineWindow(int first, int count);
+
+// Slot is inside the current window
+bool inSparklineWindow(int idx);
+
+// Page window slots in from flash, a few files per call (fetch task).
+// Returns true if it stopped at its budget and should run again soon.
+// Moving the window signals the fetch task (see fetch_events.h).
+bool sparklineStoreTick();
+
+SparklineStoreStats getSparklineStoreStats();
@@ -0,0 +1,129 @@
+#include "ticker_feed.h"
+#include "sparkline_store.h"
+
+// Minimal MessagePack writer: only the types the feed uses
+class MsgPackWriter {
+public:
+  explicit MsgPackWriter(Print& out) : out(out), written(0) {}
+
+  void array(uint16_t n) {
+    if (n < 16) {
+      byte(0x90 | n);
+    } else {
+      uint8_t b[3] = { 0xDC, (uint8_t)(n >> 8), (uint8_t)n };
+      bytes(b, 3);
+    }
+  }
+
+  void nil() { byte(0xC0); }
+  void boolean(bool v) { byte(v ? 0xC3 : 0xC2); }
+
+  void uint(uint32_t v) {
+    if (v < 0x80) {
+      byte((uint8_t)v);
+    } else if (v <= 0xFF) {
+      uint8_t b[2] = { 0xCC, (uint8_t)v };
+      bytes(b, 2);
+    } else if (v <= 0xFFFF) {
+      uint8_t b[3] = { 0xCD, (uint8_t)(v >> 8), (uint8_t)v };
+      bytes(b, 3);
+    } else {
+      uint8_t b[5] = { 0xCE, (uint8_t)(v >> 24), (uint8_t)(v >> 16), (uint8_t)(v >> 8), (uint8_t)v };
+      bytes(b, 5);
+    }
+  }
+
+  void float32(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    uint8_t b[5] = { 0xCA, (uint8_t)(bits >> 24), (uint8_t)(bits >> 16), (uint8_t)(bits >> 8), (uint8_t)bits };
+    bytes(b, 5);
+  }
+
+  void float64(double d) {
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    uint8_t b[9] = { 0xCB };
+    for (int i = 0; i < 8; i++) b[1 + i] = (uint8_t)(bits >> (56 - 8 * i));
+    bytes(b, 9);
+  }
+
+  void str(const char* s) {
+    size_t len = strnlen(s, 31);
+    byte(0xA0 | len);  // fixstr: symbols are < 32 chars
+    bytes((const uint8_t*)s, len);
+  }
+
+  void bin(const uint8_t* data, uint8_t len) {
+    uint8_t b[2] = { 0xC4, len };
+    bytes(b, 2);
+    bytes(data, len);
+  }
+
+  size_t size() const { return written; }
+
+private:
+  void byte(uint8_t b) { written += out.write(b); }
+  void bytes(const uint8_t* b, size_t n) { written += out.write(b, n); }
+
+  Print& out;
+  size_t written;
+};
+
+size_t writeTickerFeed(Print& out, const AppConfig* config, const TickerData* tickers, int from) {
+  MsgPackWriter w(out);
+
+  // This page: up to TICKER_FEED_PAGE enabled slots in [from, end)
+  if (from < 0) from = 0;
+  uint16_t enabled = 0;
+  int end = from;
+  for (; end < config->numTickers && enabled < TICKER_FEED_PAGE; end++) {
+    if (config->tickers[end].enabled) enabled++;
+  }
+
+  w.array(4);
+  w.uint(TICKER_FEED_VERSION);
+  w.uint(millis());
+  w.array(enabled);
+
+  for (int i = from; i < end; i++) {
+    if (!config->tickers[i].enabled) continue;
+    const TickerData& t = tickers[i];
+
+    w.array(11);
+    w.uint(i);
+    w.str(t.symbol);
+    w.uint(t.type);
+    w.boolean(t.priceValid);
+    w.float64(priceToDouble(t.currentPrice));
+    w.float32(t.priceChange24h);
+    w.array(TIMEFRAME_COUNT);
+    for (int tf = 0; tf < TIMEFRAME_COUNT; tf++) {
+      w.float32(t.priceChange[tf]);
+    }
+    w.float64(priceToDouble(t.high24h));
+    w.float64(priceToDouble(t.low24h));
+    w.uint(t.lastPriceUpdate);
+
+    w.array(TIMEFRAME_COUNT);
+    for (int tf = 0; tf < TIMEFRAME_COUNT; tf++) {
+      SparklineData sp;
+      if (!readSparkline(i, tf, &sp) || sp.len == 0) {
+        w.nil();
+        continue;
+      }
+      w.array(3);
+      w.float64(priceToDouble(sp.priceMin));
+      w.float64(priceToDouble(sp.priceMax));
+      w.bin(sp.points, sp.len);
+    }
+  }
+
+  if (end < config->numTickers) {
+    w.uint(end);
+  } else {
+    w.nil();
+  }
+
+  return w.size();
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <Arduino.h>
+#include "ticker_types.h"
+
+// Compact binary ticker feed (MessagePack), served at /api/v1/tickers.msgpack
+// and decoded by data/app.js. Positional arrays keep it small:
+//
+//   feed      = [version, uptimeMs, [ticker, ...], nextSlot]
+//   ticker    = [slot, symbol, type, valid, price, change24h,
+//                [chg24H, chg7D, chg30D, chg90D], high24h, low24h,
+//                lastUpdate, [sparkline24H, sparkline7D, sparkline30D, sparkline90D]]
+//   sparkline = nil | [priceMin, priceMax, points (bin, 0..255 per point)]
+//
+// Prices (price, high/low, sparkline min/max) are float64 so every digit of
+// the fixed-point value survives; change% values are float32. Bump
+// TICKER_FEED_VERSION on any layout change.
+//
+// A response carries at most TICKER_FEED_PAGE enabled tickers starting at a
+// slot (?from=); nextSlot is where the next page starts, or nil after the
+// last one. Sparklines outside the display window come from flash, so the
+// page size bounds both the response buffer and the flash reads.
+#define TICKER_FEED_VERSION 3
+
+// Encode one page of enabled tickers, from slot `from` on, straight into
+// `out` (no intermediate document). Returns the number of bytes written.
+size_t writeTickerFeed(Print& out, const AppConfig* config, const TickerData* tickers, int from);
@@ -1,6 +1,7 @@
 #pragma once
 #include <Arduino.h>
 #include "config.h"
+#include "price.h"
 
 enum TickerType : uint8_t {
     TICKER_CRYPTO = 0,
@@ -8,6 +9,18 @@ enum TickerType : uint8_t {
     TICKER_FOREX  = 2
 };
 
+// Display currencies. Every provider call is made in USD; other currencies
+// are converted on the device (see fx_rates.h).
+enum Currency : uint8_t {
+    CURRENCY_USD = 0,
+    CURRENCY_EUR = 1,
+    CURRENCY_GBP = 2,
+    CURRENCY_CHF = 3,
+    CURRENCY_JPY = 4,
+    CURRENCY_COUNT = 5
+};
+#define CURRENCY_DEFAULT 0xFF   // TickerConfig: follow AppConfig::currency
+
 enum ChartTimeframe : uint8_t {
     TIMEFRAME_24H = 0,
     TIMEFRAME_7D  = 1,
@@ -20,8 +33,8 @@ enum ChartTimeframe : uint8_t {
 struct SparklineData {
     uint8_t points[SPARKLINE_POINTS];
     uint8_t len;
-    float priceMin;
-    float priceMax;
+    Price priceMin;
+    Price priceMax;
     bool valid;
 };
 
@@ -30,15 +43,16 @@ struct TickerData {
     char symbol[MAX_SYMBOL_LEN];
     char name[MAX_NAME_LEN];
     TickerType type;
-    float currentPrice;
+    Price currentPrice;
     float priceChange24h;  // percentage (from API)
     float priceChange[TIMEFRAME_COUNT]; // per-timeframe change% (24h,7d,30d,90d)
-    float high24h;
-    float low24h;
+    Price high24h;
+    Price low24h;
     uint32_t lastPriceUpdate;
     bool priceValid;
-
-    SparklineData sparklines[TIMEFRAME_COUNT];
+    Currency currency;     // Of the prices above: USD as fetched, else converted for display
+    // Sparklines are kept apart (sparkline_store.h) so large watchlists only
+    // hold the ones about to be shown in RAM
 };
 
 // Configuration for one ticker slot (stored in config.json)
@@ -48,27 +62,54 @@ struct TickerConfig {
     TickerType type;
     float timeMultiplier;         // Display time multiplier (default 1.0)
     bool enabled;
+    uint8_t currency;             // Currency, or CURRENCY_DEFAULT
+};
+
+// Ticker slots of the configuration. Published apart from AppConfig (see
+// config_store.h) so settings snapshots don't each carry MAX_TICKERS slots.
+struct Watchlist {
+    uint8_t numTickers;
+    TickerConfig tickers[MAX_TICKERS];
+    uint32_t version;             // Watchlist version, stamped by configPublish()
 };
 
 // Full application configuration (stored in LittleFS)
 struct AppConfig {
     uint8_t brightness;
     uint32_t baseTimeMs;          // Base display time per timeframe
-    uint8_t numTickers;
-    TickerConfig tickers[MAX_TICKERS];
+    uint8_t numTickers;           // Of the snapshot's watchlist
+    const TickerConfig* tickers;  // Published watchlist, set by configPublish()
     char twelveDataApiKey[64];
     char coinGeckoApiKey[64];     // Optional demo key
     char cmcApiKey[64];           // CoinMarketCap API key
+    bool lanRelay;                // Share one device's fetches over UDP multicast
+    bool lowPower;                // Scale CPU clock and use modem sleep between fetches
+    bool marketStream;            // Live crypto prices from the exchange WebSocket
+    bool staleMarker;             // Draw stale prices in amber (see data_age.h)
+    Currency currency;            // Display currency (stock/crypto; forex keeps its quote)
+    char timezone[48];            // POSIX TZ string for quiet hours
+    uint8_t quietStartHour;       // Local hour the panel blanks (== end: no quiet hours)
+    uint8_t quietEndHour;         // Local hour the panel comes back
+    uint32_t version;             // Snapshot version, stamped by configPublish()
 };
 
-// Get default config
+// Get default config (its watchlist comes from getDefaultWatchlist())
 inline AppConfig getDefaultConfig() {
     AppConfig cfg = {};
     cfg.brightness = DEFAULT_BRIGHTNESS;
     cfg.baseTimeMs = DEFAULT_BASE_TIME_MS;
+    cfg.lowPower = true;
+    cfg.marketStream = true;
+    cfg.staleMarker = true;
+    strncpy(cfg.timezone, DEFAULT_TIMEZONE, sizeof(cfg.timezone) - 1);
+    return cfg;
+}
+
+// Default tickers
+#define DEFAULT_TICKER_COUNT 11
 
-    // Default tickers
-    struct { const char* sym; const char* apiId; TickerType type; } defaults[] = {
+inline TickerConfig getDefaultTicker(int idx) {
+    static const struct { const char* sym; const char* apiId; TickerType type; } defaults[DEFAULT_TICKER_COUNT] = {
         {"BTC",   "bitcoin",    TICKER_CRYPTO},
         {"ETH",   "ethereum",   TICKER_CRYPTO},
         {"SOL",   "solana",     TICKER_CRYPTO},
@@ -82,17 +123,22 @@ inline AppConfig getDefaultConfig() {
         {"EUR",   "EUR/USD",    TICKER_FOREX},
     };
 
-    cfg.numTickers = 11;
+    TickerConfig t = {};
+    strncpy(t.symbol, defaults[idx].sym, MAX_SYMBOL_LEN - 1);
+    strncpy(t.apiId, defaults[idx].apiId, MAX_API_ID_LEN - 1);
+    t.type = defaults[idx].type;
+    t.timeMultiplier = 1.0f;
+    t.enabled = true;
+    t.currency = CURRENCY_DEFAULT;
+    return t;
+}
 
-    for (int i = 0; i < cfg.numTickers; i++) {
-        strncpy(cfg.tickers[i].symbol, defaults[i].sym, MAX_SYMBOL_LEN - 1);
-        strncpy(cfg.tickers[i].apiId, defaults[i].apiId, MAX_API_ID_LEN - 1);
-        cfg.tickers[i].type = defaults[i].type;
-        cfg.tickers[i].timeMultiplier = 1.0f;
-        cfg.tickers[i].enabled = true;
+// Fill a watchlist with the default tickers
+inline void getDefaultWatchlist(Watchlist* list) {
+    list->numTickers = DEFAULT_TICKER_COUNT;
+    for (int i = 0; i < DEFAULT_TICKER_COUNT; i++) {
+        list->tickers[i] = getDefaultTicker(i);
     }
-
-    return cfg;
 }
 
 // Timeframe label strings
@@ -106,6 +152,34 @@ inline const char* getTimeframeLabel(ChartTimeframe tf) {
     }
 }
 
+// ISO 4217 code of a currency
+inline const char* getCurrencyCode(Currency c) {
+    switch (c) {
+        case CURRENCY_USD: return "USD";
+        case CURRENCY_EUR: return "EUR";
+        case CURRENCY_GBP: return "GBP";
+        case CURRENCY_CHF: return "CHF";
+        case CURRENCY_JPY: return "JPY";
+        default: return "?";
+    }
+}
+
+// Currency for a code ("EUR"); fallback for unknown or empty codes
+inline uint8_t parseCurrency(const char* code, uint8_t fallback) {
+    for (int c = 0; c < CURRENCY_COUNT; c++) {
+        if (code && strcmp(code, getCurrencyCode((Currency)c)) == 0) return c;
+    }
+    return fallback;
+}
+
+// Currency a ticker slot is shown in. Forex pairs are rates already and stay
+// in their quote currency unless the slot overrides it.
+inline Currency getTickerCurrency(const AppConfig* config, int idx) {
+    const TickerConfig& t = config->tickers[idx];
+    if (t.currency < CURRENCY_COUNT) return (Currency)t.currency;
+    return t.type == TICKER_FOREX ? CURRENCY_USD : config->currency;
+}
+
 // CoinGecko days parameter for each timeframe
 inline int getTimeframeDays(ChartTimeframe tf) {
     switch (tf) {
@@ -0,0 +1,235 @@
+#include "trace.h"
+
+#if TRACE_ENABLED
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+
+static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0, "TRACE_RING_SIZE must be a power of two");
+
+struct TraceEvent {
+  uint32_t tsUs;
+  const char* name;
+  TaskHandle_t task;
+  int32_t value;
+  char phase;
+};
+
+// seq is the event's index + 1 once it is fully written, 0 while a writer
+// is filling the slot, so a reader can tell a torn or recycled slot
+struct TraceSlot {
+  std::atomic<uint32_t> seq;
+  TraceEvent event;
+};
+
+// Cycle counters are per core and wrap every ~18s at 240MHz, so each core
+// converts to microseconds against its own anchor, refreshed well before
+// the counter could wrap past it.
+struct TraceClock {
+  uint32_t cycles;
+  uint32_t us;
+  uint32_t mhz;    // 0 forces a re-anchor
+};
+
+#define TRACE_REANCHOR_CYCLES 0x40000000u
+
+static TraceSlot rings[2][TRACE_RING_SIZE];
+static std::atomic<uint32_t> heads[2];
+static std::atomic<uint32_t> floors[2];   // First index the next export may show (clear)
+static TraceClock clocks[2];
+static portMUX_TYPE clockMux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t traceNowUs(int core) {
+  uint32_t now = ESP.getCycleCount();
+  TraceClock& c = clocks[core];
+  uint32_t delta = now - c.cycles;
+  if (c.mhz == 0 || delta >= TRACE_REANCHOR_CYCLES) {
+    portENTER_CRITICAL(&clockMux);
+    c.cycles = now;
+    c.us = micros();
+    c.mhz = ESP.getCpuFreqMHz();
+    portEXIT_CRITICAL(&clockMux);
+    return c.us;
+  }
+  return c.us + delta / c.mhz;
+}
+
+void traceRecord(const char* name, char phase, int32_t value) {
+  int core = xPortGetCoreID() & 1;
+  uint32_t ts = traceNowUs(core);
+  uint32_t idx = heads[core]++;
+  TraceSlot& slot = rings[core][idx & (TRACE_RING_SIZE - 1)];
+  slot.seq.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.event.tsUs = ts;
+  slot.event.name = name;
+  slot.event.task = xTaskGetCurrentTaskHandle();
+  slot.event.value = value;
+  slot.event.phase = phase;
+  slot.seq.store(idx + 1, std::memory_order_release);
+}
+
+void traceClockChanged() {
+  clocks[0].mhz = 0;
+  clocks[1].mhz = 0;
+}
+
+// Copy event idx of a core; false if its slot is being written or has been
+// reused since
+static bool readEvent(int core, uint32_t idx, TraceEvent* out) {
+  const TraceSlot& slot = rings[core][idx & (TRACE_RING_SIZE - 1)];
+  if (slot.seq.load(std::memory_order_acquire) != idx + 1) return false;
+  *out = slot.event;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot.seq.load(std::memory_order_relaxed) == idx + 1;
+}
+
+enum TraceExportStage : uint8_t {
+  EXPORT_HEADER,
+  EXPORT_PROCESS,     // Per core: process name, events, thread names
+  EXPORT_EVENTS,
+  EXPORT_THREADS,
+  EXPORT_FOOTER,
+  EXPORT_DONE
+};
+
+struct TraceExport {
+  TraceExportStage stage;
+  uint8_t core;
+  bool clear;
+  uint32_t next;      // EXPORT_EVENTS: index of the next event
+  uint32_t end;       // Head when the core's events started
+  int thread;         // EXPORT_THREADS: next task to name
+  char line[192];     // Rendered piece not yet fully copied out
+  uint16_t lineLen;
+  uint16_t lineOff;
+  // Chrome wants integer thread ids: tasks get 1.. in order of appearance
+  TaskHandle_t tasks[TRACE_MAX_TASKS];
+  int taskCount;
+};
+
+static int taskId(TraceExport* x, TaskHandle_t task) {
+  for (int i = 0; i < x->taskCount; i++) {
+    if (x->tasks[i] == task) return i + 1;
+  }
+  if (x->taskCount >= TRACE_MAX_TASKS) return 0;
+  x->tasks[x->taskCount++] = task;
+  return x->taskCount;
+}
+
+TraceExport* traceExportBegin(bool clear) {
+  TraceExport* x = (TraceExport*)calloc(1, sizeof(TraceExport));
+  if (x) x->clear = clear;
+  return x;
+}
+
+void traceExportEnd(TraceExport* x) {
+  free(x);
+}
+
+// The next piece of JSON at the cursor (without advancing it); 0 when the
+// current stage has nothing more
+static int renderNext(TraceExport* x, char* line, size_t size) {
+  int core = x->core;
+  switch (x->stage) {
+    case EXPORT_HEADER:
+      return snprintf(line, size, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    case EXPORT_PROCESS:
+      return snprintf(line, size, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"core %d\"}}",
+                      core == 0 ? "" : ",", core, core);
+    case EXPORT_EVENTS:
+      while (x->next != x->end) {
+        TraceEvent e;
+        if (!readEvent(core, x->next, &e)) {
+          x->next++;
+          continue;
+        }
+        int tid = taskId(x, e.task);
+        if (e.phase == 'C') {
+          return snprintf(line, size, ",{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%lu,\"pid\":%d,\"args\":{\"value\":%ld}}",
+                          e.name, (unsigned long)e.tsUs, core, (long)e.value);
+        }
+        return snprintf(line, size, ",{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lu,\"pid\":%d,\"tid\":%d}",
+                        e.name, e.phase, (unsigned long)e.tsUs, core, tid);
+      }
+      return 0;
+    case EXPORT_THREADS:
+      // Thread names for every task seen so far
+      if (x->thread >= x->taskCount) return 0;
+      return snprintf(line, size, ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                      core, x->thread + 1, pcTaskGetTaskName(x->tasks[x->thread]));
+    case EXPORT_FOOTER:
+      return snprintf(line, size, "]}");
+    default:
+      return 0;
+  }
+}
+
+// Step the cursor past what renderNext() produced, or to the next stage
+static void advance(TraceExport* x, bool rendered) {
+  switch (x->stage) {
+    case EXPORT_HEADER:
+      x->stage = EXPORT_PROCESS;
+      break;
+    case EXPORT_PROCESS: {
+      uint32_t end = heads[x->core];
+      uint32_t floor = floors[x->core];
+      uint32_t start = end > TRACE_RING_SIZE ? end - TRACE_RING_SIZE : 0;
+      x->next = (int32_t)(floor - start) > 0 && (int32_t)(end - floor) >= 0 ? floor : start;
+      x->end = end;
+      x->stage = EXPORT_EVENTS;
+      break;
+    }
+    case EXPORT_EVENTS:
+      if (rendered) {
+        x->next++;
+      } else {
+        if (x->clear) floors[x->core] = x->end;
+        x->thread = 0;
+        x->stage = EXPORT_THREADS;
+      }
+      break;
+    case EXPORT_THREADS:
+      if (rendered) {
+        x->thread++;
+      } else if (x->core == 0) {
+        x->core = 1;
+        x->stage = EXPORT_PROCESS;
+      } else {
+        x->stage = EXPORT_FOOTER;
+      }
+      break;
+    case EXPORT_FOOTER:
+      x->stage = EXPORT_DONE;
+      break;
+    default:
+      break;
+  }
+}
+
+size_t traceExportFill(TraceExport* x, uint8_t* buf, size_t len) {
+  size_t used = 0;
+  while (used < len) {
+    if (x->lineOff < x->lineLen) {
+      size_t n = min(len - used, (size_t)(x->lineLen - x->lineOff));
+      memcpy(buf + used, x->line + x->lineOff, n);
+      x->lineOff += n;
+      used += n;
+      continue;
+    }
+    if (x->stage == EXPORT_DONE) break;
+    int n = renderNext(x, x->line, sizeof(x->line));
+    if (n >= (int)sizeof(x->line)) {
+      // Name too long to export: drop the event
+      x->next++;
+      continue;
+    }
+    x->lineLen = n > 0 ? n : 0;
+    x->lineOff = 0;
+    advance(x, n > 0);
+  }
+  return used;
+}
+
+#endif
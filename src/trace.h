@@ -0,0 +1,62 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// Task timeline tracer.
+// Spans and counters are stamped from the CPU cycle counter into a ring per
+// core and exported as Chrome trace-event JSON (GET /api/trace; open in
+// chrome://tracing or ui.perfetto.dev). Names must be string literals: only
+// the pointer is stored.
+//
+//   TRACE_SCOPE("updateData");              // span until end of block
+//   TRACE_BEGIN("tls"); ... TRACE_END("tls");
+//   TRACE_COUNTER("heap.largest", ESP.getMaxAllocHeap());
+//
+// With TRACE_ENABLED 0 every macro expands to nothing.
+
+#if TRACE_ENABLED
+
+// Record one event ('B' begin, 'E' end, 'C' counter)
+void traceRecord(const char* name, char phase, int32_t value);
+
+// Re-anchor the cycle-counter clock after a CPU frequency change
+void traceClockChanged();
+
+// Chunked export of the retained events as trace-event JSON, for a
+// response filler: each traceExportFill() writes the next whole events that
+// fit and returns the byte count, 0 once the JSON is complete. Recording
+// carries on meanwhile; events overwritten (or still being written) by the
+// time the cursor reaches them are left out. With clear, the next export
+// starts after the last event this one reached.
+struct TraceExport;
+
+// nullptr when the heap cannot hold the cursor
+TraceExport* traceExportBegin(bool clear);
+size_t traceExportFill(TraceExport* x, uint8_t* buf, size_t len);
+void traceExportEnd(TraceExport* x);
+
+class TraceScope {
+public:
+  explicit TraceScope(const char* name) : name(name) { traceRecord(name, 'B', 0); }
+  ~TraceScope() { traceRecord(name, 'E', 0); }
+private:
+  const char* name;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define TRACE_BEGIN(name) traceRecord((name), 'B', 0)
+#define TRACE_END(name) traceRecord((name), 'E', 0)
+#define TRACE_COUNTER(name, value) traceRecord((name), 'C', (int32_t)(value))
+#define TRACE_CLOCK_CHANGED() traceClockChanged()
+
+#else
+
+#define TRACE_SCOPE(name) do {} while (0)
+#define TRACE_BEGIN(name) do {} while (0)
+#define TRACE_END(name) do {} while (0)
+#define TRACE_COUNTER(name, value) do {} while (0)
+#define TRACE_CLOCK_CHANGED() do {} while (0)
+
+#endif
@@ -1,16 +1,137 @@
 #include "web_server.h"
 #include "wifi_manager.h"
+#include "provider_health.h"
+#include "fetch_engine.h"
+#include "lan_relay.h"
+#include "ticker_feed.h"
+#include "event_log.h"
+#include "trace.h"
+#include "app_clock.h"
+#include "simulator.h"
+#include "frame_capture.h"
+#include "display_renderer.h"
+#include "power_manager.h"
+#include "market_calendar.h"
+#include "ota_update.h"
+#include "config_store.h"
+#include "sparkline_store.h"
+#include "alert_engine.h"
+#include "market_stream.h"
+#include "data_age.h"
+#include "frame_mirror.h"
+#include "fetch_events.h"
+#include "fx_rates.h"
 #include <ESPAsyncWebServer.h>
 #include <LittleFS.h>
 #include <ArduinoJson.h>
-#include <Update.h>
+#include <memory>
 
 static AsyncWebServer server(80);
-static AppConfig* g_config = nullptr;
+static AsyncWebSocket mirrorSocket("/ws/mirror");
+static uint32_t mirrorViewerIds[MIRROR_MAX_VIEWERS];   // Accepted clients, 0 = free
 static TickerData* g_tickerData = nullptr;
-static void (*g_onConfigChanged)() = nullptr;
 
-void saveConfig(AppConfig* config) {
+// JSON POST body (/api/config, /api/alerts), preallocated; one upload at a time
+static char jsonBody[CONFIG_BODY_MAX];
+static AsyncWebServerRequest* jsonBodyOwner = nullptr;
+
+// Copy one chunk of a JSON body into jsonBody. True once the whole body is
+// in; errors (too large, buffer busy) are answered here.
+static bool collectJsonBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    if (index == 0) {
+        if (total > CONFIG_BODY_MAX) {
+            request->send(413, "application/json", "{\"error\":\"Body too large\"}");
+            return false;
+        }
+        if (jsonBodyOwner) {
+            request->send(409, "application/json", "{\"error\":\"Another upload is in progress\"}");
+            return false;
+        }
+        jsonBodyOwner = request;
+        // A client that drops mid-body must not keep the buffer
+        request->onDisconnect([request]() {
+            if (jsonBodyOwner == request) jsonBodyOwner = nullptr;
+        });
+    }
+    if (jsonBodyOwner != request) {
+        return false;
+    }
+
+    memcpy(jsonBody + index, data, len);
+    if (index + len < total) {
+        return false;
+    }
+    jsonBodyOwner = nullptr;
+    return true;
+}
+
+// Request handler for the JSON POSTs: the body handler replies once the body
+// is in, so only a request that carried no body is answered here
+static void rejectEmptyJsonBody(AsyncWebServerRequest *request) {
+    if (request->contentLength() == 0) {
+        request->send(400, "application/json", "{\"error\":\"Empty body\"}");
+    }
+}
+
+// Exact decimal text as a JSON number (a double would round sub-cent prices)
+static void setPrice(JsonVariant dst, Price price) {
+    char text[PRICE_TEXT_LEN];
+    formatPriceDecimal(price, text);
+    dst.set(serialized(String(text)));
+}
+
+// OTA session state; "received" tells a client where to resume
+static void sendOtaStatus(AsyncWebServerRequest *request, int code) {
+    OtaStatus ota = getOtaStatus();
+    JsonDocument doc;
+    doc["state"] = getOtaStateName(ota.state);
+    doc["target"] = getOtaTargetName(ota.target);
+    doc["compressed"] = ota.compressed;
+    doc["size"] = ota.uploadSize;
+    doc["received"] = ota.received;
+    doc["written"] = ota.written;
+    doc["resumes"] = ota.resumes;
+    doc["elapsedMs"] = ota.elapsedMs;
+    if (ota.error[0]) doc["error"] = ota.error;
+
+    String response;
+    serializeJson(doc, response);
+    request->send(code, "application/json", response);
+}
+
+static uint32_t uintParam(AsyncWebServerRequest *request, const char* name) {
+    return request->hasParam(name) ? (uint32_t)request->getParam(name)->value().toInt() : 0;
+}
+
+static OtaTarget otaTargetParam(AsyncWebServerRequest *request) {
+    return request->hasParam("target") && request->getParam("target")->value() == "filesystem"
+        ? OTA_FILESYSTEM : OTA_FIRMWARE;
+}
+
+// Track accepted /ws/mirror clients (async_tcp task only). Returns false
+// when all viewer slots are taken.
+static bool updateMirrorViewer(uint32_t id, bool connected) {
+    int count = 0;
+    bool found = false;
+    for (int i = 0; i < MIRROR_MAX_VIEWERS; i++) {
+        if (!found && mirrorViewerIds[i] == (connected ? 0 : id)) {
+            mirrorViewerIds[i] = connected ? id : 0;
+            found = true;
+        }
+        if (mirrorViewerIds[i]) count++;
+    }
+    setMirrorViewers(count);
+    return found;
+}
+
+// Mirror frames go to every /ws/mirror client (frame_mirror worker task)
+static bool sendMirrorFrame(const uint8_t* frame, size_t len) {
+    if (!mirrorSocket.availableForWriteAll()) return false;
+    mirrorSocket.binaryAll(frame, len);
+    return true;
+}
+
+void saveConfig(const AppConfig* config) {
     JsonDocument doc;
     doc["brightness"] = config->brightness;
     doc["baseTimeMs"] = config->baseTimeMs;
@@ -18,6 +139,14 @@ void saveConfig(AppConfig* config) {
     doc["twelveDataApiKey"] = config->twelveDataApiKey;
     doc["coinGeckoApiKey"] = config->coinGeckoApiKey;
     doc["cmcApiKey"] = config->cmcApiKey;
+    doc["lanRelay"] = config->lanRelay;
+    doc["lowPower"] = config->lowPower;
+    doc["marketStream"] = config->marketStream;
+    doc["staleMarker"] = config->staleMarker;
+    doc["currency"] = getCurrencyCode(config->currency);
+    doc["timezone"] = config->timezone;
+    doc["quietStartHour"] = config->quietStartHour;
+    doc["quietEndHour"] = config->quietEndHour;
 
     JsonArray tickers = doc["tickers"].to<JsonArray>();
     for (int i = 0; i < config->numTickers; i++) {
@@ -27,6 +156,9 @@ void saveConfig(AppConfig* config) {
         t["type"] = (int)config->tickers[i].type;
         t["timeMultiplier"] = config->tickers[i].timeMultiplier;
         t["enabled"] = config->tickers[i].enabled;
+        if (config->tickers[i].currency < CURRENCY_COUNT) {
+            t["currency"] = getCurrencyCode((Currency)config->tickers[i].currency);
+        }
     }
 
     File f = LittleFS.open("/config.json", "w");
@@ -39,10 +171,8 @@ void saveConfig(AppConfig* config) {
     }
 }
 
-void initWebServer(AppConfig* config, TickerData* tickerData, void (*onConfigChanged)()) {
-    g_config = config;
+void initWebServer(TickerData* tickerData) {
     g_tickerData = tickerData;
-    g_onConfigChanged = onConfigChanged;
 
     // Serve static files from LittleFS
     server.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
@@ -59,22 +189,35 @@ void initWebServer(AppConfig* config, TickerData* tickerData, void (*onConfigCha
 
     // API endpoint: Get current config
     server.on("/api/config", HTTP_GET, [](AsyncWebServerRequest *request) {
+        TRACE_SCOPE("web.getConfig");
+        const AppConfig* config = configCurrent();
         JsonDocument doc;
-        doc["brightness"] = g_config->brightness;
-        doc["baseTimeMs"] = g_config->baseTimeMs;
-        doc["numTickers"] = g_config->numTickers;
-        doc["twelveDataApiKey"] = g_config->twelveDataApiKey;
-        doc["coinGeckoApiKey"] = g_config->coinGeckoApiKey;
-        doc["cmcApiKey"] = g_config->cmcApiKey;
+        doc["brightness"] = config->brightness;
+        doc["baseTimeMs"] = config->baseTimeMs;
+        doc["numTickers"] = config->numTickers;
+        doc["twelveDataApiKey"] = config->twelveDataApiKey;
+        doc["coinGeckoApiKey"] = config->coinGeckoApiKey;
+        doc["cmcApiKey"] = config->cmcApiKey;
+        doc["lanRelay"] = config->lanRelay;
+        doc["lowPower"] = config->lowPower;
+        doc["marketStream"] = config->marketStream;
+        doc["staleMarker"] = config->staleMarker;
+        doc["currency"] = getCurrencyCode(config->currency);
+        doc["timezone"] = config->timezone;
+        doc["quietStartHour"] = config->quietStartHour;
+        doc["quietEndHour"] = config->quietEndHour;
 
         JsonArray tickers = doc["tickers"].to<JsonArray>();
-        for (int i = 0; i < g_config->numTickers; i++) {
+        for (int i = 0; i < config->numTickers; i++) {
             JsonObject t = tickers.add<JsonObject>();
-            t["symbol"] = g_config->tickers[i].symbol;
-            t["apiId"] = g_config->tickers[i].apiId;
-            t["type"] = (int)g_config->tickers[i].type;
-            t["timeMultiplier"] = g_config->tickers[i].timeMultiplier;
-            t["enabled"] = g_config->tickers[i].enabled;
+            t["symbol"] = config->tickers[i].symbol;
+            t["apiId"] = config->tickers[i].apiId;
+            t["type"] = (int)config->tickers[i].type;
+            t["timeMultiplier"] = config->tickers[i].timeMultiplier;
+            t["enabled"] = config->tickers[i].enabled;
+            if (config->tickers[i].currency < CURRENCY_COUNT) {
+                t["currency"] = getCurrencyCode((Currency)config->tickers[i].currency);
+            }
         }
 
         String response;
@@ -83,88 +226,393 @@ void initWebServer(AppConfig* config, TickerData* tickerData, void (*onConfigCha
     });
 
     // API endpoint: Update config
-    server.on("/api/config", HTTP_POST, [](AsyncWebServerRequest *request) {}, NULL,
+    server.on("/api/config", HTTP_POST, rejectEmptyJsonBody, NULL,
         [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-            static String body;
-
-            if (index == 0) {
-                body = "";
-            }
+            TRACE_SCOPE("web.postConfig");
 
-            for (size_t i = 0; i < len; i++) {
-                body += (char)data[i];
-            }
-
-            if (index + len == total) {
+            if (collectJsonBody(request, data, len, index, total)) {
                 JsonDocument doc;
-                DeserializationError error = deserializeJson(doc, body);
+                DeserializationError error = deserializeJson(doc, (const char*)jsonBody, total);
 
                 if (error) {
                     request->send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
                     return;
                 }
 
-                // Update config
+                // Build the complete new config beside the live one
+                AppConfig next = *configCurrent();
                 if (!doc["brightness"].isNull()) {
-                    g_config->brightness = doc["brightness"];
+                    next.brightness = doc["brightness"];
                 }
                 if (!doc["baseTimeMs"].isNull()) {
-                    g_config->baseTimeMs = doc["baseTimeMs"];
+                    next.baseTimeMs = doc["baseTimeMs"];
                 }
                 if (!doc["twelveDataApiKey"].isNull()) {
-                    strlcpy(g_config->twelveDataApiKey, doc["twelveDataApiKey"] | "", sizeof(g_config->twelveDataApiKey));
+                    strlcpy(next.twelveDataApiKey, doc["twelveDataApiKey"] | "", sizeof(next.twelveDataApiKey));
                 }
                 if (!doc["coinGeckoApiKey"].isNull()) {
-                    strlcpy(g_config->coinGeckoApiKey, doc["coinGeckoApiKey"] | "", sizeof(g_config->coinGeckoApiKey));
+                    strlcpy(next.coinGeckoApiKey, doc["coinGeckoApiKey"] | "", sizeof(next.coinGeckoApiKey));
                 }
                 if (!doc["cmcApiKey"].isNull()) {
-                    strlcpy(g_config->cmcApiKey, doc["cmcApiKey"] | "", sizeof(g_config->cmcApiKey));
+                    strlcpy(next.cmcApiKey, doc["cmcApiKey"] | "", sizeof(next.cmcApiKey));
+                }
+                if (!doc["lanRelay"].isNull()) {
+                    next.lanRelay = doc["lanRelay"];
+                }
+                if (!doc["lowPower"].isNull()) {
+                    next.lowPower = doc["lowPower"];
+                }
+                if (!doc["marketStream"].isNull()) {
+                    next.marketStream = doc["marketStream"];
+                }
+                if (!doc["staleMarker"].isNull()) {
+                    next.staleMarker = doc["staleMarker"];
+                }
+                if (!doc["currency"].isNull()) {
+                    next.currency = (Currency)parseCurrency(doc["currency"] | "", next.currency);
+                }
+                if (!doc["timezone"].isNull()) {
+                    strlcpy(next.timezone, doc["timezone"] | DEFAULT_TIMEZONE, sizeof(next.timezone));
+                }
+                if (!doc["quietStartHour"].isNull()) {
+                    next.quietStartHour = constrain(doc["quietStartHour"].as<int>(), 0, 23);
+                }
+                if (!doc["quietEndHour"].isNull()) {
+                    next.quietEndHour = constrain(doc["quietEndHour"].as<int>(), 0, 23);
                 }
 
+                // Ticker slots are filled straight into the spare watchlist
+                Watchlist* list = nullptr;
                 if (!doc["tickers"].isNull()) {
+                    list = configWatchlistBegin();
+                    if (!list) {
+                        request->send(503, "application/json", "{\"error\":\"Previous watchlist still in use, retry\"}");
+                        return;
+                    }
                     JsonArray tickers = doc["tickers"];
-                    g_config->numTickers = min((int)tickers.size(), MAX_TICKERS);
+                    list->numTickers = min((int)tickers.size(), MAX_TICKERS);
 
-                    for (int i = 0; i < g_config->numTickers; i++) {
+                    for (int i = 0; i < list->numTickers; i++) {
                         JsonObject t = tickers[i];
-                        strlcpy(g_config->tickers[i].symbol, t["symbol"] | "", sizeof(g_config->tickers[i].symbol));
-                        strlcpy(g_config->tickers[i].apiId, t["apiId"] | "", sizeof(g_config->tickers[i].apiId));
-                        g_config->tickers[i].type = (TickerType)(t["type"] | 0);
-                        g_config->tickers[i].timeMultiplier = t["timeMultiplier"] | 1;
-                        g_config->tickers[i].enabled = t["enabled"] | true;
+                        strlcpy(list->tickers[i].symbol, t["symbol"] | "", sizeof(list->tickers[i].symbol));
+                        strlcpy(list->tickers[i].apiId, t["apiId"] | "", sizeof(list->tickers[i].apiId));
+                        list->tickers[i].type = (TickerType)(t["type"] | 0);
+                        list->tickers[i].timeMultiplier = t["timeMultiplier"] | 1;
+                        list->tickers[i].enabled = t["enabled"] | true;
+                        list->tickers[i].currency = parseCurrency(t["currency"] | "", CURRENCY_DEFAULT);
                     }
                 }
 
-                // Save to LittleFS
-                saveConfig(g_config);
-
-                // Trigger callback
-                if (g_onConfigChanged) {
-                    g_onConfigChanged();
+                // Readers pick it up at their next safe point
+                if (!configPublish(next, list)) {
+                    request->send(503, "application/json", "{\"error\":\"Previous config still in use, retry\"}");
+                    return;
                 }
+                saveConfig(configCurrent());
 
                 request->send(200, "application/json", "{\"status\":\"ok\"}");
             }
         }
     );
 
+    // API endpoint: Alert rules, engine stats and recently fired alerts
+    server.on("/api/alerts", HTTP_GET, [](AsyncWebServerRequest *request) {
+        TRACE_SCOPE("web.alerts");
+        JsonDocument doc;
+
+        AlertRule rules[ALERT_MAX_RULES];
+        int numRules = getAlertRules(rules, ALERT_MAX_RULES);
+        JsonArray rulesArr = doc["rules"].to<JsonArray>();
+        for (int i = 0; i < numRules; i++) {
+            alertRuleToJson(rules[i], rulesArr.add<JsonObject>());
+        }
+
+        AlertStats stats = getAlertStats();
+        JsonObject s = doc["stats"].to<JsonObject>();
+        s["rules"] = stats.rules;
+        s["fired"] = stats.fired;
+        s["shown"] = stats.shown;
+        s["dropped"] = stats.dropped;
+        s["lastLatencyMs"] = stats.lastLatencyMs;
+        s["avgLatencyMs"] = stats.avgLatencyMs;
+        s["maxLatencyMs"] = stats.maxLatencyMs;
+
+        AlertEvent recent[ALERT_RECENT];
+        int numRecent = getRecentAlerts(recent, ALERT_RECENT);
+        uint32_t now = appMillis();
+        JsonArray recentArr = doc["recent"].to<JsonArray>();
+        for (int i = 0; i < numRecent; i++) {
+            JsonObject a = recentArr.add<JsonObject>();
+            a["symbol"] = recent[i].symbol;
+            a["kind"] = getAlertKindName(recent[i].kind);
+            a["detail"] = recent[i].detail;
+            a["up"] = recent[i].up;
+            setPrice(a["price"], recent[i].price);
+            a["ageS"] = (now - recent[i].firedAt) / 1000;
+            if (recent[i].shownAt) {
+                a["latencyMs"] = recent[i].shownAt - recent[i].receivedAt;
+            }
+        }
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API endpoint: Replace the alert rules ({"rules":[...]}, see alert_engine.h)
+    server.on("/api/alerts", HTTP_POST, rejectEmptyJsonBody, NULL,
+        [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+            TRACE_SCOPE("web.postAlerts");
+            if (!collectJsonBody(request, data, len, index, total)) return;
+
+            JsonDocument doc;
+            if (deserializeJson(doc, (const char*)jsonBody, total)) {
+                request->send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+                return;
+            }
+            JsonArray rulesArr = doc["rules"];
+            if (rulesArr.size() > ALERT_MAX_RULES) {
+                request->send(400, "application/json", "{\"error\":\"Too many rules\"}");
+                return;
+            }
+
+            AlertRule rules[ALERT_MAX_RULES];
+            int count = 0;
+            for (JsonObjectConst r : rulesArr) {
+                if (!alertRuleFromJson(r, &rules[count])) {
+                    request->send(400, "application/json", "{\"error\":\"Invalid rule\"}");
+                    return;
+                }
+                count++;
+            }
+            setAlertRules(rules, count);
+            request->send(200, "application/json", "{\"status\":\"ok\"}");
+        }
+    );
+
     // API endpoint: Get system status
     server.on("/api/status", HTTP_GET, [](AsyncWebServerRequest *request) {
+        TRACE_SCOPE("web.status");
         JsonDocument doc;
         doc["freeHeap"] = ESP.getFreeHeap();
+        doc["minFreeHeap"] = ESP.getMinFreeHeap();
+        doc["largestFreeBlock"] = ESP.getMaxAllocHeap();
+        doc["largestFreeBlockLow"] = getLargestBlockLowWater();
         doc["uptime"] = millis() / 1000;
         doc["wifiSSID"] = getSSID();
         doc["wifiIP"] = getIPAddress();
         doc["wifiRSSI"] = getRSSI();
         doc["firmwareVersion"] = FIRMWARE_VERSION;
 
+        // Per-provider circuit breaker state
+        JsonArray providers = doc["providers"].to<JsonArray>();
+        uint32_t now = appMillis();
+        for (int p = 0; p < PROVIDER_COUNT; p++) {
+            ProviderHealth h = getProviderHealth((ApiProvider)p);
+            JsonObject o = providers.add<JsonObject>();
+            o["name"] = getProviderName((ApiProvider)p);
+            o["circuit"] = getCircuitStateName(h.state);
+            o["consecutiveFailures"] = h.consecutiveFailures;
+            o["lastHttpStatus"] = h.lastHttpStatus;
+            o["retryInMs"] = (h.state == CIRCUIT_OPEN && (int32_t)(h.openUntil - now) > 0) ? h.openUntil - now : 0;
+            o["requests"] = h.totalRequests;
+            o["failures"] = h.totalFailures;
+            o["rejected"] = h.totalRejected;
+
+            FetchArenaStats arena = getFetchArenaStats((ApiProvider)p);
+            o["arenaSize"] = arena.capacity;
+            o["arenaPeak"] = arena.highWater;
+            o["arenaOverflows"] = arena.overflows;
+        }
+
+        // Bytes off the wire vs JSON parsed, and fetch time, per endpoint
+        JsonArray endpoints = doc["endpoints"].to<JsonArray>();
+        for (int e = 0; e < ENDPOINT_COUNT; e++) {
+            EndpointStats st = getEndpointStats((ApiEndpoint)e);
+            JsonObject o = endpoints.add<JsonObject>();
+            o["name"] = getEndpointName((ApiEndpoint)e);
+            o["responses"] = st.responses;
+            o["gzipped"] = st.gzipped;
+            o["wireBytes"] = st.wireBytes;
+            o["bodyBytes"] = st.bodyBytes;
+            o["avgMs"] = st.responses ? (uint32_t)(st.totalMs / st.responses) : 0;
+            o["lastWireBytes"] = st.lastWireBytes;
+            o["lastBodyBytes"] = st.lastBodyBytes;
+            o["lastMs"] = st.lastMs;
+        }
+
+        LogStats logStats = getLogStats();
+        JsonObject log = doc["log"].to<JsonObject>();
+        log["events"] = logStats.recorded;
+        log["suppressed"] = logStats.suppressed;
+        log["overwritten"] = logStats.overwritten;
+        log["recordUs"] = logStats.avgRecordUs100 / 100.0f;
+        log["maxRecordUs"] = logStats.maxRecordUs100 / 100.0f;
+
+        DisplayQuality display = getDisplayQuality();
+        JsonObject d = doc["display"].to<JsonObject>();
+        d["width"] = display.width;
+        d["height"] = display.height;
+        d["chain"] = display.chain;
+        d["colorDepth"] = display.colorDepth;
+        d["doubleBuffered"] = display.doubleBuffered;
+        d["refreshHz"] = display.refreshHz;
+        d["dmaBytes"] = display.dmaBytes;
+        d["dmaBudget"] = display.dmaBudget;
+        d["on"] = display.panelOn;
+        d["minRefreshHz"] = display.minRefreshHz;
+        d["ditherFps"] = display.ditherFps;
+        d["gamma"] = display.gamma;
+        JsonArray dProbes = d["probes"].to<JsonArray>();
+        for (int i = 0; i < display.probeCount; i++) {
+            JsonObject o = dProbes.add<JsonObject>();
+            o["depth"] = display.probes[i].depth;
+            o["doubleBuffered"] = display.probes[i].doubleBuffered;
+            o["started"] = display.probes[i].started;
+            o["refreshHz"] = display.probes[i].refreshHz;
+            o["dmaBytes"] = display.probes[i].dmaBytes;
+            o["estimatedBytes"] = display.probes[i].estimatedBytes;
+        }
+
+        // Time per power state and the module draw it implies
+        PowerStatus power = getPowerStatus();
+        JsonObject pw = doc["power"].to<JsonObject>();
+        pw["state"] = getPowerStateName(power.state);
+        pw["cpuMhz"] = power.cpuMhz;
+        pw["lowPower"] = power.lowPower;
+        pw["timeValid"] = power.timeValid;
+        pw["quietHours"] = power.quietHours;
+        pw["transitions"] = power.transitions;
+        JsonArray pwStates = pw["states"].to<JsonArray>();
+        for (int i = 0; i < POWER_STATE_COUNT; i++) {
+            JsonObject o = pwStates.add<JsonObject>();
+            o["name"] = getPowerStateName((PowerState)i);
+            o["ms"] = power.totalMs[i];
+            o["estimatedMa"] = power.estimatedMa[i];
+        }
+        // Newest hour first; the first entry is still being filled
+        JsonArray pwHours = pw["hours"].to<JsonArray>();
+        for (int h = 0; h < power.hourCount; h++) {
+            const PowerHour& hour = power.hours[h];
+            uint32_t spanMs = 0;
+            float maMs = 0;
+            for (int i = 0; i < POWER_STATE_COUNT; i++) {
+                spanMs += hour.ms[i];
+                maMs += (float)hour.ms[i] * power.estimatedMa[i];
+            }
+            JsonObject o = pwHours.add<JsonObject>();
+            o["spanMs"] = spanMs;
+            o["awakeMs"] = hour.ms[POWER_ACTIVE];
+            o["avgMa"] = spanMs ? maMs / spanMs : 0;
+        }
+
+        // Sessions gating stock/forex fetches (unknown until SNTP syncs)
+        time_t wall = appTime();
+        JsonArray markets = doc["markets"].to<JsonArray>();
+        for (int type = TICKER_STOCK; type <= TICKER_FOREX && appTimeValid(wall); type++) {
+            JsonObject o = markets.add<JsonObject>();
+            o["name"] = getMarketName((TickerType)type);
+            o["open"] = isMarketOpen((TickerType)type, wall);
+            o["nextOpen"] = (uint32_t)nextMarketOpen((TickerType)type, wall);
+            o["lastClose"] = (uint32_t)lastMarketClose((TickerType)type, wall);
+        }
+
+        // Sparkline residency (see sparkline_store.h)
+        SparklineStoreStats store = getSparklineStoreStats();
+        JsonObject sl = doc["sparklineStore"].to<JsonObject>();
+        sl["backing"] = store.psram ? "psram" : "flash";
+        sl["capacity"] = store.capacity;
+        sl["resident"] = store.resident;
+        sl["hits"] = store.hits;
+        sl["flashReads"] = store.flashReads;
+        sl["evictions"] = store.evictions;
+        sl["flashWrites"] = store.flashWrites;
+
+        // Freshness SLO: stage and displayed-age percentiles (bucket bounds)
+        DataAgeStats age = getDataAgeStats();
+        JsonObject da = doc["dataAge"].to<JsonObject>();
+        da["sloMs"] = AGE_SLO_MS;
+        uint32_t frames = age.stages[AGE_DISPLAYED].count;
+        da["sloPct"] = frames ? 100.0f * age.withinSlo / frames : 100.0f;
+        da["staleFrames"] = age.staleFrames;
+        da["timeValid"] = appTimeValid(appTime());
+        for (int s = 0; s < AGE_STAGE_COUNT; s++) {
+            const AgePercentiles& p = age.stages[s];
+            JsonObject o = da[getAgeStageName((AgeStage)s)].to<JsonObject>();
+            o["count"] = p.count;
+            o["p50Ms"] = p.p50Ms;
+            o["p90Ms"] = p.p90Ms;
+            o["p99Ms"] = p.p99Ms;
+            o["maxMs"] = p.maxMs;
+        }
+
+        StreamStatus stream = getStreamStatus();
+        JsonObject st = doc["stream"].to<JsonObject>();
+        st["state"] = getStreamStateName(stream.state);
+        st["host"] = STREAM_HOST;
+        st["pairs"] = stream.pairs;
+        st["connects"] = stream.connects;
+        st["disconnects"] = stream.disconnects;
+        st["messages"] = stream.messages;
+        st["published"] = stream.published;
+        st["lastMessageAgeMs"] = stream.lastMessageMs ? appMillis() - stream.lastMessageMs : 0;
+        st["connectedMs"] = stream.connectedMs;
+        st["backoffMs"] = stream.backoffMs;
+
+        MirrorStatus mirror = getMirrorStatus();
+        JsonObject mi = doc["mirror"].to<JsonObject>();
+        mi["viewers"] = mirror.viewers;
+        mi["frames"] = mirror.frames;
+        mi["keyframes"] = mirror.keyframes;
+        mi["refused"] = mirror.refused;
+        mi["lastBytes"] = mirror.lastBytes;
+        mi["avgBytes"] = mirror.frames ? mirror.totalBytes / mirror.frames : 0;
+        mi["captureUs"] = mirror.captureUs;
+        mi["encodeUs"] = mirror.encodeUs;
+
+        // What wakes the fetch task, and how much of the time it sleeps
+        FetchWakeStats wakes = getFetchWakeStats();
+        JsonObject ft = doc["fetchTask"].to<JsonObject>();
+        JsonObject fw = ft["wakes"].to<JsonObject>();
+        for (int b = 0; b < FETCH_EVENT_COUNT; b++) {
+            fw[getFetchEventName(b)] = wakes.events[b];
+        }
+        fw["deadline"] = wakes.deadlines;
+        ft["lastWaitMs"] = wakes.lastWaitMs;
+        uint64_t total = wakes.sleptMs + wakes.busyMs;
+        ft["idlePct"] = total ? (float)(wakes.sleptMs * 1000 / total) / 10.0f : 0;
+
+        // Cached display-currency rates (units per USD)
+        static const char* fxSources[] = { "none", "watchlist", "fetched" };
+        JsonObject fx = doc["fx"].to<JsonObject>();
+        for (int c = CURRENCY_USD + 1; c < CURRENCY_COUNT; c++) {
+            FxRate rate = getFxRate((Currency)c);
+            if (rate.source == FX_NONE) continue;
+            JsonObject fr = fx[getCurrencyCode((Currency)c)].to<JsonObject>();
+            setPrice(fr["perUsd"], rate.perUsd);
+            fr["source"] = fxSources[rate.source];
+            fr["ageS"] = (appMillis() - rate.updatedAt) / 1000;
+        }
+
+        RelayStatus relay = getRelayStatus();
+        JsonObject r = doc["relay"].to<JsonObject>();
+        r["role"] = getRelayRoleName(relay.role);
+        r["nodeId"] = relay.nodeId;
+        r["leaderId"] = relay.leaderId;
+        r["leaderSeenAgoMs"] = relay.role == RELAY_FOLLOWER ? millis() - relay.lastLeaderSeenMs : 0;
+        r["packetsSent"] = relay.packetsSent;
+        r["packetsReceived"] = relay.packetsReceived;
+        r["sequenceGaps"] = relay.sequenceGaps;
+        r["queueDrops"] = relay.queueDrops;
+
         // Add current ticker prices
+        const AppConfig* config = configCurrent();
         JsonArray prices = doc["prices"].to<JsonArray>();
-        for (int i = 0; i < g_config->numTickers; i++) {
-            if (g_config->tickers[i].enabled) {
+        for (int i = 0; i < config->numTickers; i++) {
+            if (config->tickers[i].enabled) {
                 JsonObject p = prices.add<JsonObject>();
                 p["symbol"] = g_tickerData[i].symbol;
-                p["price"] = g_tickerData[i].currentPrice;
+                setPrice(p["price"], g_tickerData[i].currentPrice);
                 p["change24h"] = g_tickerData[i].priceChange24h;
             }
         }
@@ -176,57 +624,239 @@ void initWebServer(AppConfig* config, TickerData* tickerData, void (*onConfigCha
 
     // API endpoint: Get all ticker data
     server.on("/api/tickers", HTTP_GET, [](AsyncWebServerRequest *request) {
+        TRACE_SCOPE("web.tickers");
+        uint32_t t0 = micros();
         JsonDocument doc;
         JsonArray tickers = doc.to<JsonArray>();
 
-        for (int i = 0; i < g_config->numTickers; i++) {
-            if (g_config->tickers[i].enabled) {
+        const AppConfig* config = configCurrent();
+        for (int i = 0; i < config->numTickers; i++) {
+            if (config->tickers[i].enabled) {
                 JsonObject t = tickers.add<JsonObject>();
                 t["symbol"] = g_tickerData[i].symbol;
-                t["currentPrice"] = g_tickerData[i].currentPrice;
+                setPrice(t["currentPrice"], g_tickerData[i].currentPrice);
                 t["change24h"] = g_tickerData[i].priceChange24h;
-                t["high24h"] = g_tickerData[i].high24h;
-                t["low24h"] = g_tickerData[i].low24h;
+                setPrice(t["high24h"], g_tickerData[i].high24h);
+                setPrice(t["low24h"], g_tickerData[i].low24h);
                 t["lastUpdate"] = g_tickerData[i].lastPriceUpdate;
                 t["isValid"] = g_tickerData[i].priceValid;
+
+                // Where this price's age comes from (see data_age.h)
+                TickerAge age = getTickerAge(i);
+                if (age.fetchedAt) {
+                    JsonObject a = t["age"].to<JsonObject>();
+                    a["ageMs"] = priceAgeMs(i);
+                    if (age.sourceMs) a["sourceMs"] = age.sourceMs;
+                    for (int s = 0; s < AGE_DISPLAYED; s++) {
+                        if (age.stageMs[s] >= 0) a[getAgeStageName((AgeStage)s)] = age.stageMs[s];
+                    }
+                }
             }
         }
 
         String response;
         serializeJson(doc, response);
-        request->send(200, "application/json", response);
+        uint32_t elapsed = micros() - t0;
+
+        AsyncWebServerResponse *res = request->beginResponse(200, "application/json", response);
+        res->addHeader("X-Serialize-Us", String(elapsed));
+        request->send(res);
+    });
+
+    // API endpoint: Ticker set incl. sparklines, MessagePack, one page per
+    // request (?from=<slot>, see ticker_feed.h)
+    server.on("/api/v1/tickers.msgpack", HTTP_GET, [](AsyncWebServerRequest *request) {
+        TRACE_SCOPE("web.feed");
+        AsyncResponseStream *res = request->beginResponseStream("application/msgpack", 2048);
+        uint32_t t0 = micros();
+        size_t len = writeTickerFeed(*res, configCurrent(), g_tickerData, (int)uintParam(request, "from"));
+        uint32_t elapsed = micros() - t0;
+        res->addHeader("X-Feed-Version", String(TICKER_FEED_VERSION));
+        res->addHeader("X-Feed-Bytes", String((unsigned)len));
+        res->addHeader("X-Serialize-Us", String(elapsed));
+        request->send(res);
+    });
+
+    // API endpoint: Event log as text, formatted on read (see event_log.h)
+    // ?since=<seq> returns only newer events; X-Log-Next is the seq to poll with next
+    // ?level=0..3 hides events below debug/info/warn/error
+    server.on("/api/logs", HTTP_GET, [](AsyncWebServerRequest *request) {
+        TRACE_SCOPE("web.logs");
+        uint32_t since = 0;
+        LogLevel minLevel = LOG_DEBUG;
+        if (request->hasParam("since")) {
+            since = strtoul(request->getParam("since")->value().c_str(), nullptr, 10);
+        }
+        if (request->hasParam("level")) {
+            minLevel = (LogLevel)constrain(request->getParam("level")->value().toInt(), 0, 3);
+        }
+
+        LogStats stats = getLogStats();
+        AsyncResponseStream *res = request->beginResponseStream("text/plain", 2048);
+        res->printf("# events=%lu suppressed=%lu overwritten=%lu record_us=%lu.%02lu max_us=%lu.%02lu",
+                    (unsigned long)stats.recorded, (unsigned long)stats.suppressed,
+                    (unsigned long)stats.overwritten,
+                    (unsigned long)(stats.avgRecordUs100 / 100), (unsigned long)(stats.avgRecordUs100 % 100),
+                    (unsigned long)(stats.maxRecordUs100 / 100), (unsigned long)(stats.maxRecordUs100 % 100));
+        if (stats.avgMirrorUs100) {
+            res->printf(" serial_us=%lu.%02lu",
+                        (unsigned long)(stats.avgMirrorUs100 / 100), (unsigned long)(stats.avgMirrorUs100 % 100));
+        }
+        res->print("\n");
+        uint32_t next = writeLogText(*res, since, minLevel);
+        res->addHeader("X-Log-Next", String(next));
+        request->send(res);
+    });
+
+    // API endpoint: Render the frame suite offscreen and diff it against the
+    // goldens (see frame_capture.h); POST re-records the goldens instead
+    server.on("/api/frames", HTTP_GET, [](AsyncWebServerRequest *request) {
+        TRACE_SCOPE("web.frames");
+        AsyncResponseStream *res = request->beginResponseStream("application/json", 4096);
+        writeFrameSuiteReport(*res, false);
+        request->send(res);
+    });
+    server.on("/api/frames", HTTP_POST, [](AsyncWebServerRequest *request) {
+        TRACE_SCOPE("web.frames");
+        AsyncResponseStream *res = request->beginResponseStream("application/json", 4096);
+        writeFrameSuiteReport(*res, true);
+        request->send(res);
     });
 
-    // OTA firmware update endpoint
+    // API endpoint: One suite frame as a PPM image (?name=BTC_24H_up)
+    server.on("/api/frame.ppm", HTTP_GET, [](AsyncWebServerRequest *request) {
+        int index = request->hasParam("name")
+            ? findSuiteFrame(request->getParam("name")->value().c_str()) : -1;
+        if (index < 0) {
+            request->send(404, "text/plain", "Unknown frame");
+            return;
+        }
+        AsyncResponseStream *res = request->beginResponseStream("image/x-portable-pixmap", 2048);
+        writeFramePPM(*res, index);
+        request->send(res);
+    });
+
+    // API endpoint: The frame on the panel right now, as one mirror keyframe
+    // (format in frame_mirror.h)
+    server.on("/api/mirror", HTTP_GET, [](AsyncWebServerRequest *request) {
+        AsyncResponseStream *res = request->beginResponseStream("application/octet-stream", 1024);
+        if (!writeMirrorKeyframe(*res)) {
+            delete res;
+            request->send(503, "text/plain", "No memory for capture");
+            return;
+        }
+        res->addHeader("Cache-Control", "no-store");
+        request->send(res);
+    });
+
+    // Live mirror: keyframe on connect, then deltas as the panel changes.
+    // Any message from a client asks for a fresh keyframe (it lost its base).
+    mirrorSocket.onEvent([](AsyncWebSocket *socket, AsyncWebSocketClient *client, AwsEventType type,
+                            void *arg, uint8_t *data, size_t len) {
+        if (type == WS_EVT_CONNECT) {
+            if (!updateMirrorViewer(client->id(), true)) {
+                client->close(1013, "Too many viewers");
+                return;
+            }
+            requestMirrorKeyframe();
+        } else if (type == WS_EVT_DISCONNECT) {
+            updateMirrorViewer(client->id(), false);
+        } else if (type == WS_EVT_DATA) {
+            requestMirrorKeyframe();
+        }
+    });
+    server.addHandler(&mirrorSocket);
+    startFrameMirror(sendMirrorFrame);
+
+#if SIM_BUILD
+    // API endpoint: Last simulation report (see simulator.h); POST re-runs it
+    // with the current /sim/sim.json
+    server.on("/api/sim", HTTP_GET, [](AsyncWebServerRequest *request) {
+        request->send(200, "application/json", getSimReport());
+    });
+    server.on("/api/sim", HTTP_POST, [](AsyncWebServerRequest *request) {
+        requestSimulation();
+        request->send(202, "application/json", "{\"status\":\"started\"}");
+    });
+#endif
+
+#if TRACE_ENABLED
+    // API endpoint: Task timeline as Chrome trace-event JSON (see trace.h)
+    // ?clear=1 drops the exported events so the next dump starts fresh
+    // The export (up to 2 x TRACE_RING_SIZE events) is rendered a chunk
+    // at a time from a cursor over the rings, never held whole
+    server.on("/api/trace", HTTP_GET, [](AsyncWebServerRequest *request) {
+        std::shared_ptr<TraceExport> cursor(traceExportBegin(request->hasParam("clear")), traceExportEnd);
+        if (!cursor) {
+            request->send(503, "application/json", "{\"error\":\"Out of memory\"}");
+            return;
+        }
+        request->send(request->beginChunkedResponse("application/json",
+            [cursor](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                return traceExportFill(cursor.get(), buffer, maxLen);
+            }));
+    });
+#endif
+
+    // API endpoints: Resumable OTA (see ota_update.h)
+    server.on("/api/ota", HTTP_GET, [](AsyncWebServerRequest *request) {
+        sendOtaStatus(request, 200);
+    });
+
+    server.on("/api/ota/begin", HTTP_POST, [](AsyncWebServerRequest *request) {
+        String sha = request->hasParam("sha256") ? request->getParam("sha256")->value() : String();
+        bool ok = otaBegin(otaTargetParam(request), uintParam(request, "size"), sha.c_str());
+        sendOtaStatus(request, ok ? 200 : 400);
+    });
+
+    // Body bytes go straight to flash; the reply says whether all of them
+    // landed (200) or where to resume (409)
+    server.on("/api/ota/chunk", HTTP_POST,
+        [](AsyncWebServerRequest *request) {
+            OtaStatus ota = getOtaStatus();
+            uint32_t end = uintParam(request, "offset") + request->contentLength();
+            int code = ota.state == OTA_FAILED ? 500 : (ota.state == OTA_RECEIVING && ota.received >= end ? 200 : 409);
+            sendOtaStatus(request, code);
+        }, NULL,
+        [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+            TRACE_SCOPE("web.otaChunk");
+            uint32_t offset = uintParam(request, "offset");
+            if (index == 0) {
+                otaChunkStart(offset, total);
+            }
+            otaWrite(offset + index, data, len);
+        }
+    );
+
+    server.on("/api/ota/finish", HTTP_POST, [](AsyncWebServerRequest *request) {
+        // 409: incomplete, keep uploading; 500: the session failed
+        bool ok = otaFinish();
+        sendOtaStatus(request, ok ? 200 : (otaActive() ? 409 : 500));
+    });
+
+    server.on("/api/ota/abort", HTTP_POST, [](AsyncWebServerRequest *request) {
+        otaAbort("aborted by client");
+        sendOtaStatus(request, 200);
+    });
+
+    // Single-request multipart upload (curl -F image=@firmware.bin[.gz]),
+    // through the same session: ?target=filesystem, optional ?sha256=
     server.on("/update", HTTP_POST,
         [](AsyncWebServerRequest *request) {
-            bool success = !Update.hasError();
-            AsyncWebServerResponse *response = request->beginResponse(200, "text/plain", success ? "OK" : "FAIL");
+            bool success = getOtaStatus().state == OTA_VERIFIED;
+            AsyncWebServerResponse *response = request->beginResponse(success ? 200 : 500, "text/plain", success ? "OK" : "FAIL");
             response->addHeader("Connection", "close");
             request->send(response);
-            if (success) {
-                delay(500);
-                ESP.restart();
-            }
         },
         [](AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final) {
             if (!index) {
                 Serial.printf("Update start: %s\n", filename.c_str());
-                if (!Update.begin(UPDATE_SIZE_UNKNOWN)) {
-                    Update.printError(Serial);
-                }
-            }
-            if (!Update.hasError()) {
-                if (Update.write(data, len) != len) {
-                    Update.printError(Serial);
-                }
+                String sha = request->hasParam("sha256") ? request->getParam("sha256")->value() : String();
+                otaBegin(otaTargetParam(request), 0, sha.c_str());
             }
+            otaWrite(index, data, len);
             if (final) {
-                if (Update.end(true)) {
-                    Serial.printf("Update success: %u bytes\n", index + len);
-                } else {
-                    Update.printError(Serial);
-                }
+                otaFinish();
             }
         }
     );
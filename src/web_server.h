@@ -2,10 +2,10 @@
 #include "ticker_types.h"
 
 // Initialize web server on port 80
-// config: pointer to AppConfig (will be modified when user saves)
 // tickerData: pointer to TickerData array (for status display)
-// onConfigChanged: callback when config is saved (to reload data)
-void initWebServer(AppConfig* config, TickerData* tickerData, void (*onConfigChanged)());
+// Saved configs are published through config_store.h; the render and fetch
+// tasks pick them up on their own.
+void initWebServer(TickerData* tickerData);
 
 // Call in loop to handle OTA (not needed for async but kept for future use)
 void handleWebServer();
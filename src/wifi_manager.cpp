@@ -1,11 +1,17 @@
 #include "wifi_manager.h"
 #include <WiFi.h>
 #include <WiFiManager.h>
+#include "fetch_events.h"
 
 bool initWiFi(const char* apName) {
     // Ensure STA mode before WiFiManager
     WiFi.mode(WIFI_STA);
 
+    // Every (re)connect: prices fetched while offline failed, get new ones
+    WiFi.onEvent([](arduino_event_id_t event, arduino_event_info_t info) {
+        signalFetchTask(FETCH_EVENT_WIFI);
+    }, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+
     WiFiManager wifiManager;
     wifiManager.setConnectTimeout(20);
     wifiManager.setConfigPortalTimeout(120);
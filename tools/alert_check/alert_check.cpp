@@ -0,0 +1,57 @@
+// Host check for the move alert history (src/alert_history.h).
+//
+//   g++ -O2 -std=gnu++11 -Itools/alert_check -Isrc
+//       tools/alert_check/alert_check.cpp src/alert_history.cpp src/price.cpp -o alert_check
+//   ./alert_check
+//
+// Feeds a 5%-in-15-minutes rule (the /api/alerts default window) with price
+// ramps at stream (1 Hz) and poll (60 s) rates, the way checkRule() does,
+// and reports when it fires. Exits non-zero if a case goes the wrong way.
+
+#include "alert_history.h"
+#include <stdio.h>
+
+#define RULE_PCT      5.0f
+#define RULE_WINDOW_S 900
+
+struct Case {
+  const char* name;
+  uint32_t stepS;     // Time between prices
+  uint32_t rampS;     // Rise of rampPct over this long, after 10 min flat
+  float rampPct;
+  bool shouldFire;
+};
+
+static const Case cases[] = {
+  { "1 Hz, +6% in 15 min",  1,  900, 6.0f, true },
+  { "1 Hz, +6% in 30 min",  1, 1800, 6.0f, false },
+  { "1 Hz, +6% in 5 min",   1,  300, 6.0f, true },
+  { "60 s, +6% in 15 min", 60,  900, 6.0f, true },
+  { "60 s, +6% in 30 min", 60, 1800, 6.0f, false },
+};
+
+// Seconds into the ramp when the rule first fires, or -1
+static long run(const Case& c) {
+  PriceHistory history = {};
+  const uint32_t flatS = 600;
+  for (uint32_t t = 0; t <= flatS + c.rampS; t += c.stepS) {
+    float rise = t < flatS ? 0 : c.rampPct * (t - flatS) / c.rampS;
+    Price price = priceFromDouble(100.0 * (1.0 + rise / 100.0));
+    uint32_t now = 1000 + t * 1000;
+    historyAdd(&history, RULE_WINDOW_S * 1000, now, price);
+    if (historyMove(&history, price) >= RULE_PCT) return (long)t - (long)flatS;
+  }
+  return -1;
+}
+
+int main() {
+  int failures = 0;
+  for (const Case& c : cases) {
+    long firedAt = run(c);
+    bool ok = (firedAt >= 0) == c.shouldFire;
+    if (!ok) failures++;
+    if (firedAt >= 0) printf("%-4s %-22s fired %lds into the ramp\n", ok ? "ok" : "FAIL", c.name, firedAt);
+    else printf("%-4s %-22s did not fire\n", ok ? "ok" : "FAIL", c.name);
+  }
+  return failures ? 1 : 0;
+}
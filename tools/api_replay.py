@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+"""Local stand-in for the provider REST APIs (see src/api_client.h).
+
+Serves the recorded responses in data/sim/ over plain http:// so the
+firmware's fetch path, gzip inflate included, can be exercised without
+the real hosts:
+
+    python3 tools/api_replay.py
+    API_HOST=<this machine's IP> pio run -e api_replay -t upload
+
+A request for /<provider>/<path>/<name>?... is answered with
+data/sim/<provider>_<name>.json, the same fixture the simulation build
+uses for it. When the client sends Accept-Encoding: gzip the body is
+gzipped; each request is logged with its size before and after, to
+compare with the device's per-endpoint counters in GET /api/status.
+
+--no-gzip serves identity bodies only, --latency delays every response.
+
+--throttle N answers the first N requests to each provider with 429 Too
+Many Requests (plus Retry-After: S with --retry-after S), to watch the
+provider circuit breaker open, back off and recover in the "providers"
+array of GET /api/status:
+
+    python3 tools/api_replay.py --throttle 3 --retry-after 60
+"""
+
+import argparse
+import gzip
+import http.server
+import os
+import sys
+import threading
+import time
+from urllib.parse import urlsplit
+
+FIXTURES = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "data", "sim")
+PROVIDERS = ("cmc", "coingecko", "twelvedata")
+
+
+def path_parts(path):
+    parts = [p for p in urlsplit(path).path.split("/") if p]
+    return parts if len(parts) >= 2 and parts[0] in PROVIDERS else None
+
+
+def fixture(path):
+    parts = path_parts(path)
+    if not parts:
+        return None
+    name = os.path.join(FIXTURES, "%s_%s.json" % (parts[0], parts[-1]))
+    return name if os.path.isfile(name) else None
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.0"
+
+    def do_GET(self):
+        name = fixture(self.path)
+        if not name:
+            self.send_error(404)
+            return
+        if self.throttled(path_parts(self.path)[0]):
+            return
+        with open(name, "rb") as f:
+            body = f.read()
+        raw = len(body)
+        encodings = [e.split(";")[0].strip() for e in self.headers.get("Accept-Encoding", "").split(",")]
+        zipped = self.server.use_gzip and "gzip" in encodings
+        if zipped:
+            body = gzip.compress(body, self.server.level)
+        if self.server.latency:
+            time.sleep(self.server.latency / 1000.0)
+
+        self.send_response(200)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        if zipped:
+            self.send_header("Content-Encoding", "gzip")
+        self.end_headers()
+        self.wfile.write(body)
+        print("%s %s: %d bytes%s" % (self.client_address[0], os.path.basename(name), raw,
+                                     " -> %d gzipped" % len(body) if zipped else ""), file=sys.stderr)
+
+    def throttled(self, provider):
+        """429 for the provider's first --throttle requests."""
+        with self.server.lock:
+            count = self.server.requests.get(provider, 0) + 1
+            self.server.requests[provider] = count
+        if count > self.server.throttle:
+            return False
+        self.send_response(429)
+        if self.server.retry_after:
+            self.send_header("Retry-After", str(self.server.retry_after))
+        self.send_header("Content-Length", "0")
+        self.end_headers()
+        print("%s %s: 429 (%d/%d)%s" % (self.client_address[0], provider, count, self.server.throttle,
+                                       ", Retry-After %ds" % self.server.retry_after if self.server.retry_after else ""),
+              file=sys.stderr)
+        return True
+
+    def log_message(self, fmt, *args):
+        pass
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("--port", type=int, default=8080)
+    p.add_argument("--no-gzip", action="store_true", help="never gzip, whatever the client accepts")
+    p.add_argument("--level", type=int, default=6, help="gzip compression level")
+    p.add_argument("--latency", type=float, default=0, help="delay before each response (ms)")
+    p.add_argument("--throttle", type=int, default=0, metavar="N", help="429 the first N requests per provider")
+    p.add_argument("--retry-after", type=int, default=0, metavar="S", help="Retry-After seconds sent with a 429")
+    args = p.parse_args()
+
+    server = http.server.ThreadingHTTPServer(("0.0.0.0", args.port), Handler)
+    server.use_gzip = not args.no_gzip
+    server.level = args.level
+    server.latency = args.latency
+    server.throttle = args.throttle
+    server.retry_after = args.retry_after
+    server.requests = {}
+    server.lock = threading.Lock()
+    print("Serving %s on http://0.0.0.0:%d/{%s}/..." % (os.path.normpath(FIXTURES), args.port, ",".join(PROVIDERS)),
+          file=sys.stderr)
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
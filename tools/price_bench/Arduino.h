@@ -0,0 +1,7 @@
+// Host stand-in for the Arduino core: price.cpp only needs the C headers
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
@@ -0,0 +1,95 @@
+// Host benchmark for the display's price/change% formatting (src/price.h).
+//
+//   g++ -O2 -std=gnu++11 -Itools/price_bench -Isrc
+//       tools/price_bench/price_bench.cpp src/price.cpp -o price_bench
+//   ./price_bench
+//
+// Per "frame" it formats what the ticker header shows: the price, its pixel
+// width for right alignment, and the change%. The snprintf path is the
+// renderer before fixed-point prices (float price, "$%.Nf", a width pass
+// over the text, "%+.1f%%"); the fixed-point path is formatPriceLabel()
+// and formatChange(), the functions the renderer calls.
+
+#include "price.h"
+#include <chrono>
+#include <limits.h>
+#include <stdio.h>
+
+static const double samples[] = {
+  67250.12, 3412.5, 152.34, 98.76, 1.0812, 1.005, 0.1623, 0.0123,
+  0.00001234, 0.00000089, 24510.9, 0.5, 12.3456, 7.0, 0.0451, 412.37
+};
+static const float changes[] = { 2.34f, -0.41f, 0.0f, -12.5f, 105.2f, -0.05f, 7.77f, 0.9f };
+#define SAMPLE_COUNT (int)(sizeof(samples) / sizeof(samples[0]))
+#define CHANGE_COUNT (int)(sizeof(changes) / sizeof(changes[0]))
+#define ITERATIONS   2000000
+
+// ---- Before: float + snprintf ----
+
+static int priceAdv(char c, char next) {
+  if (c == '.') return 4;
+  if (next == '.') return 4;
+  return 6;
+}
+
+static int priceWidth(const char* text) {
+  int len = strlen(text);
+  if (len == 0) return 0;
+  int w = 0;
+  for (int i = 0; i < len - 1; i++) w += priceAdv(text[i], text[i + 1]);
+  return w + 5;
+}
+
+static int frameSnprintf(float price, float change, char* priceStr, char* changeStr) {
+  if (price >= 10000) snprintf(priceStr, 16, "$%.0f", price);
+  else if (price >= 100) snprintf(priceStr, 16, "$%.1f", price);
+  else if (price >= 1) snprintf(priceStr, 16, "$%.2f", price);
+  else snprintf(priceStr, 16, "$%.4f", price);
+  snprintf(changeStr, 16, "%s%.1f%%", change >= 0 ? "+" : "", change);
+  return priceWidth(priceStr);
+}
+
+// ---- After: fixed point (price.cpp) ----
+
+static int frameFixed(Price price, float change, char* priceStr, char* changeStr) {
+  int w = formatPriceLabel(price, '$', priceStr, INT_MAX);
+  formatChange(change, changeStr);
+  return w;
+}
+
+template <typename F>
+static double nsPerFrame(F frame) {
+  volatile int sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < ITERATIONS; i++) sink += frame(i % SAMPLE_COUNT, i % CHANGE_COUNT);
+  auto end = std::chrono::steady_clock::now();
+  (void)sink;
+  return std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+}
+
+int main() {
+  float floats[SAMPLE_COUNT];
+  Price prices[SAMPLE_COUNT];
+  for (int i = 0; i < SAMPLE_COUNT; i++) {
+    floats[i] = (float)samples[i];
+    prices[i] = priceFromDouble(samples[i]);
+  }
+
+  // Widths must agree with a pass over the text; the text itself differs
+  // where float loses digits (1.005) or sub-cent prices gain them
+  int widthErrors = 0;
+  for (int i = 0; i < SAMPLE_COUNT; i++) {
+    char a[PRICE_TEXT_LEN + 1], b[16], ca[16], cb[16];
+    int w = frameFixed(prices[i], changes[i % CHANGE_COUNT], a, ca);
+    frameSnprintf(floats[i], changes[i % CHANGE_COUNT], b, cb);
+    if (w != priceWidth(a)) widthErrors++;
+    printf("%-14.8f fixed %-12s %-8s snprintf %-12s %s\n", samples[i], a, ca, b, cb);
+  }
+
+  char p[PRICE_TEXT_LEN + 1], c[16];
+  double before = nsPerFrame([&](int i, int j) { return frameSnprintf(floats[i], changes[j], p, c); });
+  double after = nsPerFrame([&](int i, int j) { return frameFixed(prices[i], changes[j], p, c); });
+  printf("\nsnprintf %.0f ns/frame, fixed-point %.0f ns/frame (%.1fx), width mismatches %d\n",
+         before, after, before / after, widthErrors);
+  return widthErrors ? 1 : 0;
+}
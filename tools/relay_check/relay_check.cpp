@@ -0,0 +1,236 @@
+// Host check for the LAN relay wire codec and election rule (src/relay_wire.h).
+//
+//   g++ -O2 -std=gnu++11 -Itools/relay_check -Isrc
+//       tools/relay_check/relay_check.cpp src/relay_wire.cpp -o relay_check
+//   ./relay_check
+//
+// Round-trips prices and sparklines through datagrams built the way
+// lan_relay.cpp builds them, and runs a few nodes on a simulated loopback
+// network with the takeover and accept rules: they must settle on one
+// leader, contested leaders must resolve to the lowest id, and a silent
+// leader must be replaced. Exits non-zero if a check fails.
+
+#include "relay_wire.h"
+#include <stdio.h>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+  printf("%-4s %s\n", ok ? "ok" : "FAIL", what);
+  if (!ok) failures++;
+}
+
+// ---- Codec ----
+
+static void checkHeader() {
+  uint8_t buf[sizeof(RelayHeader)];
+  relayWriteHeader(buf, MSG_PRICES, 7, 42, 0xA1B2C3D4, 0x55AA55AA);
+  RelayHeader hdr;
+  bool ok = relayReadHeader(buf, sizeof(buf), &hdr);
+  check(ok && hdr.type == MSG_PRICES && hdr.count == 7 && hdr.seq == 42 &&
+        hdr.senderId == 0xA1B2C3D4 && hdr.watchlistHash == 0x55AA55AA, "header round trip");
+  check(!relayReadHeader(buf, sizeof(buf) - 1, &hdr), "short datagram rejected");
+  buf[0] ^= 1;
+  check(!relayReadHeader(buf, sizeof(buf), &hdr), "foreign magic rejected");
+}
+
+static void checkPrices() {
+  const int count = MAX_TICKERS;
+  TickerData tickers[MAX_TICKERS] = {};
+  for (int i = 0; i < count; i++) {
+    tickers[i].currentPrice = (Price)(i + 1) * 123456789LL;
+    tickers[i].priceValid = i % 3 != 0;
+    for (int tf = 0; tf < TIMEFRAME_COUNT; tf++) tickers[i].priceChange[tf] = i * 0.5f - tf;
+  }
+
+  // Packed per datagram as relayPublishPrices() does
+  int decoded = 0;
+  bool same = true;
+  const int perPacket = RELAY_PRICES_PER_PACKET;
+  for (int start = 0; start < count; start += perPacket) {
+    uint8_t buf[RELAY_MAX_PACKET];
+    int n = count - start < perPacket ? count - start : perPacket;
+    for (int k = 0; k < n; k++) {
+      WirePrice wp = relayWirePrice(start + k, tickers[start + k]);
+      memcpy(buf + sizeof(RelayHeader) + k * sizeof(WirePrice), &wp, sizeof(wp));
+    }
+    relayWriteHeader(buf, MSG_PRICES, n, 1, 1, 1);
+    size_t len = sizeof(RelayHeader) + n * sizeof(WirePrice);
+    same = same && len <= RELAY_MAX_PACKET;
+
+    RelayHeader hdr;
+    relayReadHeader(buf, len, &hdr);
+    WirePrice wp;
+    for (int i = 0; i < hdr.count && relayReadPrice(buf + sizeof(hdr), len - sizeof(hdr), i, &wp); i++) {
+      const TickerData& t = tickers[wp.index];
+      same = same && wp.price == t.currentPrice && ((wp.flags & 0x80) != 0) == t.priceValid &&
+             memcmp(wp.change, t.priceChange, sizeof(wp.change)) == 0;
+      decoded++;
+    }
+  }
+  check(same && decoded == count, "prices round trip across datagrams");
+
+  uint8_t body[2 * sizeof(WirePrice)] = {};
+  WirePrice wp;
+  check(relayReadPrice(body, sizeof(body), 1, &wp) && !relayReadPrice(body, sizeof(body) - 1, 1, &wp),
+        "truncated price entry rejected");
+}
+
+static SparklineData makeChart(int seed, int len) {
+  SparklineData sp = {};
+  sp.len = len;
+  sp.priceMin = seed * 1000LL;
+  sp.priceMax = seed * 2000LL + 1;
+  for (int k = 0; k < len; k++) sp.points[k] = (uint8_t)((seed * 7 + k * 3) % 32);
+  sp.valid = len > 0;
+  return sp;
+}
+
+static void checkSparklines() {
+  uint8_t body[RELAY_MAX_PACKET];
+  size_t off = 0;
+  int n = 0;
+  while (off + relaySparklineSize(makeChart(n, SPARKLINE_POINTS - n)) <= sizeof(body) - sizeof(RelayHeader)) {
+    off += relayPutSparkline(body + off, n, n % TIMEFRAME_COUNT, makeChart(n, SPARKLINE_POINTS - n));
+    n++;
+  }
+
+  size_t readOff = 0;
+  WireSparkline ws;
+  const uint8_t* points;
+  int read = 0;
+  bool same = true;
+  while (relayNextSparkline(body, off, &readOff, &ws, &points)) {
+    SparklineData expect = makeChart(read, SPARKLINE_POINTS - read);
+    same = same && ws.index == read && ws.timeframe == read % TIMEFRAME_COUNT && ws.len == expect.len &&
+           ws.priceMin == expect.priceMin && ws.priceMax == expect.priceMax &&
+           memcmp(points, expect.points, ws.len) == 0;
+    read++;
+  }
+  check(same && read == n && n > 1, "sparklines round trip");
+
+  readOff = 0;
+  check(!relayNextSparkline(body, relaySparklineSize(makeChart(0, SPARKLINE_POINTS)) - 1, &readOff, &ws, &points),
+        "truncated sparkline rejected");
+}
+
+static void checkWatchlistHash() {
+  static Watchlist a, b;
+  getDefaultWatchlist(&a);
+  getDefaultWatchlist(&b);
+  AppConfig ca = getDefaultConfig(), cb = getDefaultConfig();
+  ca.numTickers = a.numTickers;
+  ca.tickers = a.tickers;
+  cb.numTickers = b.numTickers;
+  cb.tickers = b.tickers;
+  bool equal = relayWatchlistHash(&ca) == relayWatchlistHash(&cb);
+  TickerConfig first = b.tickers[0];
+  b.tickers[0] = b.tickers[1];
+  b.tickers[1] = first;
+  check(equal && relayWatchlistHash(&ca) != relayWatchlistHash(&cb), "watchlist hash follows the slot layout");
+}
+
+// ---- Election on a simulated loopback network ----
+
+#define STEP_MS 100
+#define MAX_NODES 4
+
+struct Node {
+  uint32_t id;
+  RelayRole role;
+  uint32_t leaderId;
+  uint32_t deadline;      // Takeover
+  uint32_t lastHeartbeat;
+  bool up;
+};
+
+static void startNode(Node& n, uint32_t id, uint32_t now) {
+  n = {};
+  n.id = id;
+  n.role = RELAY_LISTENING;
+  n.deadline = now + relayTakeoverDelay(id);
+  n.up = true;
+}
+
+// relayTick() and onPacket() for every node, for durationMs
+static void run(Node* nodes, int count, uint32_t& now, uint32_t durationMs) {
+  for (uint32_t end = now + durationMs; now < end; now += STEP_MS) {
+    for (int i = 0; i < count; i++) {
+      Node& n = nodes[i];
+      if (!n.up) continue;
+      bool promoted = false;
+      if (n.role != RELAY_LEADER && (int32_t)(now - n.deadline) >= 0) {
+        n.role = RELAY_LEADER;
+        n.leaderId = n.id;
+        promoted = true;
+      }
+      if (n.role != RELAY_LEADER || (now - n.lastHeartbeat < RELAY_HEARTBEAT_MS && !promoted)) continue;
+      n.lastHeartbeat = now;
+      for (int j = 0; j < count; j++) {
+        Node& r = nodes[j];
+        if (j == i || !r.up || !relayAcceptsLeader(r.role, r.id, n.id)) continue;
+        r.role = RELAY_FOLLOWER;
+        r.leaderId = n.id;
+        r.deadline = now + relayTakeoverDelay(r.id);
+      }
+    }
+  }
+}
+
+// One leader among the running nodes, followed by all the others
+static bool settled(const Node* nodes, int count, uint32_t* leader) {
+  int leaders = 0;
+  for (int i = 0; i < count; i++) {
+    if (nodes[i].up && nodes[i].role == RELAY_LEADER) {
+      leaders++;
+      *leader = nodes[i].id;
+    }
+  }
+  if (leaders != 1) return false;
+  for (int i = 0; i < count; i++) {
+    if (nodes[i].up && nodes[i].role != RELAY_LEADER && nodes[i].leaderId != *leader) return false;
+  }
+  return true;
+}
+
+static void checkElection() {
+  Node nodes[MAX_NODES];
+  uint32_t now = 1000;
+  uint32_t leader = 0;
+
+  // Cold start: the first to time out leads, the rest follow it
+  const uint32_t ids[MAX_NODES] = { 0x1234A7D0, 0x0BADF00D, 0x7EEDBEEF, 0x00C0FFEE };
+  for (int i = 0; i < MAX_NODES; i++) startNode(nodes[i], ids[i], now);
+  run(nodes, MAX_NODES, now, RELAY_LEADER_TIMEOUT_MS + 2000 + 3 * RELAY_HEARTBEAT_MS);
+  check(settled(nodes, MAX_NODES, &leader), "cold start settles on one leader");
+
+  // Partition healed with two leaders: the lower id keeps the role
+  for (int i = 0; i < MAX_NODES; i++) nodes[i].up = false;
+  startNode(nodes[0], 9, now);
+  startNode(nodes[1], 5, now);
+  nodes[0].role = nodes[1].role = RELAY_LEADER;
+  nodes[0].leaderId = 9;
+  nodes[1].leaderId = 5;
+  run(nodes, 2, now, 2 * RELAY_HEARTBEAT_MS);
+  check(settled(nodes, 2, &leader) && leader == 5, "contested leaders resolve to the lowest id");
+
+  // Leader goes silent: a follower takes over within its takeover delay
+  startNode(nodes[2], 7, now);
+  run(nodes, 3, now, 2 * RELAY_HEARTBEAT_MS);
+  nodes[1].up = false;
+  uint32_t silentAt = now;
+  while (!(settled(nodes, 3, &leader) && leader != 5) && now - silentAt < 2 * RELAY_LEADER_TIMEOUT_MS) {
+    run(nodes, 3, now, STEP_MS);
+  }
+  check(leader != 5 && now - silentAt <= RELAY_LEADER_TIMEOUT_MS + 2000 + RELAY_HEARTBEAT_MS,
+        "silent leader replaced");
+}
+
+int main() {
+  checkHeader();
+  checkPrices();
+  checkSparklines();
+  checkWatchlistHash();
+  checkElection();
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+"""Local stand-in for the exchange ticker stream (see src/market_stream.h).
+
+Serves a recorded Binance combined stream over plain ws:// so the firmware's
+stream client can be exercised without the exchange:
+
+    python3 tools/stream_replay.py tools/stream_sample.jsonl
+    STREAM_HOST=<this machine's IP> pio run -e stream_replay -t upload
+
+A recording is one JSON object per line, {"t": <ms since start>, "msg": {...}},
+where msg is a combined-stream message as Binance sends it. Only messages for
+the streams the device asked for are sent. --record captures one from the
+live exchange:
+
+    python3 tools/stream_replay.py --record 120 btcusdt ethusdt > rec.jsonl
+
+Options exercise the client's recovery paths: --drop-after closes the
+connection after N seconds (reconnect + backoff), --silent-after stops
+sending without closing (idle timeout), --ping sends server pings.
+"""
+
+import argparse
+import asyncio
+import base64
+import hashlib
+import json
+import os
+import socket
+import ssl
+import struct
+import sys
+import time
+from urllib.parse import urlsplit, parse_qs
+
+GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+
+def frame(opcode, payload=b""):
+    head = bytes([0x80 | opcode])
+    n = len(payload)
+    if n < 126:
+        head += bytes([n])
+    elif n < 65536:
+        head += bytes([126]) + struct.pack(">H", n)
+    else:
+        head += bytes([127]) + struct.pack(">Q", n)
+    return head + payload
+
+
+async def read_frame(reader):
+    b0, b1 = await reader.readexactly(2)
+    n = b1 & 0x7F
+    if n == 126:
+        n = struct.unpack(">H", await reader.readexactly(2))[0]
+    elif n == 127:
+        n = struct.unpack(">Q", await reader.readexactly(8))[0]
+    mask = await reader.readexactly(4) if b1 & 0x80 else b"\0\0\0\0"
+    data = bytes(c ^ mask[i & 3] for i, c in enumerate(await reader.readexactly(n)))
+    return b0 & 0x0F, data
+
+
+def load(path):
+    with open(path) as f:
+        return [json.loads(line) for line in f if line.strip()]
+
+
+async def serve_client(reader, writer, args, recording):
+    peer = writer.get_extra_info("peername")
+    request = (await reader.readuntil(b"\r\n\r\n")).decode()
+    lines = request.split("\r\n")
+    target = lines[0].split(" ")[1]
+    headers = dict(l.split(": ", 1) for l in lines[1:] if ": " in l)
+    key = headers.get("Sec-WebSocket-Key", "")
+    accept = base64.b64encode(hashlib.sha1((key + GUID).encode()).digest()).decode()
+    writer.write(("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                  "Connection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n" % accept).encode())
+
+    query = parse_qs(urlsplit(target).query)
+    wanted = set(query.get("streams", [""])[0].split("/")) - {""}
+    print("%s subscribed to %d streams" % (peer, len(wanted)), file=sys.stderr)
+
+    async def control():
+        # Answer pings; the client's heartbeat keeps its idle timer alive
+        while True:
+            opcode, data = await read_frame(reader)
+            if opcode == 0x9:
+                writer.write(frame(0xA, data))
+            elif opcode == 0x8:
+                print("%s closed" % (peer,), file=sys.stderr)
+                return
+
+    async def replay():
+        start = time.monotonic()
+        last_ping = start
+        while True:
+            base = time.monotonic()
+            for entry in recording:
+                due = base + entry["t"] / 1000.0 / args.speed
+                while time.monotonic() < due:
+                    await asyncio.sleep(min(0.05, due - time.monotonic()))
+                    now = time.monotonic()
+                    if args.ping and now - last_ping >= args.ping:
+                        writer.write(frame(0x9, b"stand-in"))
+                        last_ping = now
+                elapsed = time.monotonic() - start
+                if args.drop_after and elapsed >= args.drop_after:
+                    writer.write(frame(0x8, struct.pack(">H", 1001)))
+                    return
+                if args.silent_after and elapsed >= args.silent_after:
+                    await asyncio.sleep(3600)
+                msg = entry["msg"]
+                if wanted and msg.get("stream") not in wanted:
+                    continue
+                writer.write(frame(0x1, json.dumps(msg, separators=(",", ":")).encode()))
+                await writer.drain()
+            if not args.loop:
+                return
+
+    tasks = [asyncio.ensure_future(control()), asyncio.ensure_future(replay())]
+    try:
+        await asyncio.wait(tasks, return_when=asyncio.FIRST_COMPLETED)
+    except (ConnectionError, asyncio.IncompleteReadError):
+        pass
+    for t in tasks:
+        t.cancel()
+    writer.close()
+
+
+def record(seconds, pairs):
+    """Capture the live combined stream as a recording (stdout)."""
+    host = "stream.binance.com"
+    path = "/stream?streams=" + "/".join(p.lower() + "@miniTicker" for p in pairs)
+    sock = ssl.create_default_context().wrap_socket(socket.create_connection((host, 9443)), server_hostname=host)
+    key = base64.b64encode(os.urandom(16)).decode()
+    sock.sendall(("GET %s HTTP/1.1\r\nHost: %s:9443\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                  "Sec-WebSocket-Version: 13\r\nSec-WebSocket-Key: %s\r\n\r\n" % (path, host, key)).encode())
+    f = sock.makefile("rb")
+    while f.readline() not in (b"\r\n", b""):
+        pass
+    start = time.monotonic()
+    while time.monotonic() - start < seconds:
+        b0, b1 = f.read(2)
+        n = b1 & 0x7F
+        if n == 126:
+            n = struct.unpack(">H", f.read(2))[0]
+        elif n == 127:
+            n = struct.unpack(">Q", f.read(8))[0]
+        data = f.read(n)
+        if b0 & 0x0F == 0x9:
+            mask = os.urandom(4)
+            sock.sendall(bytes([0x8A, 0x80 | len(data)]) + mask + bytes(c ^ mask[i & 3] for i, c in enumerate(data)))
+        elif b0 & 0x0F == 0x1:
+            t = int((time.monotonic() - start) * 1000)
+            print(json.dumps({"t": t, "msg": json.loads(data)}, separators=(",", ":")), flush=True)
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("recording", nargs="?")
+    p.add_argument("--port", type=int, default=9443)
+    p.add_argument("--speed", type=float, default=1.0, help="replay speed factor")
+    p.add_argument("--loop", action="store_true", help="restart the recording at its end")
+    p.add_argument("--ping", type=float, default=0, help="server ping interval (s)")
+    p.add_argument("--drop-after", type=float, default=0, help="close the connection after N s")
+    p.add_argument("--silent-after", type=float, default=0, help="stop sending after N s, keep the socket")
+    p.add_argument("--record", type=float, metavar="SECONDS", help="record the live stream for the given pairs")
+    p.add_argument("pairs", nargs="*")
+    args = p.parse_args()
+
+    if args.record:
+        record(args.record, ([args.recording] if args.recording else []) + args.pairs)
+        return
+    if not args.recording:
+        p.error("recording file required")
+
+    recording = load(args.recording)
+
+    async def run():
+        server = await asyncio.start_server(lambda r, w: serve_client(r, w, args, recording), "0.0.0.0", args.port)
+        print("Replaying %d messages on ws://0.0.0.0:%d" % (len(recording), args.port), file=sys.stderr)
+        async with server:
+            await server.serve_forever()
+
+    asyncio.run(run())
+
+
+if __name__ == "__main__":
+    main()